@@ -12,6 +12,7 @@
 #include "../core/document.h"
 #include "../core/page.h"
 #include "../core/annotations.h"
+#include "../core/observer.h"
 #include "../settings_core.h"
 #include "testingutils.h"
 
@@ -26,6 +27,7 @@ private slots:
     void testAddAnnotations();
     void testAddAnnotationUndoWithRotate_Bug318091();
     void testRemoveAnnotations();
+    void testAnnotationChangeNotifications();
 
 private:
     Okular::Document *m_document;
@@ -187,5 +189,45 @@ void AddRemoveAnnotationTest::testRemoveAnnotations()
     QVERIFY( TestingUtils::AnnotationDisposeWatcher::disposedAnnotationName() == annot1Name );
 }
 
+class AnnotationChangeObserver : public Okular::DocumentObserver
+{
+public:
+    void notifyAnnotationChanged( int page, Okular::Annotation *annotation, AnnotationChange change ) override
+    {
+        m_pages << page;
+        m_annotations << annotation;
+        m_changes << change;
+    }
+
+    QList< int > m_pages;
+    QList< Okular::Annotation * > m_annotations;
+    QList< AnnotationChange > m_changes;
+};
+
+void AddRemoveAnnotationTest::testAnnotationChangeNotifications()
+{
+    AnnotationChangeObserver observer;
+    m_document->addObserver( &observer );
+
+    Okular::Annotation *annot = new Okular::TextAnnotation();
+    annot->setBoundingRectangle( Okular::NormalizedRect( 0.1, 0.1, 0.15, 0.15 ) );
+    annot->setContents( QStringLiteral("annot contents") );
+
+    // Each operation reports the annotation it touched
+    m_document->addPageAnnotation( 0, annot );
+    m_document->editPageAnnotationContents( 0, annot, QStringLiteral("new contents"), 0, 0, 0 );
+    m_document->removePageAnnotation( 0, annot );
+    m_document->undo();
+
+    const QList< Okular::DocumentObserver::AnnotationChange > expected = { Okular::DocumentObserver::AnnotationAdded, Okular::DocumentObserver::AnnotationModified,
+                                                                           Okular::DocumentObserver::AnnotationRemoved, Okular::DocumentObserver::AnnotationAdded };
+    QCOMPARE( observer.m_changes, expected );
+    QCOMPARE( observer.m_pages, QList< int >() << 0 << 0 << 0 << 0 );
+    foreach ( Okular::Annotation *notified, observer.m_annotations )
+        QCOMPARE( notified, annot );
+
+    m_document->removeObserver( &observer );
+}
+
 QTEST_MAIN( AddRemoveAnnotationTest )
 #include "addremoveannotationtest.moc"
@@ -0,0 +1,118 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QAbstractItemModelTester>
+#include <QStandardItemModel>
+
+#include "../ui/annotationmodel.h"
+#include "../ui/annotationproxymodels.h"
+
+// Checks the review proxy models, chained as in the review panel, while
+// annotations and pages are added and removed; the source has the shape of
+// the AnnotationModel: the pages, and their annotations below them
+class AnnotationProxyModelsTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void testInsertRemove_data();
+        void testInsertRemove();
+
+    private:
+        static QStandardItem *createPage( int page );
+        static QStandardItem *createAnnotation( int page, const QString &author );
+};
+
+QStandardItem *AnnotationProxyModelsTest::createPage( int page )
+{
+    QStandardItem *item = new QStandardItem( QStringLiteral( "Page %1" ).arg( page + 1 ) );
+    item->setData( page, AnnotationModel::PageRole );
+    return item;
+}
+
+QStandardItem *AnnotationProxyModelsTest::createAnnotation( int page, const QString &author )
+{
+    QStandardItem *item = new QStandardItem( author );
+    item->setData( page, AnnotationModel::PageRole );
+    item->setData( author, AnnotationModel::AuthorRole );
+    return item;
+}
+
+void AnnotationProxyModelsTest::testInsertRemove_data()
+{
+    QTest::addColumn<bool>( "groupByPage" );
+    QTest::addColumn<bool>( "groupByAuthor" );
+    QTest::addColumn<int>( "topLevelCount" );
+
+    // 3 pages, or 4 annotations, or 2 authors
+    QTest::newRow( "flat" ) << false << false << 4;
+    QTest::newRow( "by page" ) << true << false << 3;
+    QTest::newRow( "by author" ) << false << true << 2;
+    QTest::newRow( "by page and author" ) << true << true << 3;
+}
+
+void AnnotationProxyModelsTest::testInsertRemove()
+{
+    QFETCH( bool, groupByPage );
+    QFETCH( bool, groupByAuthor );
+    QFETCH( int, topLevelCount );
+
+    QStandardItemModel source;
+    PageFilterProxyModel pageFilterModel;
+    pageFilterModel.setSourceModel( &source );
+    PageGroupProxyModel pageGroupModel;
+    pageGroupModel.groupByPage( groupByPage );
+    pageGroupModel.setSourceModel( &pageFilterModel );
+    AuthorGroupProxyModel authorGroupModel;
+    authorGroupModel.groupByAuthor( groupByAuthor );
+    authorGroupModel.setSourceModel( &pageGroupModel );
+
+    QAbstractItemModelTester pageGroupTester( &pageGroupModel, QAbstractItemModelTester::FailureReportingMode::QtTest );
+    QAbstractItemModelTester authorGroupTester( &authorGroupModel, QAbstractItemModelTester::FailureReportingMode::QtTest );
+
+    // the first annotation of a page adds the page
+    QStandardItem *page3 = createPage( 3 );
+    page3->appendRow( createAnnotation( 3, QStringLiteral( "alice" ) ) );
+    source.appendRow( page3 );
+    QStandardItem *page1 = createPage( 1 );
+    page1->appendRow( createAnnotation( 1, QStringLiteral( "bob" ) ) );
+    source.insertRow( 0, page1 );
+
+    // more annotations in the existing pages, and a page in between
+    page1->appendRow( createAnnotation( 1, QStringLiteral( "alice" ) ) );
+    QStandardItem *page2 = createPage( 2 );
+    page2->appendRow( createAnnotation( 2, QStringLiteral( "bob" ) ) );
+    source.insertRow( 1, page2 );
+    QCOMPARE( authorGroupModel.rowCount( QModelIndex() ), topLevelCount );
+
+    // the annotations are still mapped to the right ones once the pages
+    // before them moved
+    const QModelIndex page3Annotation = source.index( 0, 0, source.index( 2, 0 ) );
+    const QModelIndex mapped = authorGroupModel.mapFromSource( pageGroupModel.mapFromSource( pageFilterModel.mapFromSource( page3Annotation ) ) );
+    QVERIFY( mapped.isValid() );
+    QCOMPARE( mapped.data( AnnotationModel::PageRole ).toInt(), 3 );
+    QCOMPARE( mapped.data( AnnotationModel::AuthorRole ).toString(), QStringLiteral( "alice" ) );
+
+    // removing annotations, and the pages with them
+    page1->removeRow( 0 );
+    source.removeRow( 1 );
+    page3->removeRow( 0 );
+    source.removeRow( 1 );
+    QCOMPARE( source.rowCount(), 1 );
+    // one annotation, its page, or its author
+    QCOMPARE( authorGroupModel.rowCount( QModelIndex() ), 1 );
+    source.removeRow( 0 );
+    QCOMPARE( pageGroupModel.rowCount( QModelIndex() ), 0 );
+    QCOMPARE( authorGroupModel.rowCount( QModelIndex() ), 0 );
+}
+
+QTEST_GUILESS_MAIN( AnnotationProxyModelsTest )
+#include "annotationproxymodelstest.moc"
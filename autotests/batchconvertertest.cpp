@@ -0,0 +1,93 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QImage>
+#include <QTemporaryDir>
+
+#include "../batch/batchconverter.h"
+#include "../settings_core.h"
+
+class BatchConverterTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void testParsePageRange_data();
+        void testParsePageRange();
+        void testConvert();
+};
+
+void BatchConverterTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled( true );
+    Okular::SettingsCore::instance( QStringLiteral("batchconvertertest") );
+}
+
+void BatchConverterTest::testParsePageRange_data()
+{
+    QTest::addColumn<QString>( "range" );
+    QTest::addColumn<bool>( "valid" );
+    QTest::addColumn<QVector<int>>( "pages" );
+
+    QTest::newRow( "all" ) << QString() << true << ( QVector<int>() << 0 << 1 << 2 << 3 << 4 );
+    QTest::newRow( "single" ) << QStringLiteral( "3" ) << true << ( QVector<int>() << 2 );
+    QTest::newRow( "list" ) << QStringLiteral( "1-2, 4" ) << true << ( QVector<int>() << 0 << 1 << 3 );
+    QTest::newRow( "open end" ) << QStringLiteral( "4-" ) << true << ( QVector<int>() << 3 << 4 );
+    QTest::newRow( "open start" ) << QStringLiteral( "-2" ) << true << ( QVector<int>() << 0 << 1 );
+    QTest::newRow( "past the end" ) << QStringLiteral( "4-6" ) << false << QVector<int>();
+    QTest::newRow( "zero" ) << QStringLiteral( "0" ) << false << QVector<int>();
+    QTest::newRow( "reversed" ) << QStringLiteral( "3-1" ) << false << QVector<int>();
+    QTest::newRow( "not a number" ) << QStringLiteral( "a" ) << false << QVector<int>();
+}
+
+void BatchConverterTest::testParsePageRange()
+{
+    QFETCH( QString, range );
+    QFETCH( bool, valid );
+    QFETCH( QVector<int>, pages );
+
+    QVector<int> parsedPages;
+    QCOMPARE( BatchConverter::parsePageRange( range, 5, &parsedPages ), valid );
+    if ( valid )
+        QCOMPARE( parsedPages, pages );
+}
+
+void BatchConverterTest::testConvert()
+{
+    QTemporaryDir outputDir;
+    QVERIFY( outputDir.isValid() );
+
+    BatchConverter::Options options;
+    options.outputDir = outputDir.path();
+    options.pages = QStringLiteral( "1" );
+    options.dpi = 72;
+    options.imageFormat = "png";
+    options.images = true;
+    options.text = true;
+
+    BatchConverter converter( options );
+    QVERIFY( converter.convert( QStringLiteral(KDESRCDIR "data/file1.pdf") ) );
+
+    // a single digit, file1.pdf has one page
+    const QImage image( outputDir.filePath( QStringLiteral( "file1-1.png" ) ) );
+    QVERIFY( !image.isNull() );
+    QVERIFY( image.width() > 0 && image.height() > 0 );
+
+    QFile textFile( outputDir.filePath( QStringLiteral( "file1.txt" ) ) );
+    QVERIFY( textFile.open( QIODevice::ReadOnly ) );
+    QVERIFY( !textFile.readAll().trimmed().isEmpty() );
+
+    QVERIFY( !converter.convert( outputDir.filePath( QStringLiteral( "missing.pdf" ) ) ) );
+}
+
+QTEST_MAIN( BatchConverterTest )
+#include "batchconvertertest.moc"
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <KBookmarkManager>
+
+#include "../core/bookmarkmanager.h"
+#include "../core/document.h"
+#include "../core/observer.h"
+#include "../settings_core.h"
+
+class BookmarkObserver : public Okular::DocumentObserver
+{
+    public:
+        void notifyPageChanged( int page, int flags ) override
+        {
+            if ( flags & Okular::DocumentObserver::Bookmark )
+                m_pages.append( page );
+        }
+
+        QList<int> m_pages;
+};
+
+class BookmarkManagerTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void testExternalChange();
+        void testOrderAndRemoval();
+
+    private:
+        static Okular::DocumentViewport viewport( int page, double y );
+        static QStringList titles( const KBookmark::List &bookmarks );
+};
+
+void BookmarkManagerTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled( true );
+    QFile::remove( QStandardPaths::writableLocation( QStandardPaths::GenericDataLocation ) + QStringLiteral("/okular/bookmarks.xml") );
+    Okular::SettingsCore::instance( QStringLiteral("bookmarkmanagertest") );
+}
+
+// Test that the bookmarks of the current document are indexed again when
+// the whole bookmarks file is changed by someone else
+void BookmarkManagerTest::testExternalChange()
+{
+    Okular::Document *document = new Okular::Document( nullptr );
+    const QString testFile = QStringLiteral(KDESRCDIR "data/file2.pdf");
+    const QUrl testFileUrl = QUrl::fromLocalFile( testFile );
+    QMimeDatabase db;
+    QCOMPARE( document->openDocument( testFile, testFileUrl, db.mimeTypeForFile( testFile ) ), Okular::Document::OpenSuccess );
+    QVERIFY( document->pages() > 1 );
+
+    Okular::BookmarkManager *bookmarkManager = document->bookmarkManager();
+    bookmarkManager->addBookmark( 0 );
+    QVERIFY( bookmarkManager->isBookmarked( 0 ) );
+    bookmarkManager->save();
+
+    // another instance moves the bookmark to the second page
+    KBookmarkManager *manager = KBookmarkManager::managerForFile( QStandardPaths::writableLocation( QStandardPaths::GenericDataLocation ) + QStringLiteral("/okular/bookmarks.xml"), QStringLiteral("okular") );
+    KBookmarkGroup root = manager->root();
+    KBookmarkGroup group = root.first().toGroup();
+    QVERIFY( !group.isNull() );
+    group.deleteBookmark( group.first() );
+    Okular::DocumentViewport viewport;
+    viewport.pageNumber = 1;
+    QUrl bookmarkUrl = testFileUrl;
+    bookmarkUrl.setFragment( viewport.toString(), QUrl::DecodedMode );
+    group.addBookmark( QStringLiteral("#2"), bookmarkUrl, QString() );
+
+    // the notification of a whole file change
+    QSignalSpy changedSpy( bookmarkManager, &Okular::BookmarkManager::bookmarksChanged );
+    QVERIFY( QMetaObject::invokeMethod( bookmarkManager, "_o_changed", Q_ARG( QString, QString() ), Q_ARG( QString, QString() ) ) );
+
+    QVERIFY( !bookmarkManager->isBookmarked( 0 ) );
+    QVERIFY( bookmarkManager->isBookmarked( 1 ) );
+    QCOMPARE( bookmarkManager->bookmarks( 1 ).count(), 1 );
+    QVERIFY( bookmarkManager->bookmark( viewport ).url() == bookmarkUrl );
+    QVERIFY( changedSpy.count() >= 1 );
+    bool currentUrlChanged = false;
+    for ( const QList<QVariant> &arguments : qAsConst( changedSpy ) )
+        currentUrlChanged |= arguments.at( 0 ).toUrl() == testFileUrl;
+    QVERIFY( currentUrlChanged );
+
+    document->closeDocument();
+    delete document;
+}
+
+Okular::DocumentViewport BookmarkManagerTest::viewport( int page, double y )
+{
+    Okular::DocumentViewport vp( page );
+    vp.rePos.enabled = true;
+    vp.rePos.normalizedX = 0.5;
+    vp.rePos.normalizedY = y;
+    return vp;
+}
+
+QStringList BookmarkManagerTest::titles( const KBookmark::List &bookmarks )
+{
+    QStringList ret;
+    for ( const KBookmark &bm : bookmarks )
+        ret << bm.text();
+    return ret;
+}
+
+// Test that the bookmarks are given in the viewport order whatever order
+// they were added in, and that removing them notifies the pages that lost
+// their bookmarks
+void BookmarkManagerTest::testOrderAndRemoval()
+{
+    Okular::Document *document = new Okular::Document( nullptr );
+    const QString testFile = QStringLiteral(KDESRCDIR "data/file2.pdf");
+    const QUrl testFileUrl = QUrl::fromLocalFile( testFile );
+    QMimeDatabase db;
+    QCOMPARE( document->openDocument( testFile, testFileUrl, db.mimeTypeForFile( testFile ) ), Okular::Document::OpenSuccess );
+    QCOMPARE( document->pages(), 2u );
+    BookmarkObserver observer;
+    document->addObserver( &observer );
+
+    // the bookmarks file is shared with the other tests
+    Okular::BookmarkManager *bookmarkManager = document->bookmarkManager();
+    bookmarkManager->removeBookmarks( testFileUrl, bookmarkManager->bookmarks( testFileUrl ) );
+    QVERIFY( bookmarkManager->bookmarks().isEmpty() );
+
+    QVERIFY( bookmarkManager->addBookmark( testFileUrl, viewport( 1, 0.5 ), QStringLiteral("d") ) );
+    QVERIFY( bookmarkManager->addBookmark( testFileUrl, viewport( 0, 0.8 ), QStringLiteral("b") ) );
+    QVERIFY( bookmarkManager->addBookmark( testFileUrl, viewport( 1, 0.1 ), QStringLiteral("c") ) );
+    QVERIFY( bookmarkManager->addBookmark( testFileUrl, viewport( 0, 0.2 ), QStringLiteral("a") ) );
+
+    QCOMPARE( titles( bookmarkManager->bookmarks( 0 ) ), QStringList() << QStringLiteral("a") << QStringLiteral("b") );
+    QCOMPARE( titles( bookmarkManager->bookmarks( 1 ) ), QStringList() << QStringLiteral("c") << QStringLiteral("d") );
+    QCOMPARE( bookmarkManager->bookmark( 1 ).text(), QStringLiteral("c") );
+
+    QCOMPARE( bookmarkManager->nextBookmark( viewport( 0, 0.2 ) ).text(), QStringLiteral("b") );
+    QCOMPARE( bookmarkManager->nextBookmark( viewport( 0, 0.9 ) ).text(), QStringLiteral("c") );
+    QVERIFY( bookmarkManager->nextBookmark( viewport( 1, 0.5 ) ).isNull() );
+    QCOMPARE( bookmarkManager->previousBookmark( viewport( 1, 0.1 ) ).text(), QStringLiteral("b") );
+    QCOMPARE( bookmarkManager->previousBookmark( viewport( 1, 0.9 ) ).text(), QStringLiteral("d") );
+    QVERIFY( bookmarkManager->previousBookmark( viewport( 0, 0.2 ) ).isNull() );
+
+    // only the page whose bookmarks were removed changed
+    observer.m_pages.clear();
+    bookmarkManager->removeBookmarks( testFileUrl, bookmarkManager->bookmarks( 0 ) );
+    QCOMPARE( observer.m_pages, QList<int>() << 0 );
+    QVERIFY( !bookmarkManager->isBookmarked( 0 ) );
+    QVERIFY( bookmarkManager->previousBookmark( viewport( 1, 0.1 ) ).isNull() );
+    QCOMPARE( bookmarkManager->nextBookmark( viewport( 0, 0.2 ) ).text(), QStringLiteral("c") );
+
+    // even when no page has bookmarks anymore
+    observer.m_pages.clear();
+    bookmarkManager->removeBookmarks( testFileUrl, bookmarkManager->bookmarks( 1 ) );
+    QCOMPARE( observer.m_pages, QList<int>() << 1 );
+    QVERIFY( !bookmarkManager->isBookmarked( 1 ) );
+    QVERIFY( bookmarkManager->nextBookmark( viewport( 0, 0.2 ) ).isNull() );
+
+    document->removeObserver( &observer );
+    document->closeDocument();
+    delete document;
+}
+
+QTEST_MAIN( BookmarkManagerTest )
+#include "bookmarkmanagertest.moc"
@@ -26,6 +26,7 @@ private slots:
     void cleanupTestCase();
 
     void testSimpleCalculate();
+    void testRecalculateDependentFields();
 
 private:
     Okular::Document *m_document;
@@ -102,5 +103,36 @@ void CalculateTextTest::testSimpleCalculate()
     QCOMPARE( fields[QStringLiteral ("Sum")]->text(), QStringLiteral( "40" ) );
 }
 
+void CalculateTextTest::testRecalculateDependentFields()
+{
+    m_document->closeDocument();
+    const QString testFile = QStringLiteral( KDESRCDIR "data/simpleCalculate.pdf" );
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile( testFile );
+    QCOMPARE( m_document->openDocument( testFile, QUrl(), mime), Okular::Document::OpenSuccess );
+
+    QMap<QString, Okular::FormFieldText *> fields;
+    for ( Okular::FormField *ff: m_document->page( 0 )->formFields() )
+    {
+        fields.insert( ff->name(), static_cast<Okular::FormFieldText*>( ff ) );
+    }
+
+    // The first edit calculates everything, and records what each
+    // calculation reads
+    m_document->editFormText( 0, fields[QStringLiteral( "field1" )], QStringLiteral( "10" ), 0, 0, 0 );
+    QCOMPARE( fields[QStringLiteral( "Sum" )]->text(), QStringLiteral( "10" ) );
+
+    // Sum does not read AVG, so editing AVG leaves it alone
+    fields[QStringLiteral( "Sum" )]->setText( QStringLiteral( "untouched" ) );
+    m_document->editFormText( 0, fields[QStringLiteral( "AVG" )], QStringLiteral( "5" ), 0, 0, 0 );
+    QCOMPARE( fields[QStringLiteral( "Sum" )]->text(), QStringLiteral( "untouched" ) );
+    QCOMPARE( fields[QStringLiteral( "AVG" )]->text(), QStringLiteral( "5" ) );
+
+    // Sum reads field2, so editing it recalculates Sum, and AVG with it
+    m_document->editFormText( 0, fields[QStringLiteral( "field2" )], QStringLiteral( "20" ), 0, 0, 0 );
+    QCOMPARE( fields[QStringLiteral( "Sum" )]->text(), QStringLiteral( "30" ) );
+    QCOMPARE( fields[QStringLiteral( "AVG" )]->text(), QStringLiteral( "10" ) );
+}
+
 QTEST_MAIN( CalculateTextTest )
 #include "calculatetexttest.moc"
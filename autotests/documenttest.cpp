@@ -15,6 +15,7 @@
 #include <threadweaver/queue.h>
 
 #include "../core/annotations.h"
+#include "../core/docdata_p.h"
 #include "../core/document.h"
 #include "../core/document_p.h"
 #include "../core/generator.h"
@@ -31,6 +32,30 @@ class DocumentTest
     private slots:
         void testCloseDuringRotationJob();
         void testDocdataMigration();
+        void testDocumentDataFile();
+        void testThumbnailCache();
+        void testSharedPixmapBudget();
+};
+
+// An observer that never lets the document unload its pixmaps, and counts
+// how many times it has been asked to request them again
+class StickyObserver : public Okular::DocumentObserver
+{
+    public:
+        StickyObserver() : m_pixmapsCleared( 0 ) {}
+
+        bool canUnloadPixmap( int ) const override
+        {
+            return false;
+        }
+
+        void notifyContentsCleared( int changedFlags ) override
+        {
+            if ( changedFlags & Okular::DocumentObserver::Pixmap )
+                ++m_pixmapsCleared;
+        }
+
+        int m_pixmapsCleared;
 };
 
 // Test that we don't crash if the document is closed while a RotationJob
@@ -82,6 +107,7 @@ void DocumentTest::testDocdataMigration()
     // Copy XML file to the docdata/ directory
     const QString docDataPath = Okular::DocumentPrivate::docDataFileName(testFileUrl, testFileSize);
     QFile::remove(docDataPath);
+    QFile::remove(Okular::DocumentData::fileNameForXml(docDataPath));
     QVERIFY( QFile::copy(KDESRCDIR "data/file1-docdata.xml", docDataPath) );
 
     // Open our document
@@ -129,5 +155,187 @@ void DocumentTest::testDocdataMigration()
     delete m_document;
 }
 
+// Test that the binary docdata file reads back what was written, that the
+// page list is skipped when not asked for, and that the XML file of the
+// older versions is left for them
+void DocumentTest::testDocumentDataFile()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString xmlFileName = dir.path() + QStringLiteral("/1234.file.pdf.xml");
+    const QString fileName = Okular::DocumentData::fileNameForXml( xmlFileName );
+    QCOMPARE( fileName, dir.path() + QStringLiteral("/1234.file.pdf.okdata") );
+
+    QFile xmlFile( xmlFileName );
+    QVERIFY( xmlFile.open( QIODevice::WriteOnly ) );
+    xmlFile.close();
+
+    Okular::DocumentData data;
+    data.url = QStringLiteral("/tmp/file.pdf");
+    data.rotation = 1;
+    data.history << QStringLiteral("0;C2:0.5:0.25:1") << QStringLiteral("3;C2:0.5:0.5:1");
+    data.currentHistoryIndex = 1;
+    Okular::DocumentData::ViewInfo view;
+    view.name = QStringLiteral("PageView");
+    view.zoom = 1.5;
+    view.zoomMode = 2;
+    data.views << view;
+    data.pageList = "<pageList><page number=\"0\"/></pageList>";
+    data.save( fileName, true );
+    Okular::DocumentData::waitForSaves();
+    QVERIFY( QFile::exists( fileName ) );
+    QVERIFY( QFile::exists( xmlFileName ) );
+
+    Okular::DocumentData withoutPages;
+    QVERIFY( withoutPages.load( fileName, false ) );
+    QCOMPARE( withoutPages.url, data.url );
+    QCOMPARE( withoutPages.rotation, 1 );
+    QCOMPARE( withoutPages.history, data.history );
+    QCOMPARE( withoutPages.currentHistoryIndex, 1 );
+    QCOMPARE( withoutPages.views.count(), 1 );
+    QCOMPARE( withoutPages.views.first().name, view.name );
+    QCOMPARE( withoutPages.views.first().zoom, 1.5 );
+    QCOMPARE( withoutPages.views.first().zoomMode, 2 );
+    QVERIFY( withoutPages.pageList.isEmpty() );
+
+    Okular::DocumentData withPages;
+    QVERIFY( withPages.load( fileName, true ) );
+    QCOMPARE( withPages.pageList, data.pageList );
+
+    // a later synchronous save wins over an earlier asynchronous one
+    data.rotation = 2;
+    data.save( fileName, true );
+    data.rotation = 3;
+    data.save( fileName, false );
+    Okular::DocumentData::waitForSaves();
+    Okular::DocumentData reloaded;
+    QVERIFY( reloaded.load( fileName, false ) );
+    QCOMPARE( reloaded.rotation, 3 );
+}
+
+// Test that thumbnails are saved on disk, and that they are used instead of
+// rendering the page when the document is opened again
+void DocumentTest::testThumbnailCache()
+{
+    QStandardPaths::setTestModeEnabled( true );
+    QDir thumbnailsDir( QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation ) + QStringLiteral("/okular/thumbnails") );
+    thumbnailsDir.removeRecursively();
+
+    Okular::SettingsCore::instance( QStringLiteral("documenttest") );
+    Okular::Document *m_document = new Okular::Document( nullptr );
+    const QString testFile = QStringLiteral(KDESRCDIR "data/file1.pdf");
+    const QUrl testFileUrl = QUrl::fromLocalFile( testFile );
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile( testFile );
+
+    Okular::DocumentObserver *dummyDocumentObserver = new Okular::DocumentObserver();
+    m_document->addObserver( dummyDocumentObserver );
+
+    // a synchronous thumbnail request, rendered by the generator
+    QCOMPARE( m_document->openDocument( testFile, testFileUrl, mime ), Okular::Document::OpenSuccess );
+    m_document->requestPixmaps( QLinkedList<Okular::PixmapRequest*>() << new Okular::PixmapRequest(
+        dummyDocumentObserver, 0, 100, 140, 1, Okular::PixmapRequest::Thumbnail ) );
+    QVERIFY( m_document->page( 0 )->hasPixmap( dummyDocumentObserver, 100, 140 ) );
+    m_document->closeDocument();
+
+    const QStringList cacheDirs = thumbnailsDir.entryList( QDir::Dirs | QDir::NoDotAndDotDot );
+    QCOMPARE( cacheDirs.count(), 1 );
+    const QString thumbnailFile = thumbnailsDir.filePath( cacheDirs.first() + QStringLiteral("/0.png") );
+    QVERIFY( QFile::exists( thumbnailFile ) );
+
+    // a plain image in place of the saved thumbnail tells whether it is used
+    QImage marker( 100, 140, QImage::Format_ARGB32 );
+    marker.fill( Qt::green );
+    QVERIFY( marker.save( thumbnailFile, "PNG" ) );
+
+    // opened again, the thumbnail is read from the disk, not rendered
+    Okular::PixmapRequest::PixmapRequestFeatures features = Okular::PixmapRequest::Asynchronous;
+    features |= Okular::PixmapRequest::Thumbnail;
+    QCOMPARE( m_document->openDocument( testFile, testFileUrl, mime ), Okular::Document::OpenSuccess );
+    m_document->requestPixmaps( QLinkedList<Okular::PixmapRequest*>() << new Okular::PixmapRequest(
+        dummyDocumentObserver, 0, 100, 140, 1, features ) );
+    QTRY_VERIFY( m_document->page( 0 )->hasPixmap( dummyDocumentObserver, 100, 140 ) );
+    const QPixmap *cached = m_document->page( 0 )->_o_nearestPixmap( dummyDocumentObserver, 100, 140 );
+    QVERIFY( cached );
+    QCOMPARE( cached->toImage().pixel( 50, 70 ), QColor( Qt::green ).rgb() );
+
+    // an annotation changes the thumbnail, the cached one is not used anymore
+    Okular::Annotation *annotation = new Okular::TextAnnotation();
+    annotation->setBoundingRectangle( Okular::NormalizedRect( 0.1, 0.1, 0.15, 0.15 ) );
+    m_document->addPageAnnotation( 0, annotation );
+    Okular::DocumentObserver *otherObserver = new Okular::DocumentObserver();
+    m_document->addObserver( otherObserver );
+    m_document->requestPixmaps( QLinkedList<Okular::PixmapRequest*>() << new Okular::PixmapRequest(
+        otherObserver, 0, 100, 140, 1, features ), Okular::Document::NoOption );
+    QVERIFY( !m_document->page( 0 )->hasPixmap( otherObserver, 100, 140 ) );
+    QTRY_VERIFY( m_document->page( 0 )->hasPixmap( otherObserver, 100, 140 ) );
+    m_document->closeDocument();
+
+    const QStringList thumbnailFiles = QDir( thumbnailsDir.filePath( cacheDirs.first() ) ).entryList( QStringList() << QStringLiteral("0*.png"), QDir::Files );
+    QCOMPARE( thumbnailFiles.count(), 2 );
+
+    delete m_document;
+    delete otherObserver;
+    delete dummyDocumentObserver;
+    thumbnailsDir.removeRecursively();
+}
+
+// Test that the pixmap memory budget is shared by the documents, and that
+// the documents that are not active give their pixmaps back first, keeping
+// only the thumbnails
+void DocumentTest::testSharedPixmapBudget()
+{
+    Okular::SettingsCore::instance( QStringLiteral("documenttest") );
+    const int oldMemoryLevel = Okular::SettingsCore::memoryLevel();
+    Okular::SettingsCore::setMemoryLevel( Okular::SettingsCore::EnumMemoryLevel::Low );
+
+    const QString testFile = QStringLiteral(KDESRCDIR "data/file1.pdf");
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile( testFile );
+
+    Okular::Document *background = new Okular::Document( nullptr );
+    StickyObserver *backgroundObserver = new StickyObserver();
+    background->addObserver( backgroundObserver );
+    QCOMPARE( background->openDocument( testFile, QUrl(), mime ), Okular::Document::OpenSuccess );
+    QVERIFY( Okular::Document::allDocuments().contains( background ) );
+
+    background->requestPixmaps( QLinkedList<Okular::PixmapRequest*>() << new Okular::PixmapRequest(
+        backgroundObserver, 0, 100, 140, 1, Okular::PixmapRequest::NoFeature ) );
+    background->requestPixmaps( QLinkedList<Okular::PixmapRequest*>() << new Okular::PixmapRequest(
+        backgroundObserver, 1, 100, 140, 1, Okular::PixmapRequest::Thumbnail ) );
+    QVERIFY( background->page( 0 )->hasPixmap( backgroundObserver, 100, 140 ) );
+    QVERIFY( background->page( 1 )->hasPixmap( backgroundObserver, 100, 140 ) );
+    QCOMPARE( background->pixmapMemory(), 2ULL * 4 * 100 * 140 );
+    background->setActive( false );
+
+    // the active document makes room by taking the background page, not
+    // the thumbnail, even if the observer of the latter would not allow it
+    Okular::Document *active = new Okular::Document( nullptr );
+    Okular::DocumentObserver *activeObserver = new Okular::DocumentObserver();
+    active->addObserver( activeObserver );
+    QCOMPARE( active->openDocument( testFile, QUrl(), mime ), Okular::Document::OpenSuccess );
+    active->requestPixmaps( QLinkedList<Okular::PixmapRequest*>() << new Okular::PixmapRequest(
+        activeObserver, 0, 100, 140, 1, Okular::PixmapRequest::NoFeature ) );
+    QVERIFY( active->page( 0 )->hasPixmap( activeObserver, 100, 140 ) );
+    QVERIFY( !background->page( 0 )->hasPixmap( backgroundObserver ) );
+    QVERIFY( background->page( 1 )->hasPixmap( backgroundObserver, 100, 140 ) );
+    QCOMPARE( background->pixmapMemory(), 4ULL * 100 * 140 );
+
+    // once active again, the document asks its observers to request the
+    // freed pages again
+    QCOMPARE( backgroundObserver->m_pixmapsCleared, 0 );
+    active->setActive( false );
+    background->setActive( true );
+    QCOMPARE( backgroundObserver->m_pixmapsCleared, 1 );
+
+    delete active;
+    delete activeObserver;
+    delete background;
+    delete backgroundObserver;
+    QVERIFY( Okular::Document::allDocuments().isEmpty() );
+
+    Okular::SettingsCore::setMemoryLevel( oldMemoryLevel );
+}
+
 QTEST_MAIN( DocumentTest )
 #include "documenttest.moc"
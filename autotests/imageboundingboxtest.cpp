@@ -0,0 +1,103 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QPainter>
+
+#include "../core/area.h"
+#include "../core/utils.h"
+#include "../settings_core.h"
+
+Q_DECLARE_METATYPE(QImage::Format)
+
+class ImageBoundingBoxTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void testBoundingBox_data();
+        void testBoundingBox();
+        void testBlankImage();
+};
+
+void ImageBoundingBoxTest::initTestCase()
+{
+    Okular::SettingsCore::instance( QStringLiteral("imageboundingboxtest") );
+}
+
+void ImageBoundingBoxTest::testBoundingBox_data()
+{
+    QTest::addColumn<QImage::Format>("format");
+    QTest::addColumn<QRect>("content");
+    QTest::addColumn<QColor>("color");
+
+    // the widths are not multiples of 4, so both the vectorized and the plain paths are used
+    QTest::newRow("rgb32") << QImage::Format_RGB32 << QRect( 13, 7, 50, 30 ) << QColor( Qt::black );
+    QTest::newRow("argb32 premultiplied") << QImage::Format_ARGB32_Premultiplied << QRect( 1, 2, 98, 3 ) << QColor( Qt::red );
+    QTest::newRow("argb32 single pixel") << QImage::Format_ARGB32 << QRect( 97, 58, 1, 1 ) << QColor( Qt::blue );
+    QTest::newRow("edges") << QImage::Format_RGB32 << QRect( 0, 0, 101, 61 ) << QColor( Qt::darkGreen );
+    QTest::newRow("rgb888") << QImage::Format_RGB888 << QRect( 30, 20, 7, 9 ) << QColor( Qt::black );
+    QTest::newRow("almost white") << QImage::Format_RGB32 << QRect( 50, 0, 1, 61 ) << QColor( 254, 255, 255 );
+    // scanned as they are, 16 pixels at a time
+    QTest::newRow("grayscale8") << QImage::Format_Grayscale8 << QRect( 17, 5, 70, 40 ) << QColor( Qt::black );
+    QTest::newRow("grayscale8 light gray") << QImage::Format_Grayscale8 << QRect( 99, 30, 1, 2 ) << QColor( 254, 254, 254 );
+}
+
+void ImageBoundingBoxTest::testBoundingBox()
+{
+    QFETCH(QImage::Format, format);
+    QFETCH(QRect, content);
+    QFETCH(QColor, color);
+
+    // painted in 32 bit, not all the formats can be painted on
+    QImage image( 101, 61, QImage::Format_ARGB32_Premultiplied );
+    image.fill( Qt::white );
+    {
+        QPainter painter( &image );
+        painter.fillRect( content, color );
+        // a hole inside the content doesn't change the box
+        if ( content.width() > 2 && content.height() > 2 )
+            painter.fillRect( QRect( content.center(), QSize( 1, 1 ) ), Qt::white );
+    }
+    image = image.convertToFormat( format );
+
+    const Okular::NormalizedRect expected( content, image.width(), image.height() );
+    QCOMPARE( Okular::Utils::imageBoundingBox( &image ), expected );
+
+    // the alpha channel is ignored
+    if ( image.hasAlphaChannel() )
+    {
+        QImage transparent = image.convertToFormat( QImage::Format_ARGB32 );
+        for ( int y = 0; y < transparent.height(); ++y )
+        {
+            QRgb *line = reinterpret_cast< QRgb * >( transparent.scanLine( y ) );
+            for ( int x = 0; x < transparent.width(); ++x )
+                line[x] &= 0x00FFFFFF;
+        }
+        QCOMPARE( Okular::Utils::imageBoundingBox( &transparent ), expected );
+    }
+}
+
+void ImageBoundingBoxTest::testBlankImage()
+{
+    QImage image( 64, 64, QImage::Format_RGB32 );
+    image.fill( Qt::white );
+    QCOMPARE( Okular::Utils::imageBoundingBox( &image ), Okular::NormalizedRect( 0, 0, 0, 0 ) );
+
+    const QImage gray = image.convertToFormat( QImage::Format_Grayscale8 );
+    QCOMPARE( Okular::Utils::imageBoundingBox( &gray ), Okular::NormalizedRect( 0, 0, 0, 0 ) );
+
+    const QImage null;
+    QCOMPARE( Okular::Utils::imageBoundingBox( &null ), Okular::NormalizedRect( 0, 0, 0, 0 ) );
+}
+
+QTEST_MAIN( ImageBoundingBoxTest )
+#include "imageboundingboxtest.moc"
@@ -18,6 +18,7 @@
 #include "../shell/okular_main.h"
 #include "../shell/shell.h"
 #include "../shell/shellutils.h"
+#include "../core/docdata_p.h"
 #include "../core/document_p.h"
 #include "../ui/presentationwidget.h"
 #include "../part.h"
@@ -150,6 +151,7 @@ void MainShellTest::init()
         QFileInfo fileReadTest( url.toLocalFile() );
         const QString docDataPath = Okular::DocumentPrivate::docDataFileName(url, fileReadTest.size());
         QFile::remove(docDataPath);
+        QFile::remove(Okular::DocumentData::fileNameForXml(docDataPath));
     }
 }
 
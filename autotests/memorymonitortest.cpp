@@ -0,0 +1,124 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QTemporaryDir>
+
+#include "../core/memorymonitor_p.h"
+
+class MemoryMonitorTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void init();
+        void testCgroupLimits();
+        void testNoCgroup();
+
+    private:
+        void writeFile( const QString &fileName, const QByteArray &contents );
+        QByteArray readFile( const QString &fileName );
+
+        QScopedPointer<QTemporaryDir> m_root;
+};
+
+void MemoryMonitorTest::init()
+{
+#if !defined(Q_OS_LINUX)
+    QSKIP( "The cgroups and the pressure stall information are Linux only" );
+#endif
+    m_root.reset( new QTemporaryDir );
+    QVERIFY( m_root->isValid() );
+}
+
+void MemoryMonitorTest::writeFile( const QString &fileName, const QByteArray &contents )
+{
+    const QString path = m_root->path() + fileName;
+    QVERIFY( QDir().mkpath( QFileInfo( path ).absolutePath() ) );
+    QFile file( path );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QCOMPARE( file.write( contents ), (qint64)contents.size() );
+}
+
+QByteArray MemoryMonitorTest::readFile( const QString &fileName )
+{
+    QFile file( m_root->path() + fileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return QByteArray();
+    return file.readAll();
+}
+
+// Test that the tightest limit of the cgroup and its ancestors is used,
+// without the page cache that the kernel can reclaim, and that the pressure
+// of the cgroup is preferred to the system one
+void MemoryMonitorTest::testCgroupLimits()
+{
+    writeFile( QStringLiteral("/proc/self/cgroup"), "1:name=systemd:/user.slice/app.scope\n0::/user.slice/app.scope\n" );
+    writeFile( QStringLiteral("/proc/pressure/memory"), QByteArray() );
+    writeFile( QStringLiteral("/sys/fs/cgroup/cgroup.controllers"), "memory pids\n" );
+    // the parent has the lowest limit, but the most headroom
+    writeFile( QStringLiteral("/sys/fs/cgroup/user.slice/memory.max"), "1000000\n" );
+    writeFile( QStringLiteral("/sys/fs/cgroup/user.slice/memory.current"), "600000\n" );
+    writeFile( QStringLiteral("/sys/fs/cgroup/user.slice/memory.stat"), "anon 500000\ninactive_file 100000\nactive_file 0\n" );
+    writeFile( QStringLiteral("/sys/fs/cgroup/user.slice/app.scope/memory.max"), "2000000\n" );
+    writeFile( QStringLiteral("/sys/fs/cgroup/user.slice/app.scope/memory.current"), "1950000\n" );
+    writeFile( QStringLiteral("/sys/fs/cgroup/user.slice/app.scope/memory.stat"), "anon 1900000\ninactive_file 50000\n" );
+    writeFile( QStringLiteral("/sys/fs/cgroup/user.slice/app.scope/memory.pressure"), QByteArray() );
+
+    Okular::MemoryMonitor monitor( m_root->path() );
+    QCOMPARE( monitor.cgroupLimit(), 1000000ull );
+    bool limited = false;
+    QCOMPARE( monitor.cgroupAvailableMemory( &limited ), 100000ull );
+    QVERIFY( limited );
+
+    QVERIFY( monitor.hasPressureNotifications() );
+    QVERIFY( readFile( QStringLiteral("/sys/fs/cgroup/user.slice/app.scope/memory.pressure") ).startsWith( "some " ) );
+    QVERIFY( readFile( QStringLiteral("/proc/pressure/memory") ).isEmpty() );
+
+    // a limit that is not set
+    writeFile( QStringLiteral("/sys/fs/cgroup/user.slice/memory.max"), "max\n" );
+    QCOMPARE( monitor.cgroupLimit(), 2000000ull );
+    QCOMPARE( monitor.cgroupAvailableMemory( &limited ), 100000ull );
+    QVERIFY( limited );
+    writeFile( QStringLiteral("/sys/fs/cgroup/user.slice/app.scope/memory.current"), "2100000\n" );
+    QCOMPARE( monitor.cgroupAvailableMemory( &limited ), 0ull );
+    QVERIFY( limited );
+}
+
+// Test a process outside of any cgroup v2 hierarchy: no limit, and the
+// pressure of the whole system
+void MemoryMonitorTest::testNoCgroup()
+{
+    writeFile( QStringLiteral("/proc/self/cgroup"), "1:name=systemd:/user.slice\n" );
+    writeFile( QStringLiteral("/proc/pressure/memory"), QByteArray() );
+
+    Okular::MemoryMonitor monitor( m_root->path() );
+    QCOMPARE( monitor.cgroupLimit(), 0ull );
+    bool limited = true;
+    QCOMPARE( monitor.cgroupAvailableMemory( &limited ), 0ull );
+    QVERIFY( !limited );
+
+    QVERIFY( monitor.hasPressureNotifications() );
+    QVERIFY( readFile( QStringLiteral("/proc/pressure/memory") ).startsWith( "some " ) );
+
+    QSignalSpy pressureSpy( &monitor, &Okular::MemoryMonitor::memoryPressure );
+    QCOMPARE( monitor.pressureEvents(), 0 );
+    QVERIFY( QMetaObject::invokeMethod( &monitor, "pressureNotified" ) );
+    QCOMPARE( pressureSpy.count(), 1 );
+    QCOMPARE( monitor.pressureEvents(), 1 );
+
+    // without any pressure file, the memory has to be polled
+    QVERIFY( QFile::remove( m_root->path() + QStringLiteral("/proc/pressure/memory") ) );
+    Okular::MemoryMonitor pollingMonitor( m_root->path() );
+    QVERIFY( !pollingMonitor.hasPressureNotifications() );
+}
+
+QTEST_GUILESS_MAIN( MemoryMonitorTest )
+#include "memorymonitortest.moc"
@@ -14,6 +14,8 @@
 
 #include "../core/annotations.h"
 #include "../core/form.h"
+#include "../core/generator.h"
+#include "../core/observer.h"
 #include "../core/page.h"
 #include "../part.h"
 #include "../ui/toc.h"
@@ -27,6 +29,8 @@
 
 #include <QClipboard>
 #include <QMessageBox>
+#include <QPainter>
+#include <QPdfWriter>
 #include <QPushButton>
 #include <QScrollBar>
 #include <QTemporaryDir>
@@ -70,6 +74,43 @@ private:
     bool m_clicked;
 };
 
+class PixmapObserver : public Okular::DocumentObserver
+{
+public:
+    PixmapObserver() : m_pixmapChanges(0), m_setups(0) {}
+
+    void notifySetup(const QVector<Okular::Page *> &, int) override
+    {
+        ++m_setups;
+    }
+
+    void notifyPageChanged(int, int flags) override
+    {
+        if (flags & Okular::DocumentObserver::Pixmap)
+            ++m_pixmapChanges;
+    }
+
+    int m_pixmapChanges;
+    int m_setups;
+};
+
+// A page with the text, if any, above an image of the color, if any
+static bool writePdf(const QString &filePath, const QString &text, const QColor &imageColor = QColor())
+{
+    QPdfWriter writer(filePath);
+    QPainter painter;
+    if (!painter.begin(&writer))
+        return false;
+    if (imageColor.isValid()) {
+        QImage image(64, 64, QImage::Format_RGB32);
+        image.fill(imageColor);
+        painter.drawImage(QRectF(1000, 2000, 4000, 4000), image);
+    }
+    if (!text.isEmpty())
+        painter.drawText(QPointF(1000, 1000), text);
+    return painter.end();
+}
+
 namespace Okular
 {
 class PartTest
@@ -85,6 +126,9 @@ class PartTest
     private slots:
         void testReload();
         void testCanceledReload();
+        void testReloadInPlace();
+        void testReloadChangedImage_data();
+        void testReloadChangedImage();
         void testTOCReload();
         void testForwardPDF();
         void testForwardPDF_data();
@@ -176,6 +220,101 @@ void PartTest::testCanceledReload()
     qApp->processEvents();
 }
 
+// Test that a file changed on disk is reloaded without closing the document,
+// and that only the pages that changed are generated again
+void PartTest::testReloadInPlace()
+{
+    QVariantList dummyArgs;
+    Okular::Part part(nullptr, nullptr, dummyArgs);
+
+    QTemporaryDir tempDir;
+    const QString filePath = tempDir.path() + QStringLiteral("/reload.pdf");
+    QVERIFY( writePdf(filePath, QStringLiteral("first")) );
+    QVERIFY( openDocument(&part, filePath) );
+
+    PixmapObserver observer;
+    part.m_document->addObserver(&observer);
+    Okular::Page *page = part.m_document->page(0);
+    const uint pages = part.m_document->pages();
+    const int width = 200;
+    const int height = qRound(width * page->ratio());
+    part.m_document->requestPixmaps(QLinkedList<Okular::PixmapRequest*>() << new Okular::PixmapRequest(&observer, 0, width, height, 1, Okular::PixmapRequest::Asynchronous));
+    QTRY_COMPARE(observer.m_pixmapChanges, 1);
+    // the text page is generated along with the pixmap
+    QTRY_VERIFY(page->hasTextPage());
+    QVERIFY(page->text().contains(QStringLiteral("first")));
+    const QImage firstImage = page->pixmap(&observer)->toImage();
+
+    // written again with the same contents: nothing is generated again; the
+    // reload is done once the observers are set up again, and then no pixmap
+    // is asked for
+    QVERIFY( writePdf(filePath, QStringLiteral("first")) );
+    const int setups = observer.m_setups;
+    part.reload();
+    QCOMPARE(observer.m_setups, setups + 1);
+    QVERIFY(!part.m_document->hasPixmapRequests(&observer));
+    QCOMPARE(part.m_document->pages(), pages);
+    QCOMPARE(part.m_document->page(0), page);
+    QCOMPARE(observer.m_pixmapChanges, 1);
+    QVERIFY(page->hasTextPage());
+    QCOMPARE(page->pixmap(&observer)->toImage(), firstImage);
+
+    // the contents changed: the page keeps its place but is generated again
+    QVERIFY( writePdf(filePath, QStringLiteral("second")) );
+    part.reload();
+    QCOMPARE(part.m_document->pages(), pages);
+    QCOMPARE(part.m_document->page(0), page);
+    QTRY_VERIFY(observer.m_pixmapChanges >= 2);
+    QTRY_VERIFY(page->pixmap(&observer)->toImage() != firstImage);
+    QTRY_VERIFY(page->hasTextPage());
+    QVERIFY(page->text().contains(QStringLiteral("second")));
+    QVERIFY(!page->text().contains(QStringLiteral("first")));
+
+    part.m_document->removeObserver(&observer);
+}
+
+// Test that the pages whose text did not change, but their images did, are
+// generated again on reload, whether they have some text or none
+void PartTest::testReloadChangedImage_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("no text") << QString();
+    QTest::newRow("same text") << QStringLiteral("caption");
+}
+
+void PartTest::testReloadChangedImage()
+{
+    QFETCH(QString, text);
+
+    QVariantList dummyArgs;
+    Okular::Part part(nullptr, nullptr, dummyArgs);
+
+    QTemporaryDir tempDir;
+    const QString filePath = tempDir.path() + QStringLiteral("/reload.pdf");
+    QVERIFY( writePdf(filePath, text, Qt::red) );
+    QVERIFY( openDocument(&part, filePath) );
+
+    PixmapObserver observer;
+    part.m_document->addObserver(&observer);
+    Okular::Page *page = part.m_document->page(0);
+    const int width = 200;
+    const int height = qRound(width * page->ratio());
+    part.m_document->requestPixmaps(QLinkedList<Okular::PixmapRequest*>() << new Okular::PixmapRequest(&observer, 0, width, height, 1, Okular::PixmapRequest::Asynchronous));
+    QTRY_COMPARE(observer.m_pixmapChanges, 1);
+    if (!text.isEmpty())
+        QTRY_VERIFY(page->hasTextPage());
+    const QImage redImage = page->pixmap(&observer)->toImage();
+
+    QVERIFY( writePdf(filePath, text, Qt::blue) );
+    part.reload();
+    QCOMPARE(part.m_document->page(0), page);
+    QTRY_VERIFY(observer.m_pixmapChanges >= 2);
+    QTRY_VERIFY(page->pixmap(&observer)->toImage() != redImage);
+
+    part.m_document->removeObserver(&observer);
+}
+
 void PartTest::testTOCReload()
 {
     QVariantList dummyArgs;
@@ -239,7 +378,8 @@ void PartTest::testForwardPDF()
     QUrl u(QUrl::fromLocalFile(pdfResult));
     u.setFragment(QStringLiteral("src:100") + texDestination);
     part.openUrl(u);
-    QCOMPARE(part.m_document->currentPage(), 1u);
+    // the synctex file is parsed in a thread, the forward search happens after that
+    QTRY_COMPARE(part.m_document->currentPage(), 1u);
 }
 
 void PartTest::testForwardPDF_data()
@@ -12,6 +12,7 @@
 #include "../core/document.h"
 #include "../core/page.h"
 #include "../core/textpage.h"
+#include "../core/textpage_p.h"
 #include "../settings_core.h"
 
 Q_DECLARE_METATYPE(Okular::Document::SearchStatus)
@@ -48,6 +49,7 @@ class SearchTest : public QObject
         void testHyphenAtEndOfPage();
         void testOneColumn();
         void testTwoColumns();
+        void testCorrectedTextCache();
 };
 
 void SearchTest::initTestCase()
@@ -423,5 +425,50 @@ void SearchTest::testTwoColumns()
   delete page;
 }
 
+void SearchTest::testCorrectedTextCache()
+{
+  //Tests that a page with corrected text order can be saved and loaded again
+  //without running the layout analysis a second time.
+
+  QVector<QString> text;
+  text << QStringLiteral("This") << QStringLiteral("text") << QStringLiteral("in") << QStringLiteral("two")
+       << QStringLiteral("is") << QStringLiteral("set")    << QStringLiteral("columns.");
+
+  QVector<Okular::NormalizedRect> rect;
+  rect << Okular::NormalizedRect(0.0,  0.0,  0.20, 0.1)
+       << Okular::NormalizedRect(0.25, 0.0,  0.45, 0.1)
+       << Okular::NormalizedRect(0.6,  0.0,  0.7,  0.1)
+       << Okular::NormalizedRect(0.75, 0.0,  0.9,  0.1)
+       << Okular::NormalizedRect(0.0,  0.15, 0.1,  0.25)
+       << Okular::NormalizedRect(0.15, 0.15, 0.3,  0.25)
+       << Okular::NormalizedRect(0.6,  0.15, 1.0,  0.25);
+
+  CREATE_PAGE;
+
+  QTemporaryDir cacheDir;
+  QVERIFY(cacheDir.isValid());
+  const QString cacheFile = cacheDir.path() + QStringLiteral("/0");
+  const Okular::NormalizedRect boundingBox = page->boundingBox();
+  QVERIFY(Okular::TextPagePrivate::get(tp)->saveCorrectedText(cacheFile, page->width(), page->height(), boundingBox));
+
+  //The order depends on the layout it was corrected for
+  QVERIFY(!Okular::TextPagePrivate::loadCorrectedText(cacheFile, page->width(), page->height(), Okular::NormalizedRect(0.1, 0.1, 0.9, 0.9)));
+  QVERIFY(!Okular::TextPagePrivate::loadCorrectedText(cacheFile, page->width() * 2, page->height(), boundingBox));
+
+  Okular::TextPage *cachedTp = Okular::TextPagePrivate::loadCorrectedText(cacheFile, page->width(), page->height(), boundingBox);
+  QVERIFY(cachedTp);
+  QVERIFY(Okular::TextPagePrivate::get(cachedTp)->m_textOrderCorrected);
+  QCOMPARE(cachedTp->text(), tp->text());
+
+  Okular::Page *cachedPage = new Okular::Page(1, 100, 100, Okular::Rotation0);
+  cachedPage->setTextPage(cachedTp);
+  QCOMPARE(cachedTp->text(), tp->text());
+
+  QVERIFY(!Okular::TextPagePrivate::loadCorrectedText(cacheDir.path() + QStringLiteral("/1"), page->width(), page->height(), boundingBox));
+
+  delete cachedPage;
+  delete page;
+}
+
 QTEST_MAIN( SearchTest )
 #include "searchtest.moc"
@@ -0,0 +1,152 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include "../core/tracer_p.h"
+
+class TracedThread : public QThread
+{
+    protected:
+        void run() override
+        {
+            Okular::TraceScope trace( "image", "generator" );
+        }
+};
+
+class TracerTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void testDisabled();
+        void testChromeTraceFile();
+        void testThreadNames();
+};
+
+void TracerTest::testDisabled()
+{
+    if ( !qEnvironmentVariableIsEmpty( "OKULAR_TRACE" ) )
+        QSKIP( "Tracing is enabled by the environment" );
+
+    QVERIFY( !Okular::Tracer::isEnabled() );
+    Okular::Tracer::setEnabledByConfig( false );
+    QVERIFY( !Okular::Tracer::isEnabled() );
+}
+
+void TracerTest::testChromeTraceFile()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString fileName = dir.filePath( QStringLiteral( "trace.json" ) );
+
+    Okular::Tracer::setEnabledByConfig( true );
+    QVERIFY( Okular::Tracer::isEnabled() );
+
+    {
+        Okular::TraceScope trace( "image", "generator", 4 );
+    }
+    const qint64 queued = Okular::Tracer::now();
+    const quint64 id = Okular::Tracer::newAsyncId();
+    QVERIFY( id != 0 );
+    QVERIFY( Okular::Tracer::newAsyncId() != id );
+    const QString idString = QStringLiteral( "0x" ) + QString::number( id, 16 );
+    Okular::Tracer::async( "queued", "pixmap", id, queued, queued + 10, 2 );
+    QVERIFY( Okular::Tracer::save( fileName ) );
+
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    QJsonParseError error;
+    const QJsonDocument json = QJsonDocument::fromJson( file.readAll(), &error );
+    QCOMPARE( error.error, QJsonParseError::NoError );
+
+    int completeEvents = 0, asyncBegins = 0, asyncEnds = 0;
+    const QJsonArray events = json.object().value( QStringLiteral( "traceEvents" ) ).toArray();
+    for ( const QJsonValue &value : events )
+    {
+        const QJsonObject event = value.toObject();
+        const QString phase = event.value( QStringLiteral( "ph" ) ).toString();
+        if ( phase == QLatin1String( "X" ) && event.value( QStringLiteral( "name" ) ).toString() == QLatin1String( "image" ) )
+        {
+            ++completeEvents;
+            QCOMPARE( event.value( QStringLiteral( "cat" ) ).toString(), QStringLiteral( "generator" ) );
+            // the pages are numbered as shown to the user
+            QCOMPARE( event.value( QStringLiteral( "args" ) ).toObject().value( QStringLiteral( "page" ) ).toInt(), 5 );
+            QVERIFY( event.value( QStringLiteral( "dur" ) ).toDouble() >= 0 );
+        }
+        else if ( phase == QLatin1String( "b" ) && event.value( QStringLiteral( "name" ) ).toString() == QLatin1String( "queued" ) )
+        {
+            ++asyncBegins;
+            QCOMPARE( (qint64)event.value( QStringLiteral( "ts" ) ).toDouble(), queued );
+            QCOMPARE( event.value( QStringLiteral( "id" ) ).toString(), idString );
+        }
+        else if ( phase == QLatin1String( "e" ) && event.value( QStringLiteral( "name" ) ).toString() == QLatin1String( "queued" ) )
+        {
+            ++asyncEnds;
+            QCOMPARE( (qint64)event.value( QStringLiteral( "ts" ) ).toDouble(), queued + 10 );
+            QCOMPARE( event.value( QStringLiteral( "id" ) ).toString(), idString );
+        }
+    }
+    QCOMPARE( completeEvents, 1 );
+    QCOMPARE( asyncBegins, 1 );
+    QCOMPARE( asyncEnds, 1 );
+
+    // disabling writes the trace to the temporary directory
+    if ( qEnvironmentVariableIsEmpty( "OKULAR_TRACE" ) )
+    {
+        Okular::Tracer::setEnabledByConfig( false );
+        QVERIFY( !Okular::Tracer::isEnabled() );
+        const QString defaultFileName = QDir::temp().filePath( QStringLiteral( "okular-trace-%1.json" ).arg( QCoreApplication::applicationPid() ) );
+        QVERIFY( QFile::remove( defaultFileName ) );
+    }
+}
+
+void TracerTest::testThreadNames()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString fileName = dir.filePath( QStringLiteral( "trace.json" ) );
+    const QString threadName = QStringLiteral( "a \"quoted\" \\ name" );
+
+    Okular::Tracer::setEnabledByConfig( true );
+    TracedThread thread;
+    thread.setObjectName( threadName );
+    thread.start();
+    QVERIFY( thread.wait() );
+    QVERIFY( Okular::Tracer::save( fileName ) );
+    if ( qEnvironmentVariableIsEmpty( "OKULAR_TRACE" ) )
+    {
+        Okular::Tracer::setEnabledByConfig( false );
+        QFile::remove( QDir::temp().filePath( QStringLiteral( "okular-trace-%1.json" ).arg( QCoreApplication::applicationPid() ) ) );
+    }
+
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    QJsonParseError error;
+    const QJsonDocument json = QJsonDocument::fromJson( file.readAll(), &error );
+    QCOMPARE( error.error, QJsonParseError::NoError );
+
+    bool found = false;
+    const QJsonArray events = json.object().value( QStringLiteral( "traceEvents" ) ).toArray();
+    for ( const QJsonValue &value : events )
+    {
+        const QJsonObject event = value.toObject();
+        if ( event.value( QStringLiteral( "ph" ) ).toString() == QLatin1String( "M" ) )
+            found |= event.value( QStringLiteral( "args" ) ).toObject().value( QStringLiteral( "name" ) ).toString() == threadName;
+    }
+    QVERIFY( found );
+}
+
+QTEST_GUILESS_MAIN( TracerTest )
+#include "tracertest.moc"
@@ -0,0 +1,227 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "batchconverter.h"
+
+#include <KLocalizedString>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLinkedList>
+#include <QMimeDatabase>
+#include <QPixmap>
+#include <QTextStream>
+#include <QTimer>
+
+#include "core/document.h"
+#include "core/generator.h"
+#include "core/observer.h"
+#include "core/page.h"
+#include "core/utils.h"
+
+// The longest a page can take to render
+static const int renderTimeout = 5 * 60 * 1000;
+
+// Tells when the pixmap of its page is there
+class PageObserver : public Okular::DocumentObserver
+{
+    public:
+        PageObserver() : m_done( false ) {}
+
+        void notifyPageChanged( int, int flags ) override
+        {
+            if ( flags & Okular::DocumentObserver::Pixmap )
+                m_done = true;
+        }
+
+        bool m_done;
+};
+
+BatchConverter::BatchConverter( const Options &options )
+    : m_options( options ), m_document( new Okular::Document( nullptr ) )
+{
+    // the sizes of the pages are given at the resolution the document
+    // tells the generators when it has no widget
+    m_scale = m_options.dpi / Okular::Utils::realDpi( nullptr ).width();
+
+    QObject::connect( m_document, &Okular::Document::error, m_document, []( const QString &text, int ) {
+        qCritical().noquote() << text;
+    } );
+    QObject::connect( m_document, &Okular::Document::warning, m_document, []( const QString &text, int ) {
+        qWarning().noquote() << text;
+    } );
+}
+
+BatchConverter::~BatchConverter()
+{
+    delete m_document;
+}
+
+bool BatchConverter::convert( const QString &fileName )
+{
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile( fileName );
+    // no url, so that the docdata/ and the caches of the user are left alone
+    if ( m_document->openDocument( QFileInfo( fileName ).absoluteFilePath(), QUrl(), mime ) != Okular::Document::OpenSuccess )
+    {
+        qCritical().noquote() << i18n( "Could not open %1", fileName );
+        return false;
+    }
+
+    QVector< int > pages;
+    if ( !parsePageRange( m_options.pages, m_document->pages(), &pages ) )
+    {
+        qCritical().noquote() << i18n( "The page range %1 is not valid for %2, which has %3 pages", m_options.pages, fileName, m_document->pages() );
+        m_document->closeDocument();
+        return false;
+    }
+
+    bool ok = true;
+    const QString baseName = QDir( m_options.outputDir ).filePath( QFileInfo( fileName ).completeBaseName() );
+
+    // the text is written as it is extracted, page after page
+    QFile textFile;
+    QTextStream textStream;
+    if ( m_options.text )
+    {
+        if ( !m_document->supportsSearching() )
+        {
+            qWarning().noquote() << i18n( "%1 has no text", fileName );
+        }
+        else
+        {
+            textFile.setFileName( baseName + QStringLiteral( ".txt" ) );
+            if ( textFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+            {
+                textStream.setDevice( &textFile );
+                textStream.setCodec( "UTF-8" );
+            }
+            else
+            {
+                qCritical().noquote() << i18n( "Could not write %1", textFile.fileName() );
+                ok = false;
+            }
+        }
+    }
+
+    const int digits = QString::number( m_document->pages() ).length();
+    for ( int number : qAsConst( pages ) )
+    {
+        if ( m_options.images )
+        {
+            const QString imageFileName = QStringLiteral( "%1-%2.%3" ).arg( baseName ).arg( number + 1, digits, 10, QLatin1Char( '0' ) ).arg( QString::fromLatin1( m_options.imageFormat ) );
+            ok = renderPage( number, imageFileName ) && ok;
+        }
+
+        if ( textFile.isOpen() )
+        {
+            // the document keeps only the last text pages, as it does in
+            // the viewer
+            const Okular::Page *page = m_document->page( number );
+            if ( !page->hasTextPage() )
+                m_document->requestTextPage( number );
+
+            // the pages are separated by form feeds, like pdftotext does
+            if ( number != pages.first() )
+                textStream << '\f';
+            textStream << page->text();
+        }
+    }
+
+    if ( textFile.isOpen() )
+    {
+        textStream.flush();
+        if ( textFile.error() != QFileDevice::NoError )
+        {
+            qCritical().noquote() << i18n( "Could not write %1", textFile.fileName() );
+            ok = false;
+        }
+        textFile.close();
+    }
+
+    m_document->closeDocument();
+    return ok;
+}
+
+bool BatchConverter::renderPage( int number, const QString &fileName )
+{
+    const Okular::Page *page = m_document->page( number );
+    const int width = qMax( 1, qRound( page->width() * m_scale ) );
+    const int height = qMax( 1, qRound( page->height() * m_scale ) );
+
+    // an observer of its own for each page, removing it frees the pixmap
+    PageObserver observer;
+    m_document->addObserver( &observer );
+
+    QLinkedList< Okular::PixmapRequest * > requests;
+    requests << new Okular::PixmapRequest( &observer, number, width, height, 1, Okular::PixmapRequest::NoTiles );
+    m_document->requestPixmaps( requests );
+
+    // synchronous requests are done at once, unless the generator is busy;
+    // a request the document dropped is never done, don't wait for it
+    QTimer timeout;
+    timeout.setSingleShot( true );
+    timeout.start( renderTimeout );
+    while ( !observer.m_done && timeout.isActive() && m_document->hasPixmapRequests( &observer ) )
+        QCoreApplication::processEvents( QEventLoop::WaitForMoreEvents );
+
+    bool ok = false;
+    const QPixmap *pixmap = page->pixmap( &observer );
+    if ( !pixmap )
+        qCritical().noquote() << i18n( "Could not render page %1", number + 1 );
+    else if ( !pixmap->save( fileName, m_options.imageFormat.constData() ) )
+        qCritical().noquote() << i18n( "Could not write %1", fileName );
+    else
+        ok = true;
+
+    m_document->removeObserver( &observer );
+    return ok;
+}
+
+bool BatchConverter::parsePageRange( const QString &range, int pageCount, QVector< int > *pages )
+{
+    pages->clear();
+    if ( range.trimmed().isEmpty() )
+    {
+        for ( int number = 0; number < pageCount; ++number )
+            pages->append( number );
+        return true;
+    }
+
+    const QStringList parts = range.split( QLatin1Char( ',' ) );
+    for ( const QString &part : parts )
+    {
+        bool firstOk = true, lastOk = true;
+        int first, last;
+        const int dash = part.indexOf( QLatin1Char( '-' ) );
+        if ( dash < 0 )
+        {
+            first = last = part.trimmed().toInt( &firstOk );
+        }
+        else
+        {
+            // "-3" and "5-" go from the first page and to the last one
+            const QString from = part.left( dash ).trimmed();
+            const QString to = part.mid( dash + 1 ).trimmed();
+            first = from.isEmpty() ? 1 : from.toInt( &firstOk );
+            last = to.isEmpty() ? pageCount : to.toInt( &lastOk );
+        }
+
+        if ( !firstOk || !lastOk || first < 1 || last > pageCount || first > last )
+            return false;
+
+        for ( int number = first; number <= last; ++number )
+            pages->append( number - 1 );
+    }
+    return true;
+}
+
+/* kate: replace-tabs on; indent-width 4; */
@@ -0,0 +1,71 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULARBATCH_BATCHCONVERTER_H_
+#define _OKULARBATCH_BATCHCONVERTER_H_
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+namespace Okular
+{
+class Document;
+}
+
+/**
+ * Renders the pages of documents to image files, and writes their text to
+ * text files, one document after the other.
+ *
+ * The pages are processed one at a time, and their pixmap is freed as soon
+ * as it is written, so that the memory used does not grow with the size of
+ * the document.
+ */
+class BatchConverter
+{
+    public:
+        struct Options
+        {
+            QString outputDir;
+            // e.g. "1-3,5,8-", all the pages if empty
+            QString pages;
+            double dpi;
+            QByteArray imageFormat;
+            bool images;
+            bool text;
+        };
+
+        explicit BatchConverter( const Options &options );
+        ~BatchConverter();
+
+        /**
+         * Converts the document @p fileName, the output files are named
+         * after it. Returns false if the document could not be opened, or if
+         * any of the output files could not be written.
+         */
+        bool convert( const QString &fileName );
+
+        /**
+         * Fills @p pages with the (zero based) numbers of the pages of the
+         * 1-based @p range of a document of @p pageCount pages.
+         * Returns false if the range is not valid.
+         */
+        static bool parsePageRange( const QString &range, int pageCount, QVector< int > *pages );
+
+    private:
+        bool renderPage( int number, const QString &fileName );
+
+        Options m_options;
+        Okular::Document *m_document;
+        double m_scale;
+};
+
+#endif
+
+/* kate: replace-tabs on; indent-width 4; */
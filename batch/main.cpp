@@ -0,0 +1,132 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <KLocalizedString>
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QImageWriter>
+#include <QThread>
+
+#include "batchconverter.h"
+#include "workerpool.h"
+#include "core/version.h"
+#include "settings_core.h"
+
+int main(int argc, char** argv)
+{
+    // nothing is shown, the pages are rendered in memory
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    KLocalizedString::setApplicationDomain("okular");
+    app.setApplicationName(QStringLiteral("okularbatch"));
+    app.setApplicationVersion(QStringLiteral(OKULAR_VERSION_STRING));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(i18n("Renders the pages of documents to images, and extracts their text"));
+    parser.addVersionOption();
+    parser.addHelpOption();
+
+    const QCommandLineOption outputDirOption(QStringList() << QStringLiteral("o") << QStringLiteral("output-dir"), i18n("Directory where the images and the text are written, the current one by default"), QStringLiteral("directory"), QStringLiteral("."));
+    const QCommandLineOption pagesOption(QStringList() << QStringLiteral("p") << QStringLiteral("pages"), i18n("Pages to convert, e.g. 1-3,5,8-; all of them by default"), QStringLiteral("range"));
+    const QCommandLineOption dpiOption(QStringList() << QStringLiteral("r") << QStringLiteral("dpi"), i18n("Resolution of the images, in dots per inch"), QStringLiteral("dpi"), QStringLiteral("150"));
+    const QCommandLineOption formatOption(QStringList() << QStringLiteral("f") << QStringLiteral("format"), i18n("Format of the images, e.g. png or jpg"), QStringLiteral("format"), QStringLiteral("png"));
+    const QCommandLineOption textOption(QStringList() << QStringLiteral("t") << QStringLiteral("text"), i18n("Write the text of the documents to text files"));
+    const QCommandLineOption noImagesOption(QStringList() << QStringLiteral("no-images"), i18n("Do not render the pages to images"));
+    const QCommandLineOption jobsOption(QStringList() << QStringLiteral("j") << QStringLiteral("jobs"), i18n("How many documents are converted at the same time"), QStringLiteral("count"), QString::number(QThread::idealThreadCount()));
+    parser.addOption(outputDirOption);
+    parser.addOption(pagesOption);
+    parser.addOption(dpiOption);
+    parser.addOption(formatOption);
+    parser.addOption(textOption);
+    parser.addOption(noImagesOption);
+    parser.addOption(jobsOption);
+    parser.addPositionalArgument(QStringLiteral("files"), i18n("Documents to convert. The output files are named after them."));
+
+    parser.process(app);
+
+    const QStringList fileNames = parser.positionalArguments();
+    if (fileNames.isEmpty())
+        parser.showHelp(1);
+
+    BatchConverter::Options options;
+    options.outputDir = parser.value(outputDirOption);
+    options.pages = parser.value(pagesOption);
+    options.imageFormat = parser.value(formatOption).toLatin1();
+    options.images = !parser.isSet(noImagesOption);
+    options.text = parser.isSet(textOption);
+
+    bool ok = false;
+    options.dpi = parser.value(dpiOption).toDouble(&ok);
+    if (!ok || options.dpi <= 0)
+    {
+        qCritical().noquote() << i18n("The resolution %1 is not valid", parser.value(dpiOption));
+        return 1;
+    }
+    const int jobs = parser.value(jobsOption).toInt(&ok);
+    if (!ok || jobs < 1)
+    {
+        qCritical().noquote() << i18n("The number of jobs %1 is not valid", parser.value(jobsOption));
+        return 1;
+    }
+    if (options.images && !QImageWriter::supportedImageFormats().contains(options.imageFormat))
+    {
+        qCritical().noquote() << i18n("The image format %1 is not supported", parser.value(formatOption));
+        return 1;
+    }
+    if (!options.images && !options.text)
+    {
+        qCritical().noquote() << i18n("There is nothing to do without images nor text");
+        return 1;
+    }
+    if (!QDir().mkpath(options.outputDir))
+    {
+        qCritical().noquote() << i18n("Could not create the directory %1", options.outputDir);
+        return 1;
+    }
+
+    if (jobs > 1 && fileNames.count() > 1)
+    {
+        // the workers convert one document each, with the same options
+        QStringList arguments;
+        arguments << QStringLiteral("--jobs") << QStringLiteral("1")
+                  << QStringLiteral("--output-dir") << options.outputDir
+                  << QStringLiteral("--dpi") << parser.value(dpiOption)
+                  << QStringLiteral("--format") << parser.value(formatOption);
+        if (parser.isSet(pagesOption))
+            arguments << QStringLiteral("--pages") << options.pages;
+        if (options.text)
+            arguments << QStringLiteral("--text");
+        if (!options.images)
+            arguments << QStringLiteral("--no-images");
+
+        WorkerPool pool(arguments, jobs);
+        return pool.run(fileNames) == 0 ? 0 : 1;
+    }
+
+    Okular::SettingsCore::instance(QStringLiteral("okularbatchrc"));
+    // the pages are converted one at a time, there is no use in keeping the
+    // ones already done
+    Okular::SettingsCore::setMemoryLevel(Okular::SettingsCore::EnumMemoryLevel::Low);
+
+    int failures = 0;
+    BatchConverter converter(options);
+    for (const QString &fileName : fileNames)
+    {
+        if (!converter.convert(fileName))
+            ++failures;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+/* kate: replace-tabs on; indent-width 4; */
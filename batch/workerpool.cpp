@@ -0,0 +1,80 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "workerpool.h"
+
+#include <KLocalizedString>
+#include <QCoreApplication>
+#include <QDebug>
+
+WorkerPool::WorkerPool( const QStringList &arguments, int maxWorkers, QObject *parent )
+    : QObject( parent ), m_arguments( arguments ), m_maxWorkers( maxWorkers ), m_runningWorkers( 0 ), m_failures( 0 )
+{
+}
+
+int WorkerPool::run( const QStringList &fileNames )
+{
+    m_pendingFiles = fileNames;
+    m_failures = 0;
+
+    startWorkers();
+    if ( m_runningWorkers > 0 )
+        m_loop.exec();
+
+    return m_failures;
+}
+
+void WorkerPool::startWorkers()
+{
+    while ( m_runningWorkers < m_maxWorkers && !m_pendingFiles.isEmpty() )
+    {
+        const QString fileName = m_pendingFiles.takeFirst();
+
+        QProcess *worker = new QProcess( this );
+        // the messages of the workers go straight to ours
+        worker->setProcessChannelMode( QProcess::ForwardedChannels );
+        connect( worker, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>( &QProcess::finished ), this, [this, worker]( int exitCode, QProcess::ExitStatus exitStatus ) {
+            workerFinished( worker, exitCode, exitStatus );
+        } );
+        connect( worker, &QProcess::errorOccurred, this, [this, worker, fileName]( QProcess::ProcessError error ) {
+            // the other errors are followed by finished()
+            if ( error == QProcess::FailedToStart )
+            {
+                qCritical().noquote() << i18n( "Could not start the conversion of %1", fileName );
+                workerFinished( worker, -1, QProcess::NormalExit );
+            }
+        } );
+
+        // a file name starting with a dash is not an option
+        ++m_runningWorkers;
+        worker->start( QCoreApplication::applicationFilePath(), QStringList( m_arguments ) << QStringLiteral( "--" ) << fileName );
+    }
+}
+
+void WorkerPool::workerFinished( QProcess *worker, int exitCode, QProcess::ExitStatus exitStatus )
+{
+    if ( exitStatus != QProcess::NormalExit )
+    {
+        qCritical().noquote() << i18n( "The conversion of %1 crashed", worker->arguments().last() );
+        ++m_failures;
+    }
+    else if ( exitCode != 0 )
+    {
+        ++m_failures;
+    }
+
+    worker->deleteLater();
+    --m_runningWorkers;
+
+    startWorkers();
+    if ( m_runningWorkers == 0 )
+        m_loop.quit();
+}
+
+/* kate: replace-tabs on; indent-width 4; */
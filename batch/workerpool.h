@@ -0,0 +1,57 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULARBATCH_WORKERPOOL_H_
+#define _OKULARBATCH_WORKERPOOL_H_
+
+#include <QtCore/QEventLoop>
+#include <QtCore/QObject>
+#include <QtCore/QProcess>
+#include <QtCore/QStringList>
+
+/**
+ * Converts many documents in parallel, each one in a worker process of its
+ * own, at most a given number of them at the same time.
+ *
+ * The documents are not converted in threads of this process, as neither
+ * the documents nor all the generators can be used from several threads;
+ * a crash of a generator on a broken document only fails that document too.
+ */
+class WorkerPool : public QObject
+{
+    Q_OBJECT
+
+    public:
+        /**
+         * The workers are this same program, started with @p arguments
+         * followed by the name of the document to convert.
+         */
+        WorkerPool( const QStringList &arguments, int maxWorkers, QObject *parent = nullptr );
+
+        /**
+         * Converts the documents @p fileNames, and returns how many of them
+         * failed.
+         */
+        int run( const QStringList &fileNames );
+
+    private:
+        void startWorkers();
+        void workerFinished( QProcess *worker, int exitCode, QProcess::ExitStatus exitStatus );
+
+        QStringList m_arguments;
+        int m_maxWorkers;
+        QStringList m_pendingFiles;
+        int m_runningWorkers;
+        int m_failures;
+        QEventLoop m_loop;
+};
+
+#endif
+
+/* kate: replace-tabs on; indent-width 4; */
@@ -0,0 +1,437 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QMimeDatabase>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QTemporaryDir>
+
+#include "../core/area.h"
+#include "../core/document.h"
+#include "../core/generator.h"
+#include "../core/observer.h"
+#include "../core/page.h"
+#include "../settings_core.h"
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+Q_DECLARE_METATYPE(Okular::Document::SearchStatus)
+
+// The size of the generated documents
+static const int pageCount = 200;
+static const int linesPerPage = 50;
+static const int wordsPerLine = 12;
+
+// About the size of a page on screen
+static const int pixmapWidth = 600;
+static const int pixmapHeight = 800;
+
+// How many pages are rendered by benchmarkRenderThroughput
+static const int renderedPageCount = 50;
+
+// On the last line of every tenth page
+static const char searchedWord[] = "okularneedle";
+
+// Counts the pixmaps the document has rendered for it
+class PixmapCountingObserver : public Okular::DocumentObserver
+{
+    public:
+        PixmapCountingObserver() : m_pixmaps( 0 ) {}
+
+        void notifyPageChanged( int, int flags ) override
+        {
+            if ( flags & Okular::DocumentObserver::Pixmap )
+                ++m_pixmaps;
+        }
+
+        int m_pixmaps;
+};
+
+class DocumentBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void benchmarkOpen_data();
+        void benchmarkOpen();
+        void benchmarkFirstPaint_data();
+        void benchmarkFirstPaint();
+        void benchmarkRenderThroughput_data();
+        void benchmarkRenderThroughput();
+        void benchmarkTiledZoom_data();
+        void benchmarkTiledZoom();
+        void benchmarkTextPageBuild_data();
+        void benchmarkTextPageBuild();
+        void benchmarkSearch_data();
+        void benchmarkSearch();
+        void benchmarkMemoryPerPage_data();
+        void benchmarkMemoryPerPage();
+
+    private:
+        void addDocumentRows();
+
+        static QString lineText( int page, int line );
+        static void writePdf( const QString &fileName );
+        static void writeText( const QString &fileName );
+        static void writeImage( const QString &fileName );
+
+        static bool openDocument( Okular::Document *document, const QString &fileName );
+        static void requestPixmaps( Okular::Document *document, PixmapCountingObserver *observer, int pages );
+        static bool waitForPixmaps( PixmapCountingObserver *observer, int pixmaps );
+
+        QTemporaryDir m_dir;
+};
+
+void DocumentBenchmark::initTestCase()
+{
+    // don't clutter the docdata/ of the user
+    QStandardPaths::setTestModeEnabled( true );
+    qRegisterMetaType<Okular::Document::SearchStatus>();
+    Okular::SettingsCore::instance( QStringLiteral("documentbenchmark") );
+    // the text pages are built, not read from the cache of a previous run
+    QDir( QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation ) + QStringLiteral("/okular") ).removeRecursively();
+
+    QVERIFY( m_dir.isValid() );
+    writePdf( m_dir.filePath( QStringLiteral("document.pdf") ) );
+    writeText( m_dir.filePath( QStringLiteral("document.txt") ) );
+    writeImage( m_dir.filePath( QStringLiteral("document.png") ) );
+}
+
+void DocumentBenchmark::addDocumentRows()
+{
+    QTest::addColumn<QString>( "fileName" );
+
+    QTest::newRow( "pdf" ) << m_dir.filePath( QStringLiteral("document.pdf") );
+    QTest::newRow( "txt" ) << m_dir.filePath( QStringLiteral("document.txt") );
+    QTest::newRow( "png" ) << m_dir.filePath( QStringLiteral("document.png") );
+}
+
+// Words from a small vocabulary, so that the lines are not all the same
+QString DocumentBenchmark::lineText( int page, int line )
+{
+    static const char * const words[] = {
+        "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit",
+        "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "et", "dolore"
+    };
+    static const int wordCount = sizeof( words ) / sizeof( words[0] );
+
+    QStringList lineWords;
+    for ( int word = 0; word < wordsPerLine; ++word )
+        lineWords << QLatin1String( words[ ( page * 31 + line * 7 + word * 3 ) % wordCount ] );
+    if ( page % 10 == 0 && line == linesPerPage - 1 )
+        lineWords.last() = QLatin1String( searchedWord );
+    return lineWords.join( QLatin1Char( ' ' ) );
+}
+
+void DocumentBenchmark::writePdf( const QString &fileName )
+{
+    QPdfWriter writer( fileName );
+    writer.setPageSize( QPageSize( QPageSize::A4 ) );
+    writer.setResolution( 72 );
+
+    QPainter painter( &writer );
+    painter.setFont( QFont( QStringLiteral("Serif"), 9 ) );
+    const qreal lineHeight = painter.viewport().height() / ( linesPerPage + 1.0 );
+    for ( int page = 0; page < pageCount; ++page )
+    {
+        if ( page > 0 )
+            writer.newPage();
+        for ( int line = 0; line < linesPerPage; ++line )
+            painter.drawText( QPointF( 0, ( line + 1 ) * lineHeight ), lineText( page, line ) );
+    }
+}
+
+void DocumentBenchmark::writeText( const QString &fileName )
+{
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QTextStream stream( &file );
+    for ( int page = 0; page < pageCount; ++page )
+        for ( int line = 0; line < linesPerPage; ++line )
+            stream << lineText( page, line ) << '\n';
+}
+
+// One big page, like a scan or a photo
+void DocumentBenchmark::writeImage( const QString &fileName )
+{
+    QImage image( 4960, 7016, QImage::Format_RGB32 );
+    image.fill( Qt::white );
+
+    QPainter painter( &image );
+    painter.setFont( QFont( QStringLiteral("Serif"), 48 ) );
+    const qreal lineHeight = image.height() / ( linesPerPage + 1.0 );
+    for ( int line = 0; line < linesPerPage; ++line )
+        painter.drawText( QPointF( 200, ( line + 1 ) * lineHeight ), lineText( 0, line ) );
+    painter.end();
+
+    QVERIFY( image.save( fileName ) );
+}
+
+bool DocumentBenchmark::openDocument( Okular::Document *document, const QString &fileName )
+{
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile( fileName );
+    return document->openDocument( fileName, QUrl(), mime ) == Okular::Document::OpenSuccess;
+}
+
+void DocumentBenchmark::requestPixmaps( Okular::Document *document, PixmapCountingObserver *observer, int pages )
+{
+    QLinkedList<Okular::PixmapRequest *> requests;
+    for ( int page = 0; page < pages; ++page )
+        requests << new Okular::PixmapRequest( observer, page, pixmapWidth, pixmapHeight, 1, Okular::PixmapRequest::Asynchronous );
+    document->requestPixmaps( requests );
+}
+
+// Spins the event loop until the observer has got the given number of
+// pixmaps, without the polling delay of QTRY_VERIFY
+bool DocumentBenchmark::waitForPixmaps( PixmapCountingObserver *observer, int pixmaps )
+{
+    QTimer timeout;
+    timeout.setSingleShot( true );
+    timeout.start( 60000 );
+    while ( observer->m_pixmaps < pixmaps && timeout.isActive() )
+        QCoreApplication::processEvents( QEventLoop::WaitForMoreEvents );
+    return observer->m_pixmaps >= pixmaps;
+}
+
+void DocumentBenchmark::benchmarkOpen_data()
+{
+    addDocumentRows();
+}
+
+void DocumentBenchmark::benchmarkOpen()
+{
+    QFETCH( QString, fileName );
+
+    Okular::Document document( nullptr );
+    if ( !openDocument( &document, fileName ) )
+        QSKIP( "No generator for this document type" );
+    document.closeDocument();
+
+    QBENCHMARK {
+        openDocument( &document, fileName );
+        document.closeDocument();
+    }
+}
+
+void DocumentBenchmark::benchmarkFirstPaint_data()
+{
+    addDocumentRows();
+}
+
+// From opening the document to having the pixmap of its first page, as the
+// page view asks for it
+void DocumentBenchmark::benchmarkFirstPaint()
+{
+    QFETCH( QString, fileName );
+
+    Okular::Document document( nullptr );
+    PixmapCountingObserver observer;
+    document.addObserver( &observer );
+    if ( !openDocument( &document, fileName ) )
+        QSKIP( "No generator for this document type" );
+    document.closeDocument();
+
+    QBENCHMARK {
+        observer.m_pixmaps = 0;
+        openDocument( &document, fileName );
+        requestPixmaps( &document, &observer, 1 );
+        QVERIFY( waitForPixmaps( &observer, 1 ) );
+        document.closeDocument();
+    }
+
+    document.removeObserver( &observer );
+}
+
+void DocumentBenchmark::benchmarkRenderThroughput_data()
+{
+    addDocumentRows();
+}
+
+void DocumentBenchmark::benchmarkRenderThroughput()
+{
+    QFETCH( QString, fileName );
+
+    Okular::Document document( nullptr );
+    PixmapCountingObserver observer;
+    document.addObserver( &observer );
+    if ( !openDocument( &document, fileName ) )
+        QSKIP( "No generator for this document type" );
+    const int pages = qMin( (int)document.pages(), renderedPageCount );
+
+    QBENCHMARK {
+        observer.m_pixmaps = 0;
+        requestPixmaps( &document, &observer, pages );
+        QVERIFY( waitForPixmaps( &observer, pages ) );
+
+        // drop the pixmaps, so that the next round renders them again
+        document.removeObserver( &observer );
+        document.addObserver( &observer );
+    }
+
+    document.removeObserver( &observer );
+    document.closeDocument();
+}
+
+void DocumentBenchmark::benchmarkTiledZoom_data()
+{
+    QTest::addColumn<QString>( "fileName" );
+    QTest::addColumn<int>( "zoom" );
+
+    // only the pdf generator renders in tiles, and only past 8 megapixels
+    QTest::newRow( "pdf 600%" ) << m_dir.filePath( QStringLiteral("document.pdf") ) << 6;
+    QTest::newRow( "pdf 1200%" ) << m_dir.filePath( QStringLiteral("document.pdf") ) << 12;
+}
+
+// The visible region of a page zoomed in, as the page view asks for it,
+// rendered in tiles by the TilesManager
+void DocumentBenchmark::benchmarkTiledZoom()
+{
+    QFETCH( QString, fileName );
+    QFETCH( int, zoom );
+
+    Okular::Document document( nullptr );
+    PixmapCountingObserver observer;
+    document.addObserver( &observer );
+    if ( !openDocument( &document, fileName ) )
+        QSKIP( "No generator for this document type" );
+
+    // the top left corner of the page, the size of the screen
+    const Okular::NormalizedRect visibleRect( 0, 0, 1.0 / zoom, 1.0 / zoom );
+
+    QBENCHMARK {
+        observer.m_pixmaps = 0;
+        Okular::PixmapRequest *request = new Okular::PixmapRequest( &observer, 0, pixmapWidth * zoom, pixmapHeight * zoom, 1, Okular::PixmapRequest::Asynchronous );
+        request->setNormalizedRect( visibleRect );
+        document.requestPixmaps( QLinkedList<Okular::PixmapRequest *>() << request );
+        QVERIFY( waitForPixmaps( &observer, 1 ) );
+        QVERIFY( document.page( 0 )->hasTilesManager( &observer ) );
+
+        // drop the tiles, so that the next round renders them again
+        document.removeObserver( &observer );
+        document.addObserver( &observer );
+    }
+
+    document.removeObserver( &observer );
+    document.closeDocument();
+}
+
+void DocumentBenchmark::benchmarkTextPageBuild_data()
+{
+    addDocumentRows();
+}
+
+void DocumentBenchmark::benchmarkTextPageBuild()
+{
+    QFETCH( QString, fileName );
+
+    Okular::Document document( nullptr );
+    if ( !openDocument( &document, fileName ) )
+        QSKIP( "No generator for this document type" );
+    if ( !document.supportsSearching() )
+        QSKIP( "The document has no text" );
+
+    // the text page of a page is built again on each request
+    QBENCHMARK {
+        for ( uint page = 0; page < document.pages(); ++page )
+            document.requestTextPage( page );
+    }
+
+    document.closeDocument();
+}
+
+void DocumentBenchmark::benchmarkSearch_data()
+{
+    addDocumentRows();
+}
+
+void DocumentBenchmark::benchmarkSearch()
+{
+    QFETCH( QString, fileName );
+
+    Okular::Document document( nullptr );
+    if ( !openDocument( &document, fileName ) )
+        QSKIP( "No generator for this document type" );
+    if ( !document.supportsSearching() )
+        QSKIP( "The document has no text" );
+
+    // measure the search alone, not the building of the text pages
+    for ( uint page = 0; page < document.pages(); ++page )
+        document.requestTextPage( page );
+
+    QSignalSpy spy( &document, SIGNAL(searchFinished(int,Okular::Document::SearchStatus)) );
+    const int searchId = 0;
+    QBENCHMARK {
+        spy.clear();
+        document.searchText( searchId, QLatin1String( searchedWord ), true, Qt::CaseInsensitive, Okular::Document::AllDocument, false, QColor() );
+        QVERIFY( spy.count() == 1 || spy.wait() );
+    }
+    QCOMPARE( spy.first().at( 1 ).value<Okular::Document::SearchStatus>(), Okular::Document::MatchFound );
+
+    document.closeDocument();
+}
+
+#if defined(Q_OS_LINUX)
+static qulonglong residentMemory()
+{
+    // the second field of statm is the resident set size, in pages
+    QFile file( QStringLiteral("/proc/self/statm") );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return 0;
+    const QList<QByteArray> fields = file.readAll().split( ' ' );
+    return fields.count() > 1 ? fields.at( 1 ).toULongLong() * sysconf( _SC_PAGESIZE ) : 0;
+}
+#endif
+
+void DocumentBenchmark::benchmarkMemoryPerPage_data()
+{
+    addDocumentRows();
+}
+
+// How much the resident memory grows per page once every page has been
+// rendered and, if possible, has its text page; the pixmaps that the memory
+// manager frees in the meantime are not counted
+void DocumentBenchmark::benchmarkMemoryPerPage()
+{
+#if defined(Q_OS_LINUX)
+    QFETCH( QString, fileName );
+
+    Okular::Document document( nullptr );
+    PixmapCountingObserver observer;
+    document.addObserver( &observer );
+    if ( !openDocument( &document, fileName ) )
+        QSKIP( "No generator for this document type" );
+
+    const qulonglong before = residentMemory();
+    const int pages = document.pages();
+    requestPixmaps( &document, &observer, pages );
+    QVERIFY( waitForPixmaps( &observer, pages ) );
+    if ( document.supportsSearching() )
+    {
+        for ( int page = 0; page < pages; ++page )
+            document.requestTextPage( page );
+    }
+    const qulonglong after = residentMemory();
+
+    QTest::setBenchmarkResult( after > before ? ( after - before ) / pages : 0, QTest::BytesAllocated );
+
+    document.removeObserver( &observer );
+    document.closeDocument();
+#else
+    QSKIP( "The resident memory is only known on Linux" );
+#endif
+}
+
+QTEST_MAIN( DocumentBenchmark )
+#include "documentbenchmark.moc"
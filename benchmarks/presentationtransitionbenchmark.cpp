@@ -0,0 +1,127 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QPainter>
+
+#include "../core/pagetransition.h"
+#include "../ui/presentationtransition.h"
+
+Q_DECLARE_METATYPE(Okular::PageTransition)
+
+// a 4K projector, showing 4:3 slides
+static const QSize screenSize( 3840, 2160 );
+static const QRect slideArea( 480, 0, 2880, 2160 );
+static const int frameInterval = 16;
+
+class PresentationTransitionBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void benchmarkTransition_data();
+        void benchmarkTransition();
+
+    private:
+        static Okular::PageTransition transition( Okular::PageTransition::Type type, Okular::PageTransition::Alignment alignment, Okular::PageTransition::Direction direction, int angle );
+
+        QPixmap m_previousPage;
+        QPixmap m_currentPage;
+};
+
+void PresentationTransitionBenchmark::initTestCase()
+{
+    m_previousPage = QPixmap( screenSize );
+    m_previousPage.fill( Qt::black );
+    QPainter( &m_previousPage ).fillRect( slideArea, Qt::white );
+
+    m_currentPage = QPixmap( screenSize );
+    m_currentPage.fill( Qt::black );
+    QPainter( &m_currentPage ).fillRect( slideArea, Qt::darkBlue );
+}
+
+Okular::PageTransition PresentationTransitionBenchmark::transition( Okular::PageTransition::Type type, Okular::PageTransition::Alignment alignment, Okular::PageTransition::Direction direction, int angle )
+{
+    Okular::PageTransition t( type );
+    t.setAlignment( alignment );
+    t.setDirection( direction );
+    t.setAngle( angle );
+    return t;
+}
+
+void PresentationTransitionBenchmark::benchmarkTransition_data()
+{
+    QTest::addColumn<Okular::PageTransition>("transition");
+
+    QTest::newRow("split horizontal in") << transition( Okular::PageTransition::Split, Okular::PageTransition::Horizontal, Okular::PageTransition::Inward, 0 );
+    QTest::newRow("split vertical out") << transition( Okular::PageTransition::Split, Okular::PageTransition::Vertical, Okular::PageTransition::Outward, 0 );
+    QTest::newRow("blinds horizontal") << transition( Okular::PageTransition::Blinds, Okular::PageTransition::Horizontal, Okular::PageTransition::Inward, 0 );
+    QTest::newRow("blinds vertical") << transition( Okular::PageTransition::Blinds, Okular::PageTransition::Vertical, Okular::PageTransition::Inward, 0 );
+    QTest::newRow("box in") << transition( Okular::PageTransition::Box, Okular::PageTransition::Horizontal, Okular::PageTransition::Inward, 0 );
+    QTest::newRow("box out") << transition( Okular::PageTransition::Box, Okular::PageTransition::Horizontal, Okular::PageTransition::Outward, 0 );
+    QTest::newRow("wipe right") << transition( Okular::PageTransition::Wipe, Okular::PageTransition::Horizontal, Okular::PageTransition::Inward, 0 );
+    QTest::newRow("wipe down") << transition( Okular::PageTransition::Wipe, Okular::PageTransition::Horizontal, Okular::PageTransition::Inward, 270 );
+    QTest::newRow("dissolve") << transition( Okular::PageTransition::Dissolve, Okular::PageTransition::Horizontal, Okular::PageTransition::Inward, 0 );
+    QTest::newRow("glitter right") << transition( Okular::PageTransition::Glitter, Okular::PageTransition::Horizontal, Okular::PageTransition::Inward, 0 );
+    QTest::newRow("fade") << transition( Okular::PageTransition::Fade, Okular::PageTransition::Horizontal, Okular::PageTransition::Inward, 0 );
+}
+
+void PresentationTransitionBenchmark::benchmarkTransition()
+{
+    QFETCH(Okular::PageTransition, transition);
+
+    QPixmap screen( screenSize );
+    PresentationTransition engine;
+    QVector<qint64> frameTimes;
+    QRegion painted;
+
+    QBENCHMARK {
+        frameTimes.clear();
+        painted = QRegion();
+        QPainter( &screen ).drawPixmap( 0, 0, m_previousPage );
+
+        QVERIFY( engine.start( transition, m_previousPage, m_currentPage, screenSize, slideArea ) );
+
+        // frames at a steady pace, painted the way PresentationWidget does
+        for ( int elapsed = 0; engine.isRunning(); elapsed += frameInterval )
+        {
+            QElapsedTimer frameTime;
+            frameTime.start();
+
+            const QRegion damage = engine.advance( elapsed );
+            const QPixmap &source = engine.hasBlendedPixmap() ? engine.blendedPixmap() : m_currentPage;
+            QPainter painter( &screen );
+            for ( const QRect &r : damage.rects() )
+                painter.drawPixmap( r.topLeft(), source, r );
+            painter.end();
+            painted += damage;
+
+            frameTimes << frameTime.nsecsElapsed();
+        }
+    }
+
+    // the whole slide, and only the slide, has been repainted
+    QCOMPARE( painted, QRegion( slideArea ) );
+    QCOMPARE( screen.toImage(), m_currentPage.toImage() );
+
+    qint64 total = 0, worst = 0;
+    for ( qint64 t : qAsConst( frameTimes ) )
+    {
+        total += t;
+        worst = qMax( worst, t );
+    }
+    qInfo( "%s: %d frames in %d ms, frame time %.2f ms average, %.2f ms worst",
+           QTest::currentDataTag(), frameTimes.count(), qRound( transition.duration() * 1000 ),
+           total / 1000000.0 / frameTimes.count(), worst / 1000000.0 );
+}
+
+QTEST_MAIN( PresentationTransitionBenchmark )
+#include "presentationtransitionbenchmark.moc"
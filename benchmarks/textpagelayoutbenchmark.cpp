@@ -0,0 +1,137 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include "../core/area.h"
+#include "../core/page.h"
+#include "../core/textpage.h"
+#include "../settings_core.h"
+
+static const int charactersPerWord = 5;
+
+class TextPageLayoutBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void testReadingOrder();
+        void benchmarkCorrectTextOrder_data();
+        void benchmarkCorrectTextOrder();
+
+    private:
+        static Okular::TextPage *createTextPage( int columns, int lines, int wordsPerLine );
+        static void appendWord( Okular::TextPage *tp, const QString &word, double left, double top, double charWidth, double height );
+};
+
+void TextPageLayoutBenchmark::initTestCase()
+{
+    Okular::SettingsCore::instance( QStringLiteral("textpagelayoutbenchmark") );
+}
+
+// One glyph per character, like the PDF generator gives, laid out in columns
+Okular::TextPage *TextPageLayoutBenchmark::createTextPage( int columns, int lines, int wordsPerLine )
+{
+    Okular::TextPage *tp = new Okular::TextPage();
+
+    const double columnWidth = 1.0 / columns;
+    const double gutter = columnWidth * 0.1;
+    const double lineHeight = 1.0 / ( lines + 1 );
+    const double charWidth = ( columnWidth - gutter ) / ( wordsPerLine * ( charactersPerWord + 1 ) );
+
+    for ( int column = 0; column < columns; ++column )
+    {
+        for ( int line = 0; line < lines; ++line )
+        {
+            const double top = ( line + 0.5 ) * lineHeight;
+            for ( int word = 0; word < wordsPerLine; ++word )
+            {
+                for ( int c = 0; c < charactersPerWord; ++c )
+                {
+                    const double left = column * columnWidth + ( word * ( charactersPerWord + 1 ) + c ) * charWidth;
+                    const QString text( QChar( 'a' + ( line + word + c ) % 26 ) );
+                    tp->append( text, new Okular::NormalizedRect( left, top, left + charWidth, top + lineHeight * 0.8 ) );
+                }
+            }
+        }
+    }
+
+    return tp;
+}
+
+void TextPageLayoutBenchmark::appendWord( Okular::TextPage *tp, const QString &word, double left, double top, double charWidth, double height )
+{
+    for ( int c = 0; c < word.length(); ++c )
+    {
+        const double charLeft = left + c * charWidth;
+        tp->append( word.mid( c, 1 ), new Okular::NormalizedRect( charLeft, top, charLeft + charWidth, top + height ) );
+    }
+}
+
+// The timings are only worth something if the layout is right: two columns,
+// given line by line across the page like a generator reading the content
+// stream would, are read one column after the other
+void TextPageLayoutBenchmark::testReadingOrder()
+{
+    const QStringList left = QStringList() << QStringLiteral("alpha") << QStringLiteral("beta") << QStringLiteral("gamma") << QStringLiteral("delta");
+    const QStringList right = QStringList() << QStringLiteral("epsilon") << QStringLiteral("zeta") << QStringLiteral("eta") << QStringLiteral("theta");
+
+    Okular::TextPage *tp = new Okular::TextPage();
+    for ( int line = 0; line < left.count(); ++line )
+    {
+        const double top = 0.1 + line * 0.05;
+        appendWord( tp, left.at( line ), 0.1, top, 0.02, 0.04 );
+        appendWord( tp, right.at( line ), 0.6, top, 0.02, 0.04 );
+    }
+
+    Okular::Page page( 0, 1000, 1400, Okular::Rotation0 );
+    page.setTextPage( tp );
+
+    // the spaces and line breaks added are not the point here
+    QString text = tp->text();
+    text.remove( QRegularExpression( QStringLiteral("\\s") ) );
+    QCOMPARE( text, QStringLiteral("alphabetagammadeltaepsilonzetaetatheta") );
+}
+
+void TextPageLayoutBenchmark::benchmarkCorrectTextOrder_data()
+{
+    QTest::addColumn<int>("columns");
+    QTest::addColumn<int>("lines");
+    QTest::addColumn<int>("wordsPerLine");
+
+    QTest::newRow("one column") << 1 << 50 << 12;
+    QTest::newRow("two columns") << 2 << 60 << 8;
+    QTest::newRow("table") << 12 << 80 << 1;
+    QTest::newRow("dense four columns") << 4 << 150 << 6;
+}
+
+void TextPageLayoutBenchmark::benchmarkCorrectTextOrder()
+{
+    QFETCH(int, columns);
+    QFETCH(int, lines);
+    QFETCH(int, wordsPerLine);
+
+    Okular::Page page( 0, 1000, 1400, Okular::Rotation0 );
+    Okular::TextPage *tp = nullptr;
+
+    QBENCHMARK {
+        // Page::setTextPage corrects the text order
+        tp = createTextPage( columns, lines, wordsPerLine );
+        page.setTextPage( tp );
+    }
+
+    // no glyph got lost, only spaces and line breaks were added
+    QString text = tp->text();
+    text.remove( QRegularExpression( QStringLiteral("\\s") ) );
+    QCOMPARE( text.length(), columns * lines * wordsPerLine * charactersPerWord );
+}
+
+QTEST_MAIN( TextPageLayoutBenchmark )
+#include "textpagelayoutbenchmark.moc"
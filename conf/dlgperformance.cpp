@@ -13,8 +13,11 @@
 #include <QFont>
 
 #include <KConfigDialogManager>
+#include <KFormat>
 #include <KIconLoader>
+#include <KLocalizedString>
 
+#include "core/document.h"
 #include "settings_core.h"
 #include "ui_dlgperformancebase.h"
 
@@ -67,4 +70,40 @@ void DlgPerformance::radioGroup_changed( int which )
     }
 }
 
+void DlgPerformance::showEvent( QShowEvent *event )
+{
+    updateMemoryUsage();
+    QWidget::showEvent( event );
+}
+
+void DlgPerformance::updateMemoryUsage()
+{
+    // the memory budget is shared by all the documents of the process
+    QStringList lines;
+    qulonglong total = 0;
+    const QList< Okular::Document * > documents = Okular::Document::allDocuments();
+    for ( const Okular::Document *document : documents )
+    {
+        if ( !document->isOpened() )
+            continue;
+
+        const qulonglong memory = document->pixmapMemory();
+        total += memory;
+        const QString name = document->currentDocument().fileName();
+        if ( document->isActive() )
+            lines << i18nc( "%1 is a file name, %2 the memory it uses", "%1: %2", name, KFormat().formatByteSize( memory ) );
+        else
+            lines << i18nc( "%1 is a file name, %2 the memory it uses", "%1: %2 (in background)", name, KFormat().formatByteSize( memory ) );
+    }
+
+    if ( lines.isEmpty() )
+    {
+        m_dlg->usageLabel->clear();
+        return;
+    }
+
+    lines.prepend( i18n( "Memory used by the open documents: %1", KFormat().formatByteSize( total ) ) );
+    m_dlg->usageLabel->setText( lines.join( QLatin1Char( '\n' ) ) );
+}
+
 #include "moc_dlgperformance.cpp"
@@ -27,7 +27,12 @@ class DlgPerformance : public QWidget
         void radioGroup_changed( int which );
 
     protected:
+        void showEvent( QShowEvent *event ) override;
+
         Ui_DlgPerformanceBase * m_dlg;
+
+    private:
+        void updateMemoryUsage();
 };
 
 #endif
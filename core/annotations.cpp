@@ -11,6 +11,7 @@
 #include "annotations_p.h"
 
 // qt/kde includes
+#include <QtCore/QAtomicInt>
 #include <QtWidgets/QApplication>
 #include <QtGui/QColor>
 
@@ -492,6 +493,7 @@ Annotation::RevisionType Annotation::Revision::type() const
 AnnotationPrivate::AnnotationPrivate()
     : m_page( nullptr ), m_flags( 0 ), m_disposeFunc( nullptr )
 {
+    appearanceChanged();
 }
 
 AnnotationPrivate::~AnnotationPrivate()
@@ -864,6 +866,13 @@ void AnnotationPrivate::annotationTransform( const QTransform &matrix )
 {
     resetTransformation();
     transform( matrix );
+    appearanceChanged();
+}
+
+void AnnotationPrivate::appearanceChanged()
+{
+    static QAtomicInt serial;
+    m_appearanceSerial = serial.fetchAndAddRelaxed( 1 ) + 1;
 }
 
 void AnnotationPrivate::transform( const QTransform &matrix )
@@ -21,6 +21,8 @@
 #include "okularcore_export.h"
 #include "area.h"
 
+class PagePainter;
+
 namespace Okular {
 
 class Action;
@@ -97,6 +99,7 @@ class OKULARCORE_EXPORT Annotation
     friend class ObjectRect;
     friend class Page;
     friend class PagePrivate;
+    friend class ::PagePainter;
     /// @endcond
 
     public:
@@ -55,6 +55,12 @@ class AnnotationPrivate
          */
         virtual double distanceSqr( double x, double y, double xScale, double yScale );
 
+        /**
+         * Gives the annotation a new appearance serial, telling whoever
+         * caches its rendering that it needs to be drawn again.
+         */
+        void appearanceChanged();
+
         PagePrivate * m_page;
 
         QString m_author;
@@ -73,6 +79,9 @@ class AnnotationPrivate
 
         Annotation::DisposeDataFunction m_disposeFunc;
         QVariant m_nativeId;
+
+        // unique among all the annotations, changes whenever the look may change
+        uint m_appearanceSerial;
 };
 
 }
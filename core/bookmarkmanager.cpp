@@ -15,11 +15,15 @@
 #include <kbookmarkaction.h>
 #include <kbookmarkmanager.h>
 #include <kbookmarkmenu.h>
+#include <QCoreApplication>
 #include <QDebug>
 #include <QGuiApplication>
+#include <QTimer>
 #include <QUrl>
 #include <QStandardPaths>
 
+#include <algorithm>
+
 // local includes
 #include "document_p.h"
 #include "observer.h"
@@ -75,12 +79,16 @@ static inline bool documentViewportFuzzyCompare( const DocumentViewport &vp1, co
     return true;
 }
 
-static inline bool bookmarkLessThan( const KBookmark &b1, const KBookmark &b2 )
+// a bookmark of the current document, with its viewport already parsed
+struct IndexedBookmark
 {
-    DocumentViewport vp1( b1.url().fragment(QUrl::FullyDecoded) );
-    DocumentViewport vp2( b2.url().fragment(QUrl::FullyDecoded) );
+    DocumentViewport viewport;
+    KBookmark bookmark;
+};
 
-    return vp1 < vp2;
+static inline bool indexedBookmarkLessThan( const IndexedBookmark &b1, const IndexedBookmark &b2 )
+{
+    return b1.viewport < b2.viewport;
 }
 
 static inline bool okularBookmarkActionLessThan( QAction * a1, QAction * a2 )
@@ -95,7 +103,8 @@ class BookmarkManager::Private : public KBookmarkOwner
 {
     public:
         Private( BookmarkManager * qq )
-            : KBookmarkOwner(), q( qq ), document( nullptr ), manager( nullptr )
+            : KBookmarkOwner(), q( qq ), document( nullptr ), manager( nullptr ),
+              knownFilesIndexed( false ), saveTimer( nullptr ), savePending( false )
         {
         }
 
@@ -112,6 +121,12 @@ class BookmarkManager::Private : public KBookmarkOwner
         void openBookmark( const KBookmark & bm, Qt::MouseButtons, Qt::KeyboardModifiers ) override;
 
         QHash<QUrl, QString>::iterator bookmarkFind( const QUrl& url, bool doCreate, KBookmarkGroup *result  = nullptr);
+        void indexKnownFiles();
+        void indexUrlBookmarks();
+        void reloadUrlBookmarks();
+        QPair< QVector< IndexedBookmark >::const_iterator, QVector< IndexedBookmark >::const_iterator > pageBookmarks( int page ) const;
+        void scheduleSave( const KBookmarkGroup &group );
+        void flushSave();
 
         // slots
         void _o_changed( const QString & groupAddress, const QString & caller );
@@ -119,10 +134,19 @@ class BookmarkManager::Private : public KBookmarkOwner
         BookmarkManager * q;
         QUrl url;
         QHash<int,int> urlBookmarks;
+        // the bookmarks of url, sorted by viewport
+        QVector< IndexedBookmark > urlBookmarkIndex;
         DocumentPrivate * document;
         QString file;
         KBookmarkManager * manager;
+        // the group of every url in the bookmarks file, by url
         QHash<QUrl, QString> knownFiles;
+        bool knownFilesIndexed;
+        // the changes are written to the file once per burst of edits; the
+        // address of the group to save, or empty if there are several
+        QTimer * saveTimer;
+        bool savePending;
+        QString pendingGroupAddress;
 };
 
 static inline QUrl urlForGroup(const KBookmark &group)
@@ -147,10 +171,19 @@ BookmarkManager::BookmarkManager( DocumentPrivate * document )
     d->manager->setUpdate( true );
     connect( d->manager, SIGNAL(changed(QString,QString)),
              this, SLOT(_o_changed(QString,QString)) );
+
+    d->saveTimer = new QTimer( this );
+    d->saveTimer->setSingleShot( true );
+    d->saveTimer->setInterval( 500 );
+    connect( d->saveTimer, &QTimer::timeout, this, [this] { d->flushSave(); } );
+    // the documents may not be closed, nor this destroyed, when quitting
+    if ( QCoreApplication::instance() )
+        connect( QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this] { d->flushSave(); } );
 }
 
 BookmarkManager::~BookmarkManager()
 {
+    d->flushSave();
     delete d;
 }
 
@@ -181,28 +214,34 @@ void BookmarkManager::Private::_o_changed( const QString & groupAddress, const Q
 {
     Q_UNUSED( caller );
     if ( groupAddress.isEmpty() )
+    {
+        // the whole file changed, the group addresses may have too, and any
+        // url may have got or lost bookmarks
+        QSet<QUrl> changedUrls = knownFiles.keys().toSet();
+        indexKnownFiles();
+        changedUrls += knownFiles.keys().toSet();
+        if ( url.isValid() )
+            changedUrls.insert( url );
+
+        reloadUrlBookmarks();
+        foreach ( const QUrl &changedUrl, changedUrls )
+            emit q->bookmarksChanged( changedUrl );
+        emit q->saved();
         return;
+    }
 
     QUrl referurl;
     // first, try to find the bookmark group whom change notification was just received
-    QHash<QUrl, QString>::iterator it = knownFiles.begin(), itEnd = knownFiles.end();
-    for ( ; it != itEnd; ++it )
-    {
-        if ( it.value() == groupAddress )
-        {
-            referurl = it.key();
-            knownFiles.erase( it );
-            break;
-        }
-    }
-    if ( !referurl.isValid() )
+    const KBookmark bm = manager->findByAddress( groupAddress );
+    // better be safe than sorry
+    if ( bm.isNull() || !bm.isGroup() )
+        return;
+    referurl = urlForGroup( bm );
+    if ( knownFiles.value( referurl ) != groupAddress )
     {
-        const KBookmark bm = manager->findByAddress( groupAddress );
-        // better be safe than sorry
-        if ( bm.isNull() )
-            return;
-        Q_ASSERT( bm.isGroup() );
-        referurl = urlForGroup( bm );
+        // a group we do not know about, e.g. added by another instance
+        knownFiles.clear();
+        knownFilesIndexed = false;
     }
     Q_ASSERT( referurl.isValid() );
     emit q->bookmarksChanged( referurl );
@@ -210,29 +249,26 @@ void BookmarkManager::Private::_o_changed( const QString & groupAddress, const Q
     // (this might happen if the same document is open in another place;
     // in such case, make really sure to be in sync)
     if ( referurl == url )
+        reloadUrlBookmarks();
+    emit q->saved();
+}
+
+void BookmarkManager::Private::reloadUrlBookmarks()
+{
+    // save the old bookmarks for the current url
+    const QHash<int,int> oldUrlBookmarks = urlBookmarks;
+    // reload the information we have about it
+    indexUrlBookmarks();
+    // then notify the observers about the pages whose bookmarks changed
+    QSet<int> pages = oldUrlBookmarks.keys().toSet();
+    pages += urlBookmarks.keys().toSet();
+    foreach ( int i, pages )
     {
-        // save the old bookmarks for the current url
-        const QHash<int,int> oldUrlBookmarks = urlBookmarks;
-        // set the same url again, so we reload the information we have about it
-        q->setUrl( referurl );
-        // then notify the observers about the changes in the bookmarks
-        for ( int i = 0; i < qMax( oldUrlBookmarks.size(), urlBookmarks.size() ); i++ )
+        if ( oldUrlBookmarks.value( i ) != urlBookmarks.value( i ) )
         {
-            bool oldContains = oldUrlBookmarks.contains(i) && oldUrlBookmarks[i] > 0;
-            bool curContains = urlBookmarks.contains(i) && urlBookmarks[i] > 0;
-
-            if ( oldContains != curContains )
-            {
-                foreachObserverD( notifyPageChanged( i, DocumentObserver::Bookmark ) );
-            }
-            else if ( oldContains && oldUrlBookmarks[i] != urlBookmarks[i] )
-            {
-                foreachObserverD( notifyPageChanged( i, DocumentObserver::Bookmark ) );
-            }
-
+            foreachObserverD( notifyPageChanged( i, DocumentObserver::Bookmark ) );
         }
     }
-    emit q->saved();
 }
 
 QList<QUrl> BookmarkManager::files() const
@@ -252,21 +288,16 @@ QList<QUrl> BookmarkManager::files() const
 KBookmark::List BookmarkManager::bookmarks(const QUrl &url ) const
 {
     KBookmark::List ret;
-    KBookmarkGroup group = d->manager->root();
-    for ( KBookmark bm = group.first(); !bm.isNull(); bm = group.next( bm ) )
+    KBookmarkGroup group;
+    if ( d->bookmarkFind( url, false, &group ) == d->knownFiles.end() )
+        return ret;
+
+    for ( KBookmark b = group.first(); !b.isNull(); b = group.next( b ) )
     {
-        if ( !bm.isGroup() || urlForGroup( bm ) != url )
+        if ( b.isSeparator() || b.isGroup() )
             continue;
 
-        KBookmarkGroup group = bm.toGroup();
-        for ( KBookmark b = group.first(); !b.isNull(); b = group.next( b ) )
-        {
-            if ( b.isSeparator() || b.isGroup() )
-                continue;
-
-            ret.append( b );
-        }
-        break;
+        ret.append( b );
     }
 
     return ret;
@@ -279,32 +310,21 @@ KBookmark::List BookmarkManager::bookmarks() const
 
 KBookmark::List BookmarkManager::bookmarks( int page ) const
 {
-    const KBookmark::List bmarks = bookmarks();
     KBookmark::List ret;
-    foreach( const KBookmark &bm, bmarks )
-    {
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp.isValid() && vp.pageNumber == page )
-        {
-            ret.append(bm);
-        }
-    }
+    const auto range = d->pageBookmarks( page );
+    for ( auto it = range.first; it != range.second; ++it )
+        ret.append( it->bookmark );
 
     return ret;
 }
 
 KBookmark BookmarkManager::bookmark( int page ) const
 {
-    const KBookmark::List bmarks = bookmarks();
-    foreach( const KBookmark &bm, bmarks )
-    {
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp.isValid() && vp.pageNumber == page )
-        {
-            return bm;
-        }
-    }
-    return KBookmark();
+    const auto range = d->pageBookmarks( page );
+    if ( range.first == range.second )
+        return KBookmark();
+
+    return range.first->bookmark;
 }
 
 KBookmark BookmarkManager::bookmark( const DocumentViewport &viewport ) const
@@ -312,10 +332,75 @@ KBookmark BookmarkManager::bookmark( const DocumentViewport &viewport ) const
     if ( !viewport.isValid() || !isBookmarked( viewport.pageNumber ) )
         return KBookmark();
 
+    const auto range = d->pageBookmarks( viewport.pageNumber );
+    for ( auto it = range.first; it != range.second; ++it )
+    {
+        if ( documentViewportFuzzyCompare( it->viewport, viewport ) )
+            return it->bookmark;
+    }
+
+    return KBookmark();
+}
+
+void BookmarkManager::save() const
+{
+    d->saveTimer->stop();
+    d->savePending = false;
+    d->manager->emitChanged();
+    emit const_cast<BookmarkManager*>( this )->saved();
+}
+
+void BookmarkManager::Private::scheduleSave( const KBookmarkGroup &group )
+{
+    const QString address = group.address();
+    if ( !savePending )
+        pendingGroupAddress = address;
+    else if ( pendingGroupAddress != address )
+        pendingGroupAddress.clear();
+    savePending = true;
+    saveTimer->start();
+}
+
+void BookmarkManager::Private::flushSave()
+{
+    if ( !savePending )
+        return;
+
+    saveTimer->stop();
+    savePending = false;
+    const KBookmark bm = pendingGroupAddress.isEmpty() ? KBookmark() : manager->findByAddress( pendingGroupAddress );
+    if ( bm.isGroup() )
+        manager->emitChanged( bm.toGroup() );
+    else
+        manager->emitChanged();
+}
+
+void BookmarkManager::Private::indexKnownFiles()
+{
+    // a single walk over the top-level "folders", the first one of each url
+    // is the one used
+    knownFiles.clear();
+    KBookmarkGroup root = manager->root();
+    for ( KBookmark bm = root.first(); !bm.isNull(); bm = root.next( bm ) )
+    {
+        if ( bm.isSeparator() || !bm.isGroup() )
+            continue;
+
+        const QUrl groupUrl = urlForGroup( bm );
+        if ( !knownFiles.contains( groupUrl ) )
+            knownFiles.insert( groupUrl, bm.address() );
+    }
+    knownFilesIndexed = true;
+}
+
+void BookmarkManager::Private::indexUrlBookmarks()
+{
+    urlBookmarks.clear();
+    urlBookmarkIndex.clear();
     KBookmarkGroup thebg;
-    QHash<QUrl, QString>::iterator it = d->bookmarkFind( d->url, false, &thebg );
-    if ( it == d->knownFiles.end() )
-        return KBookmark();
+    QHash<QUrl, QString>::iterator it = bookmarkFind( url, false, &thebg );
+    if ( it == knownFiles.end() )
+        return;
 
     for ( KBookmark bm = thebg.first(); !bm.isNull(); bm = thebg.next( bm ) )
     {
@@ -323,65 +408,58 @@ KBookmark BookmarkManager::bookmark( const DocumentViewport &viewport ) const
             continue;
 
         DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( documentViewportFuzzyCompare( vp, viewport ) )
-        {
-            return bm;
-        }
-    }
+        if ( !vp.isValid() )
+            continue;
 
-    return KBookmark();
+        urlBookmarks[ vp.pageNumber ]++;
+        IndexedBookmark indexed;
+        indexed.viewport = vp;
+        indexed.bookmark = bm;
+        urlBookmarkIndex.append( indexed );
+    }
+    std::stable_sort( urlBookmarkIndex.begin(), urlBookmarkIndex.end(), indexedBookmarkLessThan );
 }
 
-void BookmarkManager::save() const
+QPair< QVector< IndexedBookmark >::const_iterator, QVector< IndexedBookmark >::const_iterator > BookmarkManager::Private::pageBookmarks( int page ) const
 {
-    d->manager->emitChanged();
-    emit const_cast<BookmarkManager*>( this )->saved();
+    const auto begin = std::lower_bound( urlBookmarkIndex.constBegin(), urlBookmarkIndex.constEnd(), page,
+                                         []( const IndexedBookmark &bm, int p ) { return bm.viewport.pageNumber < p; } );
+    const auto end = std::upper_bound( begin, urlBookmarkIndex.constEnd(), page,
+                                       []( int p, const IndexedBookmark &bm ) { return p < bm.viewport.pageNumber; } );
+    return qMakePair( begin, end );
 }
 
 QHash<QUrl, QString>::iterator BookmarkManager::Private::bookmarkFind( const QUrl& url, bool doCreate, KBookmarkGroup *result )
 {
+    // the top-level "folder" of every file is indexed by url once, instead
+    // of walking all of them for every lookup
+    if ( !knownFilesIndexed )
+        indexKnownFiles();
+
     QHash<QUrl, QString>::iterator it = knownFiles.find( url );
-    if ( it == knownFiles.end() )
+    if ( it != knownFiles.end() )
     {
-        // if the url we want to add a new entry for is not in the hash of the
-        // known files, then first try to find the file among the top-level
-        // "folder" names
-        bool found = false;
-        KBookmarkGroup root = manager->root();
-        for ( KBookmark bm = root.first(); !found && !bm.isNull(); bm = root.next( bm ) )
-        {
-            if ( bm.isSeparator() || !bm.isGroup() )
-                continue;
-
-            QUrl tmpurl( urlForGroup( bm ) );
-            if ( tmpurl == url )
-            {
-                // got it! place it the hash of known files
-                KBookmarkGroup bg = bm.toGroup();
-                it = knownFiles.insert( url, bg.address() );
-                found = true;
-                if ( result )
-                    *result = bg;
-                break;
-            }
-        }
-        if ( !found && doCreate )
+        KBookmark bm = manager->findByAddress( it.value() );
+        if ( !bm.isGroup() || urlForGroup( bm ) != url )
         {
-            // folder not found :(
-            // then, in a single step create a new folder and add it in our cache :)
-            QString purl = url.isLocalFile() ? url.toLocalFile() : url.toDisplayString();
-            KBookmarkGroup newbg = root.createNewFolder( purl );
-            newbg.setUrl( url );
-            it = knownFiles.insert( url, newbg.address() );
-            if ( result )
-                *result = newbg;
+            // the file was changed behind our back, index it again
+            indexKnownFiles();
+            it = knownFiles.find( url );
+            bm = it != knownFiles.end() ? manager->findByAddress( it.value() ) : KBookmark();
         }
+        if ( it != knownFiles.end() && result )
+            *result = bm.toGroup();
     }
-    else if ( result )
+    if ( it == knownFiles.end() && doCreate )
     {
-        const KBookmark bm = manager->findByAddress( it.value() );
-        Q_ASSERT( bm.isGroup() );
-        *result = bm.toGroup();
+        // folder not found :(
+        // then, in a single step create a new folder and add it in our cache :)
+        QString purl = url.isLocalFile() ? url.toLocalFile() : url.toDisplayString();
+        KBookmarkGroup newbg = manager->root().createNewFolder( purl );
+        newbg.setUrl( url );
+        it = knownFiles.insert( url, newbg.address() );
+        if ( result )
+            *result = newbg;
     }
     return it;
 }
@@ -453,10 +531,10 @@ bool BookmarkManager::addBookmark(const QUrl &referurl, const Okular::DocumentVi
     thebg.addBookmark( newtitle, newurl, QString() );
     if ( referurl == d->document->m_url )
     {
-        d->urlBookmarks[ vp.pageNumber ]++;
+        d->indexUrlBookmarks();
         foreachObserver( notifyPageChanged( vp.pageNumber, DocumentObserver::Bookmark ) );
     }
-    d->manager->emitChanged( thebg );
+    d->scheduleSave( thebg );
     return true;
 }
 
@@ -487,7 +565,7 @@ void BookmarkManager::renameBookmark( KBookmark* bm, const QString& newName)
         return;
 
     bm->setFullText( newName );
-    d->manager->emitChanged( thebg );
+    d->scheduleSave( thebg );
 }
 
 void BookmarkManager::renameBookmark(const QUrl &referurl, const QString& newName )
@@ -502,7 +580,7 @@ void BookmarkManager::renameBookmark(const QUrl &referurl, const QString& newNam
         return;
 
     thebg.setFullText( newName );
-    d->manager->emitChanged( thebg );
+    d->scheduleSave( thebg );
 }
 
 QString BookmarkManager::titleForUrl(const QUrl &referurl ) const
@@ -532,10 +610,10 @@ int BookmarkManager::removeBookmark(const QUrl &referurl, const KBookmark& bm )
 
     if ( referurl == d->document->m_url )
     {
-        d->urlBookmarks[ vp.pageNumber ]--;
+        d->indexUrlBookmarks();
         foreachObserver( notifyPageChanged( vp.pageNumber, DocumentObserver::Bookmark ) );
     }
-    d->manager->emitChanged( thebg );
+    d->scheduleSave( thebg );
 
     return vp.pageNumber;
 }
@@ -550,7 +628,6 @@ void BookmarkManager::removeBookmarks(const QUrl &referurl, const KBookmark::Lis
     if ( it == d->knownFiles.end() )
         return;
 
-    const QHash<int,int> oldUrlBookmarks = d->urlBookmarks;
     bool deletedAny = false;
     foreach ( const KBookmark & bm, list )
     {
@@ -558,54 +635,28 @@ void BookmarkManager::removeBookmarks(const QUrl &referurl, const KBookmark::Lis
         {
             thebg.deleteBookmark( bm );
             deletedAny = true;
-
-            DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-            if ( referurl == d->document->m_url )
-            {
-                d->urlBookmarks[ vp.pageNumber ]--;
-            }
         }
     }
 
     if ( referurl == d->document->m_url )
-    {
-        for ( int i = 0; i < qMax( oldUrlBookmarks.size(), d->urlBookmarks.size() ); i++ )
-        {
-            bool oldContains = oldUrlBookmarks.contains(i) && oldUrlBookmarks[i] > 0;
-            bool curContains = d->urlBookmarks.contains(i) && d->urlBookmarks[i] > 0;
-
-            if ( oldContains != curContains )
-            {
-                foreachObserver( notifyPageChanged( i, DocumentObserver::Bookmark ) );
-            }
-            else if ( oldContains && oldUrlBookmarks[i] != d->urlBookmarks[i] )
-            {
-                foreachObserver( notifyPageChanged( i, DocumentObserver::Bookmark ) );
-            }
-        }
-    }
+        d->reloadUrlBookmarks();
     if ( deletedAny )
-        d->manager->emitChanged( thebg );
+        d->scheduleSave( thebg );
 }
 
 QList< QAction * > BookmarkManager::actionsForUrl(const QUrl &url ) const
 {
     QList< QAction * > ret;
-    KBookmarkGroup group = d->manager->root();
-    for ( KBookmark bm = group.first(); !bm.isNull(); bm = group.next( bm ) )
+    KBookmarkGroup group;
+    if ( d->bookmarkFind( url, false, &group ) == d->knownFiles.end() )
+        return ret;
+
+    for ( KBookmark b = group.first(); !b.isNull(); b = group.next( b ) )
     {
-        if ( !bm.isGroup() || urlForGroup( bm ) != url )
+        if ( b.isSeparator() || b.isGroup() )
             continue;
 
-        KBookmarkGroup group = bm.toGroup();
-        for ( KBookmark b = group.first(); !b.isNull(); b = group.next( b ) )
-        {
-            if ( b.isSeparator() || b.isGroup() )
-                continue;
-
-            ret.append( new OkularBookmarkAction( DocumentViewport( b.url().fragment(QUrl::FullyDecoded) ), b, d, nullptr ) );
-        }
-        break;
+        ret.append( new OkularBookmarkAction( DocumentViewport( b.url().fragment(QUrl::FullyDecoded) ), b, d, nullptr ) );
     }
     qSort( ret.begin(), ret.end(), okularBookmarkActionLessThan );
     return ret;
@@ -614,80 +665,39 @@ QList< QAction * > BookmarkManager::actionsForUrl(const QUrl &url ) const
 void BookmarkManager::setUrl(const QUrl &url )
 {
     d->url = url;
-    d->urlBookmarks.clear();
-    KBookmarkGroup thebg;
-    QHash<QUrl, QString>::iterator it = d->bookmarkFind( url, false, &thebg );
-    if ( it != d->knownFiles.end() )
-    {
-        for ( KBookmark bm = thebg.first(); !bm.isNull(); bm = thebg.next( bm ) )
-        {
-            if ( bm.isSeparator() || bm.isGroup() )
-                continue;
-
-            DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-            if ( !vp.isValid() )
-                continue;
-
-            d->urlBookmarks[ vp.pageNumber ]++;
-        }
-    }
+    d->indexUrlBookmarks();
 }
 
 bool BookmarkManager::setPageBookmark( int page )
 {
+    if ( isBookmarked( page ) )
+        return false;
+
     KBookmarkGroup thebg;
     QHash<QUrl, QString>::iterator it = d->bookmarkFind( d->url, true, &thebg );
     Q_ASSERT( it != d->knownFiles.end() );
 
-    bool found = false;
-    bool added = false;
-    for ( KBookmark bm = thebg.first(); !found && !bm.isNull(); bm = thebg.next( bm ) )
-    {
-        if ( bm.isSeparator() || bm.isGroup() )
-            continue;
-
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp.isValid() && vp.pageNumber == page )
-            found = true;
-
-    }
-    if ( !found )
-    {
-        d->urlBookmarks[ page ]++;
-        DocumentViewport vp;
-        vp.pageNumber = page;
-        QUrl newurl = d->url;
-        newurl.setFragment(vp.toString(), QUrl::DecodedMode);
-        thebg.addBookmark( QLatin1String( "#" ) + QString::number( vp.pageNumber + 1 ), newurl, QString() );
-        added = true;
-        d->manager->emitChanged( thebg );
-    }
-    return added;
+    DocumentViewport vp;
+    vp.pageNumber = page;
+    QUrl newurl = d->url;
+    newurl.setFragment(vp.toString(), QUrl::DecodedMode);
+    thebg.addBookmark( QLatin1String( "#" ) + QString::number( vp.pageNumber + 1 ), newurl, QString() );
+    d->indexUrlBookmarks();
+    d->scheduleSave( thebg );
+    return true;
 }
 
 bool BookmarkManager::removePageBookmark( int page )
 {
-    KBookmarkGroup thebg;
-    QHash<QUrl, QString>::iterator it = d->bookmarkFind( d->url, false, &thebg );
-    if ( it == d->knownFiles.end() )
+    const KBookmark bm = bookmark( page );
+    if ( bm.isNull() )
         return false;
 
-    bool found = false;
-    for ( KBookmark bm = thebg.first(); !found && !bm.isNull(); bm = thebg.next( bm ) )
-    {
-        if ( bm.isSeparator() || bm.isGroup() )
-            continue;
-
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp.isValid() && vp.pageNumber == page )
-        {
-            found = true;
-            thebg.deleteBookmark( bm );
-            d->urlBookmarks[ page ]--;
-            d->manager->emitChanged( thebg );
-        }
-    }
-    return found;
+    KBookmarkGroup thebg = bm.parentGroup();
+    thebg.deleteBookmark( bm );
+    d->indexUrlBookmarks();
+    d->scheduleSave( thebg );
+    return true;
 }
 
 bool BookmarkManager::isBookmarked( int page ) const
@@ -704,41 +714,26 @@ bool BookmarkManager::isBookmarked( const DocumentViewport &viewport ) const
 
 KBookmark BookmarkManager::nextBookmark( const DocumentViewport &viewport) const
 {
-    KBookmark::List bmarks = bookmarks();
-    qSort( bmarks.begin(), bmarks.end(), bookmarkLessThan);
-
-    KBookmark bookmark;
-    foreach ( const KBookmark &bm, bmarks )
-    {
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( viewport < vp )
-        {
-            bookmark = bm;
-            break;
-        }
-    }
+    IndexedBookmark key;
+    key.viewport = viewport;
+    // the first bookmark after the viewport
+    QVector< IndexedBookmark >::const_iterator it = std::upper_bound( d->urlBookmarkIndex.constBegin(), d->urlBookmarkIndex.constEnd(), key, indexedBookmarkLessThan );
+    if ( it == d->urlBookmarkIndex.constEnd() )
+        return KBookmark();
 
-    return bookmark;
+    return it->bookmark;
 }
 
 KBookmark BookmarkManager::previousBookmark( const DocumentViewport &viewport ) const
 {
-    KBookmark::List bmarks = bookmarks();
-    qSort( bmarks.begin(), bmarks.end(), bookmarkLessThan );
-
-    KBookmark bookmark;
-    for ( KBookmark::List::const_iterator it = bmarks.constEnd(); it != bmarks.constBegin(); --it )
-    {
-        KBookmark bm = *(it-1);
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp < viewport )
-        {
-            bookmark = bm;
-            break;
-        }
-    }
+    IndexedBookmark key;
+    key.viewport = viewport;
+    // the last bookmark before the viewport
+    QVector< IndexedBookmark >::const_iterator it = std::lower_bound( d->urlBookmarkIndex.constBegin(), d->urlBookmarkIndex.constEnd(), key, indexedBookmarkLessThan );
+    if ( it == d->urlBookmarkIndex.constBegin() )
+        return KBookmark();
 
-    return bookmark;
+    return ( it - 1 )->bookmark;
 }
 
 #undef foreachObserver
@@ -0,0 +1,142 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "diskcache_p.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
+#include <QtGui/QImage>
+
+#include "debug_p.h"
+
+using namespace Okular;
+
+// touched each time the document is opened, the files of a document already
+// cached are not written again
+static const char usedStampName[] = ".used";
+
+// the thread and what it already did live and die together, whatever the
+// order the global statics of the process are destroyed in
+struct DiskCacheState
+{
+    DiskCacheState()
+    {
+        // the disk is the bottleneck, and one thread keeps the jobs in order
+        pool.setMaxThreadCount( 1 );
+    }
+
+    ~DiskCacheState()
+    {
+        pool.waitForDone();
+    }
+
+    QThreadPool pool;
+    QMutex mutex;
+    // the cache directories already pruned in this process
+    QSet< QString > prunedDirectories;
+};
+Q_GLOBAL_STATIC( DiskCacheState, s_diskCache )
+
+class SaveImageJob : public QRunnable
+{
+    public:
+        SaveImageJob( const QString &fileName, const QImage &image )
+            : m_fileName( fileName ), m_image( image )
+        {
+        }
+
+        void run() override
+        {
+            // the same image, already saved
+            if ( QFile::exists( m_fileName ) )
+                return;
+
+            if ( !QDir().mkpath( QFileInfo( m_fileName ).absolutePath() ) || !m_image.save( m_fileName, "PNG" ) )
+                qCDebug(OkularCoreDebug) << "Failed to write the cache file" << m_fileName;
+        }
+
+    private:
+        QString m_fileName;
+        QImage m_image;
+};
+
+class MarkUsedJob : public QRunnable
+{
+    public:
+        MarkUsedJob( const QString &directory, int maxAgeDays, bool prune )
+            : m_directory( directory ), m_maxAgeDays( maxAgeDays ), m_prune( prune )
+        {
+        }
+
+        void run() override
+        {
+            if ( QDir().mkpath( m_directory ) )
+            {
+                QFile stamp( m_directory + QLatin1Char( '/' ) + QLatin1String( usedStampName ) );
+                stamp.open( QIODevice::WriteOnly | QIODevice::Truncate );
+            }
+
+            if ( !m_prune )
+                return;
+
+            const QDateTime oldest = QDateTime::currentDateTime().addDays( -m_maxAgeDays );
+            const QFileInfo current( m_directory );
+            const QFileInfoList documents = current.dir().entryInfoList( QDir::Dirs | QDir::NoDotAndDotDot );
+            for ( const QFileInfo &document : documents )
+            {
+                if ( document.fileName() == current.fileName() )
+                    continue;
+
+                const QFileInfo stamp( document.absoluteFilePath() + QLatin1Char( '/' ) + QLatin1String( usedStampName ) );
+                const QDateTime used = stamp.exists() ? qMax( stamp.lastModified(), document.lastModified() ) : document.lastModified();
+                if ( used < oldest )
+                    QDir( document.absoluteFilePath() ).removeRecursively();
+            }
+        }
+
+    private:
+        QString m_directory;
+        int m_maxAgeDays;
+        bool m_prune;
+};
+
+void DiskCache::saveImage( const QString &fileName, const QImage &image )
+{
+    if ( DiskCacheState *state = s_diskCache() )
+        state->pool.start( new SaveImageJob( fileName, image ) );
+}
+
+void DiskCache::markUsed( const QString &directory, int maxAgeDays )
+{
+    DiskCacheState *state = s_diskCache();
+    if ( !state )
+        return;
+
+    bool prune;
+    {
+        QMutexLocker locker( &state->mutex );
+        const QString cacheDirectory = QFileInfo( directory ).absolutePath();
+        prune = !state->prunedDirectories.contains( cacheDirectory );
+        state->prunedDirectories.insert( cacheDirectory );
+    }
+    state->pool.start( new MarkUsedJob( directory, maxAgeDays, prune ) );
+}
+
+void DiskCache::waitForPending()
+{
+    if ( DiskCacheState *state = s_diskCache() )
+        state->pool.waitForDone();
+}
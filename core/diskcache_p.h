@@ -0,0 +1,55 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_DISKCACHE_P_H_
+#define _OKULAR_DISKCACHE_P_H_
+
+#include <QtCore/QString>
+
+#include "okularcore_export.h"
+
+class QImage;
+
+namespace Okular {
+
+/**
+ * Writes the cached thumbnails in a background thread, so that the GUI
+ * thread never waits on the disk, and removes the entries of the documents
+ * not opened for a while from the caches kept in the cache directory (the
+ * thumbnails, the text of the pages).
+ *
+ * Each cache directory holds a subdirectory per document; the files are
+ * written one after another, in the order they are asked.
+ */
+class OKULARCORE_EXPORT DiskCache
+{
+    public:
+        /**
+         * Writes @p image to @p fileName as PNG, creating its directory if
+         * needed, in the background; an existing file is left as it is.
+         */
+        static void saveImage( const QString &fileName, const QImage &image );
+
+        /**
+         * Marks the document subdirectory @p directory as used now, and, the
+         * first time it is called for their cache directory in the process,
+         * removes the other document subdirectories not used for
+         * @p maxAgeDays days; in the background.
+         */
+        static void markUsed( const QString &directory, int maxAgeDays );
+
+        /**
+         * Blocks until the files asked so far are written.
+         */
+        static void waitForPending();
+};
+
+}
+
+#endif
@@ -0,0 +1,269 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "docdata_p.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRunnable>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThreadPool>
+
+#include "debug_p.h"
+
+using namespace Okular;
+
+static const quint32 docDataMagic = 0x6f6b6464; // "okdd"
+static const quint32 docDataVersion = 1;
+
+// the sections of the file; new ones can be added, the readers skip the
+// ones they do not know
+enum DocDataSection
+{
+    UrlSection = 1,
+    RotationSection = 2,
+    HistorySection = 3,
+    ViewsSection = 4,
+    PageListSection = 5
+};
+
+// the saves are numbered, so that a save never overwrites the file with
+// older data than the one already written to it; the thread and the serials
+// live and die together, whatever the order the global statics of the
+// process are destroyed in
+struct SaveState
+{
+    SaveState()
+        : lastSerial( 0 )
+    {
+        // one thread is enough for these small files, and keeps the
+        // asynchronous saves in order
+        pool.setMaxThreadCount( 1 );
+    }
+
+    ~SaveState()
+    {
+        pool.waitForDone();
+    }
+
+    QMutex mutex;
+    quint64 lastSerial;
+    QHash< QString, quint64 > writtenSerials;
+    QThreadPool pool;
+};
+Q_GLOBAL_STATIC( SaveState, s_saveState )
+
+static void writeDocData( SaveState *state, const QString &fileName, const QByteArray &contents, quint64 serial )
+{
+    QMutexLocker locker( &state->mutex );
+    if ( state->writtenSerials.value( fileName ) > serial )
+        return;
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( contents ) != contents.size() || !file.commit() )
+    {
+        qCWarning(OkularCoreDebug) << "Failed to save docdata file" << fileName;
+        return;
+    }
+    state->writtenSerials.insert( fileName, serial );
+}
+
+class DocDataSaveJob : public QRunnable
+{
+    public:
+        DocDataSaveJob( SaveState *state, const QString &fileName, const QByteArray &contents, quint64 serial )
+            : m_state( state ), m_fileName( fileName ), m_contents( contents ), m_serial( serial )
+        {
+        }
+
+        void run() override
+        {
+            writeDocData( m_state, m_fileName, m_contents, m_serial );
+        }
+
+    private:
+        SaveState *m_state;
+        QString m_fileName;
+        QByteArray m_contents;
+        quint64 m_serial;
+};
+
+static void writeSection( QDataStream &stream, DocDataSection section, const QByteArray &payload )
+{
+    stream << (quint8)section << payload;
+}
+
+DocumentData::DocumentData()
+    : rotation( 0 ), currentHistoryIndex( -1 )
+{
+}
+
+bool DocumentData::load( const QString &fileName, bool withPageList )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return false;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    quint32 magic, version;
+    stream >> magic >> version;
+    if ( stream.status() != QDataStream::Ok || magic != docDataMagic || version > docDataVersion )
+        return false;
+
+    while ( !stream.atEnd() )
+    {
+        quint8 section;
+        stream >> section;
+        if ( section == PageListSection && !withPageList )
+        {
+            // the only big section, skip it without reading it
+            quint32 size;
+            stream >> size;
+            if ( size != 0xffffffff && stream.skipRawData( size ) != (int)size )
+                return false;
+            continue;
+        }
+
+        QByteArray payload;
+        stream >> payload;
+        if ( stream.status() != QDataStream::Ok )
+            return false;
+
+        QDataStream sectionStream( payload );
+        sectionStream.setVersion( QDataStream::Qt_5_0 );
+        switch ( section )
+        {
+            case UrlSection:
+                sectionStream >> url;
+                break;
+            case RotationSection:
+            {
+                qint32 value;
+                sectionStream >> value;
+                rotation = value;
+                break;
+            }
+            case HistorySection:
+            {
+                qint32 current;
+                sectionStream >> history >> current;
+                currentHistoryIndex = current;
+                break;
+            }
+            case ViewsSection:
+            {
+                quint32 count;
+                sectionStream >> count;
+                views.clear();
+                for ( quint32 i = 0; i < count && sectionStream.status() == QDataStream::Ok; ++i )
+                {
+                    ViewInfo view;
+                    qint32 mode;
+                    sectionStream >> view.name >> view.zoom >> mode;
+                    view.zoomMode = mode;
+                    views.append( view );
+                }
+                break;
+            }
+            case PageListSection:
+                pageList = payload;
+                break;
+            default:
+                // written by a newer version
+                break;
+        }
+        if ( sectionStream.status() != QDataStream::Ok )
+            return false;
+    }
+
+    return true;
+}
+
+void DocumentData::save( const QString &fileName, bool asynchronous ) const
+{
+    // serializing is cheap, the page list is written as it was read
+    QByteArray contents;
+    {
+        QDataStream stream( &contents, QIODevice::WriteOnly );
+        stream.setVersion( QDataStream::Qt_5_0 );
+        stream << docDataMagic << docDataVersion;
+
+        {
+            QByteArray payload;
+            QDataStream sectionStream( &payload, QIODevice::WriteOnly );
+            sectionStream.setVersion( QDataStream::Qt_5_0 );
+            sectionStream << url;
+            writeSection( stream, UrlSection, payload );
+        }
+
+        if ( rotation != 0 )
+        {
+            QByteArray payload;
+            QDataStream sectionStream( &payload, QIODevice::WriteOnly );
+            sectionStream.setVersion( QDataStream::Qt_5_0 );
+            sectionStream << (qint32)rotation;
+            writeSection( stream, RotationSection, payload );
+        }
+
+        if ( !history.isEmpty() )
+        {
+            QByteArray payload;
+            QDataStream sectionStream( &payload, QIODevice::WriteOnly );
+            sectionStream.setVersion( QDataStream::Qt_5_0 );
+            sectionStream << history << (qint32)currentHistoryIndex;
+            writeSection( stream, HistorySection, payload );
+        }
+
+        {
+            QByteArray payload;
+            QDataStream sectionStream( &payload, QIODevice::WriteOnly );
+            sectionStream.setVersion( QDataStream::Qt_5_0 );
+            sectionStream << (quint32)views.count();
+            for ( const ViewInfo &view : views )
+                sectionStream << view.name << view.zoom << (qint32)view.zoomMode;
+            writeSection( stream, ViewsSection, payload );
+        }
+
+        if ( !pageList.isEmpty() )
+            writeSection( stream, PageListSection, pageList );
+    }
+
+    SaveState *state = s_saveState();
+    if ( !state )
+        return;
+
+    quint64 serial;
+    {
+        QMutexLocker locker( &state->mutex );
+        serial = ++state->lastSerial;
+    }
+
+    if ( asynchronous )
+        state->pool.start( new DocDataSaveJob( state, fileName, contents, serial ) );
+    else
+        writeDocData( state, fileName, contents, serial );
+}
+
+void DocumentData::waitForSaves()
+{
+    if ( SaveState *state = s_saveState() )
+        state->pool.waitForDone();
+}
+
+QString DocumentData::fileNameForXml( const QString &xmlFileName )
+{
+    QString fileName = xmlFileName;
+    if ( fileName.endsWith( QLatin1String( ".xml" ) ) )
+        fileName.chop( 4 );
+    return fileName + QStringLiteral( ".okdata" );
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_DOCDATA_P_H_
+#define _OKULAR_DOCDATA_P_H_
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+#include "okularcore_export.h"
+
+namespace Okular {
+
+/**
+ * What is remembered in docdata/ about a document between two sessions:
+ * the viewport history, the rotation and the zoom of the views.
+ *
+ * It is stored in a small versioned binary file made of tagged, length
+ * prefixed sections, so that reading it does not need to parse the page
+ * contents (only kept for documents whose annotations and forms still have
+ * to be migrated from the docdata/ of older versions), and unknown
+ * sections written by newer versions are skipped.
+ *
+ * The XML files written by the older versions are imported by the
+ * DocumentPrivate when there is no binary file yet; they are left in
+ * place, for the older versions still reading them.
+ */
+class OKULARCORE_EXPORT DocumentData
+{
+    public:
+        struct ViewInfo
+        {
+            QString name;
+            // zero, or negative, if not known
+            double zoom;
+            int zoomMode;
+        };
+
+        DocumentData();
+
+        /**
+         * Reads the data from @p fileName; the page list is read only if
+         * @p withPageList is set.
+         */
+        bool load( const QString &fileName, bool withPageList );
+
+        /**
+         * Writes the data to @p fileName, in a background thread if
+         * @p asynchronous is set; the file always ends up holding the data
+         * of the last call, even if the writes complete out of order.
+         */
+        void save( const QString &fileName, bool asynchronous ) const;
+
+        /**
+         * Blocks until the asynchronous saves are done.
+         */
+        static void waitForSaves();
+
+        /**
+         * Returns the name of the binary file that replaces the XML file
+         * @p xmlFileName of the older versions.
+         */
+        static QString fileNameForXml( const QString &xmlFileName );
+
+        QString url;
+        int rotation;
+        QStringList history;
+        int currentHistoryIndex;
+        QVector< ViewInfo > views;
+        // the <pageList> element of the old XML, kept as it was read
+        QByteArray pageList;
+};
+
+}
+
+#endif
@@ -28,6 +28,8 @@
 
 // qt/kde/system includes
 #include <QtCore/QtAlgorithms>
+#include <QtCore/QBitArray>
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
@@ -39,7 +41,6 @@
 #include <QtWidgets/QLabel>
 #include <QtPrintSupport/QPrinter>
 #include <QtPrintSupport/QPrintDialog>
-#include <QStack>
 #include <QUndoCommand>
 #include <QMimeDatabase>
 #include <QDesktopServices>
@@ -70,11 +71,14 @@
 #include "bookmarkmanager.h"
 #include "chooseenginedialog_p.h"
 #include "debug_p.h"
+#include "diskcache_p.h"
+#include "docdata_p.h"
 #include "generator_p.h"
 #include "interfaces/configinterface.h"
 #include "interfaces/guiinterface.h"
 #include "interfaces/printinterface.h"
 #include "interfaces/saveinterface.h"
+#include "memorymonitor_p.h"
 #include "observer.h"
 #include "misc.h"
 #include "page.h"
@@ -85,9 +89,11 @@
 #include "settings_core.h"
 #include "sourcereference.h"
 #include "sourcereference_p.h"
+#include "sourcereferenceloader_p.h"
 #include "texteditors_p.h"
 #include "tile.h"
 #include "tilesmanager_p.h"
+#include "tracer_p.h"
 #include "utils_p.h"
 #include "view.h"
 #include "view_p.h"
@@ -106,10 +112,15 @@ struct AllocatedPixmap
     DocumentObserver *observer;
     int page;
     qulonglong memory;
+    bool thumbnail;
     // public constructor: initialize data
-    AllocatedPixmap( DocumentObserver *o, int p, qulonglong m ) : observer( o ), page( p ), memory( m ) {}
+    AllocatedPixmap( DocumentObserver *o, int p, qulonglong m, bool t = false ) : observer( o ), page( p ), memory( m ), thumbnail( t ) {}
 };
 
+// all the documents of the process, sharing the pixmap memory budget
+typedef QList< DocumentPrivate * > DocumentPrivateList;
+Q_GLOBAL_STATIC( DocumentPrivateList, s_documents )
+
 struct ArchiveData
 {
     ArchiveData()
@@ -136,6 +147,10 @@ struct RunningSearch
     bool isCurrentlySearching : 1;
     QColor cachedColor;
     int pagesDone;
+
+    // pages the generator search index says may contain cachedString,
+    // empty if all the pages need to be searched
+    QBitArray candidatePages;
 };
 
 #define foreachObserver( cmd ) {\
@@ -218,26 +233,29 @@ qulonglong DocumentPrivate::calculateMemoryToFree()
     // [MEM] choose memory parameters based on configuration profile
     qulonglong clipValue = 0;
     qulonglong memoryToFree = 0;
+    // the budget is shared by all the documents of the process (e.g. the
+    // tabs of the shell), so measure it against the memory of all of them
+    const qulonglong allocatedMemory = processPixmapsTotalMemory();
 
     switch ( SettingsCore::memoryLevel() )
     {
         case SettingsCore::EnumMemoryLevel::Low:
-            memoryToFree = m_allocatedPixmapsTotalMemory;
+            memoryToFree = allocatedMemory;
             break;
 
         case SettingsCore::EnumMemoryLevel::Normal:
         {
             qulonglong thirdTotalMemory = getTotalMemory() / 3;
             qulonglong freeMemory = getFreeMemory();
-            if (m_allocatedPixmapsTotalMemory > thirdTotalMemory) memoryToFree = m_allocatedPixmapsTotalMemory - thirdTotalMemory;
-            if (m_allocatedPixmapsTotalMemory > freeMemory) clipValue = (m_allocatedPixmapsTotalMemory - freeMemory) / 2;
+            if (allocatedMemory > thirdTotalMemory) memoryToFree = allocatedMemory - thirdTotalMemory;
+            if (allocatedMemory > freeMemory) clipValue = (allocatedMemory - freeMemory) / 2;
         }
         break;
 
         case SettingsCore::EnumMemoryLevel::Aggressive:
         {
             qulonglong freeMemory = getFreeMemory();
-            if (m_allocatedPixmapsTotalMemory > freeMemory) clipValue = (m_allocatedPixmapsTotalMemory - freeMemory) / 2;
+            if (allocatedMemory > freeMemory) clipValue = (allocatedMemory - freeMemory) / 2;
         }
         break;
         case SettingsCore::EnumMemoryLevel::Greedy:
@@ -245,7 +263,7 @@ qulonglong DocumentPrivate::calculateMemoryToFree()
             qulonglong freeSwap;
             qulonglong freeMemory = getFreeMemory( &freeSwap );
             const qulonglong memoryLimit = qMin( qMax( freeMemory, getTotalMemory()/2 ), freeMemory+freeSwap );
-            if (m_allocatedPixmapsTotalMemory > memoryLimit) clipValue = (m_allocatedPixmapsTotalMemory - memoryLimit) / 2;
+            if (allocatedMemory > memoryLimit) clipValue = (allocatedMemory - memoryLimit) / 2;
         }
         break;
     }
@@ -263,6 +281,10 @@ void DocumentPrivate::cleanupPixmapMemory()
 
 void DocumentPrivate::cleanupPixmapMemory( qulonglong memoryToFree )
 {
+    TraceScope trace( "cleanupPixmapMemory", "memory" );
+
+    // [MEM] the documents the user is not looking at pay first
+    memoryToFree = freeBackgroundDocumentsMemory( memoryToFree );
     if ( memoryToFree < 1 )
         return;
 
@@ -350,9 +372,9 @@ void DocumentPrivate::cleanupPixmapMemory( qulonglong memoryToFree )
 /* Returns the next pixmap to evict from cache, or NULL if no suitable pixmap
  * if found. If unloadableOnly is set, only unloadable pixmaps are returned. If
  * thenRemoveIt is set, the pixmap is removed from m_allocatedPixmaps before
- * returning it
+ * returning it. If includeThumbnails is not set, thumbnails are never returned
  */
-AllocatedPixmap * DocumentPrivate::searchLowestPriorityPixmap( bool unloadableOnly, bool thenRemoveIt, DocumentObserver *observer )
+AllocatedPixmap * DocumentPrivate::searchLowestPriorityPixmap( bool unloadableOnly, bool thenRemoveIt, DocumentObserver *observer, bool includeThumbnails )
 {
     QLinkedList< AllocatedPixmap * >::iterator pIt = m_allocatedPixmaps.begin();
     QLinkedList< AllocatedPixmap * >::iterator pEnd = m_allocatedPixmaps.end();
@@ -365,7 +387,7 @@ AllocatedPixmap * DocumentPrivate::searchLowestPriorityPixmap( bool unloadableOn
     {
         const AllocatedPixmap * p = *pIt;
         // Filter by observer
-        if ( observer == nullptr || p->observer == observer )
+        if ( ( observer == nullptr || p->observer == observer ) && ( includeThumbnails || !p->thumbnail ) )
         {
             const int distance = qAbs( p->page - currentViewportPage );
             if ( maxDistance < distance && ( !unloadableOnly || p->observer->canUnloadPixmap( p->page ) ) )
@@ -387,6 +409,238 @@ AllocatedPixmap * DocumentPrivate::searchLowestPriorityPixmap( bool unloadableOn
     return selectedPixmap;
 }
 
+qulonglong DocumentPrivate::processPixmapsTotalMemory()
+{
+    qulonglong total = 0;
+    foreach ( const DocumentPrivate *doc, *s_documents() )
+        total += doc->m_allocatedPixmapsTotalMemory;
+    return total;
+}
+
+/* Frees up to memoryToFree bytes from the documents that are not active,
+ * and returns how much is still left to free
+ */
+qulonglong DocumentPrivate::freeBackgroundDocumentsMemory( qulonglong memoryToFree )
+{
+    TraceScope trace( "freeBackgroundDocumentsMemory", "memory" );
+    foreach ( DocumentPrivate *doc, *s_documents() )
+    {
+        if ( memoryToFree < 1 )
+            break;
+        if ( doc == this || doc->m_active )
+            continue;
+
+        const qulonglong freed = doc->freeBackgroundPixmaps( memoryToFree );
+        memoryToFree = ( freed < memoryToFree ) ? ( memoryToFree - freed ) : 0;
+    }
+    return memoryToFree;
+}
+
+/* Frees the pixmaps of a document that is not active, starting from the
+ * farthest from its viewport, and returns the memory freed. The document is
+ * not on screen, so its observers cannot veto the unloading of the pages
+ * they show; the thumbnails are kept, so that the document can still be
+ * previewed cheaply.
+ */
+qulonglong DocumentPrivate::freeBackgroundPixmaps( qulonglong memoryToFree )
+{
+    qulonglong freed = 0;
+    while ( freed < memoryToFree )
+    {
+        AllocatedPixmap * p = searchLowestPriorityPixmap( false, true, nullptr, false );
+        if ( !p )
+            break;
+
+        qCDebug(OkularCoreDebug).nospace() << "Evicting background pixmap observer=" << p->observer << " page=" << p->page;
+
+        m_allocatedPixmapsTotalMemory -= p->memory;
+        freed += p->memory;
+        m_pagesVector.at( p->page )->deletePixmap( p->observer );
+        delete p;
+        m_pixmapsFreedInBackground = true;
+    }
+    return freed;
+}
+
+// show a placeholder only for renders expected to take longer than this (ms)
+static const double kPlaceholderRenderTime = 250.0;
+
+PixmapRequest * DocumentPrivate::createPlaceholderRequest( const PixmapRequest *request ) const
+{
+    // placeholders make sense only for real requests rendered in a thread,
+    // tiled pages already show their lower resolution tiles meanwhile
+    if ( request->preload() || !request->asynchronous() || request->isTile() || request->d->mPlaceholder
+         || !m_generator->hasFeature( Generator::Threaded ) || request->page()->hasTilesManager( request->observer() ) )
+        return nullptr;
+
+    const double megapixels = (double)request->width() * request->height() / 1000000.0;
+    const double renderTime = m_pixmapRenderCosts.value( request->pageNumber(), m_averagePixmapRenderCost ) * megapixels;
+    if ( renderTime < kPlaceholderRenderTime )
+        return nullptr;
+
+    // the constructor takes device independent pixels, and scales them down
+    const qreal dpr = qApp->devicePixelRatio();
+    PixmapRequest *placeholder = new PixmapRequest( request->observer(), request->pageNumber(), qRound( request->width() / dpr ), qRound( request->height() / dpr ),
+                                                    request->priority(), PixmapRequest::Asynchronous | PixmapRequest::Placeholder );
+    placeholder->d->mPage = request->page();
+    if ( hasPixmapForPlaceholder( placeholder ) )
+    {
+        delete placeholder;
+        return nullptr;
+    }
+    return placeholder;
+}
+
+bool DocumentPrivate::hasPixmapForPlaceholder( const PixmapRequest *placeholder ) const
+{
+    // anything at least as detailed as the placeholder is shown instead of it,
+    // so rendering the placeholder would only evict a better pixmap
+    if ( placeholder->page()->hasTilesManager( placeholder->observer() ) )
+        return true;
+
+    const QPixmap *pixmap = placeholder->page()->_o_nearestPixmap( placeholder->observer(), placeholder->width(), placeholder->height() );
+    return pixmap && pixmap->width() >= placeholder->width();
+}
+
+// the cached files of the documents not opened for this long are removed
+static const int kCacheMaxAgeDays = 30;
+
+QString DocumentPrivate::documentCacheKey()
+{
+    if ( m_documentCacheKey.isEmpty() )
+    {
+        // the documents opened without url, like the ones of the batch
+        // conversions, are not remembered, in the caches either
+        const QFileInfo fileInfo( m_docFileName );
+        if ( m_url.isEmpty() || m_docFileName.isEmpty() || !fileInfo.exists() )
+            return QString();
+
+        // the same file, modified, gets a new key
+        QCryptographicHash hash( QCryptographicHash::Sha1 );
+        hash.addData( m_url.toString().toUtf8() );
+        hash.addData( QByteArray::number( m_docSize ) );
+        hash.addData( QByteArray::number( fileInfo.lastModified().toMSecsSinceEpoch() ) );
+        m_documentCacheKey = QString::fromLatin1( hash.result().toHex() );
+    }
+
+    return m_documentCacheKey;
+}
+
+bool DocumentPrivate::canCacheContents() const
+{
+    // what is behind a password must not end up readable on disk
+    return m_generator && !m_openedWithPassword && !m_generator->metaData( QStringLiteral( "DocumentEncrypted" ), QVariant() ).toBool();
+}
+
+QByteArray DocumentPrivate::pageCacheRevision( int page ) const
+{
+    const Page *p = m_pagesVector.value( page );
+    if ( !p || ( !p->hasAnnotations() && p->formFields().isEmpty() ) )
+        return QByteArray();
+
+    // the annotations and the form fields are drawn in the thumbnails, so
+    // their state, whether from this session or from the docdata, is a part
+    // of the key
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    QDomDocument doc;
+    QDomElement annotationsElement = doc.createElement( QStringLiteral( "annotationList" ) );
+    foreach ( const Annotation *annotation, p->annotations() )
+        AnnotationUtils::storeAnnotation( annotation, annotationsElement, doc );
+    hash.addData( doc.toByteArray( -1 ) );
+
+    foreach ( const FormField *field, p->formFields() )
+    {
+        hash.addData( QByteArray::number( field->id() ) );
+        switch ( field->type() )
+        {
+            case FormField::FormButton:
+                hash.addData( static_cast< const FormFieldButton * >( field )->state() ? "1" : "0" );
+                break;
+            case FormField::FormText:
+                hash.addData( static_cast< const FormFieldText * >( field )->text().toUtf8() );
+                break;
+            case FormField::FormChoice:
+            {
+                const FormFieldChoice *choice = static_cast< const FormFieldChoice * >( field );
+                foreach ( int index, choice->currentChoices() )
+                    hash.addData( QByteArray::number( index ) + ',' );
+                hash.addData( choice->editChoice().toUtf8() );
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return hash.result().toHex().left( 16 );
+}
+
+QString DocumentPrivate::thumbnailCachePath( int page )
+{
+    if ( m_thumbnailCacheDir.isEmpty() )
+    {
+        const QString key = documentCacheKey();
+        if ( key.isEmpty() || !canCacheContents() )
+            return QString();
+
+        m_thumbnailCacheDir = QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation )
+            + QStringLiteral( "/okular/thumbnails/" ) + key;
+        DiskCache::markUsed( m_thumbnailCacheDir, kCacheMaxAgeDays );
+    }
+
+    const QByteArray revision = pageCacheRevision( page );
+    QString fileName = m_thumbnailCacheDir + QLatin1Char( '/' ) + QString::number( page );
+    if ( !revision.isEmpty() )
+        fileName += QLatin1Char( '-' ) + QString::fromLatin1( revision );
+    return fileName + QStringLiteral( ".png" );
+}
+
+QString DocumentPrivate::textPageCachePath( int page )
+{
+    if ( m_textPageCacheDir.isEmpty() )
+    {
+        const QString key = documentCacheKey();
+        if ( key.isEmpty() || !canCacheContents() )
+            return QString();
+
+        m_textPageCacheDir = QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation )
+            + QStringLiteral( "/okular/textpages/" ) + key;
+        DiskCache::markUsed( m_textPageCacheDir, kCacheMaxAgeDays );
+    }
+
+    return m_textPageCacheDir + QLatin1Char( '/' ) + QString::number( page );
+}
+
+void DocumentPrivate::saveThumbnail( const PixmapRequest *request )
+{
+    // rotated pixmaps are set asynchronously; only the images rendered at
+    // the requested size are worth keeping, not the ones read from the
+    // cache or scaled up
+    if ( m_rotation != Rotation0 || request->d->mCachePath.isEmpty() || !request->d->mCacheable )
+        return;
+
+    const QPixmap *pixmap = request->page()->d->m_pixmaps.value( request->observer() ).m_pixmap;
+    if ( !pixmap )
+        return;
+
+    // encoding the PNG takes longer than rendering a thumbnail, and the
+    // file may be there already
+    DiskCache::saveImage( request->d->mCachePath, pixmap->toImage() );
+}
+
+void DocumentPrivate::recordPixmapRenderTime( const PixmapRequest *request )
+{
+    if ( request->isTile() || request->d->mRenderTime < 0 )
+        return;
+
+    const double megapixels = (double)request->width() * request->height() / 1000000.0;
+    if ( megapixels <= 0 )
+        return;
+
+    const double cost = request->d->mRenderTime / megapixels;
+    m_pixmapRenderCosts.insert( request->pageNumber(), cost );
+    m_averagePixmapRenderCost = m_averagePixmapRenderCost > 0 ? ( m_averagePixmapRenderCost * 3 + cost ) / 4 : cost;
+}
+
 qulonglong DocumentPrivate::getTotalMemory()
 {
     static qulonglong cachedValue = 0;
@@ -405,7 +659,14 @@ qulonglong DocumentPrivate::getTotalMemory()
         QString entry = readStream.readLine();
         if ( entry.isNull() ) break;
         if ( entry.startsWith( QLatin1String("MemTotal:") ) )
-            return (cachedValue = (Q_UINT64_C(1024) * entry.section( QLatin1Char ( ' ' ), -2, -2 ).toULongLong()));
+        {
+            cachedValue = Q_UINT64_C(1024) * entry.section( QLatin1Char ( ' ' ), -2, -2 ).toULongLong();
+            // in a container the host memory is not ours to use
+            const qulonglong cgroupLimit = MemoryMonitor::self()->cgroupLimit();
+            if ( cgroupLimit > 0 && cgroupLimit < cachedValue )
+                cachedValue = cgroupLimit;
+            return cachedValue;
+        }
     }
 #elif defined(Q_OS_FREEBSD)
     qulonglong physmem;
@@ -428,8 +689,11 @@ qulonglong DocumentPrivate::getFreeMemory( qulonglong *freeSwap )
     static QTime lastUpdate = QTime::currentTime().addSecs(-3);
     static qulonglong cachedValue = 0;
     static qulonglong cachedFreeSwap = 0;
+    static int lastPressureEvents = 0;
 
-    if ( qAbs( lastUpdate.secsTo( QTime::currentTime() ) ) <= 2 )
+    // under memory pressure the cached value is stale for sure
+    const int pressureEvents = MemoryMonitor::self()->pressureEvents();
+    if ( qAbs( lastUpdate.secsTo( QTime::currentTime() ) ) <= 2 && pressureEvents == lastPressureEvents )
     {
         if (freeSwap)
             *freeSwap = cachedFreeSwap;
@@ -488,11 +752,19 @@ qulonglong DocumentPrivate::getFreeMemory( qulonglong *freeSwap )
         return 0;
     }
 
+    memoryFree *= Q_UINT64_C(1024);
+    // /proc/meminfo tells about the host, the cgroup may allow much less
+    bool limited = false;
+    const qulonglong cgroupFree = MemoryMonitor::self()->cgroupAvailableMemory( &limited );
+    if ( limited && cgroupFree < memoryFree )
+        memoryFree = cgroupFree;
+
     lastUpdate = QTime::currentTime();
+    lastPressureEvents = pressureEvents;
 
     if (freeSwap)
         *freeSwap = ( cachedFreeSwap = (Q_UINT64_C(1024) * values[3]) );
-    return ( cachedValue = (Q_UINT64_C(1024) * memoryFree) );
+    return ( cachedValue = memoryFree );
 #elif defined(Q_OS_FREEBSD)
     qulonglong cache, inact, free, psize;
     size_t cachelen, inactlen, freelen, psizelen;
@@ -537,8 +809,90 @@ bool DocumentPrivate::loadDocumentInfo( LoadDocumentInfoFlags loadWhat )
     if ( m_xmlFileName.isEmpty() )
         return false;
 
-    QFile infoFile( m_xmlFileName );
-    return loadDocumentInfo( infoFile, loadWhat );
+    DocumentData data;
+    if ( !data.load( DocumentData::fileNameForXml( m_xmlFileName ), loadWhat & LoadPageInfo ) )
+    {
+        // an XML file is written only by the older versions: import it, the
+        // next save writes the binary one next to it, leaving it for them
+        QFile infoFile( m_xmlFileName );
+        if ( infoFile.exists() )
+            return loadDocumentInfo( infoFile, loadWhat );
+        return false;
+    }
+
+    bool loadedAnything = false;
+    if ( ( loadWhat & LoadPageInfo ) && !data.pageList.isEmpty() )
+    {
+        QDomDocument doc;
+        if ( doc.setContent( data.pageList ) && restorePageList( doc.documentElement() ) )
+        {
+            m_docdataPageList = data.pageList;
+            loadedAnything = true;
+        }
+    }
+
+    if ( loadWhat & LoadGeneralInfo )
+    {
+        if ( !data.history.isEmpty() )
+        {
+            m_viewportHistory.clear();
+            const int current = ( data.currentHistoryIndex >= 0 && data.currentHistoryIndex < data.history.count() ) ? data.currentHistoryIndex : data.history.count() - 1;
+            for ( int i = 0; i < data.history.count(); ++i )
+            {
+                QLinkedList< DocumentViewport >::iterator it = m_viewportHistory.insert( m_viewportHistory.end(), DocumentViewport( data.history.at( i ) ) );
+                if ( i == current )
+                    m_viewportIterator = it;
+            }
+            loadedAnything = true;
+        }
+
+        const int newrotation = data.rotation % 4;
+        if ( newrotation != 0 )
+        {
+            setRotationInternal( newrotation, false );
+            loadedAnything = true;
+        }
+
+        for ( const DocumentData::ViewInfo &viewInfo : qAsConst( data.views ) )
+        {
+            Q_FOREACH ( View * view, m_views )
+            {
+                if ( view->name() == viewInfo.name )
+                {
+                    restoreViewZoom( view, viewInfo.zoom, viewInfo.zoomMode );
+                    loadedAnything = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    return loadedAnything;
+}
+
+bool DocumentPrivate::restorePageList( const QDomElement &pageList )
+{
+    bool loadedAnything = false;
+    QDomNode pageNode = pageList.firstChild();
+    while ( pageNode.isElement() )
+    {
+        QDomElement pageElement = pageNode.toElement();
+        if ( pageElement.hasAttribute( QStringLiteral("number") ) )
+        {
+            // get page number (node's attribute)
+            bool ok;
+            int pageNumber = pageElement.attribute( QStringLiteral("number") ).toInt( &ok );
+
+            // pass the domElement to the right page, to read config data from
+            if ( ok && pageNumber >= 0 && pageNumber < (int)m_pagesVector.count() )
+            {
+                if ( m_pagesVector[ pageNumber ]->d->restoreLocalContents( pageElement ) )
+                    loadedAnything = true;
+            }
+        }
+        pageNode = pageNode.nextSibling();
+    }
+    return loadedAnything;
 }
 
 bool DocumentPrivate::loadDocumentInfo( QFile &infoFile, LoadDocumentInfoFlags loadWhat )
@@ -573,24 +927,13 @@ bool DocumentPrivate::loadDocumentInfo( QFile &infoFile, LoadDocumentInfoFlags l
         // Restore page attributes (bookmark, annotations, ...) from the DOM
         if ( catName == QLatin1String("pageList") && ( loadWhat & LoadPageInfo ) )
         {
-            QDomNode pageNode = topLevelNode.firstChild();
-            while ( pageNode.isElement() )
+            if ( restorePageList( topLevelNode.toElement() ) )
             {
-                QDomElement pageElement = pageNode.toElement();
-                if ( pageElement.hasAttribute( QStringLiteral("number") ) )
-                {
-                    // get page number (node's attribute)
-                    bool ok;
-                    int pageNumber = pageElement.attribute( QStringLiteral("number") ).toInt( &ok );
-
-                    // pass the domElement to the right page, to read config data from
-                    if ( ok && pageNumber >= 0 && pageNumber < (int)m_pagesVector.count() )
-                    {
-                        if ( m_pagesVector[ pageNumber ]->d->restoreLocalContents( pageElement ) )
-                            loadedAnything = true;
-                    }
-                }
-                pageNode = pageNode.nextSibling();
+                // keep it as it is, to save it again until it is migrated
+                QDomDocument pageListDoc;
+                pageListDoc.appendChild( pageListDoc.importNode( topLevelNode, true ) );
+                m_docdataPageList = pageListDoc.toByteArray( -1 );
+                loadedAnything = true;
             }
         }
 
@@ -680,47 +1023,48 @@ void DocumentPrivate::loadViewsInfo( View *view, const QDomElement &e )
             const QString valueString = viewElement.attribute( QStringLiteral("value") );
             bool newzoom_ok = true;
             const double newzoom = !valueString.isEmpty() ? valueString.toDouble( &newzoom_ok ) : 1.0;
-            if ( newzoom_ok && newzoom != 0
-                 && view->supportsCapability( View::Zoom )
-                 && ( view->capabilityFlags( View::Zoom ) & ( View::CapabilityRead | View::CapabilitySerializable ) ) )
-            {
-                view->setCapability( View::Zoom, newzoom );
-            }
             const QString modeString = viewElement.attribute( QStringLiteral("mode") );
             bool newmode_ok = true;
             const int newmode = !modeString.isEmpty() ? modeString.toInt( &newmode_ok ) : 2;
-            if ( newmode_ok
-                 && view->supportsCapability( View::ZoomModality )
-                 && ( view->capabilityFlags( View::ZoomModality ) & ( View::CapabilityRead | View::CapabilitySerializable ) ) )
-            {
-                view->setCapability( View::ZoomModality, newmode );
-            }
+            restoreViewZoom( view, newzoom_ok ? newzoom : 0, newmode_ok ? newmode : -1 );
         }
 
         viewNode = viewNode.nextSibling();
     }
 }
 
-void DocumentPrivate::saveViewsInfo( View *view, QDomElement &e ) const
+void DocumentPrivate::restoreViewZoom( View *view, double zoom, int mode )
 {
+    if ( zoom > 0
+         && view->supportsCapability( View::Zoom )
+         && ( view->capabilityFlags( View::Zoom ) & ( View::CapabilityRead | View::CapabilitySerializable ) ) )
+    {
+        view->setCapability( View::Zoom, zoom );
+    }
+    if ( mode >= 0
+         && view->supportsCapability( View::ZoomModality )
+         && ( view->capabilityFlags( View::ZoomModality ) & ( View::CapabilityRead | View::CapabilitySerializable ) ) )
+    {
+        view->setCapability( View::ZoomModality, mode );
+    }
+}
+
+void DocumentPrivate::saveViewZoom( View *view, double *zoom, int *mode ) const
+{
+    *zoom = 0;
+    *mode = -1;
     if ( view->supportsCapability( View::Zoom )
          && ( view->capabilityFlags( View::Zoom ) & ( View::CapabilityRead | View::CapabilitySerializable ) )
          && view->supportsCapability( View::ZoomModality )
          && ( view->capabilityFlags( View::ZoomModality ) & ( View::CapabilityRead | View::CapabilitySerializable ) ) )
     {
-        QDomElement zoomEl = e.ownerDocument().createElement( QStringLiteral("zoom") );
-        e.appendChild( zoomEl );
         bool ok = true;
-        const double zoom = view->capability( View::Zoom ).toDouble( &ok );
-        if ( ok && zoom != 0 )
-        {
-            zoomEl.setAttribute( QStringLiteral("value"), QString::number(zoom) );
-        }
-        const int mode = view->capability( View::ZoomModality ).toInt( &ok );
+        const double viewZoom = view->capability( View::Zoom ).toDouble( &ok );
+        if ( ok && viewZoom > 0 )
+            *zoom = viewZoom;
+        const int viewMode = view->capability( View::ZoomModality ).toInt( &ok );
         if ( ok )
-        {
-            zoomEl.setAttribute( QStringLiteral("mode"), mode );
-        }
+            *mode = viewMode;
     }
 }
 
@@ -919,6 +1263,10 @@ Document::OpenResult DocumentPrivate::openDocumentInternal( const KPluginMetaDat
         if ( openResult == Document::OpenSuccess )
             openResult = Document::OpenError;
     }
+    else
+    {
+        m_openedWithPassword = !password.isEmpty();
+    }
 
     return openResult;
 }
@@ -989,7 +1337,7 @@ void DocumentPrivate::performAddPageAnnotation( int page, Annotation * annotatio
         proxy->notifyAddition( annotation, page );
 
     // notify observers about the change
-    notifyAnnotationChanges( page );
+    notifyAnnotationChange( page, annotation, DocumentObserver::AnnotationAdded );
 
     if ( annotation->flags() & Annotation::ExternallyDrawn )
     {
@@ -1021,10 +1369,12 @@ void DocumentPrivate::performRemovePageAnnotation( int page, Annotation * annota
         if ( proxy && proxy->supports(AnnotationProxy::Removal) )
             proxy->notifyRemoval( annotation, page );
 
-        kp->removeAnnotation( annotation ); // Also destroys the object
+        // the annotation is not destroyed, the undo stack keeps it for
+        // adding it back
+        kp->removeAnnotation( annotation );
 
         // in case of success, notify observers about the change
-        notifyAnnotationChanges( page );
+        notifyAnnotationChange( page, annotation, DocumentObserver::AnnotationRemoved );
 
         if ( isExternallyDrawn )
         {
@@ -1050,8 +1400,11 @@ void DocumentPrivate::performModifyPageAnnotation( int page, Annotation * annota
         proxy->notifyModification( annotation, page, appearanceChanged );
     }
 
+    // drop the cached renderings of the annotation
+    annotation->d_ptr->appearanceChanged();
+
     // notify observers about the change
-    notifyAnnotationChanges( page );
+    notifyAnnotationChange( page, annotation, DocumentObserver::AnnotationModified );
     if ( appearanceChanged && (annotation->flags() & Annotation::ExternallyDrawn) )
     {
         /* When an annotation is being moved, the generator will not render it.
@@ -1110,117 +1463,176 @@ void DocumentPrivate::performSetAnnotationContents( const QString & newContents,
     performModifyPageAnnotation( pageNumber,  annot, appearanceChanged );
 }
 
-void DocumentPrivate::recalculateForms()
+void DocumentPrivate::buildFormLookup()
+{
+    m_formFieldsById.clear();
+    m_formFieldsByName.clear();
+    foreach ( Page *page, m_pagesVector )
+    {
+        foreach ( FormField *form, page->formFields() )
+        {
+            const FormFieldEntry entry = { form, page };
+            m_formFieldsById.insert( form->id(), entry );
+            // getField() returns the first field with a given name
+            if ( !m_formFieldsByName.contains( form->name() ) )
+                m_formFieldsByName.insert( form->name(), entry );
+        }
+    }
+    m_formLookupBuilt = true;
+}
+
+void DocumentPrivate::clearFormLookup()
+{
+    m_formFieldsById.clear();
+    m_formFieldsByName.clear();
+    m_formLookupBuilt = false;
+    m_formCalculateInputs.clear();
+}
+
+FormField *DocumentPrivate::formFieldByName( const QString &name, Page **page )
+{
+    if ( !m_formLookupBuilt )
+        buildFormLookup();
+
+    const QHash< QString, FormFieldEntry >::const_iterator it = m_formFieldsByName.constFind( name );
+    if ( it == m_formFieldsByName.constEnd() )
+        return nullptr;
+
+    if ( page )
+        *page = it->page;
+    return it->field;
+}
+
+void DocumentPrivate::recordFormFieldRead( const QString &name )
+{
+    if ( m_formReadRecorder )
+        m_formReadRecorder->insert( name );
+}
+
+void DocumentPrivate::recordFormFieldWrite( const FormField *field )
+{
+    if ( m_formWriteRecorder )
+        m_formWriteRecorder->insert( field->name() );
+}
+
+void DocumentPrivate::recalculateForms( const QStringList &changedFields )
 {
     const QVariant fco = m_parent->metaData(QLatin1String("FormCalculateOrder"));
     const QVector<int> formCalculateOrder = fco.value<QVector<int>>();
+    if ( formCalculateOrder.isEmpty() )
+        return;
+
+    if ( !m_formLookupBuilt )
+        buildFormLookup();
+
+    // Without a list of changed fields everything is recalculated, otherwise
+    // only the fields that read a changed field the last time they were
+    // calculated; every field that changes on the way dirties its readers
+    // further down the calculate order.
+    const bool recalculateAll = changedFields.isEmpty();
+    QSet< QString > dirtyFields = changedFields.toSet();
+    QSet< int > pagesToRefresh;
+
+    // all the calculate scripts of this pass run as one batch
+    if ( !m_scripter )
+        m_scripter = new Scripter( this );
+    m_scripter->beginBatch();
+
     foreach(int formId, formCalculateOrder) {
-        for ( uint pageIdx = 0; pageIdx  < m_parent->pages(); pageIdx++ )
+        const QHash< int, FormFieldEntry >::const_iterator it = m_formFieldsById.constFind( formId );
+        if ( it == m_formFieldsById.constEnd() )
+            continue;
+
+        FormField *form = it->field;
+        Page *page = it->page;
+
+        // a calculation that read no field through getField() gets its
+        // inputs some other way, so it is always redone
+        const QHash< int, QSet< QString > >::const_iterator inputsIt = m_formCalculateInputs.constFind( formId );
+        if ( !recalculateAll && inputsIt != m_formCalculateInputs.constEnd() && !inputsIt->isEmpty() && !inputsIt->intersects( dirtyFields ) )
+            continue;
+
+        Action *action = form->additionalAction( FormField::CalculateField );
+        if (action)
         {
-            const Page *p = m_parent->page( pageIdx );
-            if (p)
+            FormFieldText *fft = dynamic_cast< FormFieldText * >( form );
+            std::shared_ptr<Event> event;
+            QString oldVal;
+            if ( fft )
             {
-                bool pageNeedsRefresh = false;
-                foreach( FormField *form, p->formFields() )
-                {
-                    if ( form->id() == formId ) {
-                        Action *action = form->additionalAction( FormField::CalculateField );
-                        if (action)
-                        {
-                            FormFieldText *fft = dynamic_cast< FormFieldText * >( form );
-                            std::shared_ptr<Event> event;
-                            QString oldVal;
-                            if ( fft )
-                            {
-                                // Pepare text calculate event
-                                event = Event::createFormCalculateEvent( fft, m_pagesVector[pageIdx] );
-                                if ( !m_scripter )
-                                    m_scripter = new Scripter( this );
-                                m_scripter->setEvent( event.get() );
-                                // The value maybe changed in javascript so save it first.
-                                oldVal = fft->text();
-                            }
+                // Pepare text calculate event
+                event = Event::createFormCalculateEvent( fft, page );
+                m_scripter->setEvent( event.get() );
+                // The value maybe changed in javascript so save it first.
+                oldVal = fft->text();
+            }
 
-                            m_parent->processAction( action );
-                            if ( event && fft )
-                            {
-                                // Update text field from calculate
-                                m_scripter->setEvent( nullptr );
-                                const QString newVal = event->value().toString();
-                                if ( newVal != oldVal )
-                                {
-                                    fft->setText( newVal );
-                                    emit m_parent->refreshFormWidget( fft );
-                                    pageNeedsRefresh = true;
-                                }
-                            }
-                        }
-                        else
-                        {
-                            qWarning() << "Form that is part of calculate order doesn't have a calculate action";
-                        }
-                    }
-                }
-                if ( pageNeedsRefresh )
+            // Record what the calculation reads, so it is only redone when
+            // one of those fields changes
+            QSet< QString > inputs;
+            QSet< QString > *prevReadRecorder = m_formReadRecorder;
+            QSet< QString > *prevWriteRecorder = m_formWriteRecorder;
+            m_formReadRecorder = &inputs;
+            m_formWriteRecorder = &dirtyFields;
+            m_parent->processAction( action );
+            m_formReadRecorder = prevReadRecorder;
+            m_formWriteRecorder = prevWriteRecorder;
+            m_formCalculateInputs.insert( formId, inputs );
+
+            if ( event && fft )
+            {
+                // Update text field from calculate
+                m_scripter->setEvent( nullptr );
+                const QString newVal = event->value().toString();
+                if ( newVal != oldVal )
                 {
-                    refreshPixmaps( p->number() );
+                    fft->setText( newVal );
+                    emit m_parent->refreshFormWidget( fft );
+                    pagesToRefresh.insert( page->number() );
+                    dirtyFields.insert( fft->name() );
                 }
             }
         }
+        else
+        {
+            qWarning() << "Form that is part of calculate order doesn't have a calculate action";
+        }
+    }
+
+    m_scripter->endBatch();
+
+    foreach ( int pageNumber, pagesToRefresh )
+    {
+        refreshPixmaps( pageNumber );
     }
 }
 
 void DocumentPrivate::saveDocumentInfo() const
+{
+    saveDocumentInfo( false );
+}
+
+void DocumentPrivate::saveDocumentInfo( bool asynchronous ) const
 {
     if ( m_xmlFileName.isEmpty() )
         return;
 
-    QFile infoFile( m_xmlFileName );
-    qCDebug(OkularCoreDebug) << "About to save document info to" << m_xmlFileName;
-    if (!infoFile.open( QIODevice::WriteOnly | QIODevice::Truncate))
-    {
-        qCWarning(OkularCoreDebug) << "Failed to open docdata file" << m_xmlFileName;
-        return;
-    }
-    // 1. Create DOM
-    QDomDocument doc( QStringLiteral("documentInfo") );
-    QDomProcessingInstruction xmlPi = doc.createProcessingInstruction(
-            QStringLiteral( "xml" ), QStringLiteral( "version=\"1.0\" encoding=\"utf-8\"" ) );
-    doc.appendChild( xmlPi );
-    QDomElement root = doc.createElement( QStringLiteral("documentInfo") );
-    root.setAttribute( QStringLiteral("url"), m_url.toDisplayString(QUrl::PreferLocalFile) );
-    doc.appendChild( root );
+    qCDebug(OkularCoreDebug) << "About to save document info to" << DocumentData::fileNameForXml( m_xmlFileName );
+    DocumentData data;
+    data.url = m_url.toDisplayString(QUrl::PreferLocalFile);
 
-    // 2.1. Save page attributes (bookmark state, annotations, ... ) to DOM
-    //  -> do this if there are not-yet-migrated annots or forms in docdata/
+    // 1. Save page attributes (bookmark state, annotations, ... )
+    //  -> do this if there are not-yet-migrated annots or forms in docdata/;
+    // we don't store annotations and forms in docdata/ any more, they are
+    // kept only to preserve the ones that previous Okular versions had
+    // stored there, so they are saved as they were read when the file was
+    // opened, ignoring any change made by the user
     if ( m_docdataMigrationNeeded )
-    {
-        QDomElement pageList = doc.createElement( "pageList" );
-        root.appendChild( pageList );
-        // OriginalAnnotationPageItems and OriginalFormFieldPageItems tell to
-        // store the same unmodified annotation list and form contents that we
-        // read when we opened the file and ignore any change made by the user.
-        // Since we don't store annotations and forms in docdata/ any more, this is
-        // necessary to preserve annotations/forms that previous Okular version
-        // had stored there.
-        const PageItems saveWhat = AllPageItems | OriginalAnnotationPageItems | OriginalFormFieldPageItems;
-        // <page list><page number='x'>.... </page> save pages that hold data
-        QVector< Page * >::const_iterator pIt = m_pagesVector.constBegin(), pEnd = m_pagesVector.constEnd();
-        for ( ; pIt != pEnd; ++pIt )
-            (*pIt)->d->saveLocalContents( pageList, doc, saveWhat );
-    }
+        data.pageList = m_docdataPageList;
 
-    // 2.2. Save document info (current viewport, history, ... ) to DOM
-    QDomElement generalInfo = doc.createElement( QStringLiteral("generalInfo") );
-    root.appendChild( generalInfo );
-    // create rotation node
-    if ( m_rotation != Rotation0 )
-    {
-        QDomElement rotationNode = doc.createElement( QStringLiteral("rotation") );
-        generalInfo.appendChild( rotationNode );
-        rotationNode.appendChild( doc.createTextNode( QString::number( (int)m_rotation ) ) );
-    }
-    // <general info><history> ... </history> save history up to OKULAR_HISTORY_SAVEDSTEPS viewports
+    // 2. Save document info (current viewport, history, ... )
+    data.rotation = m_rotation;
+    // save history up to OKULAR_HISTORY_SAVEDSTEPS viewports
     QLinkedList< DocumentViewport >::const_iterator backIterator = m_viewportIterator;
     if ( backIterator != m_viewportHistory.constEnd() )
     {
@@ -1229,46 +1641,33 @@ void DocumentPrivate::saveDocumentInfo() const
         while ( backSteps-- && backIterator != m_viewportHistory.constBegin() )
             --backIterator;
 
-        // create history root node
-        QDomElement historyNode = doc.createElement( QStringLiteral("history") );
-        generalInfo.appendChild( historyNode );
-
         // add old[backIterator] and present[viewportIterator] items
         QLinkedList< DocumentViewport >::const_iterator endIt = m_viewportIterator;
         ++endIt;
         while ( backIterator != endIt )
         {
-            QString name = (backIterator == m_viewportIterator) ? QStringLiteral ("current") : QStringLiteral ("oldPage");
-            QDomElement historyEntry = doc.createElement( name );
-            historyEntry.setAttribute( QStringLiteral("viewport"), (*backIterator).toString() );
-            historyNode.appendChild( historyEntry );
+            data.history.append( (*backIterator).toString() );
             ++backIterator;
         }
+        data.currentHistoryIndex = data.history.count() - 1;
     }
-    // create views root node
-    QDomElement viewsNode = doc.createElement( QStringLiteral("views") );
-    generalInfo.appendChild( viewsNode );
     Q_FOREACH ( View * view, m_views )
     {
-        QDomElement viewEntry = doc.createElement( QStringLiteral("view") );
-        viewEntry.setAttribute( QStringLiteral("name"), view->name() );
-        viewsNode.appendChild( viewEntry );
-        saveViewsInfo( view, viewEntry );
+        DocumentData::ViewInfo viewInfo;
+        viewInfo.name = view->name();
+        saveViewZoom( view, &viewInfo.zoom, &viewInfo.zoomMode );
+        data.views.append( viewInfo );
     }
 
-    // 3. Save DOM to XML file
-    QString xml = doc.toString();
-    QTextStream os( &infoFile );
-    os.setCodec( "UTF-8" );
-    os << xml;
-    infoFile.close();
+    // 3. Write it; the XML file of the older versions is left as it is
+    data.save( DocumentData::fileNameForXml( m_xmlFileName ), asynchronous );
 }
 
 void DocumentPrivate::slotTimedMemoryCheck()
 {
     // [MEM] clean memory (for 'free mem dependant' profiles only)
     if ( SettingsCore::memoryLevel() != SettingsCore::EnumMemoryLevel::Low &&
-         m_allocatedPixmapsTotalMemory > 1024*1024 )
+         processPixmapsTotalMemory() > 1024*1024 )
         cleanupPixmapMemory();
 }
 
@@ -1277,8 +1676,9 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
     /* If the pixmap cache will have to be cleaned in order to make room for the
      * next request, get the distance from the current viewport of the page
      * whose pixmap will be removed. We will ignore preload requests for pages
-     * that are at the same distance or farther */
-    const qulonglong memoryToFree = calculateMemoryToFree();
+     * that are at the same distance or farther. The documents that are not
+     * active make room first */
+    const qulonglong memoryToFree = freeBackgroundDocumentsMemory( calculateMemoryToFree() );
     const int currentViewportPage = (*m_viewportIterator).pageNumber;
     int maxDistance = INT_MAX; // Default: No maximum
     if ( memoryToFree )
@@ -1309,6 +1709,12 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
             m_pixmapRequestsStack.pop_back();
             delete r;
         }
+        // drop placeholders once something as good is there for the page
+        else if ( r->d->mPlaceholder && hasPixmapForPlaceholder( r ) )
+        {
+            m_pixmapRequestsStack.pop_back();
+            delete r;
+        }
         // request only if page isn't already present and request has valid id
         // request only if page isn't already present and request has valid id
         else if ( ( !r->d->mForce && r->page()->hasPixmap( r->observer(), r->width(), r->height(), r->normalizedRect() ) ) || !m_observers.contains(r->observer()) )
@@ -1329,7 +1735,7 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
             delete r;
         }
         // If the requested area is above 8000000 pixels, switch on the tile manager
-        else if ( !tilesManager && m_generator->hasFeature( Generator::TiledRendering ) && (long)r->width() * (long)r->height() > 8000000L )
+        else if ( !tilesManager && m_generator->hasFeature( Generator::TiledRendering ) && !( r->d->mFeatures & PixmapRequest::NoTiles ) && (long)r->width() * (long)r->height() > 8000000L )
         {
             // if the image is too big. start using tiles
             qCDebug(OkularCoreDebug).nospace() << "Start using tiles on page " << r->pageNumber()
@@ -1429,7 +1835,8 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
     else
         pixmapBytes = 4 * request->width() * request->height();
 
-    if ( pixmapBytes > (1024 * 1024) )
+    // placeholders are small and short lived, they must not evict real pixmaps
+    if ( pixmapBytes > (1024 * 1024) && !request->d->mPlaceholder )
         cleanupPixmapMemory( memoryToFree /* previously calculated value */ );
 
     // submit the request to the generator
@@ -1460,6 +1867,8 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
         // we can not really know if the generator can do async requests
         m_executingPixmapRequests.push_back( request );
         m_pixmapRequestsMutex.unlock();
+        if ( Tracer::isEnabled() && request->d->mQueuedTime >= 0 )
+            Tracer::async( "queued", "pixmap", request->d->mTraceId, request->d->mQueuedTime, Tracer::now(), request->pageNumber() );
         m_generator->generatePixmap( request );
     }
     else
@@ -1622,10 +2031,56 @@ void DocumentPrivate::_o_configChanged()
     }
 }
 
+void DocumentPrivate::updateSearchCandidatePages( RunningSearch *search )
+{
+    search->candidatePages.clear();
+
+    if ( !m_generator->hasFeature( Generator::SearchIndex ) )
+        return;
+
+    QStringList terms;
+    if ( search->cachedType == Document::GoogleAll || search->cachedType == Document::GoogleAny )
+        terms = search->cachedString.split( QLatin1Char ( ' ' ), QString::SkipEmptyParts );
+    else
+        terms << search->cachedString;
+
+    if ( terms.isEmpty() )
+        return;
+
+    // a page is a candidate if it may contain all the terms (GoogleAll) or any of them
+    const bool matchAll = search->cachedType != Document::GoogleAny;
+    QBitArray candidates( m_pagesVector.count(), matchAll );
+    foreach ( const QString &term, terms )
+    {
+        QVector< int > pages;
+        if ( !m_generator->pagesContainingText( term, search->cachedCaseSensitivity, &pages ) )
+            return;
+
+        QBitArray termPages( m_pagesVector.count() );
+        foreach ( int page, pages )
+        {
+            if ( page >= 0 && page < termPages.size() )
+                termPages.setBit( page );
+        }
+        if ( matchAll )
+            candidates &= termPages;
+        else
+            candidates |= termPages;
+    }
+
+    search->candidatePages = candidates;
+}
+
+bool DocumentPrivate::isSearchCandidatePage( const RunningSearch *search, int page ) const
+{
+    return page >= search->candidatePages.size() || search->candidatePages.testBit( page );
+}
+
 void DocumentPrivate::doContinueDirectionMatchSearch(void *doContinueDirectionMatchSearchStruct)
 {
     DoContinueDirectionMatchSearchStruct *searchStruct = static_cast<DoContinueDirectionMatchSearchStruct *>(doContinueDirectionMatchSearchStruct);
     RunningSearch *search = m_searches.value(searchStruct->searchID);
+    TraceScope trace( "search", "search", searchStruct->currentPage );
 
     if ((m_searchCancelled && !searchStruct->match) || !search)
     {
@@ -1666,12 +2121,17 @@ void DocumentPrivate::doContinueDirectionMatchSearch(void *doContinueDirectionMa
     {
         // get page
         Page * page = m_pagesVector[ searchStruct->currentPage ];
-        // request search page if needed
-        if ( !page->hasTextPage() )
-            m_parent->requestTextPage( page->number() );
 
-        // if found a match on the current page, end the loop
-        searchStruct->match = page->findText( searchStruct->searchID, search->cachedString, forward ? FromTop : FromBottom, search->cachedCaseSensitivity );
+        // if found a match on the current page, end the loop; pages ruled out
+        // by the generator search index don't need their text extracted
+        if ( isSearchCandidatePage( search, searchStruct->currentPage ) )
+        {
+            // request search page if needed
+            if ( !page->hasTextPage() )
+                m_parent->requestTextPage( page->number() );
+
+            searchStruct->match = page->findText( searchStruct->searchID, search->cachedString, forward ? FromTop : FromBottom, search->cachedCaseSensitivity );
+        }
         if ( !searchStruct->match )
         {
             if (forward) searchStruct->currentPage++;
@@ -1752,6 +2212,7 @@ void DocumentPrivate::doContinueAllDocumentSearch(void *pagesToNotifySet, void *
     QMap< Page *, QVector<RegularAreaRect *> > *pageMatches = static_cast< QMap< Page *, QVector<RegularAreaRect *> > * >(pageMatchesMap);
     QSet< int > *pagesToNotify = static_cast< QSet< int > * >( pagesToNotifySet );
     RunningSearch *search = m_searches.value(searchID);
+    TraceScope trace( "search", "search", currentPage );
 
     if (m_searchCancelled || !search)
     {
@@ -1768,6 +2229,10 @@ void DocumentPrivate::doContinueAllDocumentSearch(void *pagesToNotifySet, void *
         return;
     }
 
+    // skip the pages ruled out by the generator search index
+    while ( currentPage < m_pagesVector.count() && !isSearchCandidatePage( search, currentPage ) )
+        ++currentPage;
+
     if (currentPage < m_pagesVector.count())
     {
         // get page (from the first to the last)
@@ -1840,6 +2305,7 @@ void DocumentPrivate::doContinueGooglesDocumentSearch(void *pagesToNotifySet, vo
     QMap< Page *, QVector<MatchColor> > *pageMatches = static_cast< QMap< Page *, QVector<MatchColor> > * >(pageMatchesMap);
     QSet< int > *pagesToNotify = static_cast< QSet< int > * >( pagesToNotifySet );
     RunningSearch *search = m_searches.value(searchID);
+    TraceScope trace( "search", "search", currentPage );
 
     if (m_searchCancelled || !search)
     {
@@ -1865,6 +2331,10 @@ void DocumentPrivate::doContinueGooglesDocumentSearch(void *pagesToNotifySet, vo
     int baseHue, baseSat, baseVal;
     search->cachedColor.getHsv( &baseHue, &baseSat, &baseVal );
 
+    // skip the pages ruled out by the generator search index
+    while ( currentPage < m_pagesVector.count() && !isSearchCandidatePage( search, currentPage ) )
+        ++currentPage;
+
     if (currentPage < m_pagesVector.count())
     {
         // get page (from the first to the last)
@@ -2040,113 +2510,62 @@ bool DocumentPrivate::isNormalizedRectangleFullyVisible( const Okular::Normalize
     return rectFullyVisible;
 }
 
-struct pdfsyncpoint
+void DocumentPrivate::startSourceReferenceLoading( const QString & docFile )
 {
-    QString file;
-    qlonglong x;
-    qlonglong y;
-    int row;
-    int column;
-    int page;
-};
+    stopSourceReferenceLoading();
+
+    SourceReferenceLoader *loader = new SourceReferenceLoader( docFile );
+    QObject::connect( loader, SIGNAL(finished()), m_parent, SLOT(sourceReferencesLoaded()) );
+    QObject::connect( loader, &SourceReferenceLoader::finished, loader, &QObject::deleteLater );
+    m_sourceReferenceLoader = loader;
+    loader->start();
+}
 
-void DocumentPrivate::loadSyncFile( const QString & filePath )
+void DocumentPrivate::stopSourceReferenceLoading()
 {
-    QFile f( filePath + QLatin1String( "sync" ) );
-    if ( !f.open( QIODevice::ReadOnly ) )
-        return;
+    if ( m_sourceReferenceLoader )
+    {
+        // the parsing cannot be interrupted: just forget about it, the
+        // loader deletes itself (and the data it read) once done
+        QObject::disconnect( m_sourceReferenceLoader, nullptr, m_parent, nullptr );
+        m_sourceReferenceLoader = nullptr;
+    }
+    m_pendingSourceDestination.clear();
+    m_pdfSyncLines.clear();
+}
 
-    QTextStream ts( &f );
-    // first row: core name of the pdf output
-    const QString coreName = ts.readLine();
-    // second row: version string, in the form 'Version %u'
-    QString versionstr = ts.readLine();
-    QRegExp versionre( QStringLiteral("Version (\\d+)") );
-    versionre.setCaseSensitivity( Qt::CaseInsensitive );
-    if ( !versionre.exactMatch( versionstr ) )
+void DocumentPrivate::sourceReferencesLoaded()
+{
+    // stale loaders are disconnected, so this is the current one
+    SourceReferenceLoader *loader = m_sourceReferenceLoader;
+    if ( !loader )
         return;
 
-    QHash<int, pdfsyncpoint> points;
-    QStack<QString> fileStack;
-    int currentpage = -1;
-    const QLatin1String texStr( ".tex" );
-    const QChar spaceChar = QChar::fromLatin1( ' ' );
+    m_sourceReferenceLoader = nullptr;
+    m_synctex_scanner = loader->takeSynctexScanner();
+    if ( !m_synctex_scanner )
+        loadPdfSyncPoints( loader->pdfSyncPoints() );
 
-    fileStack.push( coreName + texStr );
+    // resolve the forward search requested while loading
+    const QString destination = m_pendingSourceDestination;
+    m_pendingSourceDestination.clear();
+    if ( destination.isEmpty() )
+        return;
 
-    const QSizeF dpi = m_generator->dpi();
+    const DocumentViewport viewport( m_parent->metaData( QStringLiteral( "NamedViewport" ), destination ).toString() );
+    if ( viewport.isValid() )
+        m_parent->setViewport( viewport, nullptr, true );
+}
 
-    QString line;
-    while ( !ts.atEnd() )
-    {
-        line = ts.readLine();
-        const QStringList tokens = line.split( spaceChar, QString::SkipEmptyParts );
-        const int tokenSize = tokens.count();
-        if ( tokenSize < 1 )
-            continue;
-        if ( tokens.first() == QLatin1String( "l" ) && tokenSize >= 3 )
-        {
-            int id = tokens.at( 1 ).toInt();
-            QHash<int, pdfsyncpoint>::const_iterator it = points.constFind( id );
-            if ( it == points.constEnd() )
-            {
-                pdfsyncpoint pt;
-                pt.x = 0;
-                pt.y = 0;
-                pt.row = tokens.at( 2 ).toInt();
-                pt.column = 0; // TODO
-                pt.page = -1;
-                pt.file = fileStack.top();
-                points[ id ] = pt;
-            }
-        }
-        else if ( tokens.first() == QLatin1String( "s" ) && tokenSize >= 2 )
-        {
-            currentpage = tokens.at( 1 ).toInt() - 1;
-        }
-        else if ( tokens.first() == QLatin1String( "p*" ) && tokenSize >= 4 )
-        {
-            // TODO
-            qCDebug(OkularCoreDebug) << "PdfSync: 'p*' line ignored";
-        }
-        else if ( tokens.first() == QLatin1String( "p" ) && tokenSize >= 4 )
-        {
-            int id = tokens.at( 1 ).toInt();
-            QHash<int, pdfsyncpoint>::iterator it = points.find( id );
-            if ( it != points.end() )
-            {
-                it->x = tokens.at( 2 ).toInt();
-                it->y = tokens.at( 3 ).toInt();
-                it->page = currentpage;
-            }
-        }
-        else if ( line.startsWith( QLatin1Char( '(' ) ) && tokenSize == 1 )
-        {
-            QString newfile = line;
-            // chop the leading '('
-            newfile.remove( 0, 1 );
-            if ( !newfile.endsWith( texStr ) )
-            {
-                newfile += texStr;
-            }
-            fileStack.push( newfile );
-        }
-        else if ( line == QLatin1String( ")" ) )
-        {
-            if ( !fileStack.isEmpty() )
-            {
-                fileStack.pop();
-            }
-            else
-               qCDebug(OkularCoreDebug) << "PdfSync: going one level down too much";
-        }
-        else
-            qCDebug(OkularCoreDebug).nospace() << "PdfSync: unknown line format: '" << line << "'";
+void DocumentPrivate::loadPdfSyncPoints( const QVector< PdfSyncPoint > & points )
+{
+    if ( points.isEmpty() )
+        return;
 
-    }
+    const QSizeF dpi = m_generator->dpi();
 
     QVector< QLinkedList< Okular::SourceRefObjectRect * > > refRects( m_pagesVector.size() );
-    foreach ( const pdfsyncpoint& pt, points )
+    for ( const PdfSyncPoint &pt : points )
     {
         // drop pdfsync points not completely valid
         if ( pt.page < 0 || pt.page >= m_pagesVector.size() )
@@ -2157,15 +2576,57 @@ void DocumentPrivate::loadSyncFile( const QString & filePath )
             ( pt.x * dpi.width() ) / ( 72.27 * 65536.0 * m_pagesVector[pt.page]->width() ),
             ( pt.y * dpi.height() ) / ( 72.27 * 65536.0 * m_pagesVector[pt.page]->height() )
             );
-        QString file = pt.file;
-        Okular::SourceReference * sourceRef = new Okular::SourceReference( file, pt.row, pt.column );
+        Okular::SourceReference * sourceRef = new Okular::SourceReference( pt.file, pt.row, pt.column );
         refRects[ pt.page ].append( new Okular::SourceRefObjectRect( p, sourceRef ) );
+
+        // index the first position of every source line for forward searches
+        QMap< int, QPair< int, NormalizedPoint > > &lines = m_pdfSyncLines[ pt.file ];
+        if ( !lines.contains( pt.row ) )
+            lines.insert( pt.row, qMakePair( pt.page, p ) );
     }
     for ( int i = 0; i < refRects.size(); ++i )
         if ( !refRects.at(i).isEmpty() )
             m_pagesVector[i]->setSourceReferences( refRects.at(i) );
 }
 
+bool DocumentPrivate::deferSourceReferenceDestination()
+{
+    if ( !m_sourceReferenceLoader || !m_nextDocumentDestination.startsWith( QLatin1String("src:"), Qt::CaseInsensitive ) )
+        return false;
+
+    m_pendingSourceDestination = m_nextDocumentDestination;
+    m_nextDocumentViewport = DocumentViewport();
+    m_nextDocumentDestination = QString();
+    return true;
+}
+
+bool DocumentPrivate::pdfSyncViewport( const QString & fileName, int line, DocumentViewport * viewport ) const
+{
+    QHash< QString, QMap< int, QPair< int, NormalizedPoint > > >::const_iterator fileIt = m_pdfSyncLines.constFind( fileName );
+    if ( fileIt == m_pdfSyncLines.constEnd() )
+    {
+        // pdfsync stores the file names as seen by TeX, usually relative ones
+        const QString baseName = QFileInfo( fileName ).fileName();
+        for ( fileIt = m_pdfSyncLines.constBegin(); fileIt != m_pdfSyncLines.constEnd(); ++fileIt )
+            if ( QFileInfo( fileIt.key() ).fileName() == baseName )
+                break;
+    }
+    if ( fileIt == m_pdfSyncLines.constEnd() || fileIt->isEmpty() )
+        return false;
+
+    // use the first line at or after the requested one, or the last one
+    QMap< int, QPair< int, NormalizedPoint > >::const_iterator lineIt = fileIt->lowerBound( line );
+    if ( lineIt == fileIt->constEnd() )
+        --lineIt;
+
+    viewport->pageNumber = lineIt->first;
+    viewport->rePos.normalizedX = lineIt->second.x;
+    viewport->rePos.normalizedY = lineIt->second.y;
+    viewport->rePos.enabled = true;
+    viewport->rePos.pos = Okular::DocumentViewport::Center;
+    return true;
+}
+
 void DocumentPrivate::clearAndWaitForRequests()
 {
     m_pixmapRequestsMutex.lock();
@@ -2210,8 +2671,11 @@ Document::Document( QWidget *widget )
     d->m_bookmarkManager = new BookmarkManager( d );
     d->m_viewportIterator = d->m_viewportHistory.insert( d->m_viewportHistory.end(), DocumentViewport() );
     d->m_undoStack = new QUndoStack(this);
+    s_documents()->append( d );
 
     connect( SettingsCore::self(), SIGNAL(configChanged()), this, SLOT(_o_configChanged()) );
+    // as configured, not only once the configuration changes
+    Tracer::setEnabledByConfig( SettingsCore::debugTrace() );
     connect(d->m_undoStack, &QUndoStack::canUndoChanged, this, &Document::canUndoChanged);
     connect(d->m_undoStack, &QUndoStack::canRedoChanged, this, &Document::canRedoChanged);
     connect(d->m_undoStack, &QUndoStack::cleanChanged, this, &Document::undoHistoryCleanChanged);
@@ -2223,6 +2687,8 @@ Document::~Document()
 {
     // delete generator, pages, and related stuff
     closeDocument();
+    if ( !s_documents.isDestroyed() )
+        s_documents()->removeAll( d );
 
     QSet< View * >::const_iterator viewIt = d->m_views.constBegin(), viewEnd = d->m_views.constEnd();
     for ( ; viewIt != viewEnd; ++viewIt )
@@ -2259,7 +2725,7 @@ QString DocumentPrivate::docDataFileName(const QUrl &url, qint64 document_size)
     }
     QString newokularfile = docdataDir + QLatin1Char('/') + fn;
     // we don't want to accidentally migrate old files when running unit tests
-    if (!QFile::exists( newokularfile ) && !QStandardPaths::isTestModeEnabled())
+    if (!QFile::exists( newokularfile ) && !QFile::exists( DocumentData::fileNameForXml( newokularfile ) ) && !QStandardPaths::isTestModeEnabled())
     {
         // see if an KDE4 file still exists
         static Kdelibs4Migration k4migration;
@@ -2477,13 +2943,8 @@ Document::OpenResult Document::openDocument(const QString & docFile, const QUrl
         return openResult;
     }
 
-    // no need to check for the existence of a synctex file, no parser will be
-    // created if none exists
-    d->m_synctex_scanner = synctex_scanner_new_with_output_file( QFile::encodeName( docFile ).constData(), nullptr, 1);
-    if ( !d->m_synctex_scanner && QFile::exists(docFile + QLatin1String( "sync" ) ) )
-    {
-        d->loadSyncFile(docFile);
-    }
+    // the synctex/pdfsync data can be big, parse it in a thread
+    d->startSourceReferenceLoading( docFile );
 
     d->m_generatorName = offer.pluginId();
     d->m_pageController = new PageController();
@@ -2495,6 +2956,7 @@ Document::OpenResult Document::openDocument(const QString & docFile, const QUrl
 
     d->m_metadataLoadingCompleted = false;
     d->m_docdataMigrationNeeded = false;
+    d->m_docdataPageList.clear();
 
     // 2. load Additional Data (bookmarks, local annotations and metadata) about the document
     if ( d->m_archiveData )
@@ -2533,24 +2995,37 @@ Document::OpenResult Document::openDocument(const QString & docFile, const QUrl
     if ( !d->m_saveBookmarksTimer )
     {
         d->m_saveBookmarksTimer = new QTimer( this );
-        connect( d->m_saveBookmarksTimer, SIGNAL(timeout()), this, SLOT(saveDocumentInfo()) );
+        // the periodic saves are written in background
+        connect( d->m_saveBookmarksTimer, &QTimer::timeout, this, [this] { d->saveDocumentInfo( true ); } );
     }
     d->m_saveBookmarksTimer->start( 5 * 60 * 1000 );
 
-    // start memory check timer
-    if ( !d->m_memCheckTimer )
+    // start memory check timer, unless the kernel tells when memory is short
+    MemoryMonitor *memoryMonitor = MemoryMonitor::self();
+    if ( memoryMonitor->hasPressureNotifications() )
     {
-        d->m_memCheckTimer = new QTimer( this );
-        connect( d->m_memCheckTimer, SIGNAL(timeout()), this, SLOT(slotTimedMemoryCheck()) );
+        connect( memoryMonitor, SIGNAL(memoryPressure()), this, SLOT(slotTimedMemoryCheck()), Qt::UniqueConnection );
+    }
+    else
+    {
+        if ( !d->m_memCheckTimer )
+        {
+            d->m_memCheckTimer = new QTimer( this );
+            connect( d->m_memCheckTimer, SIGNAL(timeout()), this, SLOT(slotTimedMemoryCheck()) );
+        }
+        d->m_memCheckTimer->start( 2000 );
     }
-    d->m_memCheckTimer->start( 2000 );
 
-    const DocumentViewport nextViewport = d->nextDocumentViewport();
-    if ( nextViewport.isValid() )
+    // a forward search can only be resolved once the source references are loaded
+    if ( !d->deferSourceReferenceDestination() )
     {
-        setViewport( nextViewport );
-        d->m_nextDocumentViewport = DocumentViewport();
-        d->m_nextDocumentDestination = QString();
+        const DocumentViewport nextViewport = d->nextDocumentViewport();
+        if ( nextViewport.isValid() )
+        {
+            setViewport( nextViewport );
+            d->m_nextDocumentViewport = DocumentViewport();
+            d->m_nextDocumentDestination = QString();
+        }
     }
 
     AudioPlayer::instance()->d->m_currentDocument = isstdin ? QUrl() : d->m_url;
@@ -2616,6 +3091,7 @@ void Document::closeDocument()
 
     delete d->m_scripter;
     d->m_scripter = nullptr;
+    d->clearFormLookup();
 
      // remove requests left in queue
     d->clearAndWaitForRequests();
@@ -2637,7 +3113,11 @@ void Document::closeDocument()
         d->saveDocumentInfo();
         d->m_generator->closeDocument();
     }
+    // the asynchronous saves of the document info done while it was open
+    // must not outlive it
+    DocumentData::waitForSaves();
 
+    d->stopSourceReferenceLoading();
     if ( d->m_synctex_scanner )
     {
         synctex_scanner_free( d->m_synctex_scanner );
@@ -2647,6 +3127,7 @@ void Document::closeDocument()
     // stop timers
     if ( d->m_memCheckTimer )
         d->m_memCheckTimer->stop();
+    disconnect( MemoryMonitor::self(), SIGNAL(memoryPressure()), this, SLOT(slotTimedMemoryCheck()) );
     if ( d->m_saveBookmarksTimer )
         d->m_saveBookmarksTimer->stop();
 
@@ -2713,6 +3194,15 @@ void Document::closeDocument()
     d->m_viewportHistory.append( DocumentViewport() );
     d->m_viewportIterator = d->m_viewportHistory.begin();
     d->m_allocatedPixmapsTotalMemory = 0;
+    d->m_pixmapsFreedInBackground = false;
+    d->m_pixmapRenderCosts.clear();
+    d->m_averagePixmapRenderCost = 0;
+    d->m_thumbnailCacheDir.clear();
+    d->m_textPageCacheDir.clear();
+    d->m_documentCacheKey.clear();
+    d->m_openedWithPassword = false;
+    // the thumbnails of the document are on disk once it is closed
+    DiskCache::waitForPending();
     d->m_allocatedTextPagesFifo.clear();
     d->m_pageSize = PageSize();
     d->m_pageSizes.clear();
@@ -2724,6 +3214,7 @@ void Document::closeDocument()
 
     d->m_undoStack->clear();
     d->m_docdataMigrationNeeded = false;
+    d->m_docdataPageList.clear();
 }
 
 void Document::addObserver( DocumentObserver * pObserver )
@@ -2778,6 +3269,8 @@ void Document::removeObserver( DocumentObserver * pObserver )
 
 void Document::reparseConfig()
 {
+    Tracer::setEnabledByConfig( SettingsCore::debugTrace() );
+
     // reparse generator config and if something changed clear Pages
     bool configchanged = false;
     if ( d->m_generator )
@@ -3068,7 +3561,7 @@ QVariant Document::metaData( const QString & key, const QVariant & option ) cons
     // source reference
     if ( key == QLatin1String("NamedViewport")
          && option.toString().startsWith( QLatin1String("src:"), Qt::CaseInsensitive )
-         && d->m_synctex_scanner)
+         && ( d->m_synctex_scanner || !d->m_pdfSyncLines.isEmpty() ) )
     {
         const QString reference = option.toString();
 
@@ -3097,8 +3590,14 @@ QVariant Document::metaData( const QString & key, const QVariant & option ) cons
         int line = lineString.toInt( &ok );
         if (!ok) line = -1;
 
+        if ( !d->m_synctex_scanner )
+        {
+            Okular::DocumentViewport viewport;
+            if ( d->pdfSyncViewport( name, line, &viewport ) )
+                return viewport.toString();
+        }
         // Use column == -1 for now.
-        if( synctex_display_query( d->m_synctex_scanner, QFile::encodeName(name).constData(), line, -1, 0 ) > 0 )
+        else if( synctex_display_query( d->m_synctex_scanner, QFile::encodeName(name).constData(), line, -1, 0 ) > 0 )
         {
             synctex_node_p node;
             // For now use the first hit. Could possibly be made smarter
@@ -3291,6 +3790,8 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
     }
 
     // 1.B [PREPROCESS REQUESTS] tweak some values of the requests
+    QLinkedList< PixmapRequest * > placeholderRequests;
+    QLinkedList< PixmapRequest * > pendingRequests;
     for ( PixmapRequest *request : requests )
     {
         // set the 'page field' (see PixmapRequest) and check if it is valid
@@ -3304,6 +3805,12 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
 
         request->d->mPage = d->m_pagesVector.value( request->pageNumber() );
 
+        // the generator reads the thumbnails saved by a previous session,
+        // if any, instead of rendering them; not in this thread, the disk
+        // may be slow
+        if ( request->isThumbnail() && !request->isTile() )
+            request->d->mCachePath = d->thumbnailCachePath( request->pageNumber() );
+
         if ( request->isTile() )
         {
             // Change the current request rect so that only invalid tiles are
@@ -3330,6 +3837,12 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
 
         if ( !request->asynchronous() )
             request->d->mPriority = 0;
+
+        // for slow pages render a low resolution version first
+        if ( PixmapRequest *placeholder = d->createPlaceholderRequest( request ) )
+            placeholderRequests.prepend( placeholder );
+
+        pendingRequests.append( request );
     }
 
     // 1.C [CANCEL REQUESTS] cancel those requests that are running and should be cancelled because of the new requests coming in
@@ -3339,7 +3852,7 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
         {
             bool newRequestsContainExecutingRequestPage = false;
             bool requestCancelled = false;
-            for ( PixmapRequest *newRequest : requests )
+            for ( PixmapRequest *newRequest : qAsConst( pendingRequests ) )
             {
                 if ( newRequest->pageNumber() == executingRequest->pageNumber() && requesterObserver == executingRequest->observer())
                 {
@@ -3366,8 +3879,12 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
     }
 
     // 2. [ADD TO STACK] add requests to stack
-    for ( PixmapRequest *request : requests )
+    const qint64 queuedTime = Tracer::isEnabled() ? Tracer::now() : -1;
+    for ( PixmapRequest *request : qAsConst( pendingRequests ) )
     {
+        request->d->mQueuedTime = queuedTime;
+        if ( queuedTime >= 0 )
+            request->d->mTraceId = Tracer::newAsyncId();
         // add request to the 'stack' at the right place
         if ( !request->priority() )
             // add priority zero requests to the top of the stack
@@ -3382,6 +3899,9 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
             d->m_pixmapRequestsStack.insert( sIt, request );
         }
     }
+    // placeholders go on top of the stack, they are cheap and will be
+    // replaced by the real pixmaps requested above
+    d->m_pixmapRequestsStack << placeholderRequests;
     d->m_pixmapRequestsMutex.unlock();
 
     // 3. [START FIRST GENERATION] if <NO>generator is ready, start a new generation,
@@ -3395,6 +3915,77 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
         o->notifyContentsCleared( Okular::DocumentObserver::Pixmap );
 }
 
+void Document::cancelPixmapRequests( DocumentObserver *observer )
+{
+    QMutexLocker locker( &d->m_pixmapRequestsMutex );
+    QLinkedList< PixmapRequest * >::iterator sIt = d->m_pixmapRequestsStack.begin();
+    while ( sIt != d->m_pixmapRequestsStack.end() )
+    {
+        if ( (*sIt)->observer() == observer )
+        {
+            delete *sIt;
+            sIt = d->m_pixmapRequestsStack.erase( sIt );
+        }
+        else
+            ++sIt;
+    }
+}
+
+bool Document::hasPixmapRequests( DocumentObserver *observer ) const
+{
+    QMutexLocker locker( &d->m_pixmapRequestsMutex );
+    for ( const PixmapRequest *request : qAsConst( d->m_pixmapRequestsStack ) )
+    {
+        if ( request->observer() == observer )
+            return true;
+    }
+    for ( const PixmapRequest *request : qAsConst( d->m_executingPixmapRequests ) )
+    {
+        if ( request->observer() == observer )
+            return true;
+    }
+    return false;
+}
+
+void Document::setActive( bool active )
+{
+    if ( d->m_active == active )
+        return;
+
+    d->m_active = active;
+    if ( !active )
+        return;
+
+    // now the other documents are in background: enforce the budget on them
+    if ( d->m_generator )
+        d->cleanupPixmapMemory();
+
+    // the pages freed meanwhile in background are on screen again
+    if ( d->m_pixmapsFreedInBackground )
+    {
+        d->m_pixmapsFreedInBackground = false;
+        foreachObserver( notifyContentsCleared( DocumentObserver::Pixmap ) );
+    }
+}
+
+bool Document::isActive() const
+{
+    return d->m_active;
+}
+
+qulonglong Document::pixmapMemory() const
+{
+    return d->m_allocatedPixmapsTotalMemory;
+}
+
+QList< Document * > Document::allDocuments()
+{
+    QList< Document * > documents;
+    foreach ( const DocumentPrivate *doc, *s_documents() )
+        documents.append( doc->m_parent );
+    return documents;
+}
+
 void Document::requestTextPage( uint page )
 {
     Page * kp = d->m_pagesVector[ page ];
@@ -3406,14 +3997,14 @@ void Document::requestTextPage( uint page )
     d->m_generator->generateTextPage( kp );
 }
 
-void DocumentPrivate::notifyAnnotationChanges( int page )
+void DocumentPrivate::notifyAnnotationChange( int page, Annotation *annotation, DocumentObserver::AnnotationChange change )
 {
-    foreachObserverD( notifyPageChanged( page, DocumentObserver::Annotations ) );
+    foreachObserverD( notifyAnnotationChanged( page, annotation, change ) );
 }
 
-void DocumentPrivate::notifyFormChanges( int /*page*/ )
+void DocumentPrivate::notifyFormChanges( int /*page*/, const QStringList &changedFields )
 {
-    recalculateForms();
+    recalculateForms( changedFields );
 }
 
 void Document::addPageAnnotation( int page, Annotation * annotation )
@@ -3766,6 +4357,7 @@ void Document::searchText( int searchID, const QString & text, bool fromStart, Q
 
     // update search structure
     bool newText = text != s->cachedString;
+    const bool newQuery = newText || type != s->cachedType || caseSensitivity != s->cachedCaseSensitivity;
     s->cachedString = text;
     s->cachedType = type;
     s->cachedCaseSensitivity = caseSensitivity;
@@ -3773,6 +4365,10 @@ void Document::searchText( int searchID, const QString & text, bool fromStart, Q
     s->cachedColor = color;
     s->isCurrentlySearching = true;
 
+    // ask the generator search index which pages are worth searching
+    if ( newQuery )
+        d->updateSearchCandidatePages( s );
+
     // global data for search
     QSet< int > *pagesToNotify = new QSet< int >;
 
@@ -3929,8 +4525,6 @@ void Document::editFormText( int pageNumber,
 {
     QUndoCommand *uc = new EditFormTextCommand( this->d, form, pageNumber, newContents, newCursorPos, form->text(), prevCursorPos, prevAnchorPos );
     d->m_undoStack->push( uc );
-
-    d->recalculateForms();
 }
 
 void Document::editFormList( int pageNumber,
@@ -3940,8 +4534,6 @@ void Document::editFormList( int pageNumber,
     const QList< int > prevChoices = form->currentChoices();
     QUndoCommand *uc = new EditFormListCommand( this->d, form, pageNumber, newChoices, prevChoices );
     d->m_undoStack->push( uc );
-
-    d->recalculateForms();
 }
 
 void Document::editFormCombo( int pageNumber,
@@ -3964,8 +4556,6 @@ void Document::editFormCombo( int pageNumber,
 
     QUndoCommand *uc = new EditFormComboCommand( this->d, form, pageNumber, newText, newCursorPos, prevText, prevCursorPos, prevAnchorPos );
     d->m_undoStack->push( uc );
-
-    d->recalculateForms();
 }
 
 void Document::editFormButtons( int pageNumber, const QList< FormFieldButton* >& formButtons, const QList< bool >& newButtonStates )
@@ -4078,6 +4668,9 @@ void Document::processAction( const Action * action )
             }
             else
             {
+                if ( d->deferSourceReferenceDestination() )
+                    return;
+
                 const DocumentViewport nextViewport = d->nextDocumentViewport();
                 // skip local links that point to nowhere (broken ones)
                 if ( !nextViewport.isValid() )
@@ -4528,25 +5121,52 @@ bool Document::canSwapBackingFile() const
 
 bool Document::swapBackingFile( const QString &newFileName, const QUrl &url )
 {
-    if ( !d->m_generator )
+    return d->swapBackingFile( newFileName, url, false );
+}
+
+bool Document::reloadChangedFile()
+{
+    if ( d->m_archiveData || d->m_docFileName.isEmpty() )
+        return false;
+
+    return d->swapBackingFile( d->m_docFileName, d->m_url, true );
+}
+
+bool DocumentPrivate::swapBackingFile( const QString &newFileName, const QUrl &url, bool contentsChanged )
+{
+    if ( !m_generator )
         return false;
 
-    if ( !d->m_generator->hasFeature( Generator::SwapBackingFile ) )
+    if ( !m_generator->hasFeature( Generator::SwapBackingFile ) )
         return false;
 
     // Save metadata about the file we're about to close
-    d->saveDocumentInfo();
+    saveDocumentInfo();
 
-    d->clearAndWaitForRequests();
+    clearAndWaitForRequests();
+
+    // only the pages with pixmaps are worth comparing, the generator knows
+    // their fingerprints from when they were rendered
+    QVector< QByteArray > oldFingerprints( m_pagesVector.count() );
+    if ( contentsChanged )
+    {
+        for ( int i = 0; i < m_pagesVector.count(); ++i )
+        {
+            if ( !m_pagesVector[i]->d->m_pixmaps.isEmpty() || !m_pagesVector[i]->d->m_tilesManagers.isEmpty() )
+                oldFingerprints[i] = m_generator->pageFingerprint( i, false );
+        }
+    }
 
     qCDebug(OkularCoreDebug) << "Swapping backing file to" << newFileName;
     QVector< Page * > newPagesVector;
-    Generator::SwapBackingFileResult result = d->m_generator->swapBackingFile( newFileName, newPagesVector );
+    Generator::SwapBackingFileResult result = m_generator->swapBackingFile( newFileName, newPagesVector );
     if (result != Generator::SwapBackingFileError)
     {
         QLinkedList< ObjectRect* > rectsToDelete;
         QLinkedList< Annotation* > annotationsToDelete;
         QSet< PagePrivate* > pagePrivatesToDelete;
+        QVector< int > pagesToRefresh;
+        bool newLayout = false;
 
         if (result == Generator::SwapBackingFileReloadInternalData)
         {
@@ -4555,14 +5175,14 @@ bool Document::swapBackingFile( const QString &newFileName, const QUrl &url )
             // we have actually closed and opened the file again
 
             // Simple sanity check
-            if (newPagesVector.count() != d->m_pagesVector.count())
+            if (newPagesVector.count() != m_pagesVector.count())
                 return false;
 
             // Update the undo stack contents
-            for (int i = 0; i < d->m_undoStack->count(); ++i)
+            for (int i = 0; i < m_undoStack->count(); ++i)
             {
                 // Trust me on the const_cast ^_^
-                QUndoCommand *uc = const_cast<QUndoCommand *>( d->m_undoStack->command( i ) );
+                QUndoCommand *uc = const_cast<QUndoCommand *>( m_undoStack->command( i ) );
                 if (OkularUndoCommand *ouc = dynamic_cast<OkularUndoCommand*>( uc ))
                 {
                     const bool success = ouc->refreshInternalPageReferences( newPagesVector );
@@ -4579,50 +5199,97 @@ bool Document::swapBackingFile( const QString &newFileName, const QUrl &url )
                 }
             }
 
-            for (int i = 0; i < d->m_pagesVector.count(); ++i)
+            for (int i = 0; i < m_pagesVector.count(); ++i)
             {
                 // switch the PagePrivate* from newPage to oldPage
                 // this way everyone still holding Page* doesn't get
                 // disturbed by it
-                Page *oldPage = d->m_pagesVector[i];
+                Page *oldPage = m_pagesVector[i];
                 Page *newPage = newPagesVector[i];
-                newPage->d->adoptGeneratedContents(oldPage->d);
+                // an empty fingerprint, before or after, means the page may
+                // have changed in a way the generator can't tell
+                bool pageChanged = contentsChanged;
+                if ( pageChanged && !oldFingerprints.at( i ).isEmpty() )
+                {
+                    const QByteArray newFingerprint = m_generator->pageFingerprint( i, true );
+                    pageChanged = newFingerprint.isEmpty() || newFingerprint != oldFingerprints.at( i );
+                }
+                if ( !pageChanged )
+                    newPage->d->adoptGeneratedContents(oldPage->d);
+                else if ( newPage->d->adoptOutdatedContents(oldPage->d) )
+                    pagesToRefresh << i;
+                else
+                {
+                    // the old pixmaps go away with the old page
+                    QLinkedList< AllocatedPixmap * >::iterator aIt = m_allocatedPixmaps.begin();
+                    while ( aIt != m_allocatedPixmaps.end() )
+                    {
+                        if ( (*aIt)->page == i )
+                        {
+                            m_allocatedPixmapsTotalMemory -= (*aIt)->memory;
+                            delete *aIt;
+                            aIt = m_allocatedPixmaps.erase( aIt );
+                        }
+                        else
+                            ++aIt;
+                    }
+                    newLayout = true;
+                }
 
                 pagePrivatesToDelete << oldPage->d;
                 oldPage->d = newPage->d;
                 oldPage->d->m_page = oldPage;
-                oldPage->d->m_doc = d;
+                oldPage->d->m_doc = this;
                 newPage->d = nullptr;
 
                 annotationsToDelete << oldPage->m_annotations;
-                rectsToDelete << oldPage->m_rects;
                 oldPage->m_annotations = newPage->m_annotations;
-                oldPage->m_rects = newPage->m_rects;
+                // generators may create the object rects only when rendering,
+                // so keep the current ones for the pages that won't be rendered again
+                if ( pageChanged || !newPage->m_rects.isEmpty() )
+                {
+                    rectsToDelete << oldPage->m_rects;
+                    oldPage->m_rects = newPage->m_rects;
+                }
+                else
+                {
+                    rectsToDelete << newPage->m_rects;
+                }
             }
             qDeleteAll( newPagesVector );
         }
 
-        d->m_url = url;
-        d->m_docFileName = newFileName;
-        d->updateMetadataXmlNameAndDocSize();
-        d->m_bookmarkManager->setUrl( d->m_url );
+        // the form fields now belong to the new pages
+        clearFormLookup();
 
-        if ( d->m_synctex_scanner )
+        m_url = url;
+        m_docFileName = newFileName;
+        updateMetadataXmlNameAndDocSize();
+        m_thumbnailCacheDir.clear();
+        m_textPageCacheDir.clear();
+        m_documentCacheKey.clear();
+        m_bookmarkManager->setUrl( m_url );
+
+        // reload the source references of the documents having some,
+        // whether synctex ones or pdfsync ones
+        if ( m_synctex_scanner || m_sourceReferenceLoader || !m_pdfSyncLines.isEmpty() )
         {
-            synctex_scanner_free( d->m_synctex_scanner );
-            d->m_synctex_scanner = synctex_scanner_new_with_output_file( QFile::encodeName( newFileName ).constData(), nullptr, 1);
-            if ( !d->m_synctex_scanner && QFile::exists(newFileName + QLatin1String( "sync" ) ) )
-            {
-                d->loadSyncFile(newFileName);
-            }
+            stopSourceReferenceLoading();
+            synctex_scanner_free( m_synctex_scanner );
+            m_synctex_scanner = nullptr;
+            startSourceReferenceLoading( newFileName );
         }
 
-        foreachObserver( notifySetup( d->m_pagesVector, DocumentObserver::UrlChanged ) );
+        const int setupFlags = DocumentObserver::UrlChanged | ( newLayout ? DocumentObserver::NewLayoutForPages : 0 );
+        foreachObserverD( notifySetup( m_pagesVector, setupFlags ) );
 
         qDeleteAll( annotationsToDelete );
         qDeleteAll( rectsToDelete );
         qDeleteAll( pagePrivatesToDelete );
 
+        for ( int page : qAsConst( pagesToRefresh ) )
+            refreshPixmaps( page );
+
         return true;
     }
     else
@@ -5020,6 +5687,7 @@ void Document::docdataMigrationDone()
     if (d->m_docdataMigrationNeeded)
     {
         d->m_docdataMigrationNeeded = false;
+        d->m_docdataPageList.clear();
         foreachObserver( notifySetup( d->m_pagesVector, 0 ) );
     }
 }
@@ -5029,11 +5697,54 @@ QAbstractItemModel * Document::layersModel() const
     return d->m_generator ? d->m_generator->layersModel() : nullptr;
 }
 
+void DocumentPrivate::notifyPixmapReady( PixmapRequest * req )
+{
+    // [MEM] 1.1 find and remove a previous entry for the same page and id
+    QLinkedList< AllocatedPixmap * >::iterator aIt = m_allocatedPixmaps.begin();
+    QLinkedList< AllocatedPixmap * >::iterator aEnd = m_allocatedPixmaps.end();
+    for ( ; aIt != aEnd; ++aIt )
+        if ( (*aIt)->page == req->pageNumber() && (*aIt)->observer == req->observer() )
+        {
+            AllocatedPixmap * p = *aIt;
+            m_allocatedPixmaps.erase( aIt );
+            m_allocatedPixmapsTotalMemory -= p->memory;
+            delete p;
+            break;
+        }
+
+    DocumentObserver *observer = req->observer();
+    if ( m_observers.contains(observer) )
+    {
+        // [MEM] 1.2 append memory allocation descriptor to the FIFO
+        qulonglong memoryBytes = 0;
+        const TilesManager *tm = req->d->tilesManager();
+        if ( tm )
+            memoryBytes = tm->totalMemory();
+        else
+            memoryBytes = 4 * req->width() * req->height();
+
+        AllocatedPixmap * memoryPage = new AllocatedPixmap( req->observer(), req->pageNumber(), memoryBytes, req->isThumbnail() );
+        m_allocatedPixmaps.append( memoryPage );
+        m_allocatedPixmapsTotalMemory += memoryBytes;
+
+        // 2. notify an observer that its pixmap changed
+        observer->notifyPageChanged( req->pageNumber(), DocumentObserver::Pixmap );
+    }
+#ifndef NDEBUG
+    else
+        qCWarning(OkularCoreDebug) << "Receiving a done request for the defunct observer" << observer;
+#endif
+}
+
 void DocumentPrivate::requestDone( PixmapRequest * req )
 {
     if ( !req )
         return;
 
+    TraceScope trace( "requestDone", "pixmap", req->pageNumber() );
+    if ( Tracer::isEnabled() && req->d->mQueuedTime >= 0 )
+        Tracer::async( "request", "pixmap", req->d->mTraceId, req->d->mQueuedTime, Tracer::now(), req->pageNumber() );
+
     if ( !m_generator || m_closingLoop )
     {
         m_pixmapRequestsMutex.lock();
@@ -5052,41 +5763,14 @@ void DocumentPrivate::requestDone( PixmapRequest * req )
 
     if ( !req->shouldAbortRender() )
     {
-        // [MEM] 1.1 find and remove a previous entry for the same page and id
-        QLinkedList< AllocatedPixmap * >::iterator aIt = m_allocatedPixmaps.begin();
-        QLinkedList< AllocatedPixmap * >::iterator aEnd = m_allocatedPixmaps.end();
-        for ( ; aIt != aEnd; ++aIt )
-            if ( (*aIt)->page == req->pageNumber() && (*aIt)->observer == req->observer() )
-            {
-                AllocatedPixmap * p = *aIt;
-                m_allocatedPixmaps.erase( aIt );
-                m_allocatedPixmapsTotalMemory -= p->memory;
-                delete p;
-                break;
-            }
+        if ( !req->d->mPlaceholder )
+            recordPixmapRenderTime( req );
 
-        DocumentObserver *observer = req->observer();
-        if ( m_observers.contains(observer) )
-        {
-            // [MEM] 1.2 append memory allocation descriptor to the FIFO
-            qulonglong memoryBytes = 0;
-            const TilesManager *tm = req->d->tilesManager();
-            if ( tm )
-                memoryBytes = tm->totalMemory();
-            else
-                memoryBytes = 4 * req->width() * req->height();
+        notifyPixmapReady( req );
 
-            AllocatedPixmap * memoryPage = new AllocatedPixmap( req->observer(), req->pageNumber(), memoryBytes );
-            m_allocatedPixmaps.append( memoryPage );
-            m_allocatedPixmapsTotalMemory += memoryBytes;
-
-            // 2. notify an observer that its pixmap changed
-            observer->notifyPageChanged( req->pageNumber(), DocumentObserver::Pixmap );
-        }
-#ifndef NDEBUG
-        else
-            qCWarning(OkularCoreDebug) << "Receiving a done request for the defunct observer" << observer;
-#endif
+        // keep thumbnails for the next time the document is opened
+        if ( req->isThumbnail() )
+            saveThumbnail( req );
     }
 
     // 3. delete request
@@ -488,6 +488,59 @@ class OKULARCORE_EXPORT Document : public QObject
          */
         void requestPixmaps( const QLinkedList<PixmapRequest*> &requests, PixmapRequestFlags reqOptions );
 
+        /**
+         * Removes the pixmap requests of the @p observer that are still
+         * waiting to be generated, for example preloads that are not
+         * needed any more. The request being generated is not affected.
+         *
+         * @since 1.5
+         */
+        void cancelPixmapRequests( DocumentObserver *observer );
+
+        /**
+         * Returns whether pixmap requests of the @p observer are waiting to
+         * be generated, or being generated. A request that the document
+         * dropped, for example because its page does not exist, is neither.
+         *
+         * @since 1.5
+         */
+        bool hasPixmapRequests( DocumentObserver *observer ) const;
+
+        /**
+         * Sets whether the document is the one the user is looking at,
+         * e.g. the current tab of a shell with several tabs.
+         *
+         * All the documents of the process share the pixmap memory budget
+         * given by the memory level; when it is exceeded the documents that
+         * are not active give their pixmaps back first, keeping only the
+         * thumbnails. Documents are active by default.
+         *
+         * @since 1.5
+         */
+        void setActive( bool active );
+
+        /**
+         * Returns whether the document is active.
+         *
+         * @see setActive()
+         * @since 1.5
+         */
+        bool isActive() const;
+
+        /**
+         * Returns the memory, in bytes, used by the pixmaps of the document.
+         *
+         * @since 1.5
+         */
+        qulonglong pixmapMemory() const;
+
+        /**
+         * Returns all the documents of the process, opened or not.
+         *
+         * @since 1.5
+         */
+        static QList< Document * > allDocuments();
+
         /**
          * Sends a request for text page generation for the given page @p number.
          */
@@ -776,6 +829,23 @@ class OKULARCORE_EXPORT Document : public QObject
          */
         bool swapBackingFileArchive( const QString &newFileName, const QUrl &url );
 
+        /**
+         * Reloads the document from its file after it changed on disk,
+         * without closing it.
+         *
+         * The pages whose contents did not change (see
+         * Generator::pageFingerprint) keep their pixmaps, text and object
+         * rects, the others are generated again.
+         *
+         * Returns false if the document cannot be reloaded this way, for
+         * example if the generator does not support swapping the backing
+         * file or the number of pages changed; the document then has to be
+         * closed and opened again.
+         *
+         * @since 1.5
+         */
+        bool reloadChangedFile();
+
         /**
          * Sets the history to be clean
          *
@@ -1220,6 +1290,7 @@ class OKULARCORE_EXPORT Document : public QObject
         Q_PRIVATE_SLOT( d, void rotationFinished( int page, Okular::Page *okularPage ) )
         Q_PRIVATE_SLOT( d, void slotFontReadingProgress( int page ) )
         Q_PRIVATE_SLOT( d, void fontReadingGotFont( const Okular::FontInfo& font ) )
+        Q_PRIVATE_SLOT( d, void sourceReferencesLoaded() )
         Q_PRIVATE_SLOT( d, void slotGeneratorConfigChanged( const QString& ) )
         Q_PRIVATE_SLOT( d, void refreshPixmaps( int ) )
         Q_PRIVATE_SLOT( d, void _o_configChanged() )
@@ -27,6 +27,7 @@
 // local includes
 #include "fontinfo.h"
 #include "generator.h"
+#include "observer.h"
 
 class QUndoStack;
 class QEventLoop;
@@ -43,6 +44,8 @@ namespace Okular {
 class ConfigInterface;
 class PageController;
 class SaveInterface;
+class SourceReferenceLoader;
+struct PdfSyncPoint;
 class Scripter;
 class View;
 }
@@ -91,8 +94,12 @@ class DocumentPrivate
             m_tempFile( nullptr ),
             m_docSize( -1 ),
             m_allocatedPixmapsTotalMemory( 0 ),
+            m_active( true ),
+            m_pixmapsFreedInBackground( false ),
             m_maxAllocatedTextPages( 0 ),
             m_warnedOutOfMemory( false ),
+            m_averagePixmapRenderCost( 0 ),
+            m_openedWithPassword( false ),
             m_rotation( Rotation0 ),
             m_exportCached( false ),
             m_bookmarkManager( nullptr ),
@@ -104,6 +111,9 @@ class DocumentPrivate
             m_pageController( nullptr ),
             m_closingLoop( nullptr ),
             m_scripter( nullptr ),
+            m_formLookupBuilt( false ),
+            m_formReadRecorder( nullptr ),
+            m_formWriteRecorder( nullptr ),
             m_archiveData( nullptr ),
             m_fontsCached( false ),
             m_annotationEditingEnabled ( true ),
@@ -122,14 +132,29 @@ class DocumentPrivate
         qulonglong calculateMemoryToFree();
         void cleanupPixmapMemory();
         void cleanupPixmapMemory( qulonglong memoryToFree );
-        AllocatedPixmap * searchLowestPriorityPixmap( bool unloadableOnly = false, bool thenRemoveIt = false, DocumentObserver *observer = nullptr /* any */ );
+        AllocatedPixmap * searchLowestPriorityPixmap( bool unloadableOnly = false, bool thenRemoveIt = false, DocumentObserver *observer = nullptr /* any */, bool includeThumbnails = true );
+        static qulonglong processPixmapsTotalMemory();
+        qulonglong freeBackgroundDocumentsMemory( qulonglong memoryToFree );
+        qulonglong freeBackgroundPixmaps( qulonglong memoryToFree );
+        PixmapRequest * createPlaceholderRequest( const PixmapRequest *request ) const;
+        bool hasPixmapForPlaceholder( const PixmapRequest *placeholder ) const;
+        void recordPixmapRenderTime( const PixmapRequest *request );
+        void notifyPixmapReady( PixmapRequest *req );
+        QString documentCacheKey();
+        bool canCacheContents() const;
+        QByteArray pageCacheRevision( int page ) const;
+        QString thumbnailCachePath( int page );
+        QString textPageCachePath( int page );
+        void saveThumbnail( const PixmapRequest *request );
         void calculateMaxTextPages();
         qulonglong getTotalMemory();
         qulonglong getFreeMemory( qulonglong *freeSwap = nullptr );
         bool loadDocumentInfo( LoadDocumentInfoFlags loadWhat );
         bool loadDocumentInfo( QFile &infoFile, LoadDocumentInfoFlags loadWhat );
+        bool restorePageList( const QDomElement &pageList );
         void loadViewsInfo( View *view, const QDomElement &e );
-        void saveViewsInfo( View *view, QDomElement &e ) const;
+        void restoreViewZoom( View *view, double zoom, int mode );
+        void saveViewZoom( View *view, double *zoom, int *mode ) const;
         QUrl giveAbsoluteUrl( const QString & fileName ) const;
         bool openRelativeFile( const QString & fileName );
         Generator * loadGeneratorLibrary( const KPluginMetaData& service );
@@ -144,8 +169,8 @@ class DocumentPrivate
         static ArchiveData *unpackDocumentArchive( const QString &archivePath );
         bool savePageDocumentInfo( QTemporaryFile *infoFile, int what ) const;
         DocumentViewport nextDocumentViewport() const;
-        void notifyAnnotationChanges( int page );
-        void notifyFormChanges( int page );
+        void notifyAnnotationChange( int page, Annotation *annotation, DocumentObserver::AnnotationChange change );
+        void notifyFormChanges( int page, const QStringList &changedFields );
         bool canAddAnnotationsNatively() const;
         bool canModifyExternalAnnotations() const;
         bool canRemoveExternalAnnotations() const;
@@ -158,15 +183,22 @@ class DocumentPrivate
         void performModifyPageAnnotation( int page, Annotation * annotation, bool appearanceChanged );
         void performSetAnnotationContents( const QString & newContents, Annotation *annot, int pageNumber );
 
-        void recalculateForms();
+        void recalculateForms( const QStringList &changedFields = QStringList() );
+        void buildFormLookup();
+        void clearFormLookup();
+        FormField *formFieldByName( const QString &name, Page **page );
+        void recordFormFieldRead( const QString &name );
+        void recordFormFieldWrite( const FormField *field );
 
         // private slots
         void saveDocumentInfo() const;
+        void saveDocumentInfo( bool asynchronous ) const;
         void slotTimedMemoryCheck();
         void sendGeneratorPixmapRequest();
         void rotationFinished( int page, Okular::Page *okularPage );
         void slotFontReadingProgress( int page );
         void fontReadingGotFont( const Okular::FontInfo& font );
+        void sourceReferencesLoaded();
         void slotGeneratorConfigChanged( const QString& );
         void refreshPixmaps( int );
         void _o_configChanged();
@@ -175,6 +207,8 @@ class DocumentPrivate
         void doContinueGooglesDocumentSearch(void *pagesToNotifySet, void *pageMatchesMap, int currentPage, int searchID, const QStringList & words);
 
         void doProcessSearchMatch( RegularAreaRect *match, RunningSearch *search, QSet< int > *pagesToNotify, int currentPage, int searchID, bool moveViewport, const QColor & color );
+        void updateSearchCandidatePages( RunningSearch *search );
+        bool isSearchCandidatePage( const RunningSearch *search, int page ) const;
 
         // generators stuff
         /**
@@ -201,10 +235,16 @@ class DocumentPrivate
         bool isNormalizedRectangleFullyVisible( const Okular::NormalizedRect & rectOfInterest, int rectPage );
 
         // For sync files
-        void loadSyncFile( const QString & filePath );
+        void startSourceReferenceLoading( const QString & docFile );
+        void stopSourceReferenceLoading();
+        void loadPdfSyncPoints( const QVector< PdfSyncPoint > & points );
+        bool deferSourceReferenceDestination();
+        bool pdfSyncViewport( const QString & fileName, int line, DocumentViewport * viewport ) const;
 
         void clearAndWaitForRequests();
 
+        bool swapBackingFile( const QString &newFileName, const QUrl &url, bool contentsChanged );
+
         // member variables
         Document *m_parent;
         QPointer<QWidget> m_widget;
@@ -236,9 +276,23 @@ class DocumentPrivate
         QMutex m_pixmapRequestsMutex;
         QLinkedList< AllocatedPixmap * > m_allocatedPixmaps;
         qulonglong m_allocatedPixmapsTotalMemory;
+        // whether the document is the one on screen (see Document::setActive),
+        // and whether its pixmaps were freed meanwhile it was not
+        bool m_active;
+        bool m_pixmapsFreedInBackground;
         QList< int > m_allocatedTextPagesFifo;
         int m_maxAllocatedTextPages;
         bool m_warnedOutOfMemory;
+        // how long rendering took, in ms per megapixel, to decide
+        // whether a low resolution placeholder is worth it
+        QHash< int, double > m_pixmapRenderCosts;
+        double m_averagePixmapRenderCost;
+        // where the thumbnails of the document are saved
+        QString m_documentCacheKey;
+        QString m_thumbnailCacheDir;
+        QString m_textPageCacheDir;
+        // nothing of the documents opened with a password is cached on disk
+        bool m_openedWithPassword;
 
         // the rotation applied to the document
         Rotation m_rotation;
@@ -276,6 +330,22 @@ class DocumentPrivate
 
         Scripter *m_scripter;
 
+        // form fields by id and by (first matching) name, built on demand
+        struct FormFieldEntry
+        {
+            FormField *field;
+            Page *page;
+        };
+        QHash< int, FormFieldEntry > m_formFieldsById;
+        QHash< QString, FormFieldEntry > m_formFieldsByName;
+        bool m_formLookupBuilt;
+        // names of the fields each calculated field read during its last
+        // calculation; empty if it read none, in which case it is always redone
+        QHash< int, QSet< QString > > m_formCalculateInputs;
+        // set while a calculate script runs, to collect its reads and writes
+        QSet< QString > *m_formReadRecorder;
+        QSet< QString > *m_formWriteRecorder;
+
         ArchiveData *m_archiveData;
         QString m_archivedFileName;
 
@@ -300,8 +370,15 @@ class DocumentPrivate
         // shown in read-only mode. This flag is set if the docdata/ XML file
         // for the current document contains any annotation or form.
         bool m_docdataMigrationNeeded;
+        // the not-yet-migrated page contents read from docdata/, as they were
+        QByteArray m_docdataPageList;
 
         synctex_scanner_p m_synctex_scanner;
+        QPointer< SourceReferenceLoader > m_sourceReferenceLoader;
+        // a "src:" destination requested while the source references were still loading
+        QString m_pendingSourceDestination;
+        // pdfsync forward search index: source file -> line -> first position
+        QHash< QString, QMap< int, QPair< int, NormalizedPoint > > > m_pdfSyncLines;
 
         // generator selection
         static QVector<KPluginMetaData> availableGenerators();
@@ -60,6 +60,16 @@ Okular::NormalizedRect buildBoundingRectangleForButtons( const QList<Okular::For
     return boundingRect;
 }
 
+QStringList fieldNames( const QList<Okular::FormFieldButton*> & formButtons )
+{
+    QStringList names;
+    foreach( FormFieldButton* formButton, formButtons )
+    {
+        names << formButton->name();
+    }
+    return names;
+}
+
 AddAnnotationCommand::AddAnnotationCommand( Okular::DocumentPrivate * docPriv,  Okular::Annotation* annotation, int pageNumber )
  : m_docPriv( docPriv ),
    m_annotation( annotation ),
@@ -507,7 +517,7 @@ void EditFormTextCommand::undo()
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     m_form->setText( m_prevContents );
     emit m_docPriv->m_parent->formTextChangedByUndoRedo( m_pageNumber, m_form, m_prevContents, m_prevCursorPos, m_prevAnchorPos );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QStringList( m_form->name() ) );
 }
 
 void EditFormTextCommand::redo()
@@ -515,7 +525,7 @@ void EditFormTextCommand::redo()
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     m_form->setText( m_newContents  );
     emit m_docPriv->m_parent->formTextChangedByUndoRedo( m_pageNumber, m_form, m_newContents, m_newCursorPos, m_newCursorPos );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QStringList( m_form->name() ) );
 }
 
 int EditFormTextCommand::id() const
@@ -564,7 +574,7 @@ void EditFormListCommand::undo()
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     m_form->setCurrentChoices( m_prevChoices );
     emit m_docPriv->m_parent->formListChangedByUndoRedo( m_pageNumber, m_form, m_prevChoices );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QStringList( m_form->name() ) );
 }
 
 void EditFormListCommand::redo()
@@ -572,7 +582,7 @@ void EditFormListCommand::redo()
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     m_form->setCurrentChoices( m_newChoices );
     emit m_docPriv->m_parent->formListChangedByUndoRedo( m_pageNumber, m_form, m_newChoices );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QStringList( m_form->name() ) );
 }
 
 bool EditFormListCommand::refreshInternalPageReferences( const QVector< Page * > &newPagesVector )
@@ -627,7 +637,7 @@ void EditFormComboCommand::undo()
     }
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     emit m_docPriv->m_parent->formComboChangedByUndoRedo( m_pageNumber, m_form, m_prevContents, m_prevCursorPos, m_prevAnchorPos );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QStringList( m_form->name() ) );
 }
 
 void EditFormComboCommand::redo()
@@ -642,7 +652,7 @@ void EditFormComboCommand::redo()
     }
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     emit m_docPriv->m_parent->formComboChangedByUndoRedo( m_pageNumber, m_form, m_newContents, m_newCursorPos, m_newCursorPos );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QStringList( m_form->name() ) );
 }
 
 int EditFormComboCommand::id() const
@@ -707,7 +717,7 @@ void EditFormButtonsCommand::undo()
     Okular::NormalizedRect boundingRect = buildBoundingRectangleForButtons( m_formButtons );
     moveViewportIfBoundingRectNotFullyVisible( boundingRect, m_docPriv, m_pageNumber );
     emit m_docPriv->m_parent->formButtonsChangedByUndoRedo( m_pageNumber, m_formButtons );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, fieldNames( m_formButtons ) );
 }
 
 void EditFormButtonsCommand::redo()
@@ -723,7 +733,7 @@ void EditFormButtonsCommand::redo()
     Okular::NormalizedRect boundingRect = buildBoundingRectangleForButtons( m_formButtons );
     moveViewportIfBoundingRectNotFullyVisible( boundingRect, m_docPriv, m_pageNumber );
     emit m_docPriv->m_parent->formButtonsChangedByUndoRedo( m_pageNumber, m_formButtons );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, fieldNames( m_formButtons ) );
 }
 
 bool EditFormButtonsCommand::refreshInternalPageReferences( const QVector< Okular::Page * > &newPagesVector )
@@ -20,6 +20,7 @@
 #include <QtPrintSupport/QPrinter>
 
 #include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
 #include <QIcon>
 #include <QMimeDatabase>
 #include <QTimer>
@@ -34,6 +35,8 @@
 #include "page.h"
 #include "page_p.h"
 #include "textpage.h"
+#include "textpage_p.h"
+#include "tracer_p.h"
 #include "utils.h"
 
 using namespace Okular;
@@ -178,6 +181,49 @@ QImage GeneratorPrivate::image( PixmapRequest * )
     return QImage();
 }
 
+QImage GeneratorPrivate::requestedImage( PixmapRequest *request )
+{
+    Q_Q( Generator );
+    TraceScope trace( "image", "generator", request->pageNumber() );
+    QElapsedTimer timer;
+    timer.start();
+
+    PixmapRequestPrivate *requestPrivate = PixmapRequestPrivate::get( request );
+    const QSize size( request->width(), request->height() );
+    if ( request->isThumbnail() && !requestPrivate->mCachePath.isEmpty() )
+    {
+        // saved by a previous session; never scale a thumbnail up, render it
+        // again instead
+        const QImage cached( requestPrivate->mCachePath );
+        if ( !cached.isNull() && cached.width() >= size.width() )
+        {
+            // not a rendering, its time says nothing about the page
+            requestPrivate->mRenderTime = -1;
+            return cached.size() == size ? cached : cached.scaled( size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+        }
+    }
+
+    QImage image;
+    if ( request->isThumbnail() && !request->isTile() )
+    {
+        const QImage thumbnail = q->thumbnail( request->pageNumber(), size );
+        if ( !thumbnail.isNull() && thumbnail.width() * 4 >= size.width() * 3 )
+        {
+            image = thumbnail.size() == size ? thumbnail : thumbnail.scaled( size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+            requestPrivate->mCacheable = thumbnail.width() >= size.width();
+        }
+    }
+    if ( image.isNull() )
+    {
+        image = q->image( request );
+        requestPrivate->mCacheable = true;
+    }
+
+    // whether rendered in a thread or not
+    requestPrivate->mRenderTime = timer.elapsed();
+    return image;
+}
+
 
 Generator::Generator(QObject* parent, const QVariantList &args)
     : Generator( *new GeneratorPrivate(), parent, args )
@@ -266,7 +312,8 @@ void Generator::generatePixmap( PixmapRequest *request )
     Q_D( Generator );
     d->mPixmapReady = false;
 
-    const bool calcBoundingBox = !request->isTile() && !request->page()->isBoundingBoxKnown();
+    // the bounding box of a placeholder would be too coarse, leave it to the real request
+    const bool calcBoundingBox = !request->isTile() && !PixmapRequestPrivate::get( request )->mPlaceholder && !request->page()->isBoundingBoxKnown();
 
     if ( request->asynchronous() && hasFeature( Threaded ) )
     {
@@ -301,7 +348,7 @@ void Generator::generatePixmap( PixmapRequest *request )
         return;
     }
 
-    const QImage& img = image( request );
+    const QImage& img = d->requestedImage( request );
     request->page()->setPixmap( request->observer(), new QPixmap( QPixmap::fromImage( img ) ), request->normalizedRect() );
     const int pageNumber = request->page()->number();
 
@@ -320,8 +367,13 @@ bool Generator::canGenerateTextPage() const
 
 void Generator::generateTextPage( Page *page )
 {
+    // the disk cache of the text is only used by the text generation thread,
+    // this runs in the GUI thread
+    TraceScope trace( "textPage", "generator", page->number() );
     TextRequest treq( page );
     TextPage *tp = textPage( &treq );
+    if ( tp )
+        TextPagePrivate::get( tp )->correctTextOrder( page->width(), page->height(), page->boundingBox() );
     page->setTextPage( tp );
     signalTextGenerationDone( page, tp );
 }
@@ -332,6 +384,11 @@ QImage Generator::image( PixmapRequest *request )
     return d->image( request );
 }
 
+QImage Generator::thumbnail( int, const QSize & )
+{
+    return QImage();
+}
+
 TextPage* Generator::textPage( TextRequest * )
 {
     return nullptr;
@@ -349,6 +406,16 @@ const DocumentSynopsis * Generator::generateDocumentSynopsis()
     return nullptr;
 }
 
+bool Generator::pagesContainingText( const QString &, Qt::CaseSensitivity, QVector< int > * )
+{
+    return false;
+}
+
+QByteArray Generator::pageFingerprint( int, bool ) const
+{
+    return QByteArray();
+}
+
 FontInfo::List Generator::fontsForPage( int )
 {
     return FontInfo::List();
@@ -591,7 +658,17 @@ PixmapRequest::PixmapRequest( DocumentObserver *observer, int pageNumber, int wi
     d->mTile = false;
     d->mNormalizedRect = NormalizedRect();
     d->mPartialUpdatesWanted = false;
+    d->mPlaceholder = features & Placeholder;
+    if ( d->mPlaceholder )
+    {
+        d->mWidth = qMax( 1, d->mWidth / PixmapRequestPrivate::placeholderDivisor );
+        d->mHeight = qMax( 1, d->mHeight / PixmapRequestPrivate::placeholderDivisor );
+    }
     d->mShouldAbortRender = 0;
+    d->mRenderTime = -1;
+    d->mCacheable = false;
+    d->mQueuedTime = -1;
+    d->mTraceId = 0;
 }
 
 PixmapRequest::~PixmapRequest()
@@ -634,6 +711,16 @@ bool PixmapRequest::preload() const
     return d->mFeatures & Preload;
 }
 
+bool PixmapRequest::isThumbnail() const
+{
+    return d->mFeatures & Thumbnail;
+}
+
+bool PixmapRequest::isPlaceholder() const
+{
+    return d->mPlaceholder;
+}
+
 Page* PixmapRequest::page() const
 {
     return d->mPage;
@@ -811,6 +898,7 @@ QDebug operator<<( QDebug str, const Okular::PixmapRequest &req )
     str << "- rect:" << req.normalizedRect();
     str << "- preload:" << ( req.preload() ? "true" : "false" );
     str << "- partialUpdates:" << ( req.partialUpdatesWanted() ? "true" : "false" );
+    str << "- placeholder:" << ( reqPriv->mPlaceholder ? "true" : "false" );
     str << "- shouldAbort:" << ( req.shouldAbortRender() ? "true" : "false" );
     str << "- force:" << ( reqPriv->mForce ? "true" : "false" );
     return str;
@@ -215,7 +215,8 @@ class OKULARCORE_EXPORT Generator : public QObject
             PrintToFile,       ///< Whether the Generator supports export to PDF & PS through the Print Dialog
             TiledRendering,    ///< Whether the Generator can render tiles @since 0.16 (KDE 4.10)
             SwapBackingFile,   ///< Whether the Generator can hot-swap the file it's reading from @since 1.3
-            SupportsCancelling ///< Whether the Generator can cancel requests @since 1.4
+            SupportsCancelling, ///< Whether the Generator can cancel requests @since 1.4
+            SearchIndex        ///< Whether the Generator can narrow down text searches using a search index of the document @since 1.5
         };
 
         /**
@@ -347,6 +348,45 @@ class OKULARCORE_EXPORT Generator : public QObject
          */
         virtual const DocumentSynopsis * generateDocumentSynopsis();
 
+        /**
+         * Fills @p pages with the numbers of the pages that may contain
+         * @p text, looking it up in a search index native to the document
+         * format. The Document then extracts the text only of those pages
+         * to find and highlight the matches.
+         *
+         * The returned pages may include pages without any match, but must
+         * include every page that contains @p text.
+         *
+         * @note the Generator has to have the feature @ref SearchIndex enabled
+         *
+         * @returns false if the index cannot answer the query, in which case
+         *          all the pages are searched
+         *
+         * @since 1.5
+         */
+        virtual bool pagesContainingText( const QString &text, Qt::CaseSensitivity caseSensitivity, QVector< int > *pages );
+
+        /**
+         * Returns a fingerprint of the contents of the page @p page, or an
+         * empty byte array if it is not known, or if it can't tell the
+         * changes of the page apart; such a page is always generated again.
+         *
+         * When a document changed on disk is reloaded, the pages whose
+         * fingerprint did not change keep their pixmaps, text and object
+         * rects, while the others are generated again, so the fingerprint
+         * must change whenever the rendering of the page would.
+         *
+         * It is asked, before the reload, for the pages that have pixmaps,
+         * with @p compute false: at that point the file on disk may already
+         * be the new one, so only a fingerprint remembered from an earlier
+         * generation of the page (e.g. of its text, which is out of the
+         * rendering path) is of use. After the reload it is asked with
+         * @p compute true, and may be computed from the new file.
+         *
+         * @since 1.5
+         */
+        virtual QByteArray pageFingerprint( int page, bool compute ) const;
+
         /**
          * Returns the 'list of embedded fonts' object of the specified \page
          * of the document.
@@ -528,6 +568,24 @@ class OKULARCORE_EXPORT Generator : public QObject
          */
         virtual QImage image( PixmapRequest *page );
 
+        /**
+         * Returns a thumbnail of the page @p page that is much cheaper to get
+         * than rendering the page with image(), like one embedded in the
+         * document, or a null image if there is none.
+         *
+         * It is called instead of image(), from the same thread, for the
+         * requests that are thumbnails (see PixmapRequest::isThumbnail()).
+         * The thumbnail is scaled to @p size, unless it is smaller than
+         * three quarters of it; in that case the page is rendered with
+         * image() instead.
+         *
+         * @warning this method may be executed in its own separated thread if the
+         * @ref Threaded is enabled!
+         *
+         * @since 1.5
+         */
+        virtual QImage thumbnail( int page, const QSize &size );
+
         /**
          * Returns the text page for the given @p request.
          *
@@ -584,6 +642,10 @@ class OKULARCORE_EXPORT Generator : public QObject
          * to the Document. Call this instead of Page::setBoundingBox() to ensure
          * that all observers are notified.
          *
+         * The rendered pixmaps of a page are only scanned for its bounding box
+         * while it is not known, so a generator that knows it without rendering
+         * should set it before the page is rendered.
+         *
          * @since 0.7 (KDE 4.1)
          */
         void updatePageBoundingBox( int page, const NormalizedRect & boundingBox );
@@ -645,7 +707,10 @@ class OKULARCORE_EXPORT PixmapRequest
         {
             NoFeature = 0,
             Asynchronous = 1,
-            Preload = 2
+            Preload = 2,
+            Thumbnail = 4, ///< The pixmap is a thumbnail of the page, since 1.5
+            NoTiles = 8, ///< The pixmap is rendered whole, even if it is big enough to be rendered in tiles, since 1.5
+            Placeholder = 16 ///< The pixmap is a low resolution version of the page, shown until a real one is there, since 1.5
         };
         Q_DECLARE_FLAGS( PixmapRequestFeatures, PixmapRequestFeature )
 
@@ -707,6 +772,23 @@ class OKULARCORE_EXPORT PixmapRequest
          */
         bool preload() const;
 
+        /**
+         * Returns whether the pixmap is a thumbnail of the page, which can
+         * come from Generator::thumbnail() or a cache on disk
+         *
+         * @since 1.5
+         */
+        bool isThumbnail() const;
+
+        /**
+         * Returns whether the pixmap is a placeholder: it is a fraction of
+         * the size given to the constructor, and it is not rendered if the
+         * page has a pixmap at least as detailed
+         *
+         * @since 1.5
+         */
+        bool isPlaceholder() const;
+
         /**
          * Returns a pointer to the page where the pixmap shall be generated for.
          */
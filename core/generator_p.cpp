@@ -11,8 +11,13 @@
 
 #include <QtCore/QDebug>
 
+#include "document_p.h"
 #include "fontinfo.h"
 #include "generator.h"
+#include "page_p.h"
+#include "textpage.h"
+#include "textpage_p.h"
+#include "tracer_p.h"
 #include "utils.h"
 
 using namespace Okular;
@@ -59,7 +64,7 @@ void PixmapGenerationThread::run()
 {
     if ( mRequest )
     {
-        PixmapRequestPrivate::get(mRequest)->mResultImage = mGenerator->image( mRequest );
+        PixmapRequestPrivate::get(mRequest)->mResultImage = mGenerator->d_func()->requestedImage( mRequest );
 
         if ( mCalcBoundingBox )
             mBoundingBox = Utils::imageBoundingBox( &PixmapRequestPrivate::get(mRequest)->mResultImage );
@@ -68,7 +73,7 @@ void PixmapGenerationThread::run()
 
 
 TextPageGenerationThread::TextPageGenerationThread( Generator *generator )
-    : mGenerator( generator ), mTextPage( nullptr )
+    : mGenerator( generator ), mTextPage( nullptr ), mPageWidth( 0 ), mPageHeight( 0 )
 {
     TextRequestPrivate *treqPriv = TextRequestPrivate::get( &mTextRequest );
     treqPriv->mPage = nullptr;
@@ -95,6 +100,12 @@ void TextPageGenerationThread::setPage( Page *page )
     TextRequestPrivate *treqPriv = TextRequestPrivate::get( &mTextRequest );
     treqPriv->mPage = page;
     treqPriv->mShouldAbortExtraction = 0;
+
+    mPageWidth = page->width();
+    mPageHeight = page->height();
+    mBoundingBox = page->boundingBox();
+    DocumentPrivate *doc = PagePrivate::get( page )->m_doc;
+    mCachePath = doc ? doc->textPageCachePath( page->number() ) : QString();
 }
 
 Page *TextPageGenerationThread::page() const
@@ -128,13 +139,28 @@ void TextPageGenerationThread::run()
 
     Q_ASSERT ( page() );
 
-    mTextPage = mGenerator->textPage( &mTextRequest );
+    TextPage *textPage = TextPagePrivate::loadCorrectedText( mCachePath, mPageWidth, mPageHeight, mBoundingBox );
+    if ( !textPage )
+    {
+        TraceScope trace( "textPage", "generator", page()->number() );
+        textPage = mGenerator->textPage( &mTextRequest );
+
+        // segment the text here instead of in the GUI thread, and keep the
+        // result so the page is not segmented again
+        if ( textPage && !mTextRequest.shouldAbortExtraction() )
+        {
+            TextPagePrivate *tpp = TextPagePrivate::get( textPage );
+            tpp->correctTextOrder( mPageWidth, mPageHeight, mBoundingBox );
+            tpp->saveCorrectedText( mCachePath, mPageWidth, mPageHeight, mBoundingBox );
+        }
+    }
 
     if ( mTextRequest.shouldAbortExtraction() )
     {
-        delete mTextPage;
-        mTextPage = nullptr;
+        delete textPage;
+        textPage = nullptr;
     }
+    mTextPage = textPage;
 }
 
 
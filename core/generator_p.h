@@ -58,6 +58,7 @@ class GeneratorPrivate
 
         virtual QVariant metaData( const QString &key, const QVariant &option ) const;
         virtual QImage image( PixmapRequest * );
+        QImage requestedImage( PixmapRequest *request );
 
         DocumentPrivate *m_document;
         // NOTE: the following should be a QSet< GeneratorFeature >,
@@ -83,6 +84,9 @@ class PixmapRequestPrivate
 
         static PixmapRequestPrivate *get(const PixmapRequest *req);
 
+        // a placeholder is a quarter of the size (1/16 of the area) of the page
+        static const int placeholderDivisor = 4;
+
         DocumentObserver *mObserver;
         int mPageNumber;
         int mWidth;
@@ -92,10 +96,23 @@ class PixmapRequestPrivate
         bool mForce : 1;
         bool mTile : 1;
         bool mPartialUpdatesWanted : 1;
+        bool mPlaceholder : 1;
         Page *mPage;
         NormalizedRect mNormalizedRect;
         QAtomicInt mShouldAbortRender;
         QImage mResultImage;
+        // how long the generator took to render the image, in ms, -1 if unknown
+        qint64 mRenderTime;
+        // the file of the cached thumbnail, for the thumbnail requests of
+        // the documents that can be cached; it may not exist yet
+        QString mCachePath;
+        // whether the image was rendered at the requested size, and so is
+        // worth saving to the cache
+        bool mCacheable;
+        // when the request was queued, and its identifier in the trace, if
+        // tracing
+        qint64 mQueuedTime;
+        quint64 mTraceId;
 };
 
 
@@ -164,6 +181,11 @@ class TextPageGenerationThread : public QThread
         Generator *mGenerator;
         TextPage *mTextPage;
         TextRequest mTextRequest;
+        // what the text order correction needs from the page, taken in setPage()
+        double mPageWidth;
+        double mPageHeight;
+        NormalizedRect mBoundingBox;
+        QString mCachePath;
 };
 
 class FontExtractionThread : public QThread
@@ -0,0 +1,214 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "memorymonitor_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QSocketNotifier>
+
+#include "debug_p.h"
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Okular;
+
+// notify when tasks are stalled on memory for 150 ms in 2 s; unprivileged
+// users can only ask for windows that are a multiple of 2 s
+static const char kPressureTrigger[] = "some 150000 2000000";
+
+static MemoryMonitor *s_monitor = nullptr;
+
+/* Reads the number in the file called name of the cgroup directory dir.
+ * Returns false if the file does not exist, or if it does not hold a number
+ * (e.g. "max" for the limits that are not set)
+ */
+static bool readCgroupValue( const QString &dir, const char *name, qulonglong *value )
+{
+    QFile file( dir + QLatin1Char( '/' ) + QLatin1String( name ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return false;
+
+    bool ok = false;
+    *value = file.readLine().trimmed().toULongLong( &ok );
+    return ok;
+}
+
+/* Returns the page cache that the kernel can reclaim from the cgroup,
+ * which memory.current accounts for as well
+ */
+static qulonglong cgroupReclaimableMemory( const QString &dir )
+{
+    QFile file( dir + QStringLiteral( "/memory.stat" ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return 0;
+
+    while ( !file.atEnd() )
+    {
+        const QByteArray line = file.readLine();
+        if ( line.startsWith( "inactive_file " ) )
+            return line.mid( 14 ).trimmed().toULongLong();
+    }
+    return 0;
+}
+
+MemoryMonitor *MemoryMonitor::self()
+{
+    if ( !s_monitor )
+        s_monitor = new MemoryMonitor( QString(), QCoreApplication::instance() );
+    return s_monitor;
+}
+
+MemoryMonitor::MemoryMonitor( const QString &rootDir, QObject *parent )
+    : QObject( parent ), m_rootDir( rootDir ), m_pressureNotifier( nullptr ), m_pressureFd( -1 ), m_pressureEvents( 0 )
+{
+    findCgroup();
+
+    // prefer the pressure of our own cgroup, which also accounts for its
+    // limit, to the one of the whole system
+    if ( m_cgroupDirs.isEmpty() || !watchPressure( m_cgroupDirs.first() + QStringLiteral( "/memory.pressure" ) ) )
+        watchPressure( m_rootDir + QStringLiteral( "/proc/pressure/memory" ) );
+}
+
+MemoryMonitor::~MemoryMonitor()
+{
+    delete m_pressureNotifier;
+#if defined(Q_OS_LINUX)
+    if ( m_pressureFd >= 0 )
+        ::close( m_pressureFd );
+#endif
+    if ( s_monitor == this )
+        s_monitor = nullptr;
+}
+
+void MemoryMonitor::findCgroup()
+{
+#if defined(Q_OS_LINUX)
+    // the cgroup v2 hierarchy is the "0::/path" entry
+    QFile cgroupFile( m_rootDir + QStringLiteral( "/proc/self/cgroup" ) );
+    if ( !cgroupFile.open( QIODevice::ReadOnly ) )
+        return;
+
+    QString path;
+    bool found = false;
+    while ( !cgroupFile.atEnd() )
+    {
+        const QByteArray line = cgroupFile.readLine().trimmed();
+        if ( line.startsWith( "0::" ) )
+        {
+            path = QString::fromLocal8Bit( line.mid( 3 ) );
+            found = true;
+            break;
+        }
+    }
+    if ( !found )
+        return;
+
+    // unified hierarchy, or hybrid one with the v2 tree mounted aside
+    QString root = m_rootDir + QStringLiteral( "/sys/fs/cgroup" );
+    if ( !QFile::exists( root + QStringLiteral( "/cgroup.controllers" ) ) )
+    {
+        root = m_rootDir + QStringLiteral( "/sys/fs/cgroup/unified" );
+        if ( !QFile::exists( root + QStringLiteral( "/cgroup.controllers" ) ) )
+            return;
+    }
+
+    while ( path.endsWith( QLatin1Char( '/' ) ) )
+        path.chop( 1 );
+    while ( true )
+    {
+        m_cgroupDirs.append( root + path );
+        if ( path.isEmpty() )
+            break;
+        path.truncate( path.lastIndexOf( QLatin1Char( '/' ) ) );
+    }
+#endif
+}
+
+bool MemoryMonitor::watchPressure( const QString &fileName )
+{
+#if defined(Q_OS_LINUX)
+    const int fd = ::open( QFile::encodeName( fileName ).constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC );
+    if ( fd < 0 )
+        return false;
+
+    // the trigger is registered by writing it, terminating zero included
+    if ( ::write( fd, kPressureTrigger, sizeof( kPressureTrigger ) ) < 0 )
+    {
+        ::close( fd );
+        return false;
+    }
+
+    // the kernel signals the trigger with POLLPRI
+    m_pressureFd = fd;
+    m_pressureNotifier = new QSocketNotifier( fd, QSocketNotifier::Exception, this );
+    connect( m_pressureNotifier, &QSocketNotifier::activated, this, &MemoryMonitor::pressureNotified );
+    qCDebug(OkularCoreDebug) << "Watching memory pressure of" << fileName;
+    return true;
+#else
+    Q_UNUSED( fileName );
+    return false;
+#endif
+}
+
+bool MemoryMonitor::hasPressureNotifications() const
+{
+    return m_pressureNotifier;
+}
+
+int MemoryMonitor::pressureEvents() const
+{
+    return m_pressureEvents;
+}
+
+qulonglong MemoryMonitor::cgroupLimit() const
+{
+    qulonglong limit = 0;
+    for ( const QString &dir : m_cgroupDirs )
+    {
+        qulonglong max;
+        if ( readCgroupValue( dir, "memory.max", &max ) && ( limit == 0 || max < limit ) )
+            limit = max;
+    }
+    return limit;
+}
+
+qulonglong MemoryMonitor::cgroupAvailableMemory( bool *limited ) const
+{
+    // every ancestor with a limit counts the memory of all its descendants,
+    // so the tightest of them is the one that matters
+    *limited = false;
+    qulonglong available = 0;
+    for ( const QString &dir : m_cgroupDirs )
+    {
+        qulonglong max, current;
+        if ( !readCgroupValue( dir, "memory.max", &max ) || !readCgroupValue( dir, "memory.current", &current ) )
+            continue;
+
+        const qulonglong reclaimable = cgroupReclaimableMemory( dir );
+        const qulonglong used = current > reclaimable ? current - reclaimable : 0;
+        const qulonglong headroom = max > used ? max - used : 0;
+        if ( !*limited || headroom < available )
+            available = headroom;
+        *limited = true;
+    }
+    return available;
+}
+
+void MemoryMonitor::pressureNotified()
+{
+    ++m_pressureEvents;
+    qCDebug(OkularCoreDebug) << "Memory pressure notified";
+    emit memoryPressure();
+}
+
+#include "moc_memorymonitor_p.cpp"
@@ -0,0 +1,98 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_MEMORYMONITOR_P_H_
+#define _OKULAR_MEMORYMONITOR_P_H_
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+
+#include "okularcore_export.h"
+
+class QSocketNotifier;
+
+namespace Okular {
+
+/**
+ * Tells how much memory the process can use, and when it is running short
+ * of it.
+ *
+ * In a cgroup (v2) with a memory limit, e.g. in a container, the system
+ * wide numbers of /proc/meminfo are the ones of the host, so the limit and
+ * the usage of the cgroup are taken into account too.
+ *
+ * Where the kernel supports pressure stall information, memoryPressure()
+ * is emitted when tasks are stalled waiting for memory, so that the
+ * documents free their pixmaps then instead of polling the free memory.
+ */
+class OKULARCORE_EXPORT MemoryMonitor : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static MemoryMonitor *self();
+
+        /**
+         * Creates a monitor that looks for the /proc and /sys/fs/cgroup
+         * files under @p rootDir, for the tests; the documents use self().
+         */
+        explicit MemoryMonitor( const QString &rootDir, QObject *parent = nullptr );
+        ~MemoryMonitor();
+
+        /**
+         * Whether memoryPressure() is emitted at all; if not, the memory
+         * has to be polled.
+         */
+        bool hasPressureNotifications() const;
+
+        /**
+         * Returns how many times memoryPressure() has been emitted, so
+         * that cached memory figures can be refreshed after it.
+         */
+        int pressureEvents() const;
+
+        /**
+         * Returns the lowest memory limit of the cgroup of the process and
+         * of its ancestors, or 0 if there is none.
+         */
+        qulonglong cgroupLimit() const;
+
+        /**
+         * Returns the memory that the process can still allocate before
+         * hitting the limit of its cgroup, or of one of its ancestors.
+         * @p limited is set to whether there is any limit at all.
+         */
+        qulonglong cgroupAvailableMemory( bool *limited ) const;
+
+    Q_SIGNALS:
+        /**
+         * Emitted when the process, or the whole system, is short of memory.
+         */
+        void memoryPressure();
+
+    private Q_SLOTS:
+        void pressureNotified();
+
+    private:
+        void findCgroup();
+        bool watchPressure( const QString &fileName );
+
+        // empty, but for the tests
+        QString m_rootDir;
+        // the cgroup directories, from the one of the process to the
+        // topmost one visible to it
+        QStringList m_cgroupDirs;
+        QSocketNotifier *m_pressureNotifier;
+        int m_pressureFd;
+        int m_pressureEvents;
+};
+
+}
+
+#endif
@@ -32,6 +32,11 @@ void DocumentObserver::notifyPageChanged( int, int )
 {
 }
 
+void DocumentObserver::notifyAnnotationChanged( int page, Okular::Annotation *, AnnotationChange )
+{
+    notifyPageChanged( page, DocumentObserver::Annotations );
+}
+
 void DocumentObserver::notifyContentsCleared( int )
 {
 }
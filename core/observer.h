@@ -20,6 +20,7 @@
 
 namespace Okular {
 
+class Annotation;
 class Page;
 
 /**
@@ -60,6 +61,17 @@ class OKULARCORE_EXPORT DocumentObserver
             UrlChanged = 4          ///< The URL has changed @since 1.3
         };
 
+        /**
+         * Describes what happened to the annotation passed to notifyAnnotationChanged().
+         *
+         * @since 1.5
+         */
+        enum AnnotationChange {
+            AnnotationAdded,        ///< The annotation has been added to the page
+            AnnotationRemoved,      ///< The annotation has been removed from the page
+            AnnotationModified      ///< The properties of the annotation have been changed
+        };
+
         /**
          * This method is called whenever the document is initialized or reconstructed.
          *
@@ -81,6 +93,20 @@ class OKULARCORE_EXPORT DocumentObserver
          */
         virtual void notifyPageChanged( int page, int flags );
 
+        /**
+         * This method is called whenever a single @p annotation on @p page has
+         * been added, removed or modified, as described by @p change.
+         *
+         * When the annotation has been removed it is not on the page anymore,
+         * but it is still alive while this method runs.
+         *
+         * The default implementation calls notifyPageChanged() with the
+         * Annotations flag, reimplement it to update only what changed.
+         *
+         * @since 1.5
+         */
+        virtual void notifyAnnotationChanged( int page, Okular::Annotation *annotation, AnnotationChange change );
+
         /**
          * This method is called whenever the content described by the passed @p flags
          * has been cleared.
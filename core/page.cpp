@@ -240,6 +240,12 @@ bool Page::hasPixmap( DocumentObserver *observer, int width, int height, const N
     return (pixmap->width() == width && pixmap->height() == height);
 }
 
+const QPixmap * Page::pixmap( DocumentObserver *observer ) const
+{
+    QMap< DocumentObserver*, PagePrivate::PixmapObject >::const_iterator it = d->m_pixmaps.constFind( observer );
+    return it != d->m_pixmaps.constEnd() ? it.value().m_pixmap : nullptr;
+}
+
 bool Page::hasTextPage() const
 {
     return d->m_text != nullptr;
@@ -580,9 +586,11 @@ void Page::setTextPage( TextPage * textPage )
     {
         d->m_text->d->m_page = this;
         /**
-         * Correct text order for before text selection
+         * Correct text order for before text selection, unless the
+         * text generation thread already did
          */
-        d->m_text->d->correctTextOrder();
+        if ( !d->m_text->d->m_textOrderCorrected )
+            d->m_text->d->correctTextOrder();
     }
 }
 
@@ -1094,6 +1102,25 @@ void PagePrivate::adoptGeneratedContents( PagePrivate *oldPage )
     restoredFormFieldList = oldPage->restoredFormFieldList;
 }
 
+bool PagePrivate::adoptOutdatedContents( PagePrivate *oldPage )
+{
+    rotateAt( oldPage->m_rotation );
+
+    restoredLocalAnnotationList = oldPage->restoredLocalAnnotationList;
+    restoredFormFieldList = oldPage->restoredFormFieldList;
+
+    if ( !qFuzzyCompare( m_width, oldPage->m_width ) || !qFuzzyCompare( m_height, oldPage->m_height ) )
+        return false;
+
+    m_pixmaps = oldPage->m_pixmaps;
+    oldPage->m_pixmaps.clear();
+
+    m_tilesManagers = oldPage->m_tilesManagers;
+    oldPage->m_tilesManagers.clear();
+
+    return true;
+}
+
 FormField *PagePrivate::findEquivalentForm( const Page *p, FormField *oldField )
 {
     // given how id is not very good of id (at least for pdf) we do a few passes
@@ -136,6 +136,9 @@ class OKULARCORE_EXPORT Page
          * (This does not inform the document's observers, call Document::SetPageBoundingBox
          * instead if you want that.)
          *
+         * Generators that know the bounding box of their pages can set it when
+         * creating them, so the rendered pixmaps are not scanned for it.
+         *
          * @since 0.7 (KDE 4.1)
          */
         void setBoundingBox( const NormalizedRect& bbox );
@@ -146,6 +149,15 @@ class OKULARCORE_EXPORT Page
          */
         bool hasPixmap( DocumentObserver *observer, int width = -1, int height = -1, const NormalizedRect &rect = NormalizedRect() ) const;
 
+        /**
+         * Returns the pixmap of the whole page for the given @p observer, or
+         * a null pointer if there is none, or if the page is rendered in tiles
+         * for it. The pixmap is owned by the page.
+         *
+         * @since 1.5
+         */
+        const QPixmap * pixmap( DocumentObserver *observer ) const;
+
         /**
          * Returns whether the page provides a text page (@ref TextPage).
          */
@@ -129,6 +129,14 @@ class PagePrivate
          */
         void adoptGeneratedContents( PagePrivate *oldPage );
 
+        /**
+         * Like adoptGeneratedContents, for an oldPage whose contents changed:
+         * only its pixmaps are moved, to be shown until the new ones are
+         * generated, and only if the page size did not change.
+         * Returns whether the pixmaps were moved.
+         */
+        bool adoptOutdatedContents( PagePrivate *oldPage );
+
         /*
          * Tries to find an equivalent form field to oldField by looking into the rect, type and name
          */
@@ -16,6 +16,7 @@
 #include <kjs/kjsarguments.h>
 
 #include <QtCore/QDebug>
+#include <QtCore/QFile>
 
 #include "../debug_p.h"
 #include "../document_p.h"
@@ -37,7 +38,7 @@ class Okular::ExecutorKJSPrivate
 {
     public:
         ExecutorKJSPrivate( DocumentPrivate *doc )
-            : m_doc( doc )
+            : m_doc( doc ), m_inBatch( false )
         {
             initTypes();
         }
@@ -47,10 +48,12 @@ class Okular::ExecutorKJSPrivate
         }
 
         void initTypes();
+        void loadBuiltInScript();
 
         DocumentPrivate *m_doc;
         KJSInterpreter *m_interpreter;
         KJSGlobalObject m_docObject;
+        bool m_inBatch;
 };
 
 void ExecutorKJSPrivate::initTypes()
@@ -75,6 +78,35 @@ void ExecutorKJSPrivate::initTypes()
     m_docObject.setProperty( ctx, QStringLiteral("Doc"), m_docObject );
     m_docObject.setProperty( ctx, QStringLiteral("spell"), JSSpell::object( ctx ) );
     m_docObject.setProperty( ctx, QStringLiteral("util"), JSUtil::object( ctx ) );
+
+    loadBuiltInScript();
+}
+
+void ExecutorKJSPrivate::loadBuiltInScript()
+{
+    // The built-in functions only need to be defined once per interpreter,
+    // instead of being parsed again together with every script.
+    static QString builtInScript;
+    if ( builtInScript.isNull() )
+    {
+        QFile builtInResource ( QStringLiteral(":/script/builtin.js") );
+        if (!builtInResource.open( QIODevice::ReadOnly ))
+        {
+            qCDebug(OkularCoreDebug) << "failed to load builtin script";
+            builtInScript = QLatin1String("");
+            return;
+        }
+        builtInScript = QString::fromUtf8( builtInResource.readAll() );
+        builtInResource.close();
+    }
+
+    KJSContext *ctx = m_interpreter->globalContext();
+    KJSResult result = m_interpreter->evaluate( QStringLiteral("builtin.js"), 1,
+                                                builtInScript, &m_docObject );
+    if ( result.isException() || ctx->hasException() )
+    {
+        qCDebug(OkularCoreDebug) << "JS exception in builtin script" << result.errorMessage();
+    }
 }
 
 ExecutorKJS::ExecutorKJS( DocumentPrivate *doc )
@@ -120,5 +152,23 @@ void ExecutorKJS::execute( const QString &script, Event *event )
                                      << event->type() << "value:" << event->value();
         }
     }
+    if ( !d->m_inBatch )
+    {
+        JSField::clearCachedFields();
+    }
+}
+
+void ExecutorKJS::beginBatch()
+{
+    Q_ASSERT( !d->m_inBatch );
+    d->m_inBatch = true;
+    JSField::beginBatch();
+}
+
+void ExecutorKJS::endBatch()
+{
+    Q_ASSERT( d->m_inBatch );
+    d->m_inBatch = false;
+    JSField::endBatch();
     JSField::clearCachedFields();
 }
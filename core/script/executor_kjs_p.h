@@ -26,6 +26,13 @@ class ExecutorKJS
 
         void execute( const QString &script, Event *event );
 
+        // Scripts executed between beginBatch() and endBatch() share the
+        // cached field wrappers, and the fields they modify are refreshed
+        // only once at the end; the batches do not nest, the Scripter calls
+        // these for its outermost batch only
+        void beginBatch();
+        void endBatch();
+
     private:
         friend class ExecutorKJSPrivate;
         ExecutorKJSPrivate* d;
@@ -15,6 +15,7 @@
 #include <kjs/kjsarguments.h>
 
 #include <qhash.h>
+#include <qset.h>
 
 #include <QtCore/QDebug>
 
@@ -32,12 +33,21 @@ typedef QHash< FormField *, Page * > FormCache;
 Q_GLOBAL_STATIC( FormCache, g_fieldCache )
 
 
+// Fields modified while running a batch of scripts
+static bool g_batching = false;
+Q_GLOBAL_STATIC( FormCache, g_modifiedFields )
+
 // Helper for modified fields
 static void updateField( FormField *field )
 {
     Page *page = g_fieldCache->value( field );
     if (page)
     {
+        if ( g_batching )
+        {
+            g_modifiedFields->insert( field, page );
+            return;
+        }
         Document *doc = PagePrivate::get( page )->m_doc->m_parent;
         QMetaObject::invokeMethod( doc, "refreshPixmaps", Qt::QueuedConnection, Q_ARG( int, page->number() ) );
         emit doc->refreshFormWidget( field );
@@ -48,6 +58,17 @@ static void updateField( FormField *field )
     }
 }
 
+// Helper for fields whose value was changed by a script
+static void fieldValueChanged( FormField *field )
+{
+    Page *page = g_fieldCache->value( field );
+    if (page)
+    {
+        PagePrivate::get( page )->m_doc->recordFormFieldWrite( field );
+    }
+    updateField( field );
+}
+
 // Field.doc
 static KJSObject fieldGetDoc( KJSContext *context, void *  )
 {
@@ -174,12 +195,12 @@ static void fieldSetValue( KJSContext *context, void *object, KJSObject value )
             if ( text == QStringLiteral( "Yes" ) )
             {
                 button->setState( true );
-                updateField( field );
+                fieldValueChanged( field );
             }
             else if ( text == QStringLiteral( "Off" ) )
             {
                 button->setState( false );
-                updateField( field );
+                fieldValueChanged( field );
             }
             break;
         }
@@ -190,7 +211,7 @@ static void fieldSetValue( KJSContext *context, void *object, KJSObject value )
             if ( text != textField->text() )
             {
                 textField->setText( text );
-                updateField( field );
+                fieldValueChanged( field );
             }
             break;
         }
@@ -241,3 +262,33 @@ void JSField::clearCachedFields()
         g_fieldCache->clear();
     }
 }
+
+void JSField::beginBatch()
+{
+    g_batching = true;
+}
+
+void JSField::endBatch()
+{
+    g_batching = false;
+    if ( !g_modifiedFields.exists() || g_modifiedFields->isEmpty() )
+    {
+        return;
+    }
+
+    // refresh each modified field once, and each page it is on once
+    const FormCache modifiedFields = *g_modifiedFields;
+    g_modifiedFields->clear();
+    QSet< Page * > pages;
+    FormCache::const_iterator it = modifiedFields.constBegin(), itEnd = modifiedFields.constEnd();
+    for ( ; it != itEnd; ++it )
+    {
+        Document *doc = PagePrivate::get( it.value() )->m_doc->m_parent;
+        if ( !pages.contains( it.value() ) )
+        {
+            pages.insert( it.value() );
+            QMetaObject::invokeMethod( doc, "refreshPixmaps", Qt::QueuedConnection, Q_ARG( int, it.value()->number() ) );
+        }
+        emit doc->refreshFormWidget( it.key() );
+    }
+}
@@ -25,6 +25,8 @@ class JSField
         static void initType( KJSContext *ctx );
         static KJSObject wrapField( KJSContext *ctx, FormField *field, Page *page );
         static void clearCachedFields();
+        static void beginBatch();
+        static void endBatch();
 };
 
 }
@@ -10,7 +10,6 @@
 #include "scripter.h"
 
 #include <QtCore/QDebug>
-#include <QFile>
 
 #include "debug_p.h"
 #include "script/executor_kjs_p.h"
@@ -26,6 +25,7 @@ class Okular::ScripterPrivate
             , m_kjs( nullptr )
 #endif
             , m_event( nullptr )
+            , m_batchDepth( 0 )
         {
         }
 
@@ -34,6 +34,7 @@ class Okular::ScripterPrivate
         QScopedPointer<ExecutorKJS> m_kjs;
 #endif
         Event *m_event;
+        int m_batchDepth;
 };
 
 Scripter::Scripter( DocumentPrivate *doc )
@@ -56,20 +57,6 @@ QString Scripter::execute( ScriptType type, const QString &script )
     else
         qDebug() << script.left( 1000 ) << "[...]";
 #endif
-    static QString builtInScript;
-    if ( builtInScript.isNull() )
-    {
-        QFile builtInResource ( ":/script/builtin.js" );
-        if (!builtInResource.open( QIODevice::ReadOnly ))
-        {
-            qCDebug(OkularCoreDebug) << "failed to load builtin script";
-        }
-        else
-        {
-            builtInScript = QString::fromUtf8( builtInResource.readAll() );
-            builtInResource.close();
-        }
-    }
 
     switch ( type )
     {
@@ -78,7 +65,7 @@ QString Scripter::execute( ScriptType type, const QString &script )
             {
                 d->m_kjs.reset(new ExecutorKJS( d->m_doc ));
             }
-            d->m_kjs->execute( builtInScript + script, d->m_event );
+            d->m_kjs->execute( script, d->m_event );
             break;
     }
 #endif
@@ -94,3 +81,29 @@ Event *Scripter::event() const
 {
     return d->m_event;
 }
+
+// the batches nest, the executor only sees the outermost one
+void Scripter::beginBatch()
+{
+    if ( d->m_batchDepth++ > 0 )
+        return;
+
+#ifdef WITH_KJS
+    if ( !d->m_kjs )
+    {
+        d->m_kjs.reset(new ExecutorKJS( d->m_doc ));
+    }
+    d->m_kjs->beginBatch();
+#endif
+}
+
+void Scripter::endBatch()
+{
+    Q_ASSERT( d->m_batchDepth > 0 );
+    if ( --d->m_batchDepth > 0 )
+        return;
+
+#ifdef WITH_KJS
+    d->m_kjs->endBatch();
+#endif
+}
@@ -35,6 +35,9 @@ class Scripter
         void setEvent( Event *event );
         Event *event() const;
 
+        void beginBatch();
+        void endBatch();
+
     private:
         friend class ScripterPrivate;
         ScripterPrivate* d;
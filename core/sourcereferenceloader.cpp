@@ -0,0 +1,147 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "sourcereferenceloader_p.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QRegExp>
+#include <QtCore/QStack>
+
+#include "debug_p.h"
+
+using namespace Okular;
+
+SourceReferenceLoader::SourceReferenceLoader( const QString &docFile, QObject *parent )
+    : QThread( parent ), m_docFile( docFile ), m_scanner( nullptr )
+{
+}
+
+SourceReferenceLoader::~SourceReferenceLoader()
+{
+    wait();
+    if ( m_scanner )
+        synctex_scanner_free( m_scanner );
+}
+
+synctex_scanner_p SourceReferenceLoader::takeSynctexScanner()
+{
+    synctex_scanner_p scanner = m_scanner;
+    m_scanner = nullptr;
+    return scanner;
+}
+
+QVector< PdfSyncPoint > SourceReferenceLoader::pdfSyncPoints() const
+{
+    return m_points;
+}
+
+void SourceReferenceLoader::run()
+{
+    // no need to check for the existence of a synctex file, no parser will be
+    // created if none exists
+    m_scanner = synctex_scanner_new_with_output_file( QFile::encodeName( m_docFile ).constData(), nullptr, 1 );
+    if ( !m_scanner )
+        loadPdfSync();
+}
+
+void SourceReferenceLoader::loadPdfSync()
+{
+    QFile f( m_docFile + QLatin1String( "sync" ) );
+    if ( !f.open( QIODevice::ReadOnly ) )
+        return;
+
+    // first row: core name of the pdf output
+    const QString coreName = QString::fromLocal8Bit( f.readLine() ).trimmed();
+    // second row: version string, in the form 'Version %u'
+    const QString versionstr = QString::fromLocal8Bit( f.readLine() ).trimmed();
+    QRegExp versionre( QStringLiteral("Version (\\d+)") );
+    versionre.setCaseSensitivity( Qt::CaseInsensitive );
+    if ( !versionre.exactMatch( versionstr ) )
+        return;
+
+    // point id -> index in m_points
+    QHash< int, int > points;
+    QStack< QString > fileStack;
+    int currentpage = -1;
+    const QLatin1String texStr( ".tex" );
+
+    fileStack.push( coreName + texStr );
+
+    while ( !f.atEnd() )
+    {
+        // the lines are mostly numbers, so tokenize the raw bytes and
+        // decode only the file names
+        const QByteArray line = f.readLine().trimmed();
+        const QList< QByteArray > tokens = line.simplified().split( ' ' );
+        const int tokenSize = tokens.count();
+        if ( line.isEmpty() )
+            continue;
+        if ( tokens.first() == "l" && tokenSize >= 3 )
+        {
+            const int id = tokens.at( 1 ).toInt();
+            if ( !points.contains( id ) )
+            {
+                PdfSyncPoint pt;
+                pt.x = 0;
+                pt.y = 0;
+                pt.row = tokens.at( 2 ).toInt();
+                pt.column = 0; // TODO
+                pt.page = -1;
+                pt.file = fileStack.isEmpty() ? QString() : fileStack.top();
+                points.insert( id, m_points.count() );
+                m_points.append( pt );
+            }
+        }
+        else if ( tokens.first() == "s" && tokenSize >= 2 )
+        {
+            currentpage = tokens.at( 1 ).toInt() - 1;
+        }
+        else if ( tokens.first() == "p*" && tokenSize >= 4 )
+        {
+            // TODO
+            qCDebug(OkularCoreDebug) << "PdfSync: 'p*' line ignored";
+        }
+        else if ( tokens.first() == "p" && tokenSize >= 4 )
+        {
+            QHash< int, int >::const_iterator it = points.constFind( tokens.at( 1 ).toInt() );
+            if ( it != points.constEnd() )
+            {
+                PdfSyncPoint &pt = m_points[ it.value() ];
+                pt.x = tokens.at( 2 ).toInt();
+                pt.y = tokens.at( 3 ).toInt();
+                pt.page = currentpage;
+            }
+        }
+        else if ( line.startsWith( '(' ) && tokenSize == 1 )
+        {
+            // chop the leading '('
+            QString newfile = QString::fromLocal8Bit( line.mid( 1 ) );
+            if ( !newfile.endsWith( texStr ) )
+            {
+                newfile += texStr;
+            }
+            fileStack.push( newfile );
+        }
+        else if ( line == ")" )
+        {
+            if ( !fileStack.isEmpty() )
+            {
+                fileStack.pop();
+            }
+            else
+               qCDebug(OkularCoreDebug) << "PdfSync: going one level down too much";
+        }
+        else
+            qCDebug(OkularCoreDebug).nospace() << "PdfSync: unknown line format: '" << line << "'";
+    }
+}
+
+#include "moc_sourcereferenceloader_p.cpp"
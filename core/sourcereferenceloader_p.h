@@ -0,0 +1,74 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_SOURCEREFERENCELOADER_P_H_
+#define _OKULAR_SOURCEREFERENCELOADER_P_H_
+
+#include <QtCore/QString>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include "synctex/synctex_parser.h"
+
+namespace Okular {
+
+/**
+ * A source reference read from a pdfsync file, still in TeX units.
+ */
+struct PdfSyncPoint
+{
+    QString file;
+    qlonglong x;
+    qlonglong y;
+    int row;
+    int column;
+    int page;
+};
+
+/**
+ * Parses the SyncTeX (or, as fallback, pdfsync) data of a document
+ * outside of the GUI thread.
+ *
+ * Big documents produce synctex files of several megabytes, whose
+ * parsing used to block the opening of the document.
+ */
+class SourceReferenceLoader : public QThread
+{
+    Q_OBJECT
+
+    public:
+        explicit SourceReferenceLoader( const QString &docFile, QObject *parent = nullptr );
+        ~SourceReferenceLoader();
+
+        /**
+         * Returns the loaded synctex scanner, if any, transferring its
+         * ownership to the caller.
+         */
+        synctex_scanner_p takeSynctexScanner();
+
+        /**
+         * Returns the points of the pdfsync file, used only when no
+         * synctex data was found.
+         */
+        QVector< PdfSyncPoint > pdfSyncPoints() const;
+
+    protected:
+        void run() override;
+
+    private:
+        void loadPdfSync();
+
+        const QString m_docFile;
+        synctex_scanner_p m_scanner;
+        QVector< PdfSyncPoint > m_points;
+};
+
+}
+
+#endif
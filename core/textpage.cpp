@@ -10,7 +10,11 @@
 #include "textpage.h"
 #include "textpage_p.h"
 
+#include <QtCore/QDataStream>
 #include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
 
 #include "area.h"
 #include "debug_p.h"
@@ -18,10 +22,10 @@
 #include "page.h"
 #include "page_p.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include <QtAlgorithms>
-#include <QVarLengthArray>
 
 using namespace Okular;
 
@@ -214,10 +218,15 @@ NormalizedRect TextEntity::transformedArea(const QTransform &matrix) const
 
 
 TextPagePrivate::TextPagePrivate()
-    : m_page( nullptr )
+    : m_page( nullptr ), m_textOrderCorrected( false )
 {
 }
 
+TextPagePrivate *TextPagePrivate::get( TextPage *textPage )
+{
+    return textPage->d;
+}
+
 TextPagePrivate::~TextPagePrivate()
 {
     qDeleteAll( m_searchPoints );
@@ -1365,9 +1374,90 @@ QList< QPair<WordsWithCharacters, QRect> > makeAndSortLines(const WordsWithChara
 }
 
 /**
- * Calculate Statistical information from the lines we made previously
+ * The geometries of a word needed by the XY Cut, computed once for all the
+ * words of the page instead of at every level of the tree
  */
-static void calculateStatisticalInformation(const QList<WordWithCharacters> &words, int pageWidth, int pageHeight, int *word_spacing, int *line_spacing, int *col_spacing)
+struct WordGeometry
+{
+    QRect area;        // geometry(pageWidth, pageHeight)
+    QRect roundedArea; // roundedGeometry(pageWidth, pageHeight)
+    int sortLeft;      // roundedGeometry(1000, 1000).left(), like compareTinyTextEntityX
+    int sortTop;       // roundedGeometry(1000, 1000).top(), like compareTinyTextEntityY
+};
+
+/**
+ * Same as makeAndSortLines, for the words whose indexes are in [begin, end).
+ * Only the indexes are sorted, with the same algorithm, so the lines and the
+ * order inside them are the same as if the words themselves were sorted.
+ */
+static void makeAndSortLineIndexes(const int *begin, const int *end, const QVector<WordGeometry> &geometries,
+                                   QVector< QVector<int> > *lines, QVector<QRect> *lineAreas)
+{
+    QVector<int> words;
+    words.reserve(end - begin);
+    for( const int *it = begin ; it != end ; ++it )
+        words.append(*it);
+
+    // Step 1
+    qSort(words.begin(), words.end(), [&geometries](int first, int second) {
+        return geometries.at(first).sortTop < geometries.at(second).sortTop;
+    });
+
+    // Step 2
+    foreach( int word, words )
+    {
+        const QRect elementArea = geometries.at(word).roundedArea;
+        bool found = false;
+
+        for( int i = 0 ; i < lines->count() ; i++ )
+        {
+            QRect &lineArea = (*lineAreas)[i];
+            const int text_y1 = elementArea.top() ,
+                      text_y2 = elementArea.top() + elementArea.height() ,
+                      text_x1 = elementArea.left(),
+                      text_x2 = elementArea.left() + elementArea.width();
+            const int line_y1 = lineArea.top() ,
+                      line_y2 = lineArea.top() + lineArea.height(),
+                      line_x1 = lineArea.left(),
+                      line_x2 = lineArea.left() + lineArea.width();
+
+            if(doesConsumeY(elementArea,lineArea,70))
+            {
+                (*lines)[i].append(word);
+
+                const int newLeft = line_x1 < text_x1 ? line_x1 : text_x1;
+                const int newRight = line_x2 > text_x2 ? line_x2 : text_x2;
+                const int newTop = line_y1 < text_y1 ? line_y1 : text_y1;
+                const int newBottom = text_y2 > line_y2 ? text_y2 : line_y2;
+
+                lineArea = QRect( newLeft,newTop, newRight - newLeft, newBottom - newTop );
+                found = true;
+                break;
+            }
+        }
+
+        if(!found)
+        {
+            lines->append(QVector<int>(1, word));
+            lineAreas->append(elementArea);
+        }
+    }
+
+    // Step 3
+    for( int i = 0 ; i < lines->count() ; i++ )
+    {
+        QVector<int> &line = (*lines)[i];
+        qSort(line.begin(), line.end(), [&geometries](int first, int second) {
+            return geometries.at(first).sortLeft < geometries.at(second).sortLeft;
+        });
+    }
+}
+
+/**
+ * Calculate Statistical information from the lines made of the words whose
+ * indexes are in [begin, end)
+ */
+static void calculateStatisticalInformation(const int *begin, const int *end, const QVector<WordGeometry> &geometries, int pageWidth, int *word_spacing, int *line_spacing, int *col_spacing)
 {
     /**
      * For the region, defined by line_rects and lines
@@ -1375,246 +1465,216 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
      * 2. Make character statistical analysis to differentiate between
      *   word spacing and column spacing.
      */
-    
+
     /**
      * Step 0
      */
-    const QList< QPair<WordsWithCharacters, QRect> > sortedLines = makeAndSortLines(words, pageWidth, pageHeight);
+    QVector< QVector<int> > sortedLines;
+    QVector<QRect> lineAreas;
+    makeAndSortLineIndexes(begin, end, geometries, &sortedLines, &lineAreas);
 
     /**
      * Step 1
+     * The line spacing is the average space between consecutive lines
      */
-    QMap<int,int> line_space_stat;
-    for(int i = 0 ; i < sortedLines.length(); i++)
+    int line_space_sum = 0, line_space_count = 0;
+    for(int i = 0 ; i + 1 < lineAreas.count() ; i++)
     {
-        const QRect rectUpper = sortedLines.at(i).second;
-
-        if(i+1 == sortedLines.length()) break;
-        const QRect rectLower = sortedLines.at(i+1).second;
+        const QRect rectUpper = lineAreas.at(i);
+        const QRect rectLower = lineAreas.at(i+1);
 
         int linespace = rectLower.top() - (rectUpper.top() + rectUpper.height());
         if(linespace < 0) linespace =-linespace;
 
-        if(line_space_stat.contains(linespace))
-            line_space_stat[linespace]++;
-        else line_space_stat[linespace] = 1;
+        line_space_sum += linespace;
+        line_space_count++;
     }
 
     *line_spacing = 0;
-    int weighted_count = 0;
-    QMapIterator<int, int> iterate_linespace(line_space_stat);
-
-    while(iterate_linespace.hasNext())
-    {
-        iterate_linespace.next();
-        *line_spacing += iterate_linespace.value() * iterate_linespace.key();
-        weighted_count += iterate_linespace.value();
-    }
-    if (*line_spacing != 0)
-        *line_spacing = (int) ( (double)*line_spacing / (double) weighted_count + 0.5);
+    if (line_space_sum != 0)
+        *line_spacing = (int) ( (double)line_space_sum / (double) line_space_count + 0.5);
 
     /**
      * Step 2
+     * The widest space of each line counts as a column space, all the
+     * others as word spaces
      */
-    // We would like to use QMap instead of QHash as it will keep the keys sorted
-    QMap<int,int> hor_space_stat;
-    QMap<int,int> col_space_stat;
-    QList< QList<QRect> > space_rects;
-    QList<QRect> max_hor_space_rects;
-
-    // Space in every line
-    for(int i = 0 ; i < sortedLines.length() ; i++)
-    {
-        const WordsWithCharacters list = sortedLines.at(i).first;
-        QList<QRect> line_space_rects;
-        int maxSpace = 0, minSpace = pageWidth;
+    QHash<int,int> hor_space_stat;
+    QHash<int,int> col_space_stat;
+    int hor_space_sum = 0, hor_space_count = 0;
 
-        // for every TinyTextEntity element in the line
-        WordsWithCharacters::ConstIterator it = list.begin(), itEnd = list.end();
-        QRect max_area1,max_area2;
-        QString before_max, after_max;
+    for(int i = 0 ; i < sortedLines.count() ; i++)
+    {
+        const QVector<int> &line = sortedLines.at(i);
+        int maxSpace = 0;
 
-        // for every line
-        for( ; it != itEnd ; it++ )
+        for(int j = 0 ; j + 1 < line.count() ; j++)
         {
-            const QRect area1 = (*it).area().roundedGeometry(pageWidth,pageHeight);
-            if( it+1 == itEnd ) break;
-
-            const QRect area2 = (*(it+1)).area().roundedGeometry(pageWidth,pageHeight);
-            int space = area2.left() - area1.right();
+            const QRect area1 = geometries.at(line.at(j)).roundedArea;
+            const QRect area2 = geometries.at(line.at(j+1)).roundedArea;
+            const int space = area2.left() - area1.right();
 
             if(space > maxSpace)
-            {
-                max_area1 = area1;
-                max_area2 = area2;
                 maxSpace = space;
-                before_max = (*it).text();
-                after_max = (*(it+1)).text();
-            }
-
-            if(space < minSpace && space != 0) minSpace = space;
 
             //if we found a real space, whose length is not zero and also less than the pageWidth
             if(space != 0 && space != pageWidth)
             {
                 // increase the count of the space amount
-                if(hor_space_stat.contains(space)) hor_space_stat[space]++;
-                else hor_space_stat[space] = 1;
-
-                int left,right,top,bottom;
-
-                left = area1.right();
-                right = area2.left();
-
-                top = area2.top() < area1.top() ? area2.top() : area1.top();
-                bottom = area2.bottom() > area1.bottom() ? area2.bottom() : area1.bottom();
-
-                QRect rect(left,top,right-left,bottom-top);
-                line_space_rects.append(rect);
+                hor_space_stat[space]++;
+                if(space > 0)
+                {
+                    hor_space_sum += space;
+                    hor_space_count++;
+                }
             }
         }
 
-        space_rects.append(line_space_rects);
-
-        if(hor_space_stat.contains(maxSpace))
+        QHash<int,int>::iterator maxSpaceIt = hor_space_stat.find(maxSpace);
+        if(maxSpaceIt != hor_space_stat.end())
         {
-            if(hor_space_stat[maxSpace] != 1)
-                hor_space_stat[maxSpace]--;
-            else hor_space_stat.remove(maxSpace);
+            if(--(*maxSpaceIt) == 0)
+                hor_space_stat.erase(maxSpaceIt);
+            if(maxSpace > 0)
+            {
+                hor_space_sum -= maxSpace;
+                hor_space_count--;
+            }
         }
 
         if(maxSpace != 0)
-        {
-            if (col_space_stat.contains(maxSpace))
-                col_space_stat[maxSpace]++;
-            else col_space_stat[maxSpace] = 1;
-
-            //store the max rect of each line
-            const int left = max_area1.right();
-                const int right = max_area2.left();
-            const int top = (max_area1.top() > max_area2.top()) ? max_area2.top() :
-                                                                  max_area1.top();
-            const int bottom = (max_area1.bottom() < max_area2.bottom()) ? max_area2.bottom() :
-                                                                           max_area1.bottom();
-
-            const QRect rect(left,top,right-left,bottom-top);
-            max_hor_space_rects.append(rect);
-        }
-        else max_hor_space_rects.append(QRect(0,0,0,0));
+            col_space_stat[maxSpace]++;
     }
 
     // All the between word space counts are in hor_space_stat
     *word_spacing = 0;
-    weighted_count = 0;
-    QMapIterator<int, int> iterate(hor_space_stat);
-
-    while (iterate.hasNext())
-    {
-        iterate.next();
-
-        if(iterate.key() > 0)
-        {
-            *word_spacing += iterate.value() * iterate.key();
-            weighted_count += iterate.value();
-        }
-    }
-    if(weighted_count)
-        *word_spacing = (int) ((double)*word_spacing / (double)weighted_count + 0.5);
+    if(hor_space_count)
+        *word_spacing = (int) ((double)hor_space_sum / (double)hor_space_count + 0.5);
 
+    // the most frequent column space, the smallest one in case of a tie
+    int col_space_count = 0;
     *col_spacing = 0;
-    QMapIterator<int, int> iterate_col(col_space_stat);
-
+    QHashIterator<int, int> iterate_col(col_space_stat);
     while (iterate_col.hasNext())
     {
         iterate_col.next();
-        if(iterate_col.value() > *col_spacing) *col_spacing = iterate_col.value();
+        if(iterate_col.value() > col_space_count || (iterate_col.value() == col_space_count && iterate_col.key() < *col_spacing))
+        {
+            col_space_count = iterate_col.value();
+            *col_spacing = iterate_col.key();
+        }
     }
-    *col_spacing = col_space_stat.key(*col_spacing);
 
     // if there is just one line in a region, there is no point in dividing it
-    if(sortedLines.length() == 1)
+    if(sortedLines.count() == 1)
         *word_spacing = *col_spacing;
 }
 
+/**
+ * Adds @p value to the projection profile @p proj of @p size entries, from
+ * @p first to @p last included. The profile holds differences between
+ * consecutive entries, and is integrated once all the words are added.
+ */
+static inline void addToProjection(int *proj, int size, int first, int last, int value)
+{
+    first = qMax(first, 0);
+    last = qMin(last, size - 1);
+    if(first > last)
+        return;
+
+    proj[first] += value;
+    proj[last + 1] -= value;
+}
+
+/**
+ * A region of the XY Cut tree: the words whose indexes are in [begin, end) and their area
+ */
+struct XYCutRegion
+{
+    int begin;
+    int end;
+    QRect area;
+};
+
 /**
  * Implements the XY Cut algorithm for textpage segmentation
  * The resulting RegionTextList will contain RegionText whose WordsWithCharacters::word and
  * WordsWithCharacters::characters are reused from wordsWithCharacters (i.e. no new nor delete happens in this function)
+ *
+ * The words are not copied while cutting: every region is a range of a single
+ * array of word indexes, and cutting a region partitions its range in place.
  */
 static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wordsWithCharacters, const NormalizedRect &boundingBox, int pageWidth, int pageHeight)
 {
-    RegionTextList tree;
-    QRect contentRect(boundingBox.geometry(pageWidth,pageHeight));
-    const RegionText root(wordsWithCharacters, contentRect);
+    const int wordCount = wordsWithCharacters.count();
+    QVector<WordGeometry> geometries(wordCount);
+    QVector<int> indexes(wordCount);
+    for(int j = 0 ; j < wordCount ; ++j)
+    {
+        const NormalizedRect &area = wordsWithCharacters.at(j).area();
+        const QRect sortArea = area.roundedGeometry(1000,1000);
+        WordGeometry &geometry = geometries[j];
+        geometry.area = area.geometry(pageWidth,pageHeight);
+        geometry.roundedArea = area.roundedGeometry(pageWidth,pageHeight);
+        geometry.sortLeft = sortArea.left();
+        geometry.sortTop = sortArea.top();
+        indexes[j] = j;
+    }
 
-    // start the tree with the root, it is our only region at the start
-    tree.push_back(root);
+    // The regions still to be cut are in a stack, the first half of a cut on top,
+    // so the leaves come out in the same order as the tree is read
+    QVector<XYCutRegion> leaves;
+    QVector<XYCutRegion> regions;
+    const XYCutRegion root = { 0, wordCount, boundingBox.geometry(pageWidth,pageHeight) };
+    regions.append(root);
 
-    int i = 0;
+    QVector<int> proj_on_xaxis;
+    QVector<int> proj_on_yaxis;
 
-    // while traversing the tree has not been ended
-    while(i < tree.length())
+    while(!regions.isEmpty())
     {
-        const RegionText node = tree.at(i);
-        QRect regionRect = node.area();
+        const XYCutRegion node = regions.takeLast();
+        QRect regionRect = node.area;
+        int *wordsBegin = indexes.data() + node.begin;
+        int *wordsEnd = indexes.data() + node.end;
 
         /**
          * 1. calculation of projection profiles
          */
-        // allocate the size of proj profiles and initialize with 0
-        int size_proj_y = node.area().height();
-        int size_proj_x = node.area().width();
-        //dynamic memory allocation
-        QVarLengthArray<int> proj_on_xaxis(size_proj_x);
-        QVarLengthArray<int> proj_on_yaxis(size_proj_y);
-
-        for( int j = 0 ; j < size_proj_y ; ++j ) proj_on_yaxis[j] = 0;
-        for( int j = 0 ; j < size_proj_x ; ++j ) proj_on_xaxis[j] = 0;
-
-        const QList<WordWithCharacters> list = node.text();
+        const int size_proj_y = qMax(node.area.height(), 0);
+        const int size_proj_x = qMax(node.area.width(), 0);
+        proj_on_xaxis.fill(0, size_proj_x + 1);
+        proj_on_yaxis.fill(0, size_proj_y + 1);
 
         // Calculate tcx and tcy locally for each new region
         int word_spacing, line_spacing, column_spacing;
-        calculateStatisticalInformation(list, pageWidth, pageHeight, &word_spacing, &line_spacing, &column_spacing);
+        calculateStatisticalInformation(wordsBegin, wordsEnd, geometries, pageWidth, &word_spacing, &line_spacing, &column_spacing);
 
         const int tcx = word_spacing * 2;
         const int tcy = line_spacing * 2;
 
-        int maxX = 0 , maxY = 0;
-        int avgX = 0;
-        int count;
-
-        // for every text in the region
-        for(int j = 0 ; j < list.length() ; ++j )
-        {
-            TinyTextEntity *ent = list.at(j).word;
-            const QRect entRect = ent->area.geometry(pageWidth, pageHeight);
-
-            // calculate vertical projection profile proj_on_xaxis1
-            for(int k = entRect.left() ; k <= entRect.left() + entRect.width() ; ++k)
-            {
-                if( ( k-regionRect.left() ) < size_proj_x && ( k-regionRect.left() ) >= 0 )
-                    proj_on_xaxis[k - regionRect.left()] += entRect.height();
-            }
-
-            // calculate horizontal projection profile in the same way
-            for(int k = entRect.top() ; k <= entRect.top() + entRect.height() ; ++k)
-            {
-                if( ( k-regionRect.top() ) < size_proj_y && ( k-regionRect.top() ) >= 0 )
-                    proj_on_yaxis[k - regionRect.top()] += entRect.width();
-            }
-        }
-
-        for( int j = 0 ; j < size_proj_y ; ++j )
+        // every word adds its height to the columns it covers (vertical
+        // projection profile) and its width to the rows it covers (horizontal
+        // projection profile)
+        for(const int *it = wordsBegin ; it != wordsEnd ; ++it)
         {
-            if (proj_on_yaxis[j] > maxY)
-                maxY = proj_on_yaxis[j];
+            const QRect &entRect = geometries.at(*it).area;
+            addToProjection(proj_on_xaxis.data(), size_proj_x,
+                            entRect.left() - regionRect.left(),
+                            entRect.left() + entRect.width() - regionRect.left(),
+                            entRect.height());
+            addToProjection(proj_on_yaxis.data(), size_proj_y,
+                            entRect.top() - regionRect.top(),
+                            entRect.top() + entRect.height() - regionRect.top(),
+                            entRect.width());
         }
+        for( int j = 1 ; j < size_proj_x ; ++j ) proj_on_xaxis[j] += proj_on_xaxis[j-1];
+        for( int j = 1 ; j < size_proj_y ; ++j ) proj_on_yaxis[j] += proj_on_yaxis[j-1];
 
-        avgX = count = 0;
+        int avgX = 0;
+        int count = 0;
         for( int j = 0 ; j < size_proj_x ; ++j )
         {
-            if(proj_on_xaxis[j] > maxX) maxX = proj_on_xaxis[j];
             if(proj_on_xaxis[j])
             {
                 count++;
@@ -1746,56 +1806,35 @@ static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wor
         else
         {
             // we can now update the node rectangle with the shrinked rectangle
-            RegionText tmpNode = tree.at(i);
-            tmpNode.setArea(regionRect);
-            tree.replace(i,tmpNode);
-            i++;
+            const XYCutRegion leaf = { node.begin, node.end, regionRect };
+            leaves.append(leaf);
             continue;
         }
 
-        WordsWithCharacters list1,list2;
-
-        // horizontal cut, topRect and bottomRect
-        if(cut_hor)
-        {
-            for( int j = 0 ; j < list.length() ; ++j )
-            {
-                const WordWithCharacters word = list.at(j);
-                const QRect wordRect = word.area().geometry(pageWidth,pageHeight);
-
-                if(topRect.intersects(wordRect))
-                    list1.append(word);
-                else
-                    list2.append(word);
-            }
-
-            RegionText node1(list1,topRect);
-            RegionText node2(list2,bottomRect);
-
-            tree.replace(i,node1);
-            tree.insert(i+1,node2);
-        }
-
-        //vertical cut, leftRect and rightRect
-        else if(cut_ver)
-        {
-            for( int j = 0 ; j < list.length() ; ++j )
-            {
-                const WordWithCharacters word = list.at(j);
-                const QRect wordRect = word.area().geometry(pageWidth,pageHeight);
-
-                if(leftRect.intersects(wordRect))
-                    list1.append(word);
-                else 
-                    list2.append(word);
-            }
-
-            RegionText node1(list1,leftRect);
-            RegionText node2(list2,rightRect);
+        // the words intersecting the first rectangle go to the first region,
+        // keeping their order, the others to the second one
+        const QRect firstRect = cut_hor ? topRect : leftRect;
+        const QRect secondRect = cut_hor ? bottomRect : rightRect;
+        const int *wordsMiddle = std::stable_partition(wordsBegin, wordsEnd, [&geometries, &firstRect](int word) {
+            return firstRect.intersects(geometries.at(word).area);
+        });
+        const int middle = wordsMiddle - indexes.constData();
+
+        const XYCutRegion node1 = { node.begin, middle, firstRect };
+        const XYCutRegion node2 = { middle, node.end, secondRect };
+        regions.append(node2);
+        regions.append(node1);
+    }
 
-            tree.replace(i,node1);
-            tree.insert(i+1,node2);
-        }
+    RegionTextList tree;
+    tree.reserve(leaves.count());
+    foreach(const XYCutRegion &leaf, leaves)
+    {
+        WordsWithCharacters list;
+        list.reserve(leaf.end - leaf.begin);
+        for(int j = leaf.begin ; j < leaf.end ; ++j)
+            list.append(wordsWithCharacters.at(indexes.at(j)));
+        tree.append(RegionText(list, leaf.area));
     }
 
     return tree;
@@ -1877,13 +1916,18 @@ WordsWithCharacters addNecessarySpace(RegionTextList tree, int pageWidth, int pa
  */
 void TextPagePrivate::correctTextOrder()
 {
-    //m_page->m_page->width() and m_page->m_page->height() are in pixels at
-    //100% zoom level, and thus depend on display DPI. We scale pageWidth and
-    //pageHeight to remove the dependence. Otherwise bugs would be more difficult
-    //to reproduce and Okular could fail in extreme cases like a large TV with low DPI.
-    const double scalingFactor = 2000.0 / (m_page->width() + m_page->height());
-    const int pageWidth  = (int) (scalingFactor * m_page->width() );
-    const int pageHeight = (int) (scalingFactor * m_page->height());
+    correctTextOrder( m_page->width(), m_page->height(), m_page->boundingBox() );
+}
+
+void TextPagePrivate::correctTextOrder( double width, double height, const NormalizedRect &boundingBox )
+{
+    //width and height are in pixels at 100% zoom level, and thus depend on
+    //display DPI. We scale pageWidth and pageHeight to remove the dependence.
+    //Otherwise bugs would be more difficult to reproduce and Okular could fail
+    //in extreme cases like a large TV with low DPI.
+    const double scalingFactor = 2000.0 / (width + height);
+    const int pageWidth  = (int) (scalingFactor * width );
+    const int pageHeight = (int) (scalingFactor * height);
 
     TextList characters = m_words;
 
@@ -1900,7 +1944,7 @@ void TextPagePrivate::correctTextOrder()
     /**
      * Make a XY Cut tree for segmentation of the texts
      */
-    const RegionTextList tree = XYCutForBoundingBoxes(wordsWithCharacters, m_page->boundingBox(), pageWidth, pageHeight);
+    const RegionTextList tree = XYCutForBoundingBoxes(wordsWithCharacters, boundingBox, pageWidth, pageHeight);
 
     /**
      * Add spaces to the word
@@ -1917,6 +1961,79 @@ void TextPagePrivate::correctTextOrder()
         listOfCharacters.append(word.characters);
     }
     setWordList(listOfCharacters);
+    m_textOrderCorrected = true;
+}
+
+// bump the version whenever the text order correction changes
+static const quint32 correctedTextMagic = 0x6f6b7470; // "oktp"
+static const quint32 correctedTextVersion = 2;
+
+bool TextPagePrivate::saveCorrectedText( const QString &fileName, double pageWidth, double pageHeight, const NormalizedRect &boundingBox ) const
+{
+    if ( fileName.isEmpty() || !QDir().mkpath( QFileInfo( fileName ).absolutePath() ) )
+        return false;
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        return false;
+
+    QDataStream stream( &file );
+    stream << correctedTextMagic << correctedTextVersion;
+    // the order depends on them, see correctTextOrder()
+    stream << pageWidth << pageHeight << boundingBox.left << boundingBox.top << boundingBox.right << boundingBox.bottom;
+    stream << (quint32)m_words.count();
+    foreach ( const TinyTextEntity *te, m_words )
+    {
+        stream << te->text() << te->area.left << te->area.top << te->area.right << te->area.bottom;
+    }
+
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+TextPage *TextPagePrivate::loadCorrectedText( const QString &fileName, double pageWidth, double pageHeight, const NormalizedRect &boundingBox )
+{
+    if ( fileName.isEmpty() )
+        return nullptr;
+
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return nullptr;
+
+    QDataStream stream( &file );
+    quint32 magic, version;
+    stream >> magic >> version;
+    if ( stream.status() != QDataStream::Ok || magic != correctedTextMagic || version != correctedTextVersion )
+        return nullptr;
+
+    // corrected for another layout, the bounding box of a page is known
+    // only once it has been rendered
+    double width, height;
+    NormalizedRect box;
+    quint32 count;
+    stream >> width >> height >> box.left >> box.top >> box.right >> box.bottom >> count;
+    if ( stream.status() != QDataStream::Ok || width != pageWidth || height != pageHeight || !( box == boundingBox ) )
+        return nullptr;
+
+    TextPage *textPage = new TextPage();
+    TextPagePrivate *d = textPage->d;
+    d->m_words.reserve( count );
+    for ( quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i )
+    {
+        QString text;
+        NormalizedRect area;
+        stream >> text >> area.left >> area.top >> area.right >> area.bottom;
+        if ( !text.isEmpty() )
+            d->m_words.append( new TinyTextEntity( text, area ) );
+    }
+
+    if ( stream.status() != QDataStream::Ok )
+    {
+        delete textPage;
+        return nullptr;
+    }
+
+    d->m_textOrderCorrected = true;
+    return textPage;
 }
 
 TextEntity::List TextPage::words(const RegularAreaRect *area, TextAreaInclusionBehaviour b) const
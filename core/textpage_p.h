@@ -16,6 +16,8 @@
 #include <QtCore/QPair>
 #include <QtGui/QTransform>
 
+#include "okularcore_export.h"
+
 class SearchPoint;
 class TinyTextEntity;
 class RegionText;
@@ -23,7 +25,9 @@ class RegionText;
 namespace Okular
 {
 
+class NormalizedRect;
 class PagePrivate;
+class TextPage;
 typedef QList< TinyTextEntity* > TextList;
 
 /**
@@ -65,10 +69,32 @@ class TextPagePrivate
          */
         void correctTextOrder();
 
+        /**
+         * Same as correctTextOrder(), for a page of the given size (at 100% zoom)
+         * and bounding box. It does not access the page, so it can run in the
+         * text generation thread.
+         */
+        void correctTextOrder( double pageWidth, double pageHeight, const NormalizedRect &boundingBox );
+
+        /**
+         * Saves the corrected words to @p fileName, along with the page size
+         * and bounding box they were corrected for
+         */
+        OKULARCORE_EXPORT bool saveCorrectedText( const QString &fileName, double pageWidth, double pageHeight, const NormalizedRect &boundingBox ) const;
+
+        /**
+         * Loads a text page saved by saveCorrectedText(), or returns nullptr,
+         * also if it was corrected for another page size or bounding box
+         */
+        OKULARCORE_EXPORT static TextPage *loadCorrectedText( const QString &fileName, double pageWidth, double pageHeight, const NormalizedRect &boundingBox );
+
+        OKULARCORE_EXPORT static TextPagePrivate *get( TextPage *textPage );
+
         // variables those can be accessed directly from TextPage
         TextList m_words;
         QMap< int, SearchPoint* > m_searchPoints;
         Page *m_page;
+        bool m_textOrderCorrected;
 
     private:
         RegularAreaRect * searchPointToArea(const SearchPoint* sp);
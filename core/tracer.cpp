@@ -0,0 +1,281 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "tracer_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include "debug_p.h"
+
+using namespace Okular;
+
+// about 50 MB, the oldest events are dropped after that
+static const int maxEvents = 1000000;
+
+QBasicAtomicInt Tracer::s_enabled = Q_BASIC_ATOMIC_INITIALIZER( 0 );
+
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    // the object of the async events, 0 for the complete ones
+    quint64 id;
+    qint64 start;
+    qint64 end;
+    int thread;
+    int page;
+};
+
+class TraceLog
+{
+    public:
+        TraceLog()
+            : next( 0 ), lastAsyncId( 0 ), enabledByEnvironment( false ), enabledByConfig( false )
+        {
+            clock.start();
+            fileName = QFile::decodeName( qgetenv( "OKULAR_TRACE" ) );
+            enabledByEnvironment = !fileName.isEmpty();
+            if ( !enabledByEnvironment )
+                fileName = QDir::temp().filePath( QStringLiteral( "okular-trace-%1.json" ).arg( QCoreApplication::applicationPid() ) );
+        }
+
+        ~TraceLog()
+        {
+            if ( Tracer::isEnabled() )
+                write( fileName );
+        }
+
+        int currentThread();
+        void record( const TraceEvent &event );
+        bool write( const QString &fileName );
+
+        QMutex mutex;
+        QVector< TraceEvent > events;
+        // the oldest event, once there are maxEvents of them
+        int next;
+        quint64 lastAsyncId;
+        QHash< int, QString > threadNames;
+        QElapsedTimer clock;
+        QString fileName;
+        bool enabledByEnvironment;
+        bool enabledByConfig;
+};
+
+Q_GLOBAL_STATIC( TraceLog, s_log )
+
+// enable tracing as soon as the library is loaded, to see the startup too
+static bool initFromEnvironment()
+{
+    if ( qEnvironmentVariableIsEmpty( "OKULAR_TRACE" ) )
+        return false;
+    Tracer::setEnabledByConfig( false );
+    return true;
+}
+static const bool s_initialized = initFromEnvironment();
+
+// small numbers are easier to read than the thread handles; the mutex of
+// the log is held
+int TraceLog::currentThread()
+{
+    static thread_local int thread = 0;
+    if ( thread == 0 )
+    {
+        thread = threadNames.count() + 1;
+        QThread *qthread = QThread::currentThread();
+        QString name = qthread->objectName();
+        if ( name.isEmpty() )
+            name = QCoreApplication::instance() && qthread == QCoreApplication::instance()->thread() ? QStringLiteral( "main" ) : QString::fromLatin1( qthread->metaObject()->className() );
+        threadNames.insert( thread, name );
+    }
+    return thread;
+}
+
+void TraceLog::record( const TraceEvent &event )
+{
+    QMutexLocker locker( &mutex );
+    TraceEvent threadEvent = event;
+    threadEvent.thread = currentThread();
+    if ( events.count() < maxEvents )
+    {
+        events.append( threadEvent );
+    }
+    else
+    {
+        events[ next ] = threadEvent;
+        next = ( next + 1 ) % maxEvents;
+    }
+}
+
+static void writeEvent( QByteArray &json, const char *name, const char *category, char phase, quint64 id, qint64 time, int thread, int page )
+{
+    static const QByteArray pid = QByteArray::number( QCoreApplication::applicationPid() );
+
+    json += "{\"name\":\"";
+    json += name;
+    json += "\",\"cat\":\"";
+    json += category;
+    json += "\",\"ph\":\"";
+    json += phase;
+    json += "\",\"ts\":";
+    json += QByteArray::number( time );
+    json += ",\"pid\":";
+    json += pid;
+    json += ",\"tid\":";
+    json += QByteArray::number( thread );
+    if ( id )
+    {
+        json += ",\"id\":\"0x";
+        json += QByteArray::number( id, 16 );
+        json += '"';
+    }
+    if ( page >= 0 )
+    {
+        // as shown to the user
+        json += ",\"args\":{\"page\":";
+        json += QByteArray::number( page + 1 );
+        json += '}';
+    }
+}
+
+bool TraceLog::write( const QString &fileName )
+{
+    QVector< TraceEvent > orderedEvents;
+    QHash< int, QString > names;
+    {
+        QMutexLocker locker( &mutex );
+        orderedEvents.reserve( events.count() );
+        for ( int i = 0; i < events.count(); ++i )
+            orderedEvents.append( events.at( ( next + i ) % events.count() ) );
+        names = threadNames;
+    }
+
+    QByteArray json = "{\"traceEvents\":[\n";
+    for ( QHash< int, QString >::const_iterator it = names.constBegin(); it != names.constEnd(); ++it )
+    {
+        // the thread names are set by anyone, QJsonDocument escapes them
+        QJsonObject args;
+        args.insert( QStringLiteral( "name" ), it.value() );
+        QJsonObject metadata;
+        metadata.insert( QStringLiteral( "name" ), QStringLiteral( "thread_name" ) );
+        metadata.insert( QStringLiteral( "ph" ), QStringLiteral( "M" ) );
+        metadata.insert( QStringLiteral( "pid" ), QCoreApplication::applicationPid() );
+        metadata.insert( QStringLiteral( "tid" ), it.key() );
+        metadata.insert( QStringLiteral( "args" ), args );
+        json += QJsonDocument( metadata ).toJson( QJsonDocument::Compact );
+        json += ",\n";
+    }
+    for ( const TraceEvent &event : qAsConst( orderedEvents ) )
+    {
+        if ( event.id )
+        {
+            writeEvent( json, event.name, event.category, 'b', event.id, event.start, event.thread, event.page );
+            json += "},\n";
+            writeEvent( json, event.name, event.category, 'e', event.id, event.end, event.thread, -1 );
+            json += "},\n";
+        }
+        else
+        {
+            writeEvent( json, event.name, event.category, 'X', 0, event.start, event.thread, event.page );
+            json += ",\"dur\":";
+            json += QByteArray::number( event.end - event.start );
+            json += "},\n";
+        }
+    }
+    // no trailing comma
+    if ( json.endsWith( ",\n" ) )
+        json.chop( 2 );
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( json ) != json.size() || !file.commit() )
+    {
+        qCWarning(OkularCoreDebug) << "Failed to write the trace to" << fileName;
+        return false;
+    }
+    qCInfo(OkularCoreDebug) << "Trace written to" << fileName;
+    return true;
+}
+
+void Tracer::setEnabledByConfig( bool enabled )
+{
+    TraceLog *log = s_log();
+    bool disabled = false;
+    {
+        QMutexLocker locker( &log->mutex );
+        log->enabledByConfig = enabled;
+        const bool enable = log->enabledByConfig || log->enabledByEnvironment;
+        if ( enable == isEnabled() )
+            return;
+
+        if ( enable )
+        {
+            log->events.clear();
+            log->next = 0;
+            s_enabled.store( 1 );
+            qCInfo(OkularCoreDebug) << "Tracing, the trace will be written to" << log->fileName;
+        }
+        else
+        {
+            s_enabled.store( 0 );
+            disabled = true;
+        }
+    }
+
+    if ( disabled )
+        log->write( log->fileName );
+}
+
+qint64 Tracer::now()
+{
+    // the log is gone once the process is exiting
+    TraceLog *log = s_log();
+    return log ? log->clock.nsecsElapsed() / 1000 : 0;
+}
+
+void Tracer::complete( const char *name, const char *category, qint64 start, qint64 end, int page )
+{
+    if ( !isEnabled() )
+        return;
+    const TraceEvent event = { name, category, 0, start, end, 0, page };
+    if ( TraceLog *log = s_log() )
+        log->record( event );
+}
+
+quint64 Tracer::newAsyncId()
+{
+    TraceLog *log = s_log();
+    if ( !log )
+        return 0;
+    QMutexLocker locker( &log->mutex );
+    return ++log->lastAsyncId;
+}
+
+void Tracer::async( const char *name, const char *category, quint64 id, qint64 start, qint64 end, int page )
+{
+    if ( !isEnabled() )
+        return;
+    const TraceEvent event = { name, category, id, start, end, 0, page };
+    if ( TraceLog *log = s_log() )
+        log->record( event );
+}
+
+bool Tracer::save( const QString &fileName )
+{
+    return s_log()->write( fileName );
+}
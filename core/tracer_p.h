@@ -0,0 +1,115 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_TRACER_P_H_
+#define _OKULAR_TRACER_P_H_
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QString>
+
+#include "okularcore_export.h"
+
+namespace Okular {
+
+/**
+ * Records the time taken by the hot paths of the rendering (queueing of the
+ * pixmap requests, generation of the images and of the text pages, painting,
+ * freeing of the pixmaps, search) and writes it as a Chrome trace event JSON
+ * file, to be opened in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Tracing is enabled by setting the OKULAR_TRACE environment variable to the
+ * name of the file to write, or from the debug configuration page, in which
+ * case the file is written to the temporary directory. The file is written
+ * when tracing is disabled, and when the process exits.
+ *
+ * Only the last events are kept, so tracing can be left enabled for a long
+ * session; when it is disabled, a trace point costs a single atomic load.
+ */
+class OKULARCORE_EXPORT Tracer
+{
+    public:
+        static bool isEnabled()
+        {
+            return s_enabled.load();
+        }
+
+        /**
+         * Enables or disables tracing as asked by the configuration; it stays
+         * enabled in any case if OKULAR_TRACE is set.
+         */
+        static void setEnabledByConfig( bool enabled );
+
+        /**
+         * Returns the current time, in microseconds, of the clock of the
+         * events.
+         */
+        static qint64 now();
+
+        /**
+         * Records the work @p name of the category @p category, done by the
+         * current thread from @p start to @p end for the page @p page (-1 if
+         * none).
+         *
+         * @p name and @p category must be string literals.
+         */
+        static void complete( const char *name, const char *category, qint64 start, qint64 end, int page );
+
+        /**
+         * Returns a new identifier for async(), never returned before in the
+         * process, unlike the addresses of the objects that are reused.
+         */
+        static quint64 newAsyncId();
+
+        /**
+         * Records the wait @p name of the category @p category, from @p start
+         * to @p end, of the object identified by @p id, as returned by
+         * newAsyncId() (e.g. the queueing of a request). Unlike complete(),
+         * the waits of different objects can overlap.
+         */
+        static void async( const char *name, const char *category, quint64 id, qint64 start, qint64 end, int page );
+
+        /**
+         * Writes the recorded events to @p fileName.
+         */
+        static bool save( const QString &fileName );
+
+    private:
+        static QBasicAtomicInt s_enabled;
+};
+
+/**
+ * Records the time spent in the scope it is declared in, if tracing is
+ * enabled.
+ */
+class TraceScope
+{
+    public:
+        TraceScope( const char *name, const char *category, int page = -1 )
+            : m_name( name ), m_category( category ), m_page( page ), m_start( Tracer::isEnabled() ? Tracer::now() : -1 )
+        {
+        }
+
+        ~TraceScope()
+        {
+            if ( m_start >= 0 )
+                Tracer::complete( m_name, m_category, m_start, Tracer::now(), m_page );
+        }
+
+    private:
+        Q_DISABLE_COPY( TraceScope )
+
+        const char *m_name;
+        const char *m_category;
+        int m_page;
+        qint64 m_start;
+};
+
+}
+
+#endif
@@ -22,6 +22,10 @@
 #include <QWindow>
 #include <QScreen>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 
 
 using namespace Okular;
@@ -77,14 +81,107 @@ inline static bool isPaperColor( QRgb argb, QRgb paperColor ) {
     return ( argb & 0xFFFFFF ) == ( paperColor & 0xFFFFFF); // ignore alpha
 }
 
-NormalizedRect Utils::imageBoundingBox( const QImage * image )
+// Index of the first pixel in [from, to) of a 32 bit row that is not of the
+// paper color, or to if there is none
+static int firstNonPaperPixel( const QRgb *row, int from, int to, QRgb paperColor )
 {
-    if ( !image )
-        return NormalizedRect();
+    int x = from;
+#ifdef __SSE2__
+    // skip 4 pixels at a time while they are all paper
+    const __m128i mask = _mm_set1_epi32( 0xFFFFFF );
+    const __m128i paper = _mm_set1_epi32( paperColor & 0xFFFFFF );
+    for ( ; x + 4 <= to; x += 4 )
+    {
+        const __m128i pixels = _mm_and_si128( _mm_loadu_si128( reinterpret_cast< const __m128i * >( row + x ) ), mask );
+        if ( _mm_movemask_epi8( _mm_cmpeq_epi32( pixels, paper ) ) != 0xFFFF )
+            break;
+    }
+#endif
+    for ( ; x < to; ++x )
+        if ( !isPaperColor( row[x], paperColor ) )
+            return x;
+    return to;
+}
 
+// Index of the last pixel in [from, to) of a 32 bit row that is not of the
+// paper color, or from - 1 if there is none
+static int lastNonPaperPixel( const QRgb *row, int from, int to, QRgb paperColor )
+{
+    int x = to;
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi32( 0xFFFFFF );
+    const __m128i paper = _mm_set1_epi32( paperColor & 0xFFFFFF );
+    for ( ; x - 4 >= from; x -= 4 )
+    {
+        const __m128i pixels = _mm_and_si128( _mm_loadu_si128( reinterpret_cast< const __m128i * >( row + x - 4 ) ), mask );
+        if ( _mm_movemask_epi8( _mm_cmpeq_epi32( pixels, paper ) ) != 0xFFFF )
+            break;
+    }
+#endif
+    while ( x > from )
+    {
+        --x;
+        if ( !isPaperColor( row[x], paperColor ) )
+            return x;
+    }
+    return from - 1;
+}
+
+// The same for an 8 bit gray row; paperGray is -1 if the paper color is not
+// a gray, then no pixel is of the paper color
+static int firstNonPaperPixel( const uchar *row, int from, int to, int paperGray )
+{
+    if ( paperGray < 0 )
+        return from;
+
+    int x = from;
+#ifdef __SSE2__
+    // skip 16 pixels at a time while they are all paper
+    const __m128i paper = _mm_set1_epi8( (char)paperGray );
+    for ( ; x + 16 <= to; x += 16 )
+    {
+        const __m128i pixels = _mm_loadu_si128( reinterpret_cast< const __m128i * >( row + x ) );
+        if ( _mm_movemask_epi8( _mm_cmpeq_epi8( pixels, paper ) ) != 0xFFFF )
+            break;
+    }
+#endif
+    for ( ; x < to; ++x )
+        if ( row[x] != paperGray )
+            return x;
+    return to;
+}
+
+static int lastNonPaperPixel( const uchar *row, int from, int to, int paperGray )
+{
+    if ( paperGray < 0 )
+        return to - 1;
+
+    int x = to;
+#ifdef __SSE2__
+    const __m128i paper = _mm_set1_epi8( (char)paperGray );
+    for ( ; x - 16 >= from; x -= 16 )
+    {
+        const __m128i pixels = _mm_loadu_si128( reinterpret_cast< const __m128i * >( row + x - 16 ) );
+        if ( _mm_movemask_epi8( _mm_cmpeq_epi8( pixels, paper ) ) != 0xFFFF )
+            break;
+    }
+#endif
+    while ( x > from )
+    {
+        --x;
+        if ( row[x] != paperGray )
+            return x;
+    }
+    return from - 1;
+}
+
+// Scans the rows of @p image as arrays of Pixel, for the pixels that are not
+// of the @p paper color
+template< typename Pixel, typename Paper >
+static NormalizedRect scanBoundingBox( const QImage *image, Paper paper )
+{
     const int width = image->width();
     const int height = image->height();
-    const QRgb paperColor = SettingsCore::paperColor().rgb();
     int left, top, bottom, right, x, y;
 
 #ifdef BBOX_DEBUG
@@ -92,36 +189,43 @@ NormalizedRect Utils::imageBoundingBox( const QImage * image )
     time.start();
 #endif
 
-    // Scan pixels for top non-white
+    // Scan rows for top non-white
     for ( top = 0; top < height; ++top )
-        for ( x = 0; x < width; ++x )
-            if ( !isPaperColor( image->pixel( x, top ), paperColor ) )
-                goto got_top;
-    return NormalizedRect( 0, 0, 0, 0 ); // the image is blank
-got_top:
+    {
+        x = firstNonPaperPixel( reinterpret_cast< const Pixel * >( image->constScanLine( top ) ), 0, width, paper );
+        if ( x < width )
+            break;
+    }
+    if ( top == height )
+        return NormalizedRect( 0, 0, 0, 0 ); // the image is blank
     left = right = x;
 
-    // Scan pixels for bottom non-white
+    // Scan rows for bottom non-white
     for ( bottom = height-1; bottom >= top; --bottom )
-        for ( x = width-1; x >= 0; --x )
-            if ( !isPaperColor( image->pixel( x, bottom ), paperColor ) )
-                goto got_bottom;
-    Q_ASSERT( 0 ); // image changed?!
-got_bottom:
+    {
+        x = lastNonPaperPixel( reinterpret_cast< const Pixel * >( image->constScanLine( bottom ) ), 0, width, paper );
+        if ( x >= 0 )
+            break;
+    }
+    Q_ASSERT( bottom >= top );
     if ( x < left )
         left = x;
     if ( x > right )
         right = x;
 
-    // Scan for leftmost and rightmost (we already found some bounds on these):
+    // Scan for leftmost and rightmost (we already found some bounds on these),
+    // only looking at the part of each row outside of them
     for ( y = top; y <= bottom && ( left > 0 || right < width-1 ); ++y )
     {
-        for ( x = 0; x < left; ++x )
-            if ( !isPaperColor( image->pixel( x, y ), paperColor ) )
-                left = x;
-        for ( x = width-1; x > right+1; --x )
-            if ( !isPaperColor( image->pixel( x, y ), paperColor ) )
+        const Pixel *row = reinterpret_cast< const Pixel * >( image->constScanLine( y ) );
+        if ( left > 0 )
+            left = firstNonPaperPixel( row, 0, left, paper );
+        if ( right < width-1 )
+        {
+            x = lastNonPaperPixel( row, right+1, width, paper );
+            if ( x > right )
                 right = x;
+        }
     }
 
     NormalizedRect bbox( QRect( left, top, ( right - left + 1), ( bottom - top + 1 ) ),
@@ -134,6 +238,38 @@ got_bottom:
     return bbox;
 }
 
+NormalizedRect Utils::imageBoundingBox( const QImage * image )
+{
+    if ( !image )
+        return NormalizedRect();
+
+    if ( image->isNull() )
+        return NormalizedRect( 0, 0, 0, 0 );
+
+    const QRgb paperColor = SettingsCore::paperColor().rgb();
+    switch ( image->format() )
+    {
+        case QImage::Format_RGB32:
+        case QImage::Format_ARGB32:
+        case QImage::Format_ARGB32_Premultiplied:
+            return scanBoundingBox< QRgb >( image, paperColor );
+
+        case QImage::Format_Grayscale8:
+        {
+            // a gray pixel is of the paper color only if the paper is gray
+            const bool grayPaper = qRed( paperColor ) == qGreen( paperColor ) && qGreen( paperColor ) == qBlue( paperColor );
+            return scanBoundingBox< uchar >( image, grayPaper ? qRed( paperColor ) : -1 );
+        }
+
+        default:
+        {
+            // anything else is scanned as a 32 bit copy
+            const QImage converted = image->convertToFormat( QImage::Format_ARGB32 );
+            return converted.isNull() ? NormalizedRect() : scanBoundingBox< QRgb >( &converted, paperColor );
+        }
+    }
+}
+
 void Okular::copyQIODevice( QIODevice *from, QIODevice *to )
 {
     QByteArray buffer( 65536, '\0' );
@@ -24,6 +24,7 @@ class ChmGeneratorTest
         void initTestCase();
         void testDocumentStructure();
         void testDocumentContent();
+        void testSearchIndex();
         void cleanupTestCase();
 
     private:
@@ -98,6 +99,53 @@ void ChmGeneratorTest::testDocumentContent()
     QCOMPARE( indexPage1->text(), QStringLiteral("Index 1This is an example Text.") );
 }
 
+void ChmGeneratorTest::testSearchIndex()
+{
+    int finishedSearches = 0;
+    Okular::Document::SearchStatus status = Okular::Document::SearchCancelled;
+    QMetaObject::Connection connection = connect( m_document, &Okular::Document::searchFinished, this,
+        [&finishedSearches, &status]( int, Okular::Document::SearchStatus endStatus ) {
+            ++finishedSearches;
+            status = endStatus;
+        } );
+
+    // the first search goes through all the pages while the index is built in
+    // background
+    const int searchId = 0;
+    m_document->searchText( searchId, QStringLiteral("html tit"), true, Qt::CaseInsensitive, Okular::Document::AllDocument, false, QColor() );
+    QTRY_COMPARE( finishedSearches, 1 );
+    QCOMPARE( status, Okular::Document::MatchFound );
+    for ( uint i = 0; i < m_document->pages(); ++i )
+        QCOMPARE( m_document->page( i )->hasHighlights( searchId ), i == 2 );
+
+    QTRY_VERIFY( m_document->metaData( QStringLiteral("SearchIndexReady") ).toBool() );
+    m_document->resetSearch( searchId );
+
+    // the later ones only build the text pages of the pages listed by the
+    // index, and find the same matches
+    for ( uint i = 0; i < m_document->pages(); ++i )
+        const_cast< Okular::Page * >( m_document->page( i ) )->setTextPage( nullptr );
+
+    m_document->searchText( searchId, QStringLiteral("html tit"), true, Qt::CaseInsensitive, Okular::Document::AllDocument, false, QColor() );
+    QTRY_COMPARE( finishedSearches, 2 );
+    QCOMPARE( status, Okular::Document::MatchFound );
+    for ( uint i = 0; i < m_document->pages(); ++i )
+    {
+        QCOMPARE( m_document->page( i )->hasHighlights( searchId ), i == 2 );
+        QCOMPARE( m_document->page( i )->hasTextPage(), i == 2 );
+    }
+
+    m_document->resetSearch( searchId );
+    m_document->searchText( searchId, QStringLiteral("nonexistingword"), true, Qt::CaseInsensitive, Okular::Document::AllDocument, false, QColor() );
+    QTRY_COMPARE( finishedSearches, 3 );
+    QCOMPARE( status, Okular::Document::NoMatchFound );
+    for ( uint i = 0; i < m_document->pages(); ++i )
+        QCOMPARE( m_document->page( i )->hasTextPage(), i == 2 );
+
+    m_document->resetSearch( searchId );
+    disconnect( connection );
+}
+
 QTEST_MAIN( ChmGeneratorTest )
 #include "chmgeneratortest.moc"
 
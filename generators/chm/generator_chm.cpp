@@ -13,6 +13,7 @@
 #include <QEventLoop>
 #include <QMutex>
 #include <QPainter>
+#include <QThread>
 #include <QDomElement>
 
 #include <KAboutData>
@@ -31,6 +32,58 @@
 
 OKULAR_EXPORT_PLUGIN(CHMGenerator, "libokularGenerator_chmlib.json")
 
+// Builds the search index of a document, in a thread so that the searches
+// made in the meantime go through the text pages and only see the index once
+// it's complete
+class CHMSearchIndexThread : public QThread
+{
+    public:
+        explicit CHMSearchIndexThread( const QString &fileName )
+            : m_fileName( fileName ), m_search( new EBookSearch() ), m_succeeded( false )
+        {
+        }
+
+        ~CHMSearchIndexThread()
+        {
+            delete m_search;
+        }
+
+        void cancel()
+        {
+            m_search->cancelIndexGeneration();
+        }
+
+        // returns the index once the thread is finished, 0 if it failed
+        EBookSearch *takeSearch()
+        {
+            if ( !m_succeeded )
+                return 0;
+            EBookSearch *search = m_search;
+            m_search = 0;
+            return search;
+        }
+
+    protected:
+        void run() override
+        {
+            // a file of its own, as the one of the generator is used by the
+            // GUI thread meanwhile
+            EBook *file = EBook::loadFile( m_fileName );
+            if ( !file )
+                return;
+
+            QByteArray indexData;
+            QDataStream stream( &indexData, QIODevice::WriteOnly );
+            m_succeeded = m_search->generateIndex( file, stream );
+            delete file;
+        }
+
+    private:
+        QString m_fileName;
+        EBookSearch *m_search;
+        bool m_succeeded;
+};
+
 static QString absolutePath( const QString &baseUrl, const QString &path )
 {
     QString absPath;
@@ -52,14 +105,20 @@ CHMGenerator::CHMGenerator( QObject *parent, const QVariantList &args )
     : Okular::Generator( parent, args )
 {
     setFeature( TextExtraction );
+    setFeature( SearchIndex );
 
     m_syncGen=0;
     m_file=0;
+    m_search=0;
+    m_searchIndexThread=0;
+    m_searchIndexFailed=false;
     m_request = 0;
 }
 
 CHMGenerator::~CHMGenerator()
 {
+    stopSearchIndex();
+    delete m_search;
     delete m_syncGen;
 }
 
@@ -159,6 +218,10 @@ bool CHMGenerator::loadDocument( const QString & fileName, QVector< Okular::Page
 bool CHMGenerator::doCloseDocument()
 {
     // delete the document information of the old document
+    stopSearchIndex();
+    delete m_search;
+    m_search=0;
+    m_searchIndexFailed=false;
     delete m_file;
     m_file=0;
     m_textpageAddedList.clear();
@@ -422,6 +485,63 @@ Okular::TextPage* CHMGenerator::textPage( Okular::TextRequest * request )
     return tp;
 }
 
+bool CHMGenerator::pagesContainingText( const QString &text, Qt::CaseSensitivity, QVector< int > *pages )
+{
+    if ( m_searchIndexFailed )
+        return false;
+
+    // the index is built in background starting from the first search, it
+    // only needs the raw HTML of the pages and not their layout so it's way
+    // cheaper than text pages; until it's ready all the pages are searched
+    if ( !m_search )
+    {
+        if ( !m_searchIndexThread )
+        {
+            m_searchIndexThread = new CHMSearchIndexThread( m_fileName );
+            connect( m_searchIndexThread, &QThread::finished, this, &CHMGenerator::searchIndexFinished );
+            m_searchIndexThread->start( QThread::LowPriority );
+        }
+        return false;
+    }
+
+    QList< QUrl > urls;
+    if ( !m_search->searchSubstring( text, &urls ) )
+        return false;
+
+    foreach ( const QUrl &url, urls )
+    {
+        const QString urlString = url.toString();
+        const int pos = urlString.indexOf( QLatin1Char( '#' ) );
+        const int page = m_urlPage.value( pos == -1 ? urlString : urlString.left( pos ), -1 );
+        if ( page != -1 )
+            pages->append( page );
+    }
+    return true;
+}
+
+void CHMGenerator::searchIndexFinished()
+{
+    // the thread of a closed document may have finished in the meantime
+    if ( !m_searchIndexThread || !m_searchIndexThread->isFinished() )
+        return;
+
+    m_search = m_searchIndexThread->takeSearch();
+    m_searchIndexFailed = !m_search;
+    delete m_searchIndexThread;
+    m_searchIndexThread = 0;
+}
+
+void CHMGenerator::stopSearchIndex()
+{
+    if ( !m_searchIndexThread )
+        return;
+
+    m_searchIndexThread->cancel();
+    m_searchIndexThread->wait();
+    delete m_searchIndexThread;
+    m_searchIndexThread = 0;
+}
+
 QVariant CHMGenerator::metaData( const QString &key, const QVariant &option ) const
 {
     if ( key == QLatin1String("NamedViewport") && !option.toString().isEmpty() )
@@ -441,6 +561,10 @@ QVariant CHMGenerator::metaData( const QString &key, const QVariant &option ) co
     {
         return m_file->title();
     }
+    else if ( key == QLatin1String("SearchIndexReady") )
+    {
+        return m_search != 0;
+    }
     return QVariant();
 }
 
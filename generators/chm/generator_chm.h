@@ -15,10 +15,12 @@
 #include <core/generator.h>
 
 #include "lib/ebook_chm.h"
+#include "lib/ebook_search.h"
 
 #include <qbitarray.h>
 
 class KHTMLPart;
+class CHMSearchIndexThread;
 
 namespace Okular {
 class TextPage;
@@ -45,9 +47,14 @@ class CHMGenerator : public Okular::Generator
 
         QVariant metaData( const QString & key, const QVariant & option ) const override;
 
+        bool pagesContainingText( const QString &text, Qt::CaseSensitivity caseSensitivity, QVector< int > *pages ) override;
+
     public Q_SLOTS:
         void slotCompleted();
 
+    private Q_SLOTS:
+        void searchIndexFinished();
+
     protected:
         bool doCloseDocument() override;
         Okular::TextPage* textPage( Okular::TextRequest *request ) override;
@@ -56,10 +63,14 @@ class CHMGenerator : public Okular::Generator
         void additionalRequestData();
         void recursiveExploreNodes( DOM::Node node, Okular::TextPage *tp );
         void preparePageForSyncOperation( const QString &url );
+        void stopSearchIndex();
         QMap<QString, int> m_urlPage;
         QVector<QString> m_pageUrl;
         Okular::DocumentSynopsis m_docSyn;
         EBook* m_file;
+        EBookSearch* m_search;
+        CHMSearchIndexThread* m_searchIndexThread;
+        bool m_searchIndexFailed;
         KHTMLPart *m_syncGen;
         QString m_fileName;
         QString m_chmUrl;
@@ -72,6 +72,7 @@ class SearchDataKeeper
 EBookSearch::EBookSearch()
 {
 	m_Index = 0;
+	m_cancelled = 0;
 }
 
 
@@ -119,7 +120,7 @@ bool EBookSearch::generateIndex( EBook * ebookFile, QDataStream & stream )
 			documents.push_back( alldocuments[i] );
 	}
 
-    if ( !m_Index->makeIndex( documents, ebookFile ) )
+	if ( !m_Index->makeIndex( documents, ebookFile, &m_cancelled ) )
 	{
 		delete m_Index;
 		m_Index = 0;
@@ -135,7 +136,8 @@ bool EBookSearch::generateIndex( EBook * ebookFile, QDataStream & stream )
 
 void EBookSearch::cancelIndexGeneration()
 {
-	m_Index->setLastWinClosed();
+	// may be called from another thread than the one generating the index
+	m_cancelled.store( 1 );
 }
 
 
@@ -219,6 +221,50 @@ bool EBookSearch::searchQuery(const QString & query, QList< QUrl > * results, EB
 	return true;
 }
 
+bool EBookSearch::searchSubstring( const QString & text, QList< QUrl > * results )
+{
+	// We should have index
+	if ( !m_Index )
+		return false;
+	
+	QString splitChars = m_Index->getCharsSplit();
+	QString partOfWordChars = m_Index->getCharsPartOfWord();
+	
+	// Tokenize the text the same way the documents were tokenized when indexing
+	QStringList terms;
+	QString term;
+
+	for ( int i = 0; i < text.length(); i++ )
+	{
+		QChar ch = text[i].toLower();
+		
+		if ( ch.isLetterOrNumber() || partOfWordChars.indexOf( ch ) != -1 )
+		{
+			term.append( ch );
+			continue;
+		}
+		
+		if ( !term.isEmpty() )
+			terms.push_back( term );
+		
+		term = QString::null;
+		
+		// Split chars are indexed as separate terms
+		if ( splitChars.indexOf( ch ) != -1 )
+			terms.push_back( ch );
+	}
+	
+	if ( !term.isEmpty() )
+		terms.push_back( term );
+	
+	// Nothing which could have been indexed, so every document may contain the text
+	if ( terms.isEmpty() )
+		return false;
+	
+	results->append( m_Index->substringQuery( terms ) );
+	return true;
+}
+
 bool EBookSearch::hasIndex() const
 {
 	return m_Index != 0;
@@ -62,6 +62,13 @@ class EBookSearch : public QObject
 		//! not merging search results, make sure it's empty.
 		bool	searchQuery ( const QString& query, QList< QUrl > * results, EBook * chmFile, unsigned int limit = 100 );
 		
+		//! Looks up the documents which may contain \param text, also as a part of longer words
+		//! and ignoring the case, and adds them to \param results. Unlike searchQuery(), this never
+		//! leaves out a document containing the text, but may add documents which contain all its
+		//! words but not the text as a whole. The return value is false if the index is not generated,
+		//! or if \param text has no indexed characters at all.
+		bool	searchSubstring( const QString& text, QList< QUrl > * results );
+		
 		//! Returns true if a valid search index is present, and therefore search could be executed
 		bool	hasIndex() const;
 		
@@ -78,6 +85,7 @@ class EBookSearch : public QObject
 	private:
 		QStringList 				m_keywordDocuments;
 		QtAs::Index 			*	m_Index;
+		QAtomicInt					m_cancelled;
 
 };
 
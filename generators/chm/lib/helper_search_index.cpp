@@ -17,6 +17,7 @@
  */
 
 #include <QApplication>
+#include <QSet>
 #include <QTextCodec>
 
 #include "ebook.h"
@@ -74,7 +75,7 @@ void Index::setLastWinClosed()
 }
 
 
-bool Index::makeIndex(const QList< QUrl >& docs, EBook *chmFile )
+bool Index::makeIndex(const QList< QUrl >& docs, EBook *chmFile, const QAtomicInt *cancelled )
 {
 	if ( docs.isEmpty() )
 		return false;
@@ -94,7 +95,7 @@ bool Index::makeIndex(const QList< QUrl >& docs, EBook *chmFile )
 	
 	for ( int i = 0; it != docList.constEnd(); ++it, ++i )
 	{
-		if ( lastWindowClosed )
+		if ( lastWindowClosed || ( cancelled && cancelled->load() ) )
 			return false;
 
 		QUrl filename = *it;
@@ -171,9 +172,6 @@ bool Index::parseDocumentToStringlist(EBook *chmFile, const QUrl& filename, QStr
 	{
 		QChar ch = text[j];
 		
-		if ( (j % 20000) == 0 )
-			qApp->processEvents( QEventLoop::ExcludeUserInputEvents );
-		
 		if ( state == STATE_IN_HTML_TAG )
 		{
 			// We are inside HTML tag.
@@ -250,10 +248,12 @@ bool Index::parseDocumentToStringlist(EBook *chmFile, const QUrl& filename, QStr
 		//
 		
 		// Check for start of HTML tag, and switch to STATE_IN_HTML_TAG if it is
+		// The word goes on after the tag, as inline tags like <b>foo</b>bar don't split
+		// the words, and the substring search still finds both parts of the others
 		if ( ch == '<' )
 		{
 			state = STATE_IN_HTML_TAG;
-			goto tokenize_buf;
+			continue;
 		}
 		
 		// Check for start of HTML entity
@@ -287,7 +287,6 @@ bool Index::parseDocumentToStringlist(EBook *chmFile, const QUrl& filename, QStr
 			continue;
 		}
 		
-tokenize_buf:		
 		// Just add the word; it is most likely a space or terminated by tokenizer.
 		if ( !parsedbuf.isEmpty() )
 		{
@@ -421,6 +420,44 @@ QList< QUrl > Index::query(const QStringList &terms, const QStringList &termSeq,
 }
 
 
+QList< QUrl > Index::substringQuery( const QStringList &terms ) const
+{
+	QSet<int> docNumbers;
+
+	for ( int i = 0; i < terms.size(); ++i )
+	{
+		// Collect the documents having an indexed word which contains the term
+		QSet<int> termDocs;
+
+		for ( QHash<QString, Entry *>::ConstIterator it = dict.constBegin(); it != dict.constEnd(); ++it )
+		{
+			if ( !it.key().contains( terms[i] ) )
+				continue;
+
+			for ( QVector<Document>::ConstIterator doc_it = it.value()->documents.constBegin(); doc_it != it.value()->documents.constEnd(); ++doc_it )
+				termDocs.insert( (*doc_it).docNumber );
+		}
+
+		if ( i == 0 )
+			docNumbers = termDocs;
+		else
+			docNumbers.intersect( termDocs );
+
+		if ( docNumbers.isEmpty() )
+			break;
+	}
+
+	QList< QUrl > results;
+	for ( QSet<int>::ConstIterator it = docNumbers.constBegin(); it != docNumbers.constEnd(); ++it )
+	{
+		if ( *it >= 0 && *it < docList.size() )
+			results << docList[ *it ];
+	}
+
+	return results;
+}
+
+
 bool Index::searchForPhrases( const QStringList &phrases, const QStringList &words, const QUrl &filename, EBook * chmFile )
 {
 	QStringList parsed_document;
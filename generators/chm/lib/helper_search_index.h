@@ -19,6 +19,7 @@
 #ifndef EBOOK_SEARCH_INDEX_H
 #define EBOOK_SEARCH_INDEX_H
 
+#include <QAtomicInt>
 #include <QUrl>
 #include <QHash>
 #include <QVector>
@@ -74,8 +75,9 @@ class Index : public QObject
 		
 		void 		writeDict( QDataStream& stream );
 		bool 		readDict( QDataStream& stream );
-		bool 		makeIndex(const QList<QUrl> &docs, EBook * chmFile );
+		bool 		makeIndex(const QList<QUrl> &docs, EBook * chmFile, const QAtomicInt * cancelled = 0 );
 		QList<QUrl>	query( const QStringList&, const QStringList&, const QStringList&, EBook * chmFile );
+		QList<QUrl>	substringQuery( const QStringList& terms ) const;
 		QString 	getCharsSplit() const { return m_charssplit; }
 		QString 	getCharsPartOfWord() const { return m_charsword; }
 
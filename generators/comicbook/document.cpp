@@ -9,6 +9,7 @@
 
 #include "document.h"
 
+#include <QtCore/QBuffer>
 #include <QtCore/QScopedPointer>
 #include <QtGui/QImage>
 #include <QtGui/QImageReader>
@@ -225,6 +226,27 @@ QImage Document::pageImage( int page ) const
     return QImage();
 }
 
+QImage Document::pageImage( int page, const QSize &scaledSize ) const
+{
+    QByteArray data;
+    if ( mArchive ) {
+        const KArchiveFile *entry = static_cast<const KArchiveFile*>( mArchiveDir->entry( mPageMap[ page ] ) );
+        if ( entry )
+            data = entry->data();
+    } else if ( mDirectory ) {
+        QImageReader reader( mPageMap[ page ] );
+        reader.setScaledSize( scaledSize );
+        return reader.read();
+    } else {
+        data = mUnrar->contentOf( mPageMap[ page ] );
+    }
+
+    QBuffer buffer( &data );
+    QImageReader reader( &buffer );
+    reader.setScaledSize( scaledSize );
+    return reader.read();
+}
+
 QString Document::lastErrorString() const
 {
     return mLastErrorString;
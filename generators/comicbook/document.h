@@ -39,6 +39,10 @@ class Document
 
         QImage pageImage( int page ) const;
 
+        // decodes the image of the page directly at the given size, which
+        // for some formats (like JPEG) is much faster than scaling it
+        QImage pageImage( int page, const QSize &scaledSize ) const;
+
         QString lastErrorString() const;
 
     private:
@@ -66,6 +66,12 @@ QImage ComicBookGenerator::image( Okular::PixmapRequest * request )
     return image.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
 }
 
+QImage ComicBookGenerator::thumbnail( int page, const QSize &size )
+{
+    // a cheap low resolution decoding is good enough for thumbnails
+    return mDocument.pageImage( page, size );
+}
+
 bool ComicBookGenerator::print( QPrinter& printer )
 {
     QPainter p( &printer );
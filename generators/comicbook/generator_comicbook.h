@@ -32,6 +32,7 @@ class ComicBookGenerator : public Okular::Generator
     protected:
         bool doCloseDocument() override;
         QImage image( Okular::PixmapRequest * request ) override;
+        QImage thumbnail( int page, const QSize &size ) override;
 
     private:
       ComicBook::Document mDocument;
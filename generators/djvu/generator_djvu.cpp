@@ -120,6 +120,14 @@ QImage DjVuGenerator::image( Okular::PixmapRequest *request )
     return img;
 }
 
+QImage DjVuGenerator::thumbnail( int page, const QSize &size )
+{
+    userMutex()->lock();
+    QImage img = m_djvu->thumbnail( page, size.width(), size.height() );
+    userMutex()->unlock();
+    return img;
+}
+
 Okular::DocumentInfo DjVuGenerator::generateDocumentInfo( const QSet<Okular::DocumentInfo::Key> &keys ) const
 {
     Okular::DocumentInfo docInfo;
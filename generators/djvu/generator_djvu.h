@@ -43,6 +43,7 @@ class DjVuGenerator : public Okular::Generator
         bool doCloseDocument() override;
         // pixmap generation
         QImage image( Okular::PixmapRequest *request ) override;
+        QImage thumbnail( int page, const QSize &size ) override;
         Okular::TextPage* textPage( Okular::TextRequest *request ) override;
 
     private:
@@ -909,6 +909,24 @@ const QVector<KDjVu::Page*> &KDjVu::pages() const
     return d->m_pages;
 }
 
+QImage KDjVu::thumbnail( int page, int width, int height )
+{
+    // only the thumbnails already there, computing one means rendering the page
+    if ( ddjvu_thumbnail_status( d->m_djvu_document, page, 0 ) != DDJVU_JOB_OK )
+        return QImage();
+
+    int thumbWidth = width;
+    int thumbHeight = height;
+    QImage res_img( width, height, QImage::Format_RGB32 );
+    if ( !ddjvu_thumbnail_render( d->m_djvu_document, page, &thumbWidth, &thumbHeight,
+                                  d->m_format, res_img.bytesPerLine(), (char *)res_img.bits() ) )
+        return QImage();
+    handle_ddjvu_messages( d->m_djvu_cxt, false );
+
+    // the thumbnail keeps the aspect ratio of the page
+    return res_img.copy( 0, 0, thumbWidth, thumbHeight );
+}
+
 QImage KDjVu::image( int page, int width, int height, int rotation )
 {
     if ( d->m_cacheEnabled )
@@ -257,6 +257,13 @@ class KDjVu
          */
         QImage image( int page, int width, int height, int rotation );
 
+        /**
+         * Returns the thumbnail of the specified \p page stored in the
+         * document, fitting \p width x \p height, or a null image if the
+         * document has no thumbnail for the page.
+         */
+        QImage thumbnail( int page, int width, int height );
+
         /**
          * Export the currently open document as PostScript file \p fileName.
          * \returns whether the exporting was successful
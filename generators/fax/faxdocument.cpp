@@ -10,6 +10,11 @@
 #include <stdlib.h>
 
 #include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QPair>
+#include <QtCore/QtAlgorithms>
+#include <QtCore/QtEndian>
+#include <QtCore/QVector>
 
 #include "faxexpand.h"
 #include "faxdocument.h"
@@ -55,18 +60,6 @@ static void normalize( pagenode *pn, int revbits, int swapbytes, size_t length )
     }
 }
 
-static bool new_image( pagenode *pn, int width, int height )
-{
-    pn->image = QImage( width, height, QImage::Format_MonoLSB );
-    pn->image.setColor( 0, qRgb( 255, 255, 255 ) );
-    pn->image.setColor( 1, qRgb( 0, 0, 0 ) );
-    pn->bytes_per_line = pn->image.bytesPerLine();
-    pn->dpi = FAX_DPI_FINE;
-    pn->imageData = new uchar[ width * height ];
-
-    return !pn->image.isNull();
-}
-
 /* get compressed data into memory */
 static unsigned char* getstrip( pagenode *pn, int strip )
 {
@@ -123,18 +116,6 @@ static unsigned char* getstrip( pagenode *pn, int strip )
     }
 
     normalize( pn, !pn->lsbfirst, ShortOrder, roundup );
-    if ( pn->size.height() == 0 )
-        pn->size.setHeight( G3count( pn, pn->expander == g32expand ) );
-
-    if ( pn->size.height() == 0 )
-    {
-        delete [] data;
-        pn->data = nullptr;
-        return nullptr;
-    }
-
-    if ( pn->strips == nullptr )
-        pn->rowsperstrip = pn->size.height();
 
     pn->dataOrig = (t16bits *)data;
 
@@ -155,6 +136,8 @@ static void draw_line( pixnum *run, int lineNum, pagenode *pn )
     if ( lineNum >= pn->size.height() )
         return;
 
+    /* the pixels are written most significant bit first, so words are
+       stored big endian to get the byte layout of QImage::Format_Mono */
     p = (t32bits *)(pn->imageData + lineNum*(2-pn->vres)*pn->bytes_per_line);
     p1 =(t32bits *)(pn->vres ? nullptr : p + pn->bytes_per_line/sizeof(*p));
 
@@ -182,9 +165,9 @@ static void draw_line( pixnum *run, int lineNum, pagenode *pn )
             pix = ~pix;
             continue;
         }
-        *p++ = acc;
+        *p++ = qToBigEndian( acc );
         if ( p1 )
-            *p1++ = acc;
+            *p1++ = qToBigEndian( acc );
         n -= 32 - nacc;
         while ( n >= 32 )
         {
@@ -199,31 +182,43 @@ static void draw_line( pixnum *run, int lineNum, pagenode *pn )
     }
     if ( nacc )
     {
-        *p++ = acc;
+        *p++ = qToBigEndian( acc );
         if ( p1 )
-            *p1++ = acc;
+            *p1++ = qToBigEndian( acc );
     }
 }
 
-static bool get_image( pagenode *pn )
+static int countBlackPixels( const uchar *line, int x0, int x1 )
 {
-    unsigned char *data = getstrip( pn, 0 );
-    if ( !data )
-        return false;
-
-    if ( !new_image( pn, pn->size.width(), (pn->vres ? 1 : 2) * pn->size.height() ) )
-        return false;
-
-    (*pn->expander)( pn, draw_line );
-
-    return true;
+    // counts the bits set in [x0, x1) of a most significant bit first line
+    const int firstByte = x0 >> 3;
+    const int lastByte = x1 >> 3;
+    const quint8 firstMask = 0xff >> ( x0 & 7 );
+    const quint8 lastMask = ~( 0xff >> ( x1 & 7 ) );
+
+    if ( firstByte == lastByte )
+        return qPopulationCount( quint8( line[ firstByte ] & firstMask & lastMask ) );
+
+    int count = qPopulationCount( quint8( line[ firstByte ] & firstMask ) );
+    for ( int i = firstByte + 1; i < lastByte; ++i )
+        count += qPopulationCount( quint8( line[ i ] ) );
+    if ( x1 & 7 )
+        count += qPopulationCount( quint8( line[ lastByte ] & lastMask ) );
+
+    return count;
 }
 
+struct FaxPage
+{
+    t16bits *data;  /* start of the page in the compressed data */
+    int lines;      /* number of coded lines */
+};
+
 class FaxDocument::Private
 {
     public:
         Private( FaxDocument *parent )
-            : mParent( parent )
+            : mParent( parent ), mDataEnd( nullptr )
         {
             mPageNode.size = QSize( 1728, 0 );
         }
@@ -231,6 +226,12 @@ class FaxDocument::Private
         FaxDocument *mParent;
         pagenode mPageNode;
         FaxDocument::DocumentType mType;
+        t16bits *mDataEnd;
+        QVector< FaxPage > mPages;
+
+        // the page expansion uses the shared mPageNode
+        QMutex mMutex;
+        QVector< QPair< int, QImage > > mImageCache;
 };
 
 FaxDocument::FaxDocument( const QString &fileName, DocumentType type )
@@ -256,7 +257,6 @@ FaxDocument::FaxDocument( const QString &fileName, DocumentType type )
 FaxDocument::~FaxDocument()
 {
     delete [] d->mPageNode.dataOrig;
-    delete [] d->mPageNode.imageData;
     delete d;
 }
 
@@ -264,46 +264,133 @@ bool FaxDocument::load()
 {
     fax_init_tables();
 
-    bool ok = get_image( &(d->mPageNode) );
-    if ( !ok )
+    pagenode *pn = &d->mPageNode;
+    if ( !getstrip( pn, 0 ) )
         return false;
 
-    // byte-swapping the image
-    int height = d->mPageNode.size.height();
-    int bytes_per_line = d->mPageNode.size.width()/8;
+    t16bits *data = pn->data;
+    d->mDataEnd = data + pn->length / sizeof( *data );
 
-    QByteArray bytes( height * bytes_per_line, 0 );
-    for ( int y= height - 1; y >= 0; --y )
+    // locate the pages: in G3 data each page ends with a RTC, while G4
+    // data only holds a single page
+    const bool twoD = pn->expander == g32expand;
+    while ( data < d->mDataEnd )
     {
-        quint32 offset  = y * bytes_per_line;
-        quint32 *source = (quint32 *) (d->mPageNode.imageData + offset);
-        quint32 *dest   = (quint32 *) (bytes.data() + offset);
-        for ( int x= (bytes_per_line/4) - 1; x >= 0; --x )
-        {
-            quint32 dv = 0, sv = *source;
-            for ( int bit = 32; bit > 0; --bit )
-            {
-                dv <<= 1;
-                dv |= sv&1;
-                sv >>= 1;
-            }
-            *dest = dv;
-            ++dest;
-            ++source;
-        }
+        pn->data = data;
+        pn->length = ( d->mDataEnd - data ) * sizeof( *data );
+
+        t16bits *pageEnd = nullptr;
+        const int lines = G3count( pn, twoD, &pageEnd );
+        if ( lines <= 0 )
+            break;
+
+        FaxPage page;
+        page.data = data;
+        page.lines = lines;
+        d->mPages.append( page );
+
+        if ( d->mType == G4 || pageEnd <= data )
+            break;
+        data = pageEnd;
+    }
+
+    return !d->mPages.isEmpty();
+}
+
+int FaxDocument::pageCount() const
+{
+    return d->mPages.count();
+}
+
+QSize FaxDocument::pageSize( int page ) const
+{
+    // lines of normal resolution pages are doubled when expanding
+    return QSize( d->mPageNode.size.width(), d->mPages.at( page ).lines * ( d->mPageNode.vres ? 1 : 2 ) );
+}
+
+QImage FaxDocument::pageImage( int page ) const
+{
+    QMutexLocker locker( &d->mMutex );
+
+    for ( int i = 0; i < d->mImageCache.count(); ++i )
+    {
+        if ( d->mImageCache.at( i ).first == page )
+            return d->mImageCache.at( i ).second;
     }
 
-    // convert it into a QImage
-    QImage img( (uchar*)bytes.data(), d->mPageNode.size.width(), d->mPageNode.size.height(), QImage::Format_MonoLSB );
-    img.setColor( 0, qRgb( 255, 255, 255 ) );
-    img.setColor( 1, qRgb( 0, 0, 0 ) );
+    const QSize size = pageSize( page );
+    QImage image( size, QImage::Format_Mono );
+    if ( image.isNull() )
+        return QImage();
+
+    image.setColor( 0, qRgb( 255, 255, 255 ) );
+    image.setColor( 1, qRgb( 0, 0, 0 ) );
+    image.fill( 0 );
+
+    const FaxPage &faxPage = d->mPages.at( page );
+    pagenode *pn = &d->mPageNode;
+    pn->data = faxPage.data;
+    pn->length = ( d->mDataEnd - faxPage.data ) * sizeof( *faxPage.data );
+    pn->size.setHeight( faxPage.lines );
+    pn->rowsperstrip = faxPage.lines;
+    pn->stripnum = 0;
+    pn->imageData = image.bits();
+    pn->bytes_per_line = image.bytesPerLine();
 
-    d->mPageNode.image = img.copy().scaled( img.width(), img.height() * 1.5 );
+    (*pn->expander)( pn, draw_line );
+
+    pn->imageData = nullptr;
 
-    return true;
+    // keep the last two pages, that's enough for a page and its thumbnail
+    // or for going back and forth between two pages
+    if ( d->mImageCache.count() == 2 )
+        d->mImageCache.removeFirst();
+    d->mImageCache.append( qMakePair( page, image ) );
+
+    return image;
 }
 
-QImage FaxDocument::image() const
+QImage FaxDocument::scaledPageImage( const QImage &image, const QSize &size )
 {
-    return d->mPageNode.image;
+    const int width = size.width();
+    const int height = size.height();
+    QImage result( width, height, QImage::Format_Grayscale8 );
+    if ( result.isNull() || image.isNull() )
+        return result;
+
+    const int sourceWidth = image.width();
+    const int sourceHeight = image.height();
+
+    // the source columns covered by each destination column
+    QVector< int > columnStart( width + 1 );
+    for ( int x = 0; x <= width; ++x )
+        columnStart[ x ] = qint64( x ) * sourceWidth / width;
+
+    QVector< int > blackPixels( width );
+    for ( int y = 0; y < height; ++y )
+    {
+        const int y0 = qint64( y ) * sourceHeight / height;
+        const int y1 = qMax( y0 + 1, int( qint64( y + 1 ) * sourceHeight / height ) );
+
+        blackPixels.fill( 0 );
+        for ( int sourceY = y0; sourceY < y1; ++sourceY )
+        {
+            const uchar *line = image.constScanLine( sourceY );
+            for ( int x = 0; x < width; ++x )
+            {
+                const int x0 = columnStart[ x ];
+                blackPixels[ x ] += countBlackPixels( line, x0, qMax( x0 + 1, columnStart[ x + 1 ] ) );
+            }
+        }
+
+        uchar *destination = result.scanLine( y );
+        for ( int x = 0; x < width; ++x )
+        {
+            const int x0 = columnStart[ x ];
+            const int area = ( qMax( x0 + 1, columnStart[ x + 1 ] ) - x0 ) * ( y1 - y0 );
+            destination[ x ] = 255 - blackPixels[ x ] * 255 / area;
+        }
+    }
+
+    return result;
 }
@@ -14,7 +14,10 @@
 
 /**
  * Loads a G3/G4 fax document and provides methods
- * to convert it into a QImage.
+ * to convert its pages into QImages.
+ *
+ * The pages are only located when loading; each of them is expanded
+ * on demand into a 1 bit per pixel image.
  */
 class FaxDocument
 {
@@ -48,9 +51,30 @@ class FaxDocument
     bool load();
 
     /**
-     * Returns the document as an image.
+     * Returns the number of pages of the document.
      */
-    QImage image() const;
+    int pageCount() const;
+
+    /**
+     * Returns the size in pixels of the given @p page.
+     */
+    QSize pageSize( int page ) const;
+
+    /**
+     * Returns the given @p page as a QImage::Format_Mono image, where
+     * the color index 1 is black.
+     *
+     * The most recently expanded pages are cached, so this is cheap when
+     * the same page is requested several times in a row.
+     */
+    QImage pageImage( int page ) const;
+
+    /**
+     * Scales the monochrome @p image to @p size with an integer box
+     * filter which works directly on the packed bits, and returns the
+     * result as a QImage::Format_Grayscale8 image.
+     */
+    static QImage scaledPageImage( const QImage &image, const QSize &size );
 
   private:
     class Private;
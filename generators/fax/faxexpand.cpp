@@ -719,7 +719,7 @@ static const unsigned char zerotab[256] = {
 
 /* count fax lines */
 int
-G3count(pagenode *pn, int twoD)
+G3count(pagenode *pn, int twoD, t16bits **pageEnd)
 {
     t16bits *p = pn->data;
     t16bits *end = p + pn->length/sizeof(*p);
@@ -742,5 +742,7 @@ G3count(pagenode *pn, int twoD)
 		zeros--;
 	}
     }
+    if (pageEnd)		/* the word holding the end of the RTC */
+	*pageEnd = (EOLcnt >= 6 && p > pn->data) ? p - 1 : p;
     return lines - EOLcnt;	/* don't count trailing EOLs */
 }
@@ -116,7 +116,8 @@ void g4expand(class pagenode *pn, drawfunc df);
 /* initialise code tables */
 extern void fax_init_tables(void);
 
-/* count lines in image */
-extern int G3count(class pagenode *pn, int twoD);
+/* count lines in image; if pageEnd is given, it is set to where the
+   RTC ending the page was found, i.e. where the next page may start */
+extern int G3count(class pagenode *pn, int twoD, t16bits **pageEnd = nullptr);
 
 #endif
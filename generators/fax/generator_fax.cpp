@@ -21,7 +21,7 @@
 OKULAR_EXPORT_PLUGIN(FaxGenerator, "libokularGenerator_fax.json")
 
 FaxGenerator::FaxGenerator( QObject *parent, const QVariantList &args )
-    : Generator( parent, args )
+    : Generator( parent, args ), m_document( nullptr )
 {
     setFeature( Threaded );
     setFeature( PrintNative );
@@ -30,6 +30,13 @@ FaxGenerator::FaxGenerator( QObject *parent, const QVariantList &args )
 
 FaxGenerator::~FaxGenerator()
 {
+    delete m_document;
+}
+
+// the pages are displayed stretched vertically by 1.5
+static QSize displayedPageSize( const QSize &size )
+{
+    return QSize( size.width(), size.height() * 3 / 2 );
 }
 
 bool FaxGenerator::loadDocument( const QString & fileName, QVector<Okular::Page*> & pagesVector )
@@ -39,40 +46,45 @@ bool FaxGenerator::loadDocument( const QString & fileName, QVector<Okular::Page*
     else
         m_type = FaxDocument::G4;
 
-    FaxDocument faxDocument( fileName, m_type );
+    FaxDocument *faxDocument = new FaxDocument( fileName, m_type );
 
-    if ( !faxDocument.load() )
+    if ( !faxDocument->load() )
     {
+        delete faxDocument;
         emit error( i18n( "Unable to load document" ), -1 );
         return false;
     }
 
-    m_img = faxDocument.image();
+    m_document = faxDocument;
 
-    pagesVector.resize( 1 );
+    pagesVector.resize( m_document->pageCount() );
 
-    Okular::Page * page = new Okular::Page( 0, m_img.width(), m_img.height(), Okular::Rotation0 );
-    pagesVector[0] = page;
+    for ( int i = 0; i < pagesVector.count(); ++i )
+    {
+        const QSize size = displayedPageSize( m_document->pageSize( i ) );
+        pagesVector[i] = new Okular::Page( i, size.width(), size.height(), Okular::Rotation0 );
+    }
 
     return true;
 }
 
 bool FaxGenerator::doCloseDocument()
 {
-    m_img = QImage();
+    delete m_document;
+    m_document = nullptr;
 
     return true;
 }
 
 QImage FaxGenerator::image( Okular::PixmapRequest * request )
 {
-    // perform a smooth scaled generation
+    // box-filter the page straight from its 1 bpp expansion
     int width = request->width();
     int height = request->height();
     if ( request->page()->rotation() % 2 == 1 )
         qSwap( width, height );
 
-    return m_img.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+    return FaxDocument::scaledPageImage( m_document->pageImage( request->pageNumber() ), QSize( width, height ) );
 }
 
 Okular::DocumentInfo FaxGenerator::generateDocumentInfo( const QSet<Okular::DocumentInfo::Key> &keys ) const
@@ -92,14 +104,17 @@ bool FaxGenerator::print( QPrinter& printer )
 {
     QPainter p( &printer );
 
-    QImage image( m_img );
-
-    if ( ( image.width() > printer.width() ) || ( image.height() > printer.height() ) )
+    for ( int i = 0; i < m_document->pageCount(); ++i )
+    {
+        if ( i != 0 )
+            printer.newPage();
 
-        image = image.scaled( printer.width(), printer.height(),
-                              Qt::KeepAspectRatio, Qt::SmoothTransformation );
+        QSize size = displayedPageSize( m_document->pageSize( i ) );
+        if ( ( size.width() > printer.width() ) || ( size.height() > printer.height() ) )
+            size.scale( printer.width(), printer.height(), Qt::KeepAspectRatio );
 
-    p.drawImage( 0, 0, image );
+        p.drawImage( 0, 0, FaxDocument::scaledPageImage( m_document->pageImage( i ), size ) );
+    }
 
     return true;
 }
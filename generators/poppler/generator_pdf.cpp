@@ -16,6 +16,7 @@
 
 // qt/kde includes
 #include <qcheckbox.h>
+#include <qcryptographichash.h>
 #include <qcolor.h>
 #include <qdir.h>
 #include <qfile.h>
@@ -57,6 +58,7 @@
 #include "debug_pdf.h"
 #include "annots.h"
 #include "formfields.h"
+#include "pagepipeline.h"
 #include "popplerembeddedfile.h"
 
 Q_DECLARE_METATYPE(Poppler::Annotation*)
@@ -585,6 +587,7 @@ Okular::Document::OpenResult PDFGenerator::init(QVector<Okular::Page*> & pagesVe
     }
     pagesVector.resize(pageCount);
     rectsGenerated.fill(false, pageCount);
+    pageFingerprints.fill(QByteArray(), pageCount);
 
     annotationsOnOpenHash.clear();
 
@@ -602,6 +605,17 @@ Okular::Document::OpenResult PDFGenerator::init(QVector<Okular::Page*> & pagesVe
 
 PDFGenerator::SwapBackingFileResult PDFGenerator::swapBackingFile( QString const &newFileName, QVector<Okular::Page*> & newPagesVector )
 {
+    // check the new file before closing the current one, so the document
+    // stays usable if it can't be swapped
+    {
+        QMutexLocker locker( userMutex() );
+        Poppler::Document *newDoc = Poppler::Document::load( newFileName );
+        const bool usable = pdfdoc && newDoc && !newDoc->isLocked() && newDoc->numPages() == pdfdoc->numPages();
+        delete newDoc;
+        if ( !usable )
+            return SwapBackingFileError;
+    }
+
     doCloseDocument();
     auto openResult = loadDocumentWithPassword(newFileName, newPagesVector, QString());
     if (openResult != Okular::Document::OpenSuccess)
@@ -626,6 +640,7 @@ bool PDFGenerator::doCloseDocument()
     docEmbeddedFiles.clear();
     nextFontPage = 0;
     rectsGenerated.clear();
+    pageFingerprints.clear();
 
     return true;
 }
@@ -757,6 +772,53 @@ const Okular::DocumentSynopsis * PDFGenerator::generateDocumentSynopsis()
     return &docSyn;
 }
 
+// the resolution of the rendering hashed in the fingerprints
+static const double fingerprintDpi = 12.0;
+
+static QByteArray popplerPageFingerprint( const Poppler::Page *p, const QList<Poppler::TextBox*> &textList )
+{
+    // a page without text, like a scan or a figure, is told apart only by
+    // its images and graphics: it is always regenerated
+    if ( textList.isEmpty() )
+        return QByteArray();
+
+    // poppler does not give access to the content streams, so hash the
+    // page geometry and its text, as extracted for the text page anyway,
+    // and a coarse rendering for the images and the graphics around it
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    const QSizeF size = p->pageSizeF();
+    hash.addData( QByteArray::number( size.width() ) + 'x' + QByteArray::number( size.height() ) + '@' + QByteArray::number( (int)p->orientation() ) );
+    foreach ( const Poppler::TextBox *box, textList )
+    {
+        const QRectF bbox = box->boundingBox();
+        hash.addData( box->text().toUtf8() + '@' + QByteArray::number( bbox.x() ) + ',' + QByteArray::number( bbox.y() ) );
+    }
+    const QImage image = p->renderToImage( fingerprintDpi, fingerprintDpi );
+    for ( int y = 0; y < image.height(); ++y )
+        hash.addData( reinterpret_cast< const char * >( image.constScanLine( y ) ), image.bytesPerLine() );
+    return hash.result();
+}
+
+QByteArray PDFGenerator::pageFingerprint( int page, bool compute ) const
+{
+    QMutexLocker locker( userMutex() );
+    if ( !pdfdoc || page < 0 || page >= pageFingerprints.count() )
+        return QByteArray();
+
+    if ( pageFingerprints.at( page ).isEmpty() && compute )
+    {
+        Poppler::Page *p = pdfdoc->page( page );
+        if ( p )
+        {
+            const QList<Poppler::TextBox*> textList = p->textList();
+            pageFingerprints[ page ] = popplerPageFingerprint( p, textList );
+            qDeleteAll( textList );
+            delete p;
+        }
+    }
+    return pageFingerprints.at( page );
+}
+
 static Okular::FontInfo::FontType convertPopplerFontInfoTypeToOkularFontInfoType( Poppler::FontInfo::Type type )
 {
     switch ( type )
@@ -958,6 +1020,20 @@ static bool shouldAbortRenderCallback(const QVariant &vPayload)
 }
 #endif
 
+QImage PDFGenerator::thumbnail( int page, const QSize &size )
+{
+    Q_UNUSED( size )
+
+    // the thumbnail embedded in the page (/Thumb), if any
+    userMutex()->lock();
+    Poppler::Page *p = pdfdoc->page( page );
+    const QImage thumbnail = p ? p->thumbnail() : QImage();
+    delete p;
+    userMutex()->unlock();
+
+    return thumbnail;
+}
+
 QImage PDFGenerator::image( Okular::PixmapRequest * request )
 {
     // debug requests to this (xpdf) generator
@@ -1200,6 +1276,11 @@ Okular::TextPage* PDFGenerator::textPage( Okular::TextRequest *request )
         const QSizeF s = pp->pageSizeF();
         pageWidth = s.width();
         pageHeight = s.height();
+
+        // remember what the page looked like, the file may change before
+        // a reload
+        if ( !request->shouldAbortExtraction() )
+            pageFingerprints[ page->number() ] = popplerPageFingerprint( pp, textList );
     }
     else
     {
@@ -1260,27 +1341,65 @@ bool PDFGenerator::print( QPrinter& printer )
     QList<int> pageList = Okular::FilePrinter::pageList( printer, pdfdoc->numPages(),
                                                          document()->currentPage() + 1,
                                                          document()->bookmarkedPageList() );
-    for ( int i = 0; i < pageList.count(); ++i )
-    {
-        if ( i != 0 )
-            printer.newPage();
+    for ( int &page : pageList )
+        --page;
 
-        const int page = pageList.at( i ) - 1;
-        userMutex()->lock();
-        Poppler::Page *pp = pdfdoc->page( page );
-        if (pp)
-        {
 #ifdef Q_OS_WIN
-            QImage img = pp->renderToImage(  printer.physicalDpiX(), printer.physicalDpiY() );
+    const double dpiX = printer.physicalDpiX();
+    const double dpiY = printer.physicalDpiY();
 #else
-            // UNIX: Same resolution as the postscript rasterizer; see discussion at https://git.reviewboard.kde.org/r/130218/
-            QImage img = pp->renderToImage( 300, 300 );
+    // UNIX: Same resolution as the postscript rasterizer; see discussion at https://git.reviewboard.kde.org/r/130218/
+    const double dpiX = 300;
+    const double dpiY = 300;
 #endif
+    const PagePipeline::Job renderPage = [dpiX, dpiY]( Poppler::Page *pp ) {
+        return QVariant( pp->renderToImage( dpiX, dpiY ) );
+    };
+    bool firstPage = true;
+    const PagePipeline::Consumer printPage = [&printer, &painter, &firstPage]( int, const QVariant &result ) {
+        if ( !firstPage )
+            printer.newPage();
+        firstPage = false;
+
+        const QImage img = result.value<QImage>();
+        if ( !img.isNull() )
             painter.drawImage( painter.window(), img, QRectF(0, 0, img.width(), img.height()) );
-            delete pp;
-        }
+        return true;
+    };
+    const PagePipeline::Progress printProgress = [this]( int done, int total ) {
+        emit notice( i18n( "Printed page %1 of %2", done, total ), -1 );
+    };
+
+    // render the pages in parallel, and paint them in order as they get ready;
+    // a single page is not worth copying the document
+    QScopedPointer<PagePipeline> pipeline;
+    if ( pageList.count() > 1 )
+    {
+        userMutex()->lock();
+        pipeline.reset( PagePipeline::create( pdfdoc ) );
         userMutex()->unlock();
     }
+    if ( pipeline )
+    {
+        pipeline->run( pageList, renderPage, printPage, printProgress );
+    }
+    else
+    {
+        for ( int i = 0; i < pageList.count(); ++i )
+        {
+            QVariant result;
+            userMutex()->lock();
+            Poppler::Page *pp = pdfdoc->page( pageList.at( i ) );
+            if (pp)
+            {
+                result = renderPage( pp );
+                delete pp;
+            }
+            userMutex()->unlock();
+            printPage( pageList.at( i ), result );
+            printProgress( i + 1, pageList.count() );
+        }
+    }
     painter.end();
     return true;
     }
@@ -1420,6 +1539,11 @@ QVariant PDFGenerator::metaData( const QString & key, const QVariant & option )
         QMutexLocker ml(userMutex());
         return pdfdoc->scripts();
     }
+    else if ( key == QLatin1String("DocumentEncrypted") )
+    {
+        QMutexLocker ml(userMutex());
+        return pdfdoc->isEncrypted();
+    }
     else if ( key == QLatin1String("HasUnsupportedXfaForm") )
     {
         QMutexLocker ml(userMutex());
@@ -1522,19 +1646,51 @@ bool PDFGenerator::exportTo( const QString &fileName, const Okular::ExportFormat
             return false;
 
         QTextStream ts( &f );
-        int num = document()->pages();
+        const PagePipeline::Job extractText = []( Poppler::Page *pp ) {
+            return QVariant( pp->text(QRect()).normalized(QString::NormalizationForm_KC) );
+        };
+        const PagePipeline::Consumer writeText = [&ts]( int, const QVariant &result ) {
+            ts << result.toString();
+            return true;
+        };
+        const PagePipeline::Progress exportProgress = [this]( int done, int total ) {
+            emit notice( i18n( "Exported page %1 of %2", done, total ), -1 );
+        };
+
+        QList<int> pageList;
+        const int num = document()->pages();
         for ( int i = 0; i < num; ++i )
+            pageList.append( i );
+
+        // the workers use a copy of the document as it is displayed, the
+        // file on disk may have changed since it was opened
+        QScopedPointer<PagePipeline> pipeline;
+        if ( num > 1 )
         {
-            QString text;
             userMutex()->lock();
-            Poppler::Page *pp = pdfdoc->page(i);
-            if (pp)
+            pipeline.reset( PagePipeline::create( pdfdoc ) );
+            userMutex()->unlock();
+        }
+        if ( pipeline )
+        {
+            pipeline->run( pageList, extractText, writeText, exportProgress );
+        }
+        else
+        {
+            for ( int i = 0; i < num; ++i )
             {
-                text = pp->text(QRect()).normalized(QString::NormalizationForm_KC);
+                QVariant text;
+                userMutex()->lock();
+                Poppler::Page *pp = pdfdoc->page(i);
+                if (pp)
+                {
+                    text = extractText(pp);
+                }
+                userMutex()->unlock();
+                writeText( i, text );
+                delete pp;
+                exportProgress( i + 1, num );
             }
-            userMutex()->unlock();
-            ts << text;
-            delete pp;
         }
         f.close();
 
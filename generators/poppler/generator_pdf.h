@@ -67,6 +67,7 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
         // [INHERITED] document information
         Okular::DocumentInfo generateDocumentInfo( const QSet<Okular::DocumentInfo::Key> &keys ) const override;
         const Okular::DocumentSynopsis * generateDocumentSynopsis() override;
+        QByteArray pageFingerprint( int page, bool compute ) const override;
         Okular::FontInfo::List fontsForPage( int page ) override;
         const QList<Okular::EmbeddedFile*> * embeddedFiles() const override;
         PageSizeMetric pagesSizeMetric() const override{ return Pixels; }
@@ -78,6 +79,7 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
 
         // [INHERITED] perform actions on document / pages
         QImage image( Okular::PixmapRequest *page ) override;
+        QImage thumbnail( int page, const QSize &size ) override;
 
         // [INHERITED] print page using an already configured kprinter
         bool print( QPrinter& printer ) override;
@@ -145,6 +147,8 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
         QHash<Okular::Annotation*, Poppler::Annotation*> annotationsOnOpenHash;
 
         QBitArray rectsGenerated;
+        // fingerprints of the pages whose text was extracted, see pageFingerprint()
+        mutable QVector<QByteArray> pageFingerprints;
 
         QPointer<PDFOptionsPage> pdfOptionsPage;
         
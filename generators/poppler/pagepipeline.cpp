@@ -0,0 +1,172 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "pagepipeline.h"
+
+#include <qbuffer.h>
+#include <qthread.h>
+#include <qvector.h>
+
+class PagePipeline::Worker : public QThread
+{
+    public:
+        explicit Worker( PagePipeline *pipeline )
+            : m_pipeline( pipeline )
+        {
+        }
+
+    protected:
+        void run() override
+        {
+            m_pipeline->work();
+        }
+
+    private:
+        PagePipeline *m_pipeline;
+};
+
+PagePipeline *PagePipeline::create( Poppler::Document *document )
+{
+    // the workers would need the password
+    if ( document->isEncrypted() )
+        return nullptr;
+
+    QByteArray data;
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+
+    Poppler::PDFConverter *converter = document->pdfConverter();
+    converter->setOutputDevice( &buffer );
+    converter->setPDFOptions( converter->pdfOptions() | Poppler::PDFConverter::WithChanges );
+    const bool converted = converter->convert();
+    delete converter;
+    if ( !converted )
+        return nullptr;
+
+    return new PagePipeline( data, document );
+}
+
+PagePipeline::PagePipeline( const QByteArray &data, Poppler::Document *document )
+    : m_data( data ),
+      m_backend( document->renderBackend() ), m_hints( document->renderHints() ), m_paperColor( document->paperColor() ),
+      m_nextIndex( 0 ), m_consumedIndex( 0 ), m_capacity( 1 ), m_stop( false )
+{
+}
+
+PagePipeline::~PagePipeline()
+{
+}
+
+bool PagePipeline::run( const QList< int > &pages, const Job &job, const Consumer &consumer, const Progress &progress )
+{
+    if ( pages.isEmpty() )
+        return true;
+
+    // every worker keeps a rendered page in memory, so don't go wild
+    const int workerCount = qBound( 1, QThread::idealThreadCount(), qMin( 4, pages.count() ) );
+
+    m_mutex.lock();
+    m_pages = pages;
+    m_job = job;
+    m_results.clear();
+    m_nextIndex = 0;
+    m_consumedIndex = 0;
+    m_capacity = workerCount * 2;
+    m_stop = false;
+    m_mutex.unlock();
+
+    QVector< Worker * > workers;
+    for ( int i = 0; i < workerCount; ++i )
+    {
+        Worker *worker = new Worker( this );
+        worker->start();
+        workers.append( worker );
+    }
+
+    bool completed = true;
+    for ( int i = 0; i < pages.count(); ++i )
+    {
+        m_mutex.lock();
+        while ( !m_results.contains( i ) )
+            m_resultReady.wait( &m_mutex );
+        const QVariant result = m_results.take( i );
+        m_consumedIndex = i + 1;
+        m_slotFree.wakeAll();
+        m_mutex.unlock();
+
+        if ( !consumer( pages.at( i ), result ) )
+        {
+            completed = false;
+            break;
+        }
+        if ( progress )
+            progress( i + 1, pages.count() );
+    }
+
+    m_mutex.lock();
+    m_stop = true;
+    m_slotFree.wakeAll();
+    m_mutex.unlock();
+
+    for ( Worker *worker : qAsConst( workers ) )
+    {
+        worker->wait();
+        delete worker;
+    }
+
+    m_results.clear();
+    m_job = Job();
+    return completed;
+}
+
+void PagePipeline::work()
+{
+    Poppler::Document *document = Poppler::Document::loadFromData( m_data );
+    if ( document )
+    {
+        document->setRenderBackend( m_backend );
+        document->setPaperColor( m_paperColor );
+        for ( int bit = 0; bit < 16; ++bit )
+        {
+            const Poppler::Document::RenderHint hint = static_cast< Poppler::Document::RenderHint >( 1 << bit );
+            document->setRenderHint( hint, m_hints.testFlag( hint ) );
+        }
+    }
+
+    forever
+    {
+        m_mutex.lock();
+        // don't get too far ahead of the consumer
+        while ( !m_stop && m_nextIndex < m_pages.count() && m_nextIndex >= m_consumedIndex + m_capacity )
+            m_slotFree.wait( &m_mutex );
+        if ( m_stop || m_nextIndex >= m_pages.count() )
+        {
+            m_mutex.unlock();
+            break;
+        }
+        const int index = m_nextIndex++;
+        const int pageNumber = m_pages.at( index );
+        m_mutex.unlock();
+
+        QVariant result;
+        Poppler::Page *page = document ? document->page( pageNumber ) : nullptr;
+        if ( page )
+        {
+            result = m_job( page );
+            delete page;
+        }
+
+        m_mutex.lock();
+        m_results.insert( index, result );
+        m_resultReady.wakeAll();
+        m_mutex.unlock();
+    }
+
+    delete document;
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_GENERATOR_PDF_PAGEPIPELINE_H_
+#define _OKULAR_GENERATOR_PDF_PAGEPIPELINE_H_
+
+#include <poppler-qt5.h>
+
+#include <qbytearray.h>
+#include <qcolor.h>
+#include <qhash.h>
+#include <qlist.h>
+#include <qmutex.h>
+#include <qvariant.h>
+#include <qwaitcondition.h>
+
+#include <functional>
+
+/**
+ * Runs a job (rendering, text extraction, ...) on many pages at once.
+ *
+ * Every worker thread loads its own instance of the document, so the pages
+ * are processed in parallel without holding the generator's user mutex;
+ * the results are handed over in page order to the thread calling run(),
+ * through a bounded queue so that memory stays limited when the consumer
+ * (e.g. a printer) is slower than the workers.
+ */
+class PagePipeline
+{
+    public:
+        typedef std::function< QVariant ( Poppler::Page *page ) > Job;
+        typedef std::function< bool ( int page, const QVariant &result ) > Consumer;
+        typedef std::function< void ( int done, int total ) > Progress;
+
+        /**
+         * Creates a pipeline working on a copy of @p document, including
+         * its unsaved changes and render settings.
+         * The user mutex must be held while calling this.
+         *
+         * Returns 0 if the document cannot be copied (e.g. it is encrypted).
+         */
+        static PagePipeline *create( Poppler::Document *document );
+
+        ~PagePipeline();
+
+        /**
+         * Runs @p job on the @p pages (0-based) and calls @p consumer with
+         * the results, in the order of @p pages. A page that cannot be loaded
+         * gives an invalid QVariant.
+         *
+         * Stops as soon as @p consumer returns false; returns whether all
+         * the pages have been consumed.
+         *
+         * @p progress, if any, is called after each page is consumed, with
+         * the number of pages consumed so far and the number of @p pages.
+         */
+        bool run( const QList< int > &pages, const Job &job, const Consumer &consumer, const Progress &progress = Progress() );
+
+    private:
+        PagePipeline( const QByteArray &data, Poppler::Document *document );
+        Q_DISABLE_COPY( PagePipeline )
+
+        class Worker;
+        void work();
+
+        // the workers load the document from it
+        const QByteArray m_data;
+        const Poppler::Document::RenderBackend m_backend;
+        const Poppler::Document::RenderHints m_hints;
+        const QColor m_paperColor;
+
+        // state of the current run, protected by m_mutex
+        QMutex m_mutex;
+        QWaitCondition m_resultReady;
+        QWaitCondition m_slotFree;
+        QList< int > m_pages;
+        Job m_job;
+        QHash< int, QVariant > m_results;
+        int m_nextIndex;
+        int m_consumedIndex;
+        int m_capacity;
+        bool m_stop;
+};
+
+#endif
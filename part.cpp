@@ -1856,6 +1856,9 @@ bool Part::closeUrl()
 
 void Part::guiActivateEvent(KParts::GUIActivateEvent *event)
 {
+    // the documents in the other tabs give their memory back first
+    m_document->setActive( event->activated() );
+
     updateViewActions();
 
     KParts::ReadWritePart::guiActivateEvent(event);
@@ -1949,6 +1952,22 @@ bool Part::slotAttemptReload( bool oneShot, const QUrl &newUrl )
     }
     QScopedValueRollback<bool> rollback(m_isReloading, true);
 
+    // when the file just changed on disk, try to reload it in place: the
+    // pages that did not change keep what was rendered for them
+    if ( m_viewportDirty.pageNumber == -1 && newUrl.isEmpty() && !isModified() && m_document->canSwapBackingFile() )
+    {
+        m_toc->prepareForReload();
+        m_pageView->displayMessage( i18n("Reloading the document...") );
+        if ( m_document->reloadChangedFile() )
+        {
+            m_toc->finishReload();
+            m_fileLastModified = QFileInfo( localFilePath() ).lastModified();
+            emit enablePrintAction(m_document->printingSupport() != Okular::Document::NoPrinting);
+            return true;
+        }
+        m_toc->rollbackReload();
+    }
+
     bool tocReloadPrepared = false;
 
     // do the following the first time the file is reloaded
@@ -19,6 +19,8 @@
 #include <QIcon>
 #include <KLocalizedString>
 
+#include <algorithm>
+
 #include "core/annotations.h"
 #include "core/document.h"
 #include "core/observer.h"
@@ -62,10 +64,12 @@ public:
 
     void notifySetup( const QVector< Okular::Page * > &pages, int setupFlags ) override;
     void notifyPageChanged( int page, int flags ) override;
+    void notifyAnnotationChanged( int page, Okular::Annotation *annotation, AnnotationChange change ) override;
 
     QModelIndex indexForItem( AnnItem *item ) const;
     void rebuildTree( const QVector< Okular::Page * > &pages );
     AnnItem* findItem( int page, int *index ) const;
+    int insertPosition( int page ) const;
 
     AnnotationModel *q;
     AnnItem *root;
@@ -169,8 +173,7 @@ void AnnotationModelPrivate::notifyPageChanged( int page, int flags )
     //         => add a new branch, and add the annotations for the page
     if ( !annItem )
     {
-        int i = 0;
-        while ( i < root->children.count() && root->children.at( i )->page < page ) ++i;
+        const int i = insertPosition( page );
 
         AnnItem *annItem = new AnnItem();
         annItem->page = page;
@@ -246,6 +249,79 @@ void AnnotationModelPrivate::notifyPageChanged( int page, int flags )
     }
 }
 
+void AnnotationModelPrivate::notifyAnnotationChanged( int page, Okular::Annotation *annotation, AnnotationChange change )
+{
+    if ( annotation->subType() == Okular::Annotation::AWidget )
+        return;
+
+    int annItemIndex = -1;
+    AnnItem *annItem = findItem( page, &annItemIndex );
+
+    switch ( change )
+    {
+        case AnnotationAdded:
+        {
+            // the page appends new annotations to its list, so do the same
+            if ( !annItem )
+            {
+                annItemIndex = insertPosition( page );
+                q->beginInsertRows( QModelIndex(), annItemIndex, annItemIndex );
+                annItem = new AnnItem();
+                annItem->page = page;
+                annItem->parent = root;
+                root->children.insert( annItemIndex, annItem );
+                q->endInsertRows();
+            }
+            const int row = annItem->children.count();
+            q->beginInsertRows( indexForItem( annItem ), row, row );
+            new AnnItem( annItem, annotation );
+            q->endInsertRows();
+            break;
+        }
+        case AnnotationRemoved:
+        {
+            if ( !annItem )
+                return;
+
+            // the last annotation of the page takes the page branch with it
+            if ( annItem->children.count() == 1 && annItem->children.first()->annotation == annotation )
+            {
+                q->beginRemoveRows( QModelIndex(), annItemIndex, annItemIndex );
+                delete root->children.takeAt( annItemIndex );
+                q->endRemoveRows();
+                return;
+            }
+            for ( int i = 0; i < annItem->children.count(); ++i )
+            {
+                if ( annItem->children.at( i )->annotation == annotation )
+                {
+                    q->beginRemoveRows( indexForItem( annItem ), i, i );
+                    delete annItem->children.takeAt( i );
+                    q->endRemoveRows();
+                    return;
+                }
+            }
+            break;
+        }
+        case AnnotationModified:
+        {
+            if ( !annItem )
+                return;
+
+            for ( AnnItem *item : qAsConst( annItem->children ) )
+            {
+                if ( item->annotation == annotation )
+                {
+                    const QModelIndex index = indexForItem( item );
+                    emit q->dataChanged( index, index );
+                    return;
+                }
+            }
+            break;
+        }
+    }
+}
+
 QModelIndex AnnotationModelPrivate::indexForItem( AnnItem *item ) const
 {
     if ( item->parent )
@@ -281,21 +357,26 @@ void AnnotationModelPrivate::rebuildTree( const QVector< Okular::Page * > &pages
 
 AnnItem* AnnotationModelPrivate::findItem( int page, int *index ) const
 {
-    for ( int i = 0; i < root->children.count(); ++i )
+    // the page branches are sorted by page number
+    const int i = insertPosition( page );
+    if ( i < root->children.count() && root->children.at( i )->page == page )
     {
-        AnnItem *tmp = root->children.at( i );
-        if ( tmp->page == page )
-        {
-            if ( index )
-                *index = i;
-            return tmp;
-        }
+        if ( index )
+            *index = i;
+        return root->children.at( i );
     }
     if ( index )
         *index = -1;
     return nullptr;
 }
 
+int AnnotationModelPrivate::insertPosition( int page ) const
+{
+    const QList< AnnItem* >::const_iterator it = std::lower_bound( root->children.constBegin(), root->children.constEnd(), page,
+        []( const AnnItem *item, int page ) { return item->page < page; } );
+    return it - root->children.constBegin();
+}
+
 
 AnnotationModel::AnnotationModel( Okular::Document *document, QObject *parent )
     : QAbstractItemModel( parent ), d( new AnnotationModelPrivate( this ) )
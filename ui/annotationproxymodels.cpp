@@ -14,6 +14,8 @@
 
 #include <QIcon>
 
+#include <algorithm>
+
 #include "annotationmodel.h"
 #include "debug_ui.h"
 
@@ -68,7 +70,8 @@ bool PageFilterProxyModel::filterAcceptsRow( int row, const QModelIndex &sourceP
 
 PageGroupProxyModel::PageGroupProxyModel( QObject *parent )
   : QAbstractProxyModel( parent ),
-    mGroupByPage( false )
+    mGroupByPage( false ),
+    mNextPageId( 1 )
 {
 }
 
@@ -101,10 +104,10 @@ int PageGroupProxyModel::rowCount( const QModelIndex &parentIndex ) const
       if ( parentIndex.parent().isValid() )
         return 0;
       else {
-        return mTreeIndexes[ parentIndex.row() ].second.count(); // second-level
+        return sourceModel()->rowCount( mapToSource( parentIndex ) ); // second-level
       }
     } else {
-      return mTreeIndexes.count(); // top-level
+      return mPageIds.count(); // top-level
     }
   } else {
     if ( !parentIndex.isValid() ) // top-level
@@ -121,13 +124,14 @@ QModelIndex PageGroupProxyModel::index( int row, int column, const QModelIndex &
 
   if ( mGroupByPage ) {
     if ( parentIndex.isValid() ) {
-      if ( parentIndex.row() >= 0 && parentIndex.row() < mTreeIndexes.count()
-           && row < mTreeIndexes[ parentIndex.row() ].second.count() )
-        return createIndex( row, column, qint32( parentIndex.row() + 1 ) );
+      // the annotations point to their page by its id
+      if ( parentIndex.internalId() == 0 && parentIndex.row() >= 0 && parentIndex.row() < mPageIds.count()
+           && row < sourceModel()->rowCount( sourceModel()->index( parentIndex.row(), 0 ) ) )
+        return createIndex( row, column, mPageIds.at( parentIndex.row() ) );
       else
         return QModelIndex();
     } else {
-      if ( row < mTreeIndexes.count() )
+      if ( row < mPageIds.count() )
         return createIndex( row, column );
       else
         return QModelIndex();
@@ -145,8 +149,11 @@ QModelIndex PageGroupProxyModel::parent( const QModelIndex &idx ) const
   if ( mGroupByPage ) {
     if ( idx.internalId() == 0 ) // top-level
       return QModelIndex();
-    else
-      return index( idx.internalId() - 1, idx.column() );
+
+    const QPersistentModelIndex pageIndex = mPages.value( idx.internalId() );
+    if ( !pageIndex.isValid() )
+      return QModelIndex();
+    return createIndex( pageIndex.row(), idx.column() );
   } else {
     // We have only top-level items
     return QModelIndex();
@@ -157,15 +164,17 @@ QModelIndex PageGroupProxyModel::mapFromSource( const QModelIndex &sourceIndex )
 {
   if ( mGroupByPage ) {
     if ( sourceIndex.parent().isValid() ) {
-      return index( sourceIndex.row(), sourceIndex.column(), sourceIndex.parent() );
+      return index( sourceIndex.row(), sourceIndex.column(), mapFromSource( sourceIndex.parent() ) );
     } else {
       return index( sourceIndex.row(), sourceIndex.column() );
     }
   } else {
-    for ( int i = 0; i < mIndexes.count(); ++i ) {
-      if ( mIndexes[ i ] == sourceIndex )
-        return index( i, 0 );
-    }
+    if ( !sourceIndex.parent().isValid() )
+      return QModelIndex();
+
+    const int i = flatPosition( sourceIndex.parent().row(), sourceIndex.row() );
+    if ( i < mIndexes.count() && mIndexes[ i ] == sourceIndex )
+      return index( i, 0 );
 
     return QModelIndex();
   }
@@ -177,19 +186,11 @@ QModelIndex PageGroupProxyModel::mapToSource( const QModelIndex &proxyIndex ) co
     return QModelIndex();
 
   if ( mGroupByPage ) {
-    if ( proxyIndex.internalId() == 0 ) {
-
-      if ( proxyIndex.row() >= mTreeIndexes.count() || proxyIndex.row() < 0 )
-        return QModelIndex();
-
-      return mTreeIndexes[ proxyIndex.row() ].first;
-    } else {
-      if ( qint32(proxyIndex.internalId()) - 1 >= mTreeIndexes.count() ||
-           proxyIndex.row() >= mTreeIndexes[ proxyIndex.internalId() - 1 ].second.count() )
-        return QModelIndex();
-
-      return mTreeIndexes[ proxyIndex.internalId() - 1 ].second[ proxyIndex.row() ];
-    }
+    // the pages and their annotations are the same as in the source
+    if ( proxyIndex.internalId() == 0 )
+      return sourceModel()->index( proxyIndex.row(), 0 );
+    else
+      return sourceModel()->index( proxyIndex.row(), 0, mPages.value( proxyIndex.internalId() ) );
   } else {
     if ( proxyIndex.column() > 0 || proxyIndex.row() >= mIndexes.count() )
       return QModelIndex();
@@ -204,8 +205,10 @@ void PageGroupProxyModel::setSourceModel( QAbstractItemModel *model )
   if ( sourceModel() ) {
     disconnect( sourceModel(), &QAbstractItemModel::layoutChanged, this, &PageGroupProxyModel::rebuildIndexes );
     disconnect( sourceModel(), &QAbstractItemModel::modelReset, this, &PageGroupProxyModel::rebuildIndexes );
-    disconnect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &PageGroupProxyModel::rebuildIndexes );
-    disconnect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &PageGroupProxyModel::rebuildIndexes );
+    disconnect( sourceModel(), &QAbstractItemModel::rowsAboutToBeInserted, this, &PageGroupProxyModel::sourceRowsAboutToBeInserted );
+    disconnect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &PageGroupProxyModel::sourceRowsInserted );
+    disconnect( sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &PageGroupProxyModel::sourceRowsAboutToBeRemoved );
+    disconnect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &PageGroupProxyModel::sourceRowsRemoved );
     disconnect( sourceModel(), &QAbstractItemModel::dataChanged, this, &PageGroupProxyModel::sourceDataChanged );
   }
 
@@ -213,8 +216,10 @@ void PageGroupProxyModel::setSourceModel( QAbstractItemModel *model )
 
   connect( sourceModel(), &QAbstractItemModel::layoutChanged, this, &PageGroupProxyModel::rebuildIndexes );
   connect( sourceModel(), &QAbstractItemModel::modelReset, this, &PageGroupProxyModel::rebuildIndexes );
-  connect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &PageGroupProxyModel::rebuildIndexes );
-  connect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &PageGroupProxyModel::rebuildIndexes );
+  connect( sourceModel(), &QAbstractItemModel::rowsAboutToBeInserted, this, &PageGroupProxyModel::sourceRowsAboutToBeInserted );
+  connect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &PageGroupProxyModel::sourceRowsInserted );
+  connect( sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &PageGroupProxyModel::sourceRowsAboutToBeRemoved );
+  connect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &PageGroupProxyModel::sourceRowsRemoved );
   connect( sourceModel(), &QAbstractItemModel::dataChanged, this, &PageGroupProxyModel::sourceDataChanged );
 
   rebuildIndexes();
@@ -224,22 +229,14 @@ void PageGroupProxyModel::rebuildIndexes()
 {
   beginResetModel();
 
-  if ( mGroupByPage ) {
-    mTreeIndexes.clear();
-
-    for ( int row = 0; row < sourceModel()->rowCount(); ++row ) {
-      const QModelIndex pageIndex = sourceModel()->index( row, 0 );
-
-      QList<QModelIndex> itemIndexes;
-      for ( int subRow = 0; subRow < sourceModel()->rowCount( pageIndex ); ++subRow ) {
-        itemIndexes.append( sourceModel()->index( subRow, 0, pageIndex ) );
-      }
+  mIndexes.clear();
+  mPageIds.clear();
+  mPages.clear();
 
-      mTreeIndexes.append( QPair<QModelIndex, QList<QModelIndex> >( pageIndex, itemIndexes ) );
-    }
+  // when grouping by page the structure of the source is kept as is
+  if ( mGroupByPage ) {
+    addPages( 0, sourceModel()->rowCount() - 1 );
   } else {
-    mIndexes.clear();
-
     for ( int row = 0; row < sourceModel()->rowCount(); ++row ) {
       const QModelIndex pageIndex = sourceModel()->index( row, 0 );
       for ( int subRow = 0; subRow < sourceModel()->rowCount( pageIndex ); ++subRow ) {
@@ -251,6 +248,104 @@ void PageGroupProxyModel::rebuildIndexes()
   endResetModel();
 }
 
+int PageGroupProxyModel::flatPosition( int pageRow, int row ) const
+{
+  // the flat list is sorted by page and then by position in the page
+  const QList<QPersistentModelIndex>::const_iterator it = std::lower_bound( mIndexes.constBegin(), mIndexes.constEnd(), qMakePair( pageRow, row ),
+    []( const QPersistentModelIndex &index, const QPair<int, int> &position ) { return qMakePair( index.parent().row(), index.row() ) < position; } );
+  return it - mIndexes.constBegin();
+}
+
+void PageGroupProxyModel::addPages( int first, int last )
+{
+  for ( int row = first; row <= last; ++row ) {
+    const quintptr id = mNextPageId++;
+    mPageIds.insert( row, id );
+    mPages.insert( id, sourceModel()->index( row, 0 ) );
+  }
+}
+
+void PageGroupProxyModel::removePages( int first, int last )
+{
+  for ( int row = last; row >= first; --row )
+    mPages.remove( mPageIds.takeAt( row ) );
+}
+
+void PageGroupProxyModel::sourceRowsAboutToBeInserted( const QModelIndex &parentIndex, int first, int last )
+{
+  if ( mGroupByPage )
+    beginInsertRows( mapFromSource( parentIndex ), first, last );
+}
+
+void PageGroupProxyModel::sourceRowsInserted( const QModelIndex &parentIndex, int first, int last )
+{
+  if ( mGroupByPage ) {
+    if ( !parentIndex.isValid() )
+      addPages( first, last );
+    endInsertRows();
+    return;
+  }
+
+  // collect the new annotations, either the inserted ones or the ones
+  // of the inserted pages
+  QList<QPersistentModelIndex> indexes;
+  int position;
+  if ( parentIndex.isValid() ) {
+    position = flatPosition( parentIndex.row(), first );
+    for ( int row = first; row <= last; ++row )
+      indexes.append( sourceModel()->index( row, 0, parentIndex ) );
+  } else {
+    position = flatPosition( first, 0 );
+    for ( int row = first; row <= last; ++row ) {
+      const QModelIndex pageIndex = sourceModel()->index( row, 0 );
+      for ( int subRow = 0; subRow < sourceModel()->rowCount( pageIndex ); ++subRow )
+        indexes.append( sourceModel()->index( subRow, 0, pageIndex ) );
+    }
+  }
+
+  if ( indexes.isEmpty() )
+    return;
+
+  beginInsertRows( QModelIndex(), position, position + indexes.count() - 1 );
+  for ( int i = 0; i < indexes.count(); ++i )
+    mIndexes.insert( position + i, indexes.at( i ) );
+  endInsertRows();
+}
+
+void PageGroupProxyModel::sourceRowsAboutToBeRemoved( const QModelIndex &parentIndex, int first, int last )
+{
+  if ( mGroupByPage ) {
+    beginRemoveRows( mapFromSource( parentIndex ), first, last );
+    return;
+  }
+
+  int begin, end;
+  if ( parentIndex.isValid() ) {
+    begin = flatPosition( parentIndex.row(), first );
+    end = flatPosition( parentIndex.row(), last + 1 );
+  } else {
+    begin = flatPosition( first, 0 );
+    end = flatPosition( last + 1, 0 );
+  }
+
+  if ( begin == end )
+    return;
+
+  beginRemoveRows( QModelIndex(), begin, end - 1 );
+  mIndexes.erase( mIndexes.begin() + begin, mIndexes.begin() + end );
+  endRemoveRows();
+}
+
+void PageGroupProxyModel::sourceRowsRemoved( const QModelIndex &parentIndex, int first, int last )
+{
+  if ( !mGroupByPage )
+    return;
+
+  if ( !parentIndex.isValid() )
+    removePages( first, last );
+  endRemoveRows();
+}
+
 void PageGroupProxyModel::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
 {
     emit dataChanged(mapFromSource(topLeft), mapFromSource(bottomRight), roles);
@@ -288,6 +383,8 @@ class AuthorGroupItem
         }
 
         void appendChild( AuthorGroupItem *child ) { mChilds.append( child ); }
+        void insertChild( int row, AuthorGroupItem *child ) { mChilds.insert( row, child ); }
+        AuthorGroupItem* takeChild( int row ) { return mChilds.takeAt( row ); }
         AuthorGroupItem* parent() const { return mParent; }
         AuthorGroupItem* child( int row ) const { return mChilds.value( row ); }
         int childCount() const { return mChilds.count(); }
@@ -305,7 +402,7 @@ class AuthorGroupItem
 
         const AuthorGroupItem* findIndex( const QModelIndex &index ) const
         {
-            if ( index == mIndex )
+            if ( mIndex == index )
                 return this;
 
             for ( int i = 0; i < mChilds.count(); ++i ) {
@@ -331,7 +428,7 @@ class AuthorGroupItem
     private:
         AuthorGroupItem *mParent;
         Type mType;
-        QModelIndex mIndex;
+        QPersistentModelIndex mIndex;
         QList<AuthorGroupItem*> mChilds;
         QString mAuthor;
 };
@@ -349,11 +446,89 @@ class AuthorGroupProxyModel::Private
             delete mRoot;
         }
 
+        AuthorGroupItem *sourceItem( const QModelIndex &sourceIndex ) const;
+        AuthorGroupItem *createTopLevelItem( const QModelIndex &idx ) const;
+        AuthorGroupItem *createAuthorPageItem( const QModelIndex &idx ) const;
+        AuthorGroupItem *authorItem( AuthorGroupItem *parentItem, const QString &author ) const;
+        QModelIndex proxyIndex( AuthorGroupItem *item ) const;
+
         AuthorGroupProxyModel *mParent;
         AuthorGroupItem *mRoot;
         bool mGroupByAuthor;
 };
 
+// When not grouping by author the tree has the same shape as the source
+AuthorGroupItem *AuthorGroupProxyModel::Private::sourceItem( const QModelIndex &sourceIndex ) const
+{
+    if ( !sourceIndex.isValid() )
+        return mRoot;
+
+    AuthorGroupItem *parentItem = sourceItem( sourceIndex.parent() );
+    return parentItem ? parentItem->child( sourceIndex.row() ) : nullptr;
+}
+
+AuthorGroupItem *AuthorGroupProxyModel::Private::createTopLevelItem( const QModelIndex &idx ) const
+{
+    QAbstractItemModel *model = mParent->sourceModel();
+    const QString author = model->data( idx, AnnotationModel::AuthorRole ).toString();
+    if ( !author.isEmpty() ) {
+        // We have the annotations as top-level items
+        return new AuthorGroupItem( mRoot, AuthorGroupItem::Annotation, idx );
+    }
+
+    // We have the pages as top-level items
+    AuthorGroupItem *pageItem = new AuthorGroupItem( mRoot, AuthorGroupItem::Page, idx );
+
+    // Append all annotations as second-level
+    for ( int subRow = 0; subRow < model->rowCount( idx ); ++subRow ) {
+        const QModelIndex subIdx = model->index( subRow, 0, idx );
+        AuthorGroupItem *item = new AuthorGroupItem( pageItem, AuthorGroupItem::Annotation, subIdx );
+        pageItem->appendChild( item );
+    }
+    return pageItem;
+}
+
+// When grouping by author, the pages have their annotations grouped by
+// author, in the order the authors first appear
+AuthorGroupItem *AuthorGroupProxyModel::Private::createAuthorPageItem( const QModelIndex &idx ) const
+{
+    QAbstractItemModel *model = mParent->sourceModel();
+    AuthorGroupItem *pageItem = new AuthorGroupItem( mRoot, AuthorGroupItem::Page, idx );
+
+    for ( int subRow = 0; subRow < model->rowCount( idx ); ++subRow ) {
+        const QModelIndex annIdx = model->index( subRow, 0, idx );
+        const QString author = model->data( annIdx, AnnotationModel::AuthorRole ).toString();
+
+        AuthorGroupItem *item = authorItem( pageItem, author );
+        if ( !item ) {
+            item = new AuthorGroupItem( pageItem, AuthorGroupItem::Author );
+            item->setAuthor( author );
+            pageItem->appendChild( item );
+        }
+
+        item->appendChild( new AuthorGroupItem( item, AuthorGroupItem::Annotation, annIdx ) );
+    }
+    return pageItem;
+}
+
+AuthorGroupItem *AuthorGroupProxyModel::Private::authorItem( AuthorGroupItem *parentItem, const QString &author ) const
+{
+    for ( int row = 0; row < parentItem->childCount(); ++row ) {
+        AuthorGroupItem *item = parentItem->child( row );
+        if ( item->type() == AuthorGroupItem::Author && item->author() == author )
+            return item;
+    }
+    return nullptr;
+}
+
+QModelIndex AuthorGroupProxyModel::Private::proxyIndex( AuthorGroupItem *item ) const
+{
+    if ( item == mRoot )
+        return QModelIndex();
+
+    return mParent->index( item->row(), 0, proxyIndex( item->parent() ) );
+}
+
 AuthorGroupProxyModel::AuthorGroupProxyModel( QObject *parent )
     : QAbstractProxyModel( parent ),
       d( new Private( this ) )
@@ -418,7 +593,7 @@ QModelIndex AuthorGroupProxyModel::mapFromSource( const QModelIndex &sourceIndex
     if ( !sourceIndex.isValid() )
         return QModelIndex();
 
-    const AuthorGroupItem *item = d->mRoot->findIndex( sourceIndex );
+    const AuthorGroupItem *item = d->mGroupByAuthor ? d->mRoot->findIndex( sourceIndex ) : d->sourceItem( sourceIndex );
     if ( !item )
         return QModelIndex();
 
@@ -440,8 +615,8 @@ void AuthorGroupProxyModel::setSourceModel( QAbstractItemModel *model )
     if ( sourceModel() ) {
         disconnect( sourceModel(), &QAbstractItemModel::layoutChanged, this, &AuthorGroupProxyModel::rebuildIndexes );
         disconnect( sourceModel(), &QAbstractItemModel::modelReset, this, &AuthorGroupProxyModel::rebuildIndexes );
-        disconnect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &AuthorGroupProxyModel::rebuildIndexes );
-        disconnect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &AuthorGroupProxyModel::rebuildIndexes );
+        disconnect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &AuthorGroupProxyModel::sourceRowsInserted );
+        disconnect( sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &AuthorGroupProxyModel::sourceRowsAboutToBeRemoved );
         disconnect( sourceModel(), &QAbstractItemModel::dataChanged, this, &AuthorGroupProxyModel::sourceDataChanged );
     }
 
@@ -449,8 +624,8 @@ void AuthorGroupProxyModel::setSourceModel( QAbstractItemModel *model )
 
     connect( sourceModel(), &QAbstractItemModel::layoutChanged, this, &AuthorGroupProxyModel::rebuildIndexes );
     connect( sourceModel(), &QAbstractItemModel::modelReset, this, &AuthorGroupProxyModel::rebuildIndexes );
-    connect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &AuthorGroupProxyModel::rebuildIndexes );
-    connect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &AuthorGroupProxyModel::rebuildIndexes );
+    connect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &AuthorGroupProxyModel::sourceRowsInserted );
+    connect( sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &AuthorGroupProxyModel::sourceRowsAboutToBeRemoved );
     connect( sourceModel(), &QAbstractItemModel::dataChanged, this, &AuthorGroupProxyModel::sourceDataChanged );
 
     rebuildIndexes();
@@ -533,81 +708,150 @@ void AuthorGroupProxyModel::rebuildIndexes()
     d->mRoot = new AuthorGroupItem( nullptr );
 
     if ( d->mGroupByAuthor ) {
-        QMap<QString, AuthorGroupItem*> authorMap;
-
         for ( int row = 0; row < sourceModel()->rowCount(); ++row ) {
             const QModelIndex idx = sourceModel()->index( row, 0 );
             const QString author = sourceModel()->data( idx, AnnotationModel::AuthorRole ).toString();
             if ( !author.isEmpty() ) {
                 // We have the annotations as top-level, so introduce authors as new
                 // top-levels and append the annotations
-                AuthorGroupItem *authorItem = authorMap.value( author, 0 );
+                AuthorGroupItem *authorItem = d->authorItem( d->mRoot, author );
                 if ( !authorItem ) {
                     authorItem = new AuthorGroupItem( d->mRoot, AuthorGroupItem::Author );
                     authorItem->setAuthor( author );
-
-                    // Add item to tree
                     d->mRoot->appendChild( authorItem );
-
-                    // Insert to lookup list
-                    authorMap.insert( author, authorItem );
                 }
 
-                AuthorGroupItem *item = new AuthorGroupItem( authorItem, AuthorGroupItem::Annotation, idx );
-                authorItem->appendChild( item );
+                authorItem->appendChild( new AuthorGroupItem( authorItem, AuthorGroupItem::Annotation, idx ) );
             } else {
                 // We have the pages as top-level, so we use them as top-level, append the
                 // authors for all annotations of the page, and then the annotations themself
-                AuthorGroupItem *pageItem = new AuthorGroupItem( d->mRoot, AuthorGroupItem::Page, idx );
-                d->mRoot->appendChild( pageItem );
+                d->mRoot->appendChild( d->createAuthorPageItem( idx ) );
+            }
+        }
+    } else {
+        for ( int row = 0; row < sourceModel()->rowCount(); ++row ) {
+            d->mRoot->appendChild( d->createTopLevelItem( sourceModel()->index( row, 0 ) ) );
+        }
+    }
+
+    endResetModel();
+}
+
+void AuthorGroupProxyModel::insertAnnotation( AuthorGroupItem *parentItem, const QModelIndex &idx )
+{
+    const QString author = sourceModel()->data( idx, AnnotationModel::AuthorRole ).toString();
+    AuthorGroupItem *authorItem = d->authorItem( parentItem, author );
+    if ( !authorItem ) {
+        // a new author comes last, as if it appeared after the others
+        const int row = parentItem->childCount();
+        beginInsertRows( d->proxyIndex( parentItem ), row, row );
+        authorItem = new AuthorGroupItem( parentItem, AuthorGroupItem::Author );
+        authorItem->setAuthor( author );
+        authorItem->appendChild( new AuthorGroupItem( authorItem, AuthorGroupItem::Annotation, idx ) );
+        parentItem->appendChild( authorItem );
+        endInsertRows();
+        return;
+    }
 
-                // First collect all authors...
-                QMap<QString, AuthorGroupItem*> pageAuthorMap;
-                for ( int subRow = 0; subRow < sourceModel()->rowCount( idx ); ++subRow ) {
-                    const QModelIndex annIdx = sourceModel()->index( subRow, 0, idx );
-                    const QString author = sourceModel()->data( annIdx, AnnotationModel::AuthorRole ).toString();
+    // the annotations of an author are kept in the order of the source
+    int row = 0;
+    while ( row < authorItem->childCount() && authorItem->child( row )->index().row() < idx.row() )
+        ++row;
 
-                    AuthorGroupItem *authorItem = pageAuthorMap.value( author, 0 );
-                    if ( !authorItem ) {
-                        authorItem = new AuthorGroupItem( pageItem, AuthorGroupItem::Author );
-                        authorItem->setAuthor( author );
+    beginInsertRows( d->proxyIndex( authorItem ), row, row );
+    authorItem->insertChild( row, new AuthorGroupItem( authorItem, AuthorGroupItem::Annotation, idx ) );
+    endInsertRows();
+}
 
-                        // Add item to tree
-                        pageItem->appendChild( authorItem );
+void AuthorGroupProxyModel::removeAnnotation( AuthorGroupItem *parentItem, const QModelIndex &idx )
+{
+    const QString author = sourceModel()->data( idx, AnnotationModel::AuthorRole ).toString();
+    AuthorGroupItem *authorItem = d->authorItem( parentItem, author );
+    if ( !authorItem )
+        return;
 
-                        // Insert to lookup list
-                        pageAuthorMap.insert( author, authorItem );
-                    }
+    for ( int row = 0; row < authorItem->childCount(); ++row ) {
+        if ( authorItem->child( row )->index() != idx )
+            continue;
+
+        // the last annotation of an author takes the author with it
+        if ( authorItem->childCount() == 1 ) {
+            const int authorRow = authorItem->row();
+            beginRemoveRows( d->proxyIndex( parentItem ), authorRow, authorRow );
+            delete parentItem->takeChild( authorRow );
+            endRemoveRows();
+        } else {
+            beginRemoveRows( d->proxyIndex( authorItem ), row, row );
+            delete authorItem->takeChild( row );
+            endRemoveRows();
+        }
+        return;
+    }
+}
 
-                    AuthorGroupItem *item = new AuthorGroupItem( authorItem, AuthorGroupItem::Annotation, annIdx );
-                    authorItem->appendChild( item );
-                }
-            }
+void AuthorGroupProxyModel::sourceRowsInserted( const QModelIndex &parentIndex, int first, int last )
+{
+    if ( d->mGroupByAuthor ) {
+        // the pages are kept as they are, their annotations and the
+        // top-level annotations go in the group of their author
+        if ( !parentIndex.isValid() && sourceModel()->data( sourceModel()->index( first, 0 ), AnnotationModel::AuthorRole ).toString().isEmpty() ) {
+            beginInsertRows( QModelIndex(), first, last );
+            for ( int row = first; row <= last; ++row )
+                d->mRoot->insertChild( row, d->createAuthorPageItem( sourceModel()->index( row, 0 ) ) );
+            endInsertRows();
+            return;
         }
-    } else {
-        for ( int row = 0; row < sourceModel()->rowCount(); ++row ) {
-            const QModelIndex idx = sourceModel()->index( row, 0 );
-            const QString author = sourceModel()->data( idx, AnnotationModel::AuthorRole ).toString();
-            if ( !author.isEmpty() ) {
-                // We have the annotations as top-level items
-                AuthorGroupItem *item = new AuthorGroupItem( d->mRoot, AuthorGroupItem::Annotation, idx );
-                d->mRoot->appendChild( item );
-            } else {
-                // We have the pages as top-level items
-                AuthorGroupItem *pageItem = new AuthorGroupItem( d->mRoot, AuthorGroupItem::Page, idx );
-                d->mRoot->appendChild( pageItem );
-
-                // Append all annotations as second-level
-                for ( int subRow = 0; subRow < sourceModel()->rowCount( idx ); ++subRow ) {
-                    const QModelIndex subIdx = sourceModel()->index( subRow, 0, idx );
-                    AuthorGroupItem *item = new AuthorGroupItem( pageItem, AuthorGroupItem::Annotation, subIdx );
-                    pageItem->appendChild( item );
-                }
-            }
+
+        AuthorGroupItem *parentItem = parentIndex.isValid() ? d->mRoot->child( parentIndex.row() ) : d->mRoot;
+        if ( !parentItem )
+            return;
+        for ( int row = first; row <= last; ++row )
+            insertAnnotation( parentItem, sourceModel()->index( row, 0, parentIndex ) );
+        return;
+    }
+
+    AuthorGroupItem *parentItem = d->sourceItem( parentIndex );
+    if ( !parentItem )
+        return;
+
+    beginInsertRows( mapFromSource( parentIndex ), first, last );
+    for ( int row = first; row <= last; ++row ) {
+        const QModelIndex idx = sourceModel()->index( row, 0, parentIndex );
+        if ( parentIndex.isValid() )
+            parentItem->insertChild( row, new AuthorGroupItem( parentItem, AuthorGroupItem::Annotation, idx ) );
+        else
+            parentItem->insertChild( row, d->createTopLevelItem( idx ) );
+    }
+    endInsertRows();
+}
+
+void AuthorGroupProxyModel::sourceRowsAboutToBeRemoved( const QModelIndex &parentIndex, int first, int last )
+{
+    if ( d->mGroupByAuthor ) {
+        if ( !parentIndex.isValid() && sourceModel()->data( sourceModel()->index( first, 0 ), AnnotationModel::AuthorRole ).toString().isEmpty() ) {
+            beginRemoveRows( QModelIndex(), first, last );
+            for ( int row = last; row >= first; --row )
+                delete d->mRoot->takeChild( row );
+            endRemoveRows();
+            return;
         }
+
+        AuthorGroupItem *parentItem = parentIndex.isValid() ? d->mRoot->child( parentIndex.row() ) : d->mRoot;
+        if ( !parentItem )
+            return;
+        for ( int row = last; row >= first; --row )
+            removeAnnotation( parentItem, sourceModel()->index( row, 0, parentIndex ) );
+        return;
     }
 
-    endResetModel();
+    AuthorGroupItem *parentItem = d->sourceItem( parentIndex );
+    if ( !parentItem )
+        return;
+
+    beginRemoveRows( mapFromSource( parentIndex ), first, last );
+    for ( int row = last; row >= first; --row )
+        delete parentItem->takeChild( row );
+    endRemoveRows();
 }
 
 void AuthorGroupProxyModel::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
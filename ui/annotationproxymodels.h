@@ -11,7 +11,9 @@
 #define ANNOTATIONPROXYMODEL_H
 
 #include <QtCore/QSortFilterProxyModel>
+#include <QtCore/QHash>
 #include <QtCore/QPair>
+#include <QtCore/QPersistentModelIndex>
 
 /**
  * A proxy model, which filters out all pages except the
@@ -87,14 +89,31 @@ class PageGroupProxyModel : public QAbstractProxyModel
 
   private Q_SLOTS:
     void rebuildIndexes();
+    void sourceRowsAboutToBeInserted( const QModelIndex &parentIndex, int first, int last );
+    void sourceRowsInserted( const QModelIndex &parentIndex, int first, int last );
+    void sourceRowsAboutToBeRemoved( const QModelIndex &parentIndex, int first, int last );
+    void sourceRowsRemoved( const QModelIndex &parentIndex, int first, int last );
     void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
 
   private:
+    int flatPosition( int pageRow, int row ) const;
+    void addPages( int first, int last );
+    void removePages( int first, int last );
+
     bool mGroupByPage;
-    QList<QModelIndex> mIndexes;
-    QList<QPair< QModelIndex, QList<QModelIndex> > > mTreeIndexes;
+    // the annotations of all the pages, only used when not grouping by page
+    QList<QPersistentModelIndex> mIndexes;
+    // when grouping by page, the annotations point to their page by an id
+    // instead of by its row, so that adding or removing pages does not
+    // change the other indexes; the ids of the pages by row, and the pages
+    // by id
+    QList<quintptr> mPageIds;
+    QHash<quintptr, QPersistentModelIndex> mPages;
+    quintptr mNextPageId;
 };
 
+class AuthorGroupItem;
+
 /**
  * A proxy model which groups the annotations by author.
  */
@@ -137,9 +156,14 @@ class AuthorGroupProxyModel : public QAbstractProxyModel
 
     private Q_SLOTS:
         void rebuildIndexes();
+        void sourceRowsInserted( const QModelIndex &parentIndex, int first, int last );
+        void sourceRowsAboutToBeRemoved( const QModelIndex &parentIndex, int first, int last );
         void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
 
     private:
+        void insertAnnotation( AuthorGroupItem *parentItem, const QModelIndex &idx );
+        void removeAnnotation( AuthorGroupItem *parentItem, const QModelIndex &idx );
+
         class Private;
         Private* const d;
 };
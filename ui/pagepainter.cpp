@@ -10,6 +10,7 @@
 #include "pagepainter.h"
 
 // qt / kde includes
+#include <qcache.h>
 #include <qrect.h>
 #include <qpainter.h>
 #include <qpalette.h>
@@ -28,11 +29,13 @@
 #include "core/page.h"
 #include "core/page_p.h"
 #include "core/annotations.h"
+#include "core/annotations_p.h"
 #include "core/utils.h"
 #include "guiutils.h"
 #include "settings.h"
 #include "core/observer.h"
 #include "core/tile.h"
+#include "core/tracer_p.h"
 #include "settings_core.h"
 #include "ui/debug_ui.h"
 
@@ -40,6 +43,53 @@ Q_GLOBAL_STATIC_WITH_ARGS( QPixmap, busyPixmap, ( KIconLoader::global()->loadIco
 
 #define TEXTANNOTATION_ICONSIZE 24
 
+// size of the annotation appearance cache, in KiB
+#define ANNOTATION_APPEARANCE_CACHE_SIZE 32768
+// annotations bigger than this (in pixels) and than the painted area are
+// not cached, but painted only where needed each time
+#define ANNOTATION_APPEARANCE_MAX_AREA 1048576
+
+namespace {
+
+// one rendering of an annotation at a given page size
+struct AnnotationAppearanceKey
+{
+    uint serial;
+    int scaledWidth;
+    int scaledHeight;
+    int croppedWidth;
+    qreal dpr;
+};
+
+inline bool operator==( const AnnotationAppearanceKey &a, const AnnotationAppearanceKey &b )
+{
+    return a.serial == b.serial && a.scaledWidth == b.scaledWidth && a.scaledHeight == b.scaledHeight &&
+           a.croppedWidth == b.croppedWidth && a.dpr == b.dpr;
+}
+
+inline uint qHash( const AnnotationAppearanceKey &key, uint seed = 0 )
+{
+    return ::qHash( key.serial, seed ) ^ ::qHash( key.scaledWidth ) ^ ( ::qHash( key.scaledHeight ) << 1 );
+}
+
+typedef QCache< AnnotationAppearanceKey, QImage > AnnotationAppearanceCache;
+
+}
+
+Q_GLOBAL_STATIC_WITH_ARGS( AnnotationAppearanceCache, annotationAppearances, ( ANNOTATION_APPEARANCE_CACHE_SIZE ) )
+
+// return the cached appearance for key, rendering it if needed
+template< typename Render >
+static QImage cachedAppearance( const AnnotationAppearanceKey &key, Render render )
+{
+    if ( const QImage *image = annotationAppearances()->object( key ) )
+        return *image;
+
+    const QImage image = render();
+    annotationAppearances()->insert( key, new QImage( image ), qMax( 1, image.byteCount() / 1024 ) );
+    return image;
+}
+
 inline QPen buildPen( const Okular::Annotation *ann, double width, const QColor &color )
 {
     QPen p(
@@ -63,6 +113,7 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
     Okular::DocumentObserver *observer, int flags, int scaledWidth, int scaledHeight, const QRect &limits,
     const Okular::NormalizedRect &crop, Okular::NormalizedPoint *viewPortPoint )
 {
+    Okular::TraceScope trace( "paint", "ui", page->number() );
     qreal dpr = destPainter->device()->devicePixelRatioF();
 
     /* Calculate the cropped geometry of the page */
@@ -429,181 +480,15 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
                    yOffset = (double)limits.top() / (double)scaledHeight + crop.top,
                    yScale = (double)scaledHeight / (double)limits.height();
 
-            // paint all buffered annotations in the page
+            // paint all buffered annotations in the page, from their cached
+            // rendering when possible
             QList< Okular::Annotation * >::const_iterator aIt = bufferedAnnotations->constBegin(), aEnd = bufferedAnnotations->constEnd();
             for ( ; aIt != aEnd; ++aIt )
             {
                 Okular::Annotation * a = *aIt;
-                Okular::Annotation::SubType type = a->subType();
-                QColor acolor = a->style().color();
-                if ( !acolor.isValid() )
-                    acolor = Qt::yellow;
-                acolor.setAlphaF( a->style().opacity() );
-
-                // draw LineAnnotation MISSING: all
-                if ( type == Okular::Annotation::ALine )
-                {
-                    // get the annotation
-                    Okular::LineAnnotation * la = (Okular::LineAnnotation *) a;
-
-                    NormalizedPath path;
-                    // normalize page point to image
-                    const QLinkedList<Okular::NormalizedPoint> points = la->transformedLinePoints();
-                    QLinkedList<Okular::NormalizedPoint>::const_iterator it = points.constBegin();
-                    QLinkedList<Okular::NormalizedPoint>::const_iterator itEnd = points.constEnd();
-                    for ( ; it != itEnd; ++it )
-                    {
-                        Okular::NormalizedPoint point;
-                        point.x = ( (*it).x - xOffset) * xScale;
-                        point.y = ( (*it).y - yOffset) * yScale;
-                        path.append( point );
-                    }
-
-                    const QPen linePen = buildPen( a, a->style().width(), a->style().color() );
-                    QBrush fillBrush;
-
-                    if ( la->lineClosed() && la->lineInnerColor().isValid() )
-                        fillBrush = QBrush( la->lineInnerColor() );
-
-                    // draw the line as normalized path into image
-                    drawShapeOnImage( backImage, path, la->lineClosed(),
-                                      linePen,
-                                      fillBrush, pageScale ,Multiply);
-
-                    if ( path.count() == 2 && fabs( la->lineLeadingForwardPoint() ) > 0.1 )
-                    {
-                        Okular::NormalizedPoint delta( la->transformedLinePoints().last().x - la->transformedLinePoints().first().x, la->transformedLinePoints().first().y - la->transformedLinePoints().last().y );
-                        double angle = atan2( delta.y, delta.x );
-                        if ( delta.y < 0 )
-                            angle += 2 * M_PI;
-
-                        int sign = la->lineLeadingForwardPoint() > 0.0 ? 1 : -1;
-                        double LLx = fabs( la->lineLeadingForwardPoint() ) * cos( angle + sign * M_PI_2 + 2 * M_PI ) / page->width();
-                        double LLy = fabs( la->lineLeadingForwardPoint() ) * sin( angle + sign * M_PI_2 + 2 * M_PI ) / page->height();
-
-                        NormalizedPath path2;
-                        NormalizedPath path3;
-
-                        Okular::NormalizedPoint point;
-                        point.x = ( la->transformedLinePoints().first().x + LLx - xOffset ) * xScale;
-                        point.y = ( la->transformedLinePoints().first().y - LLy - yOffset ) * yScale;
-                        path2.append( point );
-                        point.x = ( la->transformedLinePoints().last().x + LLx - xOffset ) * xScale;
-                        point.y = ( la->transformedLinePoints().last().y - LLy - yOffset ) * yScale;
-                        path3.append( point );
-                        // do we have the extension on the "back"?
-                        if ( fabs( la->lineLeadingBackwardPoint() ) > 0.1 )
-                        {
-                            double LLEx = la->lineLeadingBackwardPoint() * cos( angle - sign * M_PI_2 + 2 * M_PI ) / page->width();
-                            double LLEy = la->lineLeadingBackwardPoint() * sin( angle - sign * M_PI_2 + 2 * M_PI ) / page->height();
-                            point.x = ( la->transformedLinePoints().first().x + LLEx - xOffset ) * xScale;
-                            point.y = ( la->transformedLinePoints().first().y - LLEy - yOffset ) * yScale;
-                            path2.append( point );
-                            point.x = ( la->transformedLinePoints().last().x + LLEx - xOffset ) * xScale;
-                            point.y = ( la->transformedLinePoints().last().y - LLEy - yOffset ) * yScale;
-                            path3.append( point );
-                        }
-                        else
-                        {
-                            path2.append( path[0] );
-                            path3.append( path[1] );
-                        }
-
-                        drawShapeOnImage( backImage, path2, false, linePen, QBrush(), pageScale, Multiply );
-                        drawShapeOnImage( backImage, path3, false, linePen, QBrush(), pageScale, Multiply );
-                    }
-                }
-                // draw HighlightAnnotation MISSING: under/strike width, feather, capping
-                else if ( type == Okular::Annotation::AHighlight )
-                {
-                    // get the annotation
-                    Okular::HighlightAnnotation * ha = (Okular::HighlightAnnotation *) a;
-                    Okular::HighlightAnnotation::HighlightType type = ha->highlightType();
-
-                    // draw each quad of the annotation
-                    int quads = ha->highlightQuads().size();
-                    for ( int q = 0; q < quads; q++ )
-                    {
-                        NormalizedPath path;
-                        const Okular::HighlightAnnotation::Quad & quad = ha->highlightQuads()[ q ];
-                        // normalize page point to image
-                        for ( int i = 0; i < 4; i++ )
-                        {
-                            Okular::NormalizedPoint point;
-                            point.x = (quad.transformedPoint( i ).x - xOffset) * xScale;
-                            point.y = (quad.transformedPoint( i ).y - yOffset) * yScale;
-                            path.append( point );
-                        }
-                        // draw the normalized path into image
-                        switch ( type )
-                        {
-                            // highlight the whole rect
-                            case Okular::HighlightAnnotation::Highlight:
-                                drawShapeOnImage( backImage, path, true, Qt::NoPen, acolor, pageScale, Multiply );
-                                break;
-                            // highlight the bottom part of the rect
-                            case Okular::HighlightAnnotation::Squiggly:
-                                path[ 3 ].x = ( path[ 0 ].x + path[ 3 ].x ) / 2.0;
-                                path[ 3 ].y = ( path[ 0 ].y + path[ 3 ].y ) / 2.0;
-                                path[ 2 ].x = ( path[ 1 ].x + path[ 2 ].x ) / 2.0;
-                                path[ 2 ].y = ( path[ 1 ].y + path[ 2 ].y ) / 2.0;
-                                drawShapeOnImage( backImage, path, true, Qt::NoPen, acolor, pageScale, Multiply );
-                                break;
-                            // make a line at 3/4 of the height
-                            case Okular::HighlightAnnotation::Underline:
-                                path[ 0 ].x = ( 3 * path[ 0 ].x + path[ 3 ].x ) / 4.0;
-                                path[ 0 ].y = ( 3 * path[ 0 ].y + path[ 3 ].y ) / 4.0;
-                                path[ 1 ].x = ( 3 * path[ 1 ].x + path[ 2 ].x ) / 4.0;
-                                path[ 1 ].y = ( 3 * path[ 1 ].y + path[ 2 ].y ) / 4.0;
-                                path.pop_back();
-                                path.pop_back();
-                                drawShapeOnImage( backImage, path, false, QPen( acolor, 2 ), QBrush(), pageScale );
-                                break;
-                            // make a line at 1/2 of the height
-                            case Okular::HighlightAnnotation::StrikeOut:
-                                path[ 0 ].x = ( path[ 0 ].x + path[ 3 ].x ) / 2.0;
-                                path[ 0 ].y = ( path[ 0 ].y + path[ 3 ].y ) / 2.0;
-                                path[ 1 ].x = ( path[ 1 ].x + path[ 2 ].x ) / 2.0;
-                                path[ 1 ].y = ( path[ 1 ].y + path[ 2 ].y ) / 2.0;
-                                path.pop_back();
-                                path.pop_back();
-                                drawShapeOnImage( backImage, path, false, QPen( acolor, 2 ), QBrush(), pageScale );
-                                break;
-                        }
-                    }
-                }
-                // draw InkAnnotation MISSING:invar width, PENTRACER
-                else if ( type == Okular::Annotation::AInk )
-                {
-                    // get the annotation
-                    Okular::InkAnnotation * ia = (Okular::InkAnnotation *) a;
-
-                    // draw each ink path
-                    const QList< QLinkedList<Okular::NormalizedPoint> > transformedInkPaths = ia->transformedInkPaths();
-
-                    const QPen inkPen = buildPen( a, a->style().width(), acolor );
-
-                    int paths = transformedInkPaths.size();
-                    for ( int p = 0; p < paths; p++ )
-                    {
-                        NormalizedPath path;
-                        const QLinkedList<Okular::NormalizedPoint> & inkPath = transformedInkPaths[ p ];
-
-                        // normalize page point to image
-                        QLinkedList<Okular::NormalizedPoint>::const_iterator pIt = inkPath.constBegin(), pEnd = inkPath.constEnd();
-                        for ( ; pIt != pEnd; ++pIt )
-                        {
-                            const Okular::NormalizedPoint & inkPoint = *pIt;
-                            Okular::NormalizedPoint point;
-                            point.x = (inkPoint.x - xOffset) * xScale;
-                            point.y = (inkPoint.y - yOffset) * yScale;
-                            path.append( point );
-                        }
-                        // draw the normalized path into image
-                        drawShapeOnImage( backImage, path, false, inkPen, QBrush(), pageScale );
-                    }
-                }
-            } // end current annotation drawing
+                if ( !drawCachedAnnotation( backImage, page, a, scaledWidth, scaledHeight, croppedWidth, crop, limits, dpr ) )
+                    drawBufferedAnnotation( backImage, page, a, xOffset, xScale, yOffset, yScale, pageScale );
+            }
         }
         if(viewPortPoint)
         {
@@ -662,6 +547,8 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
                 acolor = Qt::yellow;
             acolor.setAlpha( opacity );
 
+            const AnnotationAppearanceKey key = { appearanceSerial( a ), scaledWidth, scaledHeight, croppedWidth, dpr };
+
             // get annotation boundary and drawn rect
             QRect annotBoundary = a->transformedBoundingRectangle().geometry( scaledWidth, scaledHeight ).translated( -scaledCrop.topLeft() );
             QRect annotRect = annotBoundary.intersected( limits );
@@ -677,58 +564,58 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
                 Okular::TextAnnotation * text = (Okular::TextAnnotation *)a;
                 if ( text->textType() == Okular::TextAnnotation::InPlace )
                 {
-                    QImage image( annotBoundary.size(), QImage::Format_ARGB32 );
-                    image.fill( acolor.rgba() );
-                    QPainter painter( &image );
-                    painter.setFont( text->textFont() );
-                    Qt::AlignmentFlag halign = ( text->inplaceAlignment() == 1 ? Qt::AlignHCenter : ( text->inplaceAlignment() == 2 ? Qt::AlignRight : Qt::AlignLeft ) );
-                    const double invXScale = (double)page->width() / scaledWidth;
-                    const double invYScale = (double)page->height() / scaledHeight;
-                    const double borderWidth = text->style().width();
-                    painter.scale( 1 / invXScale, 1 / invYScale );
-                    painter.drawText( borderWidth * invXScale, borderWidth * invYScale,
-                                      (image.width() - 2 * borderWidth) * invXScale,
-                                      (image.height() - 2 * borderWidth) * invYScale,
-                                      Qt::AlignTop | halign | Qt::TextWrapAnywhere,
-                                      text->contents() );
-                    painter.resetTransform();
-                    //Required as asking for a zero width pen results
-                    //in a default width pen (1.0) being created
-                    if ( borderWidth != 0 )
-                    {
-                        QPen pen( Qt::black, borderWidth );
-                        painter.setPen( pen );
-                        painter.drawRect( 0, 0, image.width() - 1, image.height() - 1 );
-                    }
-                    painter.end();
+                    const QImage image = cachedAppearance( key, [&] {
+                        QImage image( annotBoundary.size(), QImage::Format_ARGB32 );
+                        image.fill( acolor.rgba() );
+                        QPainter painter( &image );
+                        painter.setFont( text->textFont() );
+                        Qt::AlignmentFlag halign = ( text->inplaceAlignment() == 1 ? Qt::AlignHCenter : ( text->inplaceAlignment() == 2 ? Qt::AlignRight : Qt::AlignLeft ) );
+                        const double invXScale = (double)page->width() / scaledWidth;
+                        const double invYScale = (double)page->height() / scaledHeight;
+                        const double borderWidth = text->style().width();
+                        painter.scale( 1 / invXScale, 1 / invYScale );
+                        painter.drawText( borderWidth * invXScale, borderWidth * invYScale,
+                                          (image.width() - 2 * borderWidth) * invXScale,
+                                          (image.height() - 2 * borderWidth) * invYScale,
+                                          Qt::AlignTop | halign | Qt::TextWrapAnywhere,
+                                          text->contents() );
+                        painter.resetTransform();
+                        //Required as asking for a zero width pen results
+                        //in a default width pen (1.0) being created
+                        if ( borderWidth != 0 )
+                        {
+                            QPen pen( Qt::black, borderWidth );
+                            painter.setPen( pen );
+                            painter.drawRect( 0, 0, image.width() - 1, image.height() - 1 );
+                        }
+                        painter.end();
+                        return image;
+                    } );
 
                     mixedPainter->drawImage( annotBoundary.topLeft(), image );
                 }
                 else if ( text->textType() == Okular::TextAnnotation::Linked )
                 {
                 // get pixmap, colorize and alpha-blend it
-                    QString path;
-                    QPixmap pixmap = GuiUtils::iconLoader()->loadIcon( text->textIcon().toLower(), KIconLoader::User, 32, KIconLoader::DefaultState, QStringList(), &path, true );
-                    if ( path.isEmpty() )
-                        pixmap = GuiUtils::iconLoader()->loadIcon( text->textIcon().toLower(), KIconLoader::NoGroup, 32 );
-                    QRect annotBoundary2 = QRect( annotBoundary.topLeft(), QSize( TEXTANNOTATION_ICONSIZE * dpr, TEXTANNOTATION_ICONSIZE * dpr ) );
-                    QRect annotRect2 = annotBoundary2.intersected( limits );
-                    QRect innerRect2( annotRect2.left() - annotBoundary2.left(), annotRect2.top() -
-                    annotBoundary2.top(), annotRect2.width(), annotRect2.height() );
-
-                    QPixmap scaledCroppedPixmap = pixmap.scaled(TEXTANNOTATION_ICONSIZE * dpr, TEXTANNOTATION_ICONSIZE * dpr).copy(dInnerRect.toAlignedRect());
-                    scaledCroppedPixmap.setDevicePixelRatio(dpr);
-                    QImage scaledCroppedImage = scaledCroppedPixmap.toImage();
-
-                    // if the annotation color is valid (ie it was set), then
-                    // use it to colorize the icon, otherwise the icon will be
-                    // "gray"
-                    if ( a->style().color().isValid() )
-                        GuiUtils::colorizeImage( scaledCroppedImage, a->style().color(), opacity );
-                    pixmap = QPixmap::fromImage( scaledCroppedImage );
+                    const QImage icon = cachedAppearance( key, [&] {
+                        QString path;
+                        QPixmap pixmap = GuiUtils::iconLoader()->loadIcon( text->textIcon().toLower(), KIconLoader::User, 32, KIconLoader::DefaultState, QStringList(), &path, true );
+                        if ( path.isEmpty() )
+                            pixmap = GuiUtils::iconLoader()->loadIcon( text->textIcon().toLower(), KIconLoader::NoGroup, 32 );
+
+                        QImage scaledImage = pixmap.scaled(TEXTANNOTATION_ICONSIZE * dpr, TEXTANNOTATION_ICONSIZE * dpr).toImage();
+
+                        // if the annotation color is valid (ie it was set), then
+                        // use it to colorize the icon, otherwise the icon will be
+                        // "gray"
+                        if ( a->style().color().isValid() )
+                            GuiUtils::colorizeImage( scaledImage, a->style().color(), opacity );
+                        scaledImage.setDevicePixelRatio(dpr);
+                        return scaledImage;
+                    } );
 
                     // draw the mangled image to painter
-                    mixedPainter->drawPixmap( annotRect.topLeft(), pixmap);
+                    mixedPainter->drawImage( annotRect.topLeft(), icon, dInnerRect.toAlignedRect() );
                 }
 
             }
@@ -738,22 +625,24 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
                 Okular::StampAnnotation * stamp = (Okular::StampAnnotation *)a;
 
                 // get pixmap and alpha blend it if needed
-                QPixmap pixmap = GuiUtils::loadStamp( stamp->stampIconName(), annotBoundary.size() );
-                if ( !pixmap.isNull() ) // should never happen but can happen on huge sizes
-                {
-                    const QRect dInnerRect(QRectF(innerRect.x() * dpr, innerRect.y() * dpr, innerRect.width() * dpr, innerRect.height() * dpr).toAlignedRect());
-
-                    QPixmap scaledCroppedPixmap = pixmap.scaled(annotBoundary.width() * dpr, annotBoundary.height() * dpr).copy(dInnerRect);
-                    scaledCroppedPixmap.setDevicePixelRatio(dpr);
-
-                    QImage scaledCroppedImage = scaledCroppedPixmap.toImage();
+                const QImage stampImage = cachedAppearance( key, [&] {
+                    const QPixmap pixmap = GuiUtils::loadStamp( stamp->stampIconName(), annotBoundary.size() );
+                    if ( pixmap.isNull() ) // should never happen but can happen on huge sizes
+                        return QImage();
 
+                    QImage scaledImage = pixmap.scaled(annotBoundary.width() * dpr, annotBoundary.height() * dpr).toImage();
                     if ( opacity < 255 )
-                        changeImageAlpha( scaledCroppedImage, opacity );
-                    pixmap = QPixmap::fromImage( scaledCroppedImage );
+                        changeImageAlpha( scaledImage, opacity );
+                    scaledImage.setDevicePixelRatio(dpr);
+                    return scaledImage;
+                } );
+
+                if ( !stampImage.isNull() )
+                {
+                    const QRect dInnerRect(QRectF(innerRect.x() * dpr, innerRect.y() * dpr, innerRect.width() * dpr, innerRect.height() * dpr).toAlignedRect());
 
-                    // draw the scaled and al
-                    mixedPainter->drawPixmap( annotRect.topLeft(), pixmap );
+                    // draw the scaled and alpha blended stamp
+                    mixedPainter->drawImage( annotRect.topLeft(), stampImage, dInnerRect );
                 }
             }
             // draw GeomAnnotation
@@ -853,6 +742,236 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
 
 
 /** Private Helpers :: Pixmap conversion **/
+uint PagePainter::appearanceSerial( const Okular::Annotation *annotation )
+{
+    return annotation->d_ptr->m_appearanceSerial;
+}
+
+bool PagePainter::drawCachedAnnotation( QImage &backImage, const Okular::Page *page, Okular::Annotation *a,
+    int scaledWidth, int scaledHeight, int croppedWidth, const Okular::NormalizedRect &crop, const QRect &limits, qreal dpr )
+{
+    const double pageScale = (double)croppedWidth / page->width();
+
+    // the shapes of lines and highlights are multiplied with the page: render
+    // them over white, which multiplies to the page unchanged
+    bool multiply = false;
+    double leadingLines = 0;
+    if ( a->subType() == Okular::Annotation::ALine )
+    {
+        const Okular::LineAnnotation * la = static_cast< const Okular::LineAnnotation * >( a );
+        multiply = true;
+        leadingLines = ( fabs( la->lineLeadingForwardPoint() ) + fabs( la->lineLeadingBackwardPoint() ) ) * scaledWidth / page->width();
+    }
+    else if ( a->subType() == Okular::Annotation::AHighlight )
+    {
+        const Okular::HighlightAnnotation::HighlightType type = static_cast< const Okular::HighlightAnnotation * >( a )->highlightType();
+        multiply = type == Okular::HighlightAnnotation::Highlight || type == Okular::HighlightAnnotation::Squiggly;
+    }
+
+    // the area of the annotation in the uncropped page, with room for the pen
+    const int margin = ceil( ( a->style().width() + 2 ) * pageScale + leadingLines ) + 2;
+    const QRect rect = a->transformedBoundingRectangle().geometry( scaledWidth, scaledHeight ).adjusted( -margin, -margin, margin, margin );
+
+    // drawShapeOnImage() works in image pixels, that the painter scales once
+    // more by the device pixel ratio of the image
+    const qreal deviceScale = dpr * backImage.devicePixelRatio();
+    const QSize size( ceil( rect.width() * deviceScale ), ceil( rect.height() * deviceScale ) );
+    const qint64 area = (qint64)size.width() * size.height();
+    if ( area > ANNOTATION_APPEARANCE_MAX_AREA && area > 4 * (qint64)backImage.width() * backImage.height() )
+        return false;
+
+    const AnnotationAppearanceKey key = { appearanceSerial( a ), scaledWidth, scaledHeight, croppedWidth, dpr };
+    const QImage image = cachedAppearance( key, [&] {
+        QImage image( size, QImage::Format_ARGB32_Premultiplied );
+        image.setDevicePixelRatio( backImage.devicePixelRatio() );
+        image.fill( multiply ? Qt::white : Qt::transparent );
+        drawBufferedAnnotation( image, page, a, (double)rect.left() / scaledWidth, scaledWidth * dpr / size.width(),
+                                (double)rect.top() / scaledHeight, scaledHeight * dpr / size.height(), pageScale );
+        return image;
+    } );
+
+    QPainter painter( &backImage );
+    if ( multiply )
+        painter.setCompositionMode( QPainter::CompositionMode_Multiply );
+    painter.drawImage( QPointF( ( rect.left() - crop.left * scaledWidth - limits.left() ) * dpr,
+                                ( rect.top() - crop.top * scaledHeight - limits.top() ) * dpr ), image );
+    return true;
+}
+
+void PagePainter::drawBufferedAnnotation( QImage &image, const Okular::Page *page, Okular::Annotation *a,
+    double xOffset, double xScale, double yOffset, double yScale, double pageScale )
+{
+    Okular::Annotation::SubType type = a->subType();
+    QColor acolor = a->style().color();
+    if ( !acolor.isValid() )
+        acolor = Qt::yellow;
+    acolor.setAlphaF( a->style().opacity() );
+
+    // draw LineAnnotation MISSING: all
+    if ( type == Okular::Annotation::ALine )
+    {
+        // get the annotation
+        Okular::LineAnnotation * la = (Okular::LineAnnotation *) a;
+
+        NormalizedPath path;
+        // normalize page point to image
+        const QLinkedList<Okular::NormalizedPoint> points = la->transformedLinePoints();
+        QLinkedList<Okular::NormalizedPoint>::const_iterator it = points.constBegin();
+        QLinkedList<Okular::NormalizedPoint>::const_iterator itEnd = points.constEnd();
+        for ( ; it != itEnd; ++it )
+        {
+            Okular::NormalizedPoint point;
+            point.x = ( (*it).x - xOffset) * xScale;
+            point.y = ( (*it).y - yOffset) * yScale;
+            path.append( point );
+        }
+
+        const QPen linePen = buildPen( a, a->style().width(), a->style().color() );
+        QBrush fillBrush;
+
+        if ( la->lineClosed() && la->lineInnerColor().isValid() )
+            fillBrush = QBrush( la->lineInnerColor() );
+
+        // draw the line as normalized path into image
+        drawShapeOnImage( image, path, la->lineClosed(),
+                          linePen,
+                          fillBrush, pageScale ,Multiply);
+
+        if ( path.count() == 2 && fabs( la->lineLeadingForwardPoint() ) > 0.1 )
+        {
+            Okular::NormalizedPoint delta( la->transformedLinePoints().last().x - la->transformedLinePoints().first().x, la->transformedLinePoints().first().y - la->transformedLinePoints().last().y );
+            double angle = atan2( delta.y, delta.x );
+            if ( delta.y < 0 )
+                angle += 2 * M_PI;
+
+            int sign = la->lineLeadingForwardPoint() > 0.0 ? 1 : -1;
+            double LLx = fabs( la->lineLeadingForwardPoint() ) * cos( angle + sign * M_PI_2 + 2 * M_PI ) / page->width();
+            double LLy = fabs( la->lineLeadingForwardPoint() ) * sin( angle + sign * M_PI_2 + 2 * M_PI ) / page->height();
+
+            NormalizedPath path2;
+            NormalizedPath path3;
+
+            Okular::NormalizedPoint point;
+            point.x = ( la->transformedLinePoints().first().x + LLx - xOffset ) * xScale;
+            point.y = ( la->transformedLinePoints().first().y - LLy - yOffset ) * yScale;
+            path2.append( point );
+            point.x = ( la->transformedLinePoints().last().x + LLx - xOffset ) * xScale;
+            point.y = ( la->transformedLinePoints().last().y - LLy - yOffset ) * yScale;
+            path3.append( point );
+            // do we have the extension on the "back"?
+            if ( fabs( la->lineLeadingBackwardPoint() ) > 0.1 )
+            {
+                double LLEx = la->lineLeadingBackwardPoint() * cos( angle - sign * M_PI_2 + 2 * M_PI ) / page->width();
+                double LLEy = la->lineLeadingBackwardPoint() * sin( angle - sign * M_PI_2 + 2 * M_PI ) / page->height();
+                point.x = ( la->transformedLinePoints().first().x + LLEx - xOffset ) * xScale;
+                point.y = ( la->transformedLinePoints().first().y - LLEy - yOffset ) * yScale;
+                path2.append( point );
+                point.x = ( la->transformedLinePoints().last().x + LLEx - xOffset ) * xScale;
+                point.y = ( la->transformedLinePoints().last().y - LLEy - yOffset ) * yScale;
+                path3.append( point );
+            }
+            else
+            {
+                path2.append( path[0] );
+                path3.append( path[1] );
+            }
+
+            drawShapeOnImage( image, path2, false, linePen, QBrush(), pageScale, Multiply );
+            drawShapeOnImage( image, path3, false, linePen, QBrush(), pageScale, Multiply );
+        }
+    }
+    // draw HighlightAnnotation MISSING: under/strike width, feather, capping
+    else if ( type == Okular::Annotation::AHighlight )
+    {
+        // get the annotation
+        Okular::HighlightAnnotation * ha = (Okular::HighlightAnnotation *) a;
+        Okular::HighlightAnnotation::HighlightType type = ha->highlightType();
+
+        // draw each quad of the annotation
+        int quads = ha->highlightQuads().size();
+        for ( int q = 0; q < quads; q++ )
+        {
+            NormalizedPath path;
+            const Okular::HighlightAnnotation::Quad & quad = ha->highlightQuads()[ q ];
+            // normalize page point to image
+            for ( int i = 0; i < 4; i++ )
+            {
+                Okular::NormalizedPoint point;
+                point.x = (quad.transformedPoint( i ).x - xOffset) * xScale;
+                point.y = (quad.transformedPoint( i ).y - yOffset) * yScale;
+                path.append( point );
+            }
+            // draw the normalized path into image
+            switch ( type )
+            {
+                // highlight the whole rect
+                case Okular::HighlightAnnotation::Highlight:
+                    drawShapeOnImage( image, path, true, Qt::NoPen, acolor, pageScale, Multiply );
+                    break;
+                // highlight the bottom part of the rect
+                case Okular::HighlightAnnotation::Squiggly:
+                    path[ 3 ].x = ( path[ 0 ].x + path[ 3 ].x ) / 2.0;
+                    path[ 3 ].y = ( path[ 0 ].y + path[ 3 ].y ) / 2.0;
+                    path[ 2 ].x = ( path[ 1 ].x + path[ 2 ].x ) / 2.0;
+                    path[ 2 ].y = ( path[ 1 ].y + path[ 2 ].y ) / 2.0;
+                    drawShapeOnImage( image, path, true, Qt::NoPen, acolor, pageScale, Multiply );
+                    break;
+                // make a line at 3/4 of the height
+                case Okular::HighlightAnnotation::Underline:
+                    path[ 0 ].x = ( 3 * path[ 0 ].x + path[ 3 ].x ) / 4.0;
+                    path[ 0 ].y = ( 3 * path[ 0 ].y + path[ 3 ].y ) / 4.0;
+                    path[ 1 ].x = ( 3 * path[ 1 ].x + path[ 2 ].x ) / 4.0;
+                    path[ 1 ].y = ( 3 * path[ 1 ].y + path[ 2 ].y ) / 4.0;
+                    path.pop_back();
+                    path.pop_back();
+                    drawShapeOnImage( image, path, false, QPen( acolor, 2 ), QBrush(), pageScale );
+                    break;
+                // make a line at 1/2 of the height
+                case Okular::HighlightAnnotation::StrikeOut:
+                    path[ 0 ].x = ( path[ 0 ].x + path[ 3 ].x ) / 2.0;
+                    path[ 0 ].y = ( path[ 0 ].y + path[ 3 ].y ) / 2.0;
+                    path[ 1 ].x = ( path[ 1 ].x + path[ 2 ].x ) / 2.0;
+                    path[ 1 ].y = ( path[ 1 ].y + path[ 2 ].y ) / 2.0;
+                    path.pop_back();
+                    path.pop_back();
+                    drawShapeOnImage( image, path, false, QPen( acolor, 2 ), QBrush(), pageScale );
+                    break;
+            }
+        }
+    }
+    // draw InkAnnotation MISSING:invar width, PENTRACER
+    else if ( type == Okular::Annotation::AInk )
+    {
+        // get the annotation
+        Okular::InkAnnotation * ia = (Okular::InkAnnotation *) a;
+
+        // draw each ink path
+        const QList< QLinkedList<Okular::NormalizedPoint> > transformedInkPaths = ia->transformedInkPaths();
+
+        const QPen inkPen = buildPen( a, a->style().width(), acolor );
+
+        int paths = transformedInkPaths.size();
+        for ( int p = 0; p < paths; p++ )
+        {
+            NormalizedPath path;
+            const QLinkedList<Okular::NormalizedPoint> & inkPath = transformedInkPaths[ p ];
+
+            // normalize page point to image
+            QLinkedList<Okular::NormalizedPoint>::const_iterator pIt = inkPath.constBegin(), pEnd = inkPath.constEnd();
+            for ( ; pIt != pEnd; ++pIt )
+            {
+                const Okular::NormalizedPoint & inkPoint = *pIt;
+                Okular::NormalizedPoint point;
+                point.x = (inkPoint.x - xOffset) * xScale;
+                point.y = (inkPoint.y - yOffset) * yScale;
+                path.append( point );
+            }
+            // draw the normalized path into image
+            drawShapeOnImage( image, path, false, inkPen, QBrush(), pageScale );
+        }
+    }
+}
+
 void PagePainter::cropPixmapOnImage( QImage & dest, const QPixmap * src, const QRect & r )
 {
     qreal dpr = src->devicePixelRatioF();
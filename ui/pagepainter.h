@@ -19,6 +19,7 @@
 class QPainter;
 class QRect;
 namespace Okular {
+    class Annotation;
     class DocumentObserver;
     class Page;
 }
@@ -59,6 +60,20 @@ class Q_DECL_EXPORT PagePainter
         // set the alpha component of the image to a given value
         static void changeImageAlpha( QImage & image, unsigned int alpha );
 
+        // the serial identifying the current look of the annotation
+        static uint appearanceSerial( const Okular::Annotation *annotation );
+
+        // draw the line, highlight or ink annotation 'a' on the 'image' buffer,
+        // mapping normalized page coordinates through the offsets and scales
+        static void drawBufferedAnnotation( QImage &image, const Okular::Page *page, Okular::Annotation *a,
+            double xOffset, double xScale, double yOffset, double yScale, double pageScale );
+
+        // draw the buffered annotation 'a' on 'backImage' from its cached
+        // rendering, returns false when it is too big to be cached
+        static bool drawCachedAnnotation( QImage &backImage, const Okular::Page *page, Okular::Annotation *a,
+            int scaledWidth, int scaledHeight, int croppedWidth, const Okular::NormalizedRect &crop,
+            const QRect &limits, qreal dpr );
+
         // my pretty dear raster function
         typedef QList< Okular::NormalizedPoint > NormalizedPath;
         enum RasterOperation { Normal, Multiply };
@@ -41,6 +41,9 @@
 #include <QMimeDatabase>
 #include <QMimeData>
 #include <QGestureEvent>
+#include <QElapsedTimer>
+
+#include <algorithm>
 
 #include <qaction.h>
 #include <kactionmenu.h>
@@ -131,12 +134,28 @@ public:
     OkularTTS* tts();
 #endif
     QString selectedText() const;
+    void itemsInRect( const QRect &rect, int *first, int *last ) const;
+    void updateScrollVelocity( int scrollValue );
+    const QVector< PageViewItem * > &itemsWithWidgets();
 
     // the document, pageviewItems and the 'visible cache'
     PageView *q;
     Okular::Document * document;
     QVector< PageViewItem * > items;
     QLinkedList< PageViewItem * > visibleItems;
+
+    // index of the layout, built by slotRelayoutPages: the top of every row
+    // of items (and the bottom of the last one), so the items in a rect
+    // are found without looking at all of them
+    QVector< int > rowTops;
+    int layoutColumns;
+    int layoutFirstCell;        // cells left empty before the first page
+    int layoutShownRow;         // the only row shown in non continuous mode
+    bool layoutContinuous;
+
+    // the items having form or video widgets, which follow the viewport
+    QVector< PageViewItem * > widgetItems;
+    bool widgetItemsDirty;
     MagnifierView *magnifierView;
 
     // view layout (columns and continuous in Settings), zoom and mouse
@@ -173,6 +192,12 @@ public:
     // auto scroll
     int scrollIncrement;
     QTimer * autoScrollTimer;
+    // scrolling speed in pixels per millisecond (positive going down), to
+    // preload ahead and to use placeholder pixmaps while flinging
+    QElapsedTimer scrollTime;
+    int lastScrollValue;
+    double scrollVelocity;
+    QTimer * scrollSettleTimer;
     // annotations
     PageViewAnnotator * annotator;
     //text annotation dialogs list
@@ -253,6 +278,64 @@ PageViewPrivate::PageViewPrivate( PageView *qq )
 {
 }
 
+void PageViewPrivate::itemsInRect( const QRect &rect, int *first, int *last ) const
+{
+    *first = 0;
+    *last = items.count();
+    // no layout yet, look at all the items
+    if ( rowTops.count() < 2 || layoutColumns < 1 )
+        return;
+
+    const int rowCount = rowTops.count() - 1;
+    int firstRow = layoutShownRow;
+    int lastRow = layoutShownRow;
+    if ( layoutContinuous )
+    {
+        firstRow = std::upper_bound( rowTops.constBegin(), rowTops.constEnd(), rect.top() ) - rowTops.constBegin() - 1;
+        lastRow = std::upper_bound( rowTops.constBegin(), rowTops.constEnd(), rect.bottom() ) - rowTops.constBegin() - 1;
+    }
+    firstRow = qBound( 0, firstRow, rowCount - 1 );
+    lastRow = qBound( 0, lastRow, rowCount - 1 );
+
+    *first = qBound( 0, firstRow * layoutColumns - layoutFirstCell, items.count() );
+    *last = qBound( 0, ( lastRow + 1 ) * layoutColumns - layoutFirstCell, items.count() );
+}
+
+void PageViewPrivate::updateScrollVelocity( int scrollValue )
+{
+    const qint64 elapsed = scrollTime.isValid() ? scrollTime.restart() : -1;
+    if ( elapsed < 0 )
+        scrollTime.start();
+
+    if ( elapsed < 0 || elapsed > 300 )
+    {
+        // scrolling (re)started, nothing to tell the speed from yet
+        scrollVelocity = 0.0;
+    }
+    else if ( elapsed > 0 )
+    {
+        // smooth it, wheel and keyboard scrolling come in steps
+        const double velocity = ( scrollValue - lastScrollValue ) / (double)elapsed;
+        scrollVelocity = ( scrollVelocity + velocity ) / 2.0;
+    }
+    lastScrollValue = scrollValue;
+}
+
+const QVector< PageViewItem * > &PageViewPrivate::itemsWithWidgets()
+{
+    if ( widgetItemsDirty )
+    {
+        widgetItems.clear();
+        for ( PageViewItem *item : qAsConst( items ) )
+        {
+            if ( !item->formWidgets().isEmpty() || !item->videoWidgets().isEmpty() )
+                widgetItems.append( item );
+        }
+        widgetItemsDirty = false;
+    }
+    return widgetItems;
+}
+
 FormWidgetsController* PageViewPrivate::formWidgetsController()
 {
     if ( !formsWidgetController )
@@ -322,8 +405,16 @@ PageView::PageView( QWidget *parent, Okular::Document *document )
     d->controlWheelAccumulatedDelta = 0;
     d->scrollIncrement = 0;
     d->autoScrollTimer = nullptr;
+    d->lastScrollValue = 0;
+    d->scrollVelocity = 0.0;
+    d->scrollSettleTimer = nullptr;
     d->annotator = nullptr;
     d->dirtyLayout = false;
+    d->layoutColumns = 1;
+    d->layoutFirstCell = 0;
+    d->layoutShownRow = 0;
+    d->layoutContinuous = true;
+    d->widgetItemsDirty = true;
     d->blockViewport = false;
     d->blockPixmapsRequest = false;
     d->messageWindow = new PageViewMessage(this);
@@ -945,6 +1036,7 @@ void PageView::createAnnotationsVideoWidgets(PageViewItem *item, const QLinkedLi
 {
     qDeleteAll( item->videoWidgets() );
     item->videoWidgets().clear();
+    d->widgetItemsDirty = true;
 
     QLinkedList< Okular::Annotation * >::const_iterator aIt = annotations.constBegin(), aEnd = annotations.constEnd();
     for ( ; aIt != aEnd; ++aIt )
@@ -1041,6 +1133,7 @@ void PageView::notifySetup( const QVector< Okular::Page * > & pageSet, int setup
                         {
                             qWarning() << "Lost form field on document save, something is wrong";
                             item->formWidgets().remove(w);
+                            d->widgetItemsDirty = true;
                             delete w;
                         }
                     }
@@ -1078,6 +1171,8 @@ void PageView::notifySetup( const QVector< Okular::Page * > & pageSet, int setup
         delete *dIt;
     d->items.clear();
     d->visibleItems.clear();
+    d->rowTops.clear();
+    d->widgetItemsDirty = true;
     d->pagesWithTextSelection.clear();
     toggleFormWidgets( false );
     if ( d->formsWidgetController )
@@ -3901,6 +3996,10 @@ void PageView::selectionClear(const ClearMode mode)
 // const to be used for both zoomFactorFitMode function and slotRelayoutPages.
 static const int kcolWidthMargin = 6;
 static const int krowHeightMargin = 12;
+// scrolling speeds (pixels per millisecond) above which the preloading
+// follows the scrolling direction, and only placeholders are rendered
+static const double kdirectedPreloadVelocity = 0.5;
+static const double kflingVelocity = 4.0;
 
 double PageView::zoomFactorFitMode( ZoomMode mode )
 {
@@ -4603,6 +4702,16 @@ void PageView::slotRelayoutPages()
 #endif
         }
 
+        // remember the rows, for itemsInRect()
+        d->rowTops.resize( nRows + 1 );
+        d->rowTops[ 0 ] = origInsertY;
+        for ( int i = 0; i < nRows; i++ )
+            d->rowTops[ i + 1 ] = d->rowTops[ i ] + rowHeight[ i ];
+        d->layoutColumns = nCols;
+        d->layoutFirstCell = centerFirstPage ? nCols - 1 : 0;
+        d->layoutShownRow = pageRowIdx;
+        d->layoutContinuous = continuousView;
+
         delete [] colWidth;
         delete [] rowHeight;
 
@@ -4655,8 +4764,28 @@ void PageView::delayedResizeEvent()
     slotRequestVisiblePixmaps();
 }
 
-static void slotRequestPreloadPixmap( Okular::DocumentObserver * observer, const PageViewItem * i, const QRect &expandedViewportRect, QLinkedList< Okular::PixmapRequest * > *requestedPixmaps )
+static bool requestPlaceholderPixmap( Okular::DocumentObserver * observer, const PageViewItem * i, int priority, QLinkedList< Okular::PixmapRequest * > *requestedPixmaps )
 {
+    // a scaled down pixmap, good enough for a page flying past; not for
+    // tiled pages, and never replacing a pixmap we already have
+    if ( i->page()->hasPixmap( observer ) || i->page()->hasTilesManager( observer ) || i->uncroppedWidth() <= 0 )
+        return false;
+
+    Okular::PixmapRequest::PixmapRequestFeatures requestFeatures = Okular::PixmapRequest::Preload;
+    requestFeatures |= Okular::PixmapRequest::Asynchronous;
+    requestFeatures |= Okular::PixmapRequest::Placeholder;
+    requestedPixmaps->push_back( new Okular::PixmapRequest( observer, i->pageNumber(), i->uncroppedWidth(), i->uncroppedHeight(), priority, requestFeatures ) );
+    return true;
+}
+
+static void slotRequestPreloadPixmap( Okular::DocumentObserver * observer, const PageViewItem * i, const QRect &expandedViewportRect, bool placeholder, QLinkedList< Okular::PixmapRequest * > *requestedPixmaps )
+{
+    if ( placeholder )
+    {
+        requestPlaceholderPixmap( observer, i, PAGEVIEW_PRELOAD_PRIO, requestedPixmaps );
+        return;
+    }
+
     Okular::NormalizedRect preRenderRegion;
     const QRect intersectionRect = expandedViewportRect.intersected( i->croppedGeometry() );
     if ( !intersectionRect.isEmpty() )
@@ -4693,6 +4822,23 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
 
     // precalc view limits for intersecting with page coords inside the loop
     const bool isEvent = newValue != -1 && !d->blockViewport;
+    if ( isEvent )
+        d->updateScrollVelocity( verticalScrollBar()->value() );
+    const bool flinging = qAbs( d->scrollVelocity ) > kflingVelocity;
+    if ( flinging )
+    {
+        // render the real pixmaps once the scrolling calms down
+        if ( !d->scrollSettleTimer )
+        {
+            d->scrollSettleTimer = new QTimer( this );
+            d->scrollSettleTimer->setSingleShot( true );
+            connect( d->scrollSettleTimer, &QTimer::timeout, this, [this] {
+                d->scrollVelocity = 0.0;
+                slotRequestVisiblePixmaps();
+            } );
+        }
+        d->scrollSettleTimer->start( 200 );
+    }
     const QRect viewportRect( horizontalScrollBar()->value(),
                               verticalScrollBar()->value(),
                               viewport()->width(), viewport()->height() );
@@ -4708,14 +4854,9 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
     // Margin (in pixels) around the viewport to preload
     const int pixelsToExpand = 512;
 
-    // iterate over all items
-    d->visibleItems.clear();
-    QLinkedList< Okular::PixmapRequest * > requestedPixmaps;
-    QVector< Okular::VisiblePageRect * > visibleRects;
-    QVector< PageViewItem * >::const_iterator iIt = d->items.constBegin(), iEnd = d->items.constEnd();
-    for ( ; iIt != iEnd; ++iIt )
+    // move the form and video widgets along with their pages
+    for ( PageViewItem *i : d->itemsWithWidgets() )
     {
-        PageViewItem * i = *iIt;
         foreach( FormWidgetIface *fwi, i->formWidgets() )
         {
             Okular::NormalizedRect r = fwi->rect();
@@ -4735,7 +4876,17 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
                 vw->pageLeft();
             }
         }
+    }
 
+    // iterate over the items in the rows crossing the viewport
+    d->visibleItems.clear();
+    QLinkedList< Okular::PixmapRequest * > requestedPixmaps;
+    QVector< Okular::VisiblePageRect * > visibleRects;
+    int firstItem, lastItem;
+    d->itemsInRect( viewportRect, &firstItem, &lastItem );
+    for ( int itemIndex = firstItem; itemIndex < lastItem; ++itemIndex )
+    {
+        PageViewItem * i = d->items[ itemIndex ];
         if ( !i->isVisible() )
             continue;
 #ifdef PAGEVIEW_DEBUG
@@ -4769,7 +4920,11 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
         }
 
         // if the item has not the right pixmap, add a request for it
-        if ( !i->page()->hasPixmap( this, i->uncroppedWidth(), i->uncroppedHeight(), expandedVisibleRect ) )
+        if ( flinging )
+        {
+            requestPlaceholderPixmap( this, i, PAGEVIEW_PRIO, &requestedPixmaps );
+        }
+        else if ( !i->page()->hasPixmap( this, i->uncroppedWidth(), i->uncroppedHeight(), expandedVisibleRect ) )
         {
 #ifdef PAGEVIEW_DEBUG
             kWarning() << "rerequesting visible pixmaps for page" << i->pageNumber() << "!";
@@ -4819,22 +4974,37 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
         if (Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Greedy)
             pagesToPreload = d->items.count();
 
+        // while scrolling, spend the preloading on the pages coming next,
+        // the ones behind are not going to be needed soon
+        int pagesAfter = pagesToPreload;
+        int pagesBefore = pagesToPreload;
+        if ( d->scrollVelocity > kdirectedPreloadVelocity )
+        {
+            pagesAfter = qMin( pagesToPreload * 2, d->items.count() );
+            pagesBefore = 0;
+        }
+        else if ( d->scrollVelocity < -kdirectedPreloadVelocity )
+        {
+            pagesBefore = qMin( pagesToPreload * 2, d->items.count() );
+            pagesAfter = 0;
+        }
+
         const QRect expandedViewportRect = viewportRect.adjusted( 0, -pixelsToExpand, 0, pixelsToExpand );
 
-        for( int j = 1; j <= pagesToPreload; j++ )
+        for( int j = 1; j <= qMax( pagesAfter, pagesBefore ); j++ )
         {
             // add the page after the 'visible series' in preload
             const int tailRequest = d->visibleItems.last()->pageNumber() + j;
-            if ( tailRequest < (int)d->items.count() )
+            if ( j <= pagesAfter && tailRequest < (int)d->items.count() )
             {
-                slotRequestPreloadPixmap( this, d->items[ tailRequest ], expandedViewportRect, &requestedPixmaps );
+                slotRequestPreloadPixmap( this, d->items[ tailRequest ], expandedViewportRect, flinging, &requestedPixmaps );
             }
 
             // add the page before the 'visible series' in preload
             const int headRequest = d->visibleItems.first()->pageNumber() - j;
-            if ( headRequest >= 0 )
+            if ( j <= pagesBefore && headRequest >= 0 )
             {
-                slotRequestPreloadPixmap( this, d->items[ headRequest ], expandedViewportRect, &requestedPixmaps );
+                slotRequestPreloadPixmap( this, d->items[ headRequest ], expandedViewportRect, flinging, &requestedPixmaps );
             }
 
             // stop if we've already reached both ends of the document
@@ -4843,11 +5013,16 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
         }
     }
 
-    // send requests to the document
+    // send requests to the document, they replace the previous ones
     if ( !requestedPixmaps.isEmpty() )
     {
         d->document->requestPixmaps( requestedPixmaps );
     }
+    else if ( isEvent )
+    {
+        // the pages still queued are not where we are going any more
+        d->document->cancelPixmapRequests( this );
+    }
     // if this functions was invoked by viewport events, send update to document
     if ( isEvent && nearPageNumber != -1 )
     {
@@ -0,0 +1,467 @@
+/***************************************************************************
+ *   Copyright (C) 2004 by Enrico Ros <eros.kde@email.it>                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "presentationtransition.h"
+
+// qt/kde includes
+#include <qpainter.h>
+
+#include <stdlib.h>
+
+PresentationTransition::PresentationTransition()
+    : m_type( Okular::PageTransition::Replace ), m_running( false ), m_duration( 0 ),
+    m_uncoveredRects( 0 ), m_opacity( 0 )
+{
+}
+
+bool PresentationTransition::start( const Okular::PageTransition &transition, const QPixmap &previous, const QPixmap &current, const QSize &size, const QRect &area )
+{
+    stop();
+
+    const bool isInward = transition.direction() == Okular::PageTransition::Inward;
+    const bool isHorizontal = transition.alignment() == Okular::PageTransition::Horizontal;
+    const int width = size.width();
+    const int height = size.height();
+
+    m_type = transition.type();
+    m_duration = qRound( transition.duration() * 1000 );
+    m_area = area;
+
+    // if it's just a 'replace' transition, the current page is shown at once
+    if ( m_type == Okular::PageTransition::Replace || m_duration <= 0 || m_area.isEmpty() )
+        return false;
+
+    switch( m_type )
+    {
+            // split: horizontal / vertical and inward / outward
+        case Okular::PageTransition::Split:
+        {
+            const int steps = isHorizontal ? 100 : 75;
+            if ( isHorizontal )
+            {
+                if ( isInward )
+                {
+                    int xPosition = 0;
+                    for ( int i = 0; i < steps; i++ )
+                    {
+                        int xNext = ((i + 1) * width) / (2 * steps);
+                        m_rects.push_back( QRect( xPosition, 0, xNext - xPosition, height ) );
+                        m_rects.push_back( QRect( width - xNext, 0, xNext - xPosition, height ) );
+                        xPosition = xNext;
+                    }
+                }
+                else
+                {
+                    int xPosition = width / 2;
+                    for ( int i = 0; i < steps; i++ )
+                    {
+                        int xNext = ((steps - (i + 1)) * width) / (2 * steps);
+                        m_rects.push_back( QRect( xNext, 0, xPosition - xNext, height ) );
+                        m_rects.push_back( QRect( width - xPosition, 0, xPosition - xNext, height ) );
+                        xPosition = xNext;
+                    }
+                }
+            }
+            else
+            {
+                if ( isInward )
+                {
+                    int yPosition = 0;
+                    for ( int i = 0; i < steps; i++ )
+                    {
+                        int yNext = ((i + 1) * height) / (2 * steps);
+                        m_rects.push_back( QRect( 0, yPosition, width, yNext - yPosition ) );
+                        m_rects.push_back( QRect( 0, height - yNext, width, yNext - yPosition ) );
+                        yPosition = yNext;
+                    }
+                }
+                else
+                {
+                    int yPosition = height / 2;
+                    for ( int i = 0; i < steps; i++ )
+                    {
+                        int yNext = ((steps - (i + 1)) * height) / (2 * steps);
+                        m_rects.push_back( QRect( 0, yNext, width, yPosition - yNext ) );
+                        m_rects.push_back( QRect( 0, height - yPosition, width, yPosition - yNext ) );
+                        yPosition = yNext;
+                    }
+                }
+            }
+        } break;
+
+            // blinds: horizontal(l-to-r) / vertical(t-to-b)
+        case Okular::PageTransition::Blinds:
+        {
+            const int blinds = isHorizontal ? 8 : 6;
+            const int steps = width / (4 * blinds);
+            if ( isHorizontal )
+            {
+                int xPosition[ 8 ];
+                for ( int b = 0; b < blinds; b++ )
+                    xPosition[ b ] = (b * width) / blinds;
+
+                for ( int i = 0; i < steps; i++ )
+                {
+                    int stepOffset = (int)( ((float)i * (float)width) / ((float)blinds * (float)steps) );
+                    for ( int b = 0; b < blinds; b++ )
+                    {
+                        m_rects.push_back( QRect( xPosition[ b ], 0, stepOffset, height ) );
+                        xPosition[ b ] = stepOffset + (b * width) / blinds;
+                    }
+                }
+            }
+            else
+            {
+                int yPosition[ 6 ];
+                for ( int b = 0; b < blinds; b++ )
+                    yPosition[ b ] = (b * height) / blinds;
+
+                for ( int i = 0; i < steps; i++ )
+                {
+                    int stepOffset = (int)( ((float)i * (float)height) / ((float)blinds * (float)steps) );
+                    for ( int b = 0; b < blinds; b++ )
+                    {
+                        m_rects.push_back( QRect( 0, yPosition[ b ], width, stepOffset ) );
+                        yPosition[ b ] = stepOffset + (b * height) / blinds;
+                    }
+                }
+            }
+        } break;
+
+            // box: inward / outward
+        case Okular::PageTransition::Box:
+        {
+            const int steps = width / 10;
+            if ( isInward )
+            {
+                int L = 0, T = 0, R = width, B = height;
+                for ( int i = 0; i < steps; i++ )
+                {
+                    // compure shrinked box coords
+                    int newL = ((i + 1) * width) / (2 * steps);
+                    int newT = ((i + 1) * height) / (2 * steps);
+                    int newR = width - newL;
+                    int newB = height - newT;
+                    // add left, right, topcenter, bottomcenter rects
+                    m_rects.push_back( QRect( L, T, newL - L, B - T ) );
+                    m_rects.push_back( QRect( newR, T, R - newR, B - T ) );
+                    m_rects.push_back( QRect( newL, T, newR - newL, newT - T ) );
+                    m_rects.push_back( QRect( newL, newB, newR - newL, B - newB ) );
+                    L = newL; T = newT; R = newR, B = newB;
+                }
+            }
+            else
+            {
+                int L = width / 2, T = height / 2, R = L, B = T;
+                for ( int i = 0; i < steps; i++ )
+                {
+                    // compure shrinked box coords
+                    int newL = ((steps - (i + 1)) * width) / (2 * steps);
+                    int newT = ((steps - (i + 1)) * height) / (2 * steps);
+                    int newR = width - newL;
+                    int newB = height - newT;
+                    // add left, right, topcenter, bottomcenter rects
+                    m_rects.push_back( QRect( newL, newT, L - newL, newB - newT ) );
+                    m_rects.push_back( QRect( R, newT, newR - R, newB - newT ) );
+                    m_rects.push_back( QRect( L, newT, R - L, T - newT ) );
+                    m_rects.push_back( QRect( L, B, R - L, newB - B ) );
+                    L = newL; T = newT; R = newR, B = newB;
+                }
+            }
+        } break;
+
+            // wipe: implemented for 4 canonical angles
+        case Okular::PageTransition::Wipe:
+        {
+            const int angle = transition.angle();
+            const int steps = (angle == 0) || (angle == 180) ? width / 8 : height / 8;
+            if ( angle == 0 )
+            {
+                int xPosition = 0;
+                for ( int i = 0; i < steps; i++ )
+                {
+                    int xNext = ((i + 1) * width) / steps;
+                    m_rects.push_back( QRect( xPosition, 0, xNext - xPosition, height ) );
+                    xPosition = xNext;
+                }
+            }
+            else if ( angle == 90 )
+            {
+                int yPosition = height;
+                for ( int i = 0; i < steps; i++ )
+                {
+                    int yNext = ((steps - (i + 1)) * height) / steps;
+                    m_rects.push_back( QRect( 0, yNext, width, yPosition - yNext ) );
+                    yPosition = yNext;
+                }
+            }
+            else if ( angle == 180 )
+            {
+                int xPosition = width;
+                for ( int i = 0; i < steps; i++ )
+                {
+                    int xNext = ((steps - (i + 1)) * width) / steps;
+                    m_rects.push_back( QRect( xNext, 0, xPosition - xNext, height ) );
+                    xPosition = xNext;
+                }
+            }
+            else if ( angle == 270 )
+            {
+                int yPosition = 0;
+                for ( int i = 0; i < steps; i++ )
+                {
+                    int yNext = ((i + 1) * height) / steps;
+                    m_rects.push_back( QRect( 0, yPosition, width, yNext - yPosition ) );
+                    yPosition = yNext;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        } break;
+
+            // dissolve: replace 'random' rects
+        case Okular::PageTransition::Dissolve:
+        {
+            const int gridXsteps = 50;
+            const int gridYsteps = 38;
+            const int steps = gridXsteps * gridYsteps;
+            int oldX = 0;
+            int oldY = 0;
+            // create a grid of gridXstep by gridYstep QRects
+            for ( int y = 0; y < gridYsteps; y++ )
+            {
+                int newY = (int)( height * ((float)(y+1) / (float)gridYsteps) );
+                for ( int x = 0; x < gridXsteps; x++ )
+                {
+                    int newX = (int)( width * ((float)(x+1) / (float)gridXsteps) );
+                    m_rects.push_back( QRect( oldX, oldY, newX - oldX, newY - oldY ) );
+                    oldX = newX;
+                }
+                oldX = 0;
+                oldY = newY;
+            }
+            // randomize the grid
+            for ( int i = 0; i < steps; i++ )
+            {
+#ifndef Q_OS_WIN
+                int n1 = (int)(steps * drand48());
+                int n2 = (int)(steps * drand48());
+#else
+                int n1 = (int)(steps * (std::rand() / RAND_MAX));
+                int n2 = (int)(steps * (std::rand() / RAND_MAX));
+#endif
+                // swap items if index differs
+                if ( n1 != n2 )
+                {
+                    QRect r = m_rects[ n2 ];
+                    m_rects[ n2 ] = m_rects[ n1 ];
+                    m_rects[ n1 ] = r;
+                }
+            }
+        } break;
+
+            // glitter: similar to dissolve but has a direction
+        case Okular::PageTransition::Glitter:
+        {
+            const int gridXsteps = 50;
+            const int gridYsteps = 38;
+            const int steps = gridXsteps * gridYsteps;
+            const int angle = transition.angle();
+            // generate boxes using a given direction
+            if ( angle == 90 )
+            {
+                int yPosition = height;
+                for ( int i = 0; i < gridYsteps; i++ )
+                {
+                    int yNext = ((gridYsteps - (i + 1)) * height) / gridYsteps;
+                    int xPosition = 0;
+                    for ( int j = 0; j < gridXsteps; j++ )
+                    {
+                        int xNext = ((j + 1) * width) / gridXsteps;
+                        m_rects.push_back( QRect( xPosition, yNext, xNext - xPosition, yPosition - yNext ) );
+                        xPosition = xNext;
+                    }
+                    yPosition = yNext;
+                }
+            }
+            else if ( angle == 180 )
+            {
+                int xPosition = width;
+                for ( int i = 0; i < gridXsteps; i++ )
+                {
+                    int xNext = ((gridXsteps - (i + 1)) * width) / gridXsteps;
+                    int yPosition = 0;
+                    for ( int j = 0; j < gridYsteps; j++ )
+                    {
+                        int yNext = ((j + 1) * height) / gridYsteps;
+                        m_rects.push_back( QRect( xNext, yPosition, xPosition - xNext, yNext - yPosition ) );
+                        yPosition = yNext;
+                    }
+                    xPosition = xNext;
+                }
+            }
+            else if ( angle == 270 )
+            {
+                int yPosition = 0;
+                for ( int i = 0; i < gridYsteps; i++ )
+                {
+                    int yNext = ((i + 1) * height) / gridYsteps;
+                    int xPosition = 0;
+                    for ( int j = 0; j < gridXsteps; j++ )
+                    {
+                        int xNext = ((j + 1) * width) / gridXsteps;
+                        m_rects.push_back( QRect( xPosition, yPosition, xNext - xPosition, yNext - yPosition ) );
+                        xPosition = xNext;
+                    }
+                    yPosition = yNext;
+                }
+            }
+            else // if angle is 0 or 315
+            {
+                int xPosition = 0;
+                for ( int i = 0; i < gridXsteps; i++ )
+                {
+                    int xNext = ((i + 1) * width) / gridXsteps;
+                    int yPosition = 0;
+                    for ( int j = 0; j < gridYsteps; j++ )
+                    {
+                        int yNext = ((j + 1) * height) / gridYsteps;
+                        m_rects.push_back( QRect( xPosition, yPosition, xNext - xPosition, yNext - yPosition ) );
+                        yPosition = yNext;
+                    }
+                    xPosition = xNext;
+                }
+            }
+            // add a 'glitter' (1 over 10 pieces is randomized)
+            int randomSteps = steps / 20;
+            for ( int i = 0; i < randomSteps; i++ )
+            {
+#ifndef Q_OS_WIN
+                int n1 = (int)(steps * drand48());
+                int n2 = (int)(steps * drand48());
+#else
+                int n1 = (int)(steps * (std::rand() / RAND_MAX));
+                int n2 = (int)(steps * (std::rand() / RAND_MAX));
+#endif
+                // swap items if index differs
+                if ( n1 != n2 )
+                {
+                    QRect r = m_rects[ n2 ];
+                    m_rects[ n2 ] = m_rects[ n1 ];
+                    m_rects[ n1 ] = r;
+                }
+            }
+        } break;
+
+        case Okular::PageTransition::Fade:
+        {
+            if ( previous.isNull() || previous.size() != current.size() )
+                return false;
+
+            m_previousPixmap = previous;
+            m_currentPixmap = current;
+            m_opacity = 0;
+
+            // reuse the back buffer of the previous fade, and start it from the
+            // previous page so the region that does not change is right too
+            if ( m_backBuffer.size() != current.size() )
+                m_backBuffer = QPixmap( current.size() );
+            m_backBuffer.setDevicePixelRatio( current.devicePixelRatio() );
+            QPainter pixmapPainter( &m_backBuffer );
+            pixmapPainter.setCompositionMode( QPainter::CompositionMode_Source );
+            pixmapPainter.drawPixmap( 0, 0, m_previousPixmap );
+        } break;
+        // implement missing transitions (a binary raster engine needed here)
+        case Okular::PageTransition::Fly:
+
+        case Okular::PageTransition::Push:
+
+        case Okular::PageTransition::Cover:
+
+        case Okular::PageTransition::Uncover:
+
+        default:
+            return false;
+    }
+
+    m_running = true;
+    return true;
+}
+
+void PresentationTransition::stop()
+{
+    m_running = false;
+    m_rects.clear();
+    m_uncoveredRects = 0;
+    // release the pages, so they can be painted over without a copy
+    m_previousPixmap = QPixmap();
+    m_currentPixmap = QPixmap();
+}
+
+bool PresentationTransition::isRunning() const
+{
+    return m_running;
+}
+
+QRegion PresentationTransition::advance( int elapsed )
+{
+    if ( !m_running )
+        return QRegion();
+
+    const bool finished = elapsed >= m_duration;
+    QRegion damage;
+
+    if ( m_type == Okular::PageTransition::Fade )
+    {
+        m_opacity = finished ? 1.0 : (double)elapsed / m_duration;
+
+        if ( !finished )
+        {
+            // blend only the area that differs between the pages
+            const qreal dpr = m_backBuffer.devicePixelRatio();
+            const QRect dR( QRectF( m_area.x() * dpr, m_area.y() * dpr, m_area.width() * dpr, m_area.height() * dpr ).toAlignedRect() );
+            QPainter pixmapPainter( &m_backBuffer );
+            pixmapPainter.setCompositionMode( QPainter::CompositionMode_Source );
+            pixmapPainter.drawPixmap( m_area.topLeft(), m_previousPixmap, dR );
+            pixmapPainter.setCompositionMode( QPainter::CompositionMode_SourceOver );
+            pixmapPainter.setOpacity( m_opacity );
+            pixmapPainter.drawPixmap( m_area.topLeft(), m_currentPixmap, dR );
+        }
+        damage = m_area;
+    }
+    else
+    {
+        // uncover all the pieces due by now, whatever number of frames it took
+        const int target = finished ? m_rects.count() : (int)( (qint64)m_rects.count() * elapsed / m_duration );
+        for ( ; m_uncoveredRects < target; ++m_uncoveredRects )
+            damage += m_rects[ m_uncoveredRects ];
+        damage &= m_area;
+    }
+
+    // not all the transitions cover the whole screen with their pieces
+    if ( finished )
+        damage = m_area;
+
+    if ( finished )
+        stop();
+
+    return damage;
+}
+
+bool PresentationTransition::hasBlendedPixmap() const
+{
+    return m_running && m_type == Okular::PageTransition::Fade;
+}
+
+const QPixmap &PresentationTransition::blendedPixmap() const
+{
+    return m_backBuffer;
+}
@@ -0,0 +1,87 @@
+/***************************************************************************
+ *   Copyright (C) 2004 by Enrico Ros <eros.kde@email.it>                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_PRESENTATIONTRANSITION_H_
+#define _OKULAR_PRESENTATIONTRANSITION_H_
+
+#include <qpixmap.h>
+#include <qrect.h>
+#include <qregion.h>
+#include <qvector.h>
+#include "core/pagetransition.h"
+
+/**
+ * @short Computes the frames of a page transition of the presentation mode.
+ *
+ * Frames are computed from the time elapsed since the transition started,
+ * so the transition lasts its duration however slow painting is; a slow
+ * machine just shows fewer frames. Each frame reports only the region of
+ * the screen that changed, and the back buffer used for blending is kept
+ * between transitions.
+ */
+class PresentationTransition
+{
+    public:
+        PresentationTransition();
+
+        /**
+         * Starts @p transition from the @p previous to the @p current page
+         * pixmap, both covering a screen of @p size logical pixels. Only the
+         * @p area of the screen differs between the two pixmaps.
+         *
+         * Returns false if the transition is not animated, in which case the
+         * current pixmap can be shown right away.
+         */
+        bool start( const Okular::PageTransition &transition, const QPixmap &previous, const QPixmap &current, const QSize &size, const QRect &area );
+
+        /**
+         * Stops the transition, the current pixmap is to be shown.
+         */
+        void stop();
+
+        /**
+         * Whether the transition has frames left to show.
+         */
+        bool isRunning() const;
+
+        /**
+         * Advances the transition to @p elapsed milliseconds since it started
+         * and returns the region of the screen to repaint for the new frame.
+         */
+        QRegion advance( int elapsed );
+
+        /**
+         * Whether the screen has to be painted from blendedPixmap() instead
+         * of the current page pixmap.
+         */
+        bool hasBlendedPixmap() const;
+
+        /**
+         * The current frame of a blending transition.
+         */
+        const QPixmap &blendedPixmap() const;
+
+    private:
+        Okular::PageTransition::Type m_type;
+        bool m_running;
+        int m_duration;
+        QRect m_area;
+
+        // transitions uncovering the current page piece by piece
+        QVector< QRect > m_rects;
+        int m_uncoveredRects;
+
+        // transitions blending the two pages
+        QPixmap m_previousPixmap;
+        QPixmap m_currentPixmap;
+        QPixmap m_backBuffer;
+        double m_opacity;
+};
+
+#endif
@@ -73,6 +73,9 @@
 // comment this to disable the top-right progress indicator
 #define ENABLE_PROGRESS_OVERLAY
 
+// delay between the frames of transitions, in ms (about 60 frames per second)
+#define TRANSITION_FRAME_INTERVAL 16
+
 
 // a frame contains a pointer to the page object, its geometry and the
 // transition effect to the next frame
@@ -148,7 +151,7 @@ PresentationWidget::PresentationWidget( QWidget * parent, Okular::Document * doc
     m_ac( collection ), m_screenSelect( nullptr ), m_isSetup( false ), m_blockNotifications( false ), m_inBlackScreenMode( false ),
     m_showSummaryView( Okular::Settings::slidesShowSummary() ),
     m_advanceSlides( Okular::SettingsCore::slidesAdvance() ),
-    m_goToNextPageOnRelease( false )
+    m_goToNextPageOnRelease( false ), m_goingBackwards( false )
 {
     Q_UNUSED( parent )
     setAttribute( Qt::WA_DeleteOnClose );
@@ -243,6 +246,7 @@ PresentationWidget::PresentationWidget( QWidget * parent, Okular::Document * doc
     setContextMenuPolicy( Qt::PreventContextMenu );
     m_transitionTimer = new QTimer( this );
     m_transitionTimer->setSingleShot( true );
+    m_transitionTimer->setTimerType( Qt::PreciseTimer );
     connect(m_transitionTimer, &QTimer::timeout, this, &PresentationWidget::slotTransitionStep);
     m_overlayHideTimer = new QTimer( this );
     m_overlayHideTimer->setSingleShot( true );
@@ -438,6 +442,10 @@ void PresentationWidget::notifyCurrentPageChanged( int previousPage, int current
 
     if ( currentPage != -1 )
     {
+        // remember where the presentation is heading, for the preloading
+        if ( previousPage != -1 )
+            m_goingBackwards = currentPage < previousPage && !( previousPage == m_frames.count() - 1 && currentPage == 0 );
+
         m_frameIndex = currentPage;
 
         // check if pixmap exists or else request it
@@ -817,6 +825,9 @@ void PresentationWidget::paintEvent( QPaintEvent * pe )
         return;
     }
 
+    // while blending pages the screen shows the transition frame
+    const QPixmap &pagePixmap = m_transition.hasBlendedPixmap() ? m_transition.blendedPixmap() : m_lastRenderedPixmap;
+
     // blit the pixmap to the screen
     QVector<QRect> allRects = pe->region().rects();
     uint numRects = allRects.count();
@@ -836,7 +847,7 @@ void PresentationWidget::paintEvent( QPaintEvent * pe )
             QPainter pixPainter( &backPixmap );
 
             // first draw the background on the backbuffer
-            pixPainter.drawPixmap( QPoint(0,0), m_lastRenderedPixmap, dR );
+            pixPainter.drawPixmap( QPoint(0,0), pagePixmap, dR );
 
             // then blend the overlay (a piece of) over the background
             QRect ovr = m_overlayGeometry.intersected( r );
@@ -852,7 +863,7 @@ void PresentationWidget::paintEvent( QPaintEvent * pe )
         } else
 #endif
         // copy the rendered pixmap to the screen
-        painter.drawPixmap( r.topLeft(), m_lastRenderedPixmap, dR );
+        painter.drawPixmap( r.topLeft(), pagePixmap, dR );
     }
 
     // paint drawings
@@ -1006,18 +1017,25 @@ void PresentationWidget::changePage( int newPage )
 
 void PresentationWidget::generatePage( bool disableTransition )
 {
+    // the page on screen becomes the previous one, and the pixmap of the page
+    // before it is reused for the new page (it is completely painted over)
     if ( m_lastRenderedPixmap.isNull() )
     {
-        qreal dpr = qApp->devicePixelRatio();
-        m_lastRenderedPixmap = QPixmap( m_width * dpr, m_height * dpr );
-        m_lastRenderedPixmap.setDevicePixelRatio(dpr);
-
         m_previousPagePixmap = QPixmap();
+        m_previousRenderedArea = QRect( 0, 0, m_width, m_height );
     }
     else
     {
-        m_previousPagePixmap = m_lastRenderedPixmap;
+        m_previousPagePixmap.swap( m_lastRenderedPixmap );
+        m_previousRenderedArea = m_lastRenderedArea;
+    }
+    if ( m_lastRenderedPixmap.isNull() || m_lastRenderedPixmap.size() != m_previousPagePixmap.size() )
+    {
+        qreal dpr = qApp->devicePixelRatio();
+        m_lastRenderedPixmap = QPixmap( m_width * dpr, m_height * dpr );
+        m_lastRenderedPixmap.setDevicePixelRatio(dpr);
     }
+    m_lastRenderedArea = m_frameIndex >= 0 && m_frameIndex < (int)m_document->pages() ? m_frames[ m_frameIndex ]->geometry : QRect( 0, 0, m_width, m_height );
 
     // opens the painter over the pixmap
     QPainter pixmapPainter;
@@ -1418,40 +1436,40 @@ void PresentationWidget::requestPixmaps()
     // ask for next and previous page if not in low memory usage setting
     if ( Okular::SettingsCore::memoryLevel() != Okular::SettingsCore::EnumMemoryLevel::Low )
     {
-        int pagesToPreload = 1;
+        // preload the next slides in the direction the presentation is
+        // going, the previous one has most likely just been shown
+        int pagesAhead = 2;
+        int pagesBehind = 0;
 
         // If greedy, preload everything
         if (Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Greedy)
-            pagesToPreload = (int)m_document->pages();
+            pagesAhead = pagesBehind = (int)m_document->pages();
 
         Okular::PixmapRequest::PixmapRequestFeatures requestFeatures = Okular::PixmapRequest::Preload;
         requestFeatures |= Okular::PixmapRequest::Asynchronous;
 
-        for( int j = 1; j <= pagesToPreload; j++ )
+        const int pageCount = m_frames.count();
+        const int step = m_goingBackwards ? -1 : 1;
+        // when preloading both ways everything is reached without wrapping around
+        const bool loop = pagesBehind == 0 && Okular::Settings::slidesLoop();
+        auto preloadPage = [&]( int page ) {
+            if ( loop )
+                page = ( page + pageCount ) % pageCount;
+            if ( page < 0 || page >= pageCount || page == m_frameIndex )
+                return;
+            PresentationFrame *preloadFrame = m_frames[ page ];
+            const int preloadW = preloadFrame->geometry.width();
+            const int preloadH = preloadFrame->geometry.height();
+            if ( !preloadFrame->page->hasPixmap( this, preloadW, preloadH ) )
+                requests.push_back( new Okular::PixmapRequest( this, page, preloadW, preloadH, PRESENTATION_PRELOAD_PRIO, requestFeatures ) );
+        };
+
+        for( int j = 1; j <= qMax( pagesAhead, pagesBehind ) && j < pageCount; j++ )
         {
-            int tailRequest = m_frameIndex + j;
-            if ( tailRequest < (int)m_document->pages() )
-            {
-                PresentationFrame *nextFrame = m_frames[ tailRequest ];
-                pixW = nextFrame->geometry.width();
-                pixH = nextFrame->geometry.height();
-                if ( !nextFrame->page->hasPixmap( this, pixW, pixH ) )
-                    requests.push_back( new Okular::PixmapRequest( this, tailRequest, pixW, pixH, PRESENTATION_PRELOAD_PRIO, requestFeatures ) );
-            }
-
-            int headRequest = m_frameIndex - j;
-            if ( headRequest >= 0 )
-            {
-                PresentationFrame *prevFrame = m_frames[ headRequest ];
-                pixW = prevFrame->geometry.width();
-                pixH = prevFrame->geometry.height();
-                if ( !prevFrame->page->hasPixmap( this, pixW, pixH ) )
-                    requests.push_back( new Okular::PixmapRequest( this, headRequest, pixW, pixH, PRESENTATION_PRELOAD_PRIO, requestFeatures ) );
-            }
-
-            // stop if we've already reached both ends of the document
-            if ( headRequest < 0 && tailRequest >= (int)m_document->pages() )
-                break;
+            if ( j <= pagesAhead )
+                preloadPage( m_frameIndex + j * step );
+            if ( j <= pagesBehind )
+                preloadPage( m_frameIndex - j * step );
         }
     }
     m_document->requestPixmaps( requests );
@@ -1482,7 +1500,7 @@ void PresentationWidget::slotNextPage()
         if ( m_transitionTimer->isActive() )
         {
             m_transitionTimer->stop();
-            m_lastRenderedPixmap = m_currentPagePixmap;
+            m_transition.stop();
             update();
         }
     }
@@ -1509,7 +1527,7 @@ void PresentationWidget::slotPrevPage()
         if ( m_transitionTimer->isActive() )
         {
             m_transitionTimer->stop();
-            m_lastRenderedPixmap = m_currentPagePixmap;
+            m_transition.stop();
             update();
         }
     }
@@ -1534,43 +1552,11 @@ void PresentationWidget::slotHideOverlay()
 
 void PresentationWidget::slotTransitionStep()
 {
-    switch( m_currentTransition.type() )
-    {
-        case Okular::PageTransition::Fade:
-        {
-            QPainter pixmapPainter;
-            m_currentPixmapOpacity += 1.0 / m_transitionSteps;
-            m_lastRenderedPixmap = QPixmap( m_lastRenderedPixmap.size() );
-            m_lastRenderedPixmap.setDevicePixelRatio( qApp->devicePixelRatio() );
-            m_lastRenderedPixmap.fill( Qt::transparent );
-            pixmapPainter.begin( &m_lastRenderedPixmap );
-            pixmapPainter.setCompositionMode( QPainter::CompositionMode_Source );
-            pixmapPainter.setOpacity( 1 - m_currentPixmapOpacity );
-            pixmapPainter.drawPixmap( 0, 0, m_previousPagePixmap );
-            pixmapPainter.setOpacity( m_currentPixmapOpacity );
-            pixmapPainter.drawPixmap( 0, 0, m_currentPagePixmap );
-            update();
-            if( m_currentPixmapOpacity >= 1 )
-                return;
-        } break;
-        default:
-        {
-            if ( m_transitionRects.empty() )
-            {
-                // it's better to fix the transition to cover the whole screen than
-                // enabling the following line that wastes cpu for nothing
-                //update();
-                return;
-            }
+    // the frame depends on the time elapsed, not on how many frames were shown
+    update( m_transition.advance( m_transitionTime.elapsed() ) );
 
-            for ( int i = 0; i < m_transitionMul && !m_transitionRects.empty(); i++ )
-            {
-                update( m_transitionRects.first() );
-                m_transitionRects.pop_front();
-            }
-        } break;
-    }
-    m_transitionTimer->start( m_transitionDelay );
+    if ( m_transition.isRunning() )
+        m_transitionTimer->start( TRANSITION_FRAME_INTERVAL );
 }
 
 void PresentationWidget::slotDelayedEvents()
@@ -1711,6 +1697,7 @@ void PresentationWidget::applyNewScreenSize( const QSize & oldSize )
     {
         m_transitionTimer->stop();
     }
+    m_transition.stop();
     generatePage( true /* no transitions */ );
 }
 
@@ -1979,395 +1966,17 @@ const Okular::PageTransition PresentationWidget::defaultTransition( int type ) c
 /** ONLY the TRANSITIONS GENERATION function from here on **/
 void PresentationWidget::initTransition( const Okular::PageTransition *transition )
 {
-    // if it's just a 'replace' transition, repaint the screen
-    if ( transition->type() == Okular::PageTransition::Replace )
+    // only the union of the old and the new page changes on the screen
+    const QRect area = m_lastRenderedArea | m_previousRenderedArea;
+
+    if ( !m_transition.start( *transition, m_previousPagePixmap, m_lastRenderedPixmap, QSize( m_width, m_height ), area ) )
     {
         update();
         return;
     }
 
-    const bool isInward = transition->direction() == Okular::PageTransition::Inward;
-    const bool isHorizontal = transition->alignment() == Okular::PageTransition::Horizontal;
-    const float totalTime = transition->duration();
-
-    m_transitionRects.clear();
-    m_currentTransition = *transition;
-    m_currentPagePixmap = m_lastRenderedPixmap;
-
-    switch( transition->type() )
-    {
-            // split: horizontal / vertical and inward / outward
-        case Okular::PageTransition::Split:
-        {
-            const int steps = isHorizontal ? 100 : 75;
-            if ( isHorizontal )
-            {
-                if ( isInward )
-                {
-                    int xPosition = 0;
-                    for ( int i = 0; i < steps; i++ )
-                    {
-                        int xNext = ((i + 1) * m_width) / (2 * steps);
-                        m_transitionRects.push_back( QRect( xPosition, 0, xNext - xPosition, m_height ) );
-                        m_transitionRects.push_back( QRect( m_width - xNext, 0, xNext - xPosition, m_height ) );
-                        xPosition = xNext;
-                    }
-                }
-                else
-                {
-                    int xPosition = m_width / 2;
-                    for ( int i = 0; i < steps; i++ )
-                    {
-                        int xNext = ((steps - (i + 1)) * m_width) / (2 * steps);
-                        m_transitionRects.push_back( QRect( xNext, 0, xPosition - xNext, m_height ) );
-                        m_transitionRects.push_back( QRect( m_width - xPosition, 0, xPosition - xNext, m_height ) );
-                        xPosition = xNext;
-                    }
-                }
-            }
-            else
-            {
-                if ( isInward )
-                {
-                    int yPosition = 0;
-                    for ( int i = 0; i < steps; i++ )
-                    {
-                        int yNext = ((i + 1) * m_height) / (2 * steps);
-                        m_transitionRects.push_back( QRect( 0, yPosition, m_width, yNext - yPosition ) );
-                        m_transitionRects.push_back( QRect( 0, m_height - yNext, m_width, yNext - yPosition ) );
-                        yPosition = yNext;
-                    }
-                }
-                else
-                {
-                    int yPosition = m_height / 2;
-                    for ( int i = 0; i < steps; i++ )
-                    {
-                        int yNext = ((steps - (i + 1)) * m_height) / (2 * steps);
-                        m_transitionRects.push_back( QRect( 0, yNext, m_width, yPosition - yNext ) );
-                        m_transitionRects.push_back( QRect( 0, m_height - yPosition, m_width, yPosition - yNext ) );
-                        yPosition = yNext;
-                    }
-                }
-            }
-            m_transitionMul = 2;
-            m_transitionDelay = (int)( (totalTime * 1000) / steps );
-        } break;
-
-            // blinds: horizontal(l-to-r) / vertical(t-to-b)
-        case Okular::PageTransition::Blinds:
-        {
-            const int blinds = isHorizontal ? 8 : 6;
-            const int steps = m_width / (4 * blinds);
-            if ( isHorizontal )
-            {
-                int xPosition[ 8 ];
-                for ( int b = 0; b < blinds; b++ )
-                    xPosition[ b ] = (b * m_width) / blinds;
-
-                for ( int i = 0; i < steps; i++ )
-                {
-                    int stepOffset = (int)( ((float)i * (float)m_width) / ((float)blinds * (float)steps) );
-                    for ( int b = 0; b < blinds; b++ )
-                    {
-                        m_transitionRects.push_back( QRect( xPosition[ b ], 0, stepOffset, m_height ) );
-                        xPosition[ b ] = stepOffset + (b * m_width) / blinds;
-                    }
-                }
-            }
-            else
-            {
-                int yPosition[ 6 ];
-                for ( int b = 0; b < blinds; b++ )
-                    yPosition[ b ] = (b * m_height) / blinds;
-
-                for ( int i = 0; i < steps; i++ )
-                {
-                    int stepOffset = (int)( ((float)i * (float)m_height) / ((float)blinds * (float)steps) );
-                    for ( int b = 0; b < blinds; b++ )
-                    {
-                        m_transitionRects.push_back( QRect( 0, yPosition[ b ], m_width, stepOffset ) );
-                        yPosition[ b ] = stepOffset + (b * m_height) / blinds;
-                    }
-                }
-            }
-            m_transitionMul = blinds;
-            m_transitionDelay = (int)( (totalTime * 1000) / steps );
-        } break;
-
-            // box: inward / outward
-        case Okular::PageTransition::Box:
-        {
-            const int steps = m_width / 10;
-            if ( isInward )
-            {
-                int L = 0, T = 0, R = m_width, B = m_height;
-                for ( int i = 0; i < steps; i++ )
-                {
-                    // compure shrinked box coords
-                    int newL = ((i + 1) * m_width) / (2 * steps);
-                    int newT = ((i + 1) * m_height) / (2 * steps);
-                    int newR = m_width - newL;
-                    int newB = m_height - newT;
-                    // add left, right, topcenter, bottomcenter rects
-                    m_transitionRects.push_back( QRect( L, T, newL - L, B - T ) );
-                    m_transitionRects.push_back( QRect( newR, T, R - newR, B - T ) );
-                    m_transitionRects.push_back( QRect( newL, T, newR - newL, newT - T ) );
-                    m_transitionRects.push_back( QRect( newL, newB, newR - newL, B - newB ) );
-                    L = newL; T = newT; R = newR, B = newB;
-                }
-            }
-            else
-            {
-                int L = m_width / 2, T = m_height / 2, R = L, B = T;
-                for ( int i = 0; i < steps; i++ )
-                {
-                    // compure shrinked box coords
-                    int newL = ((steps - (i + 1)) * m_width) / (2 * steps);
-                    int newT = ((steps - (i + 1)) * m_height) / (2 * steps);
-                    int newR = m_width - newL;
-                    int newB = m_height - newT;
-                    // add left, right, topcenter, bottomcenter rects
-                    m_transitionRects.push_back( QRect( newL, newT, L - newL, newB - newT ) );
-                    m_transitionRects.push_back( QRect( R, newT, newR - R, newB - newT ) );
-                    m_transitionRects.push_back( QRect( L, newT, R - L, T - newT ) );
-                    m_transitionRects.push_back( QRect( L, B, R - L, newB - B ) );
-                    L = newL; T = newT; R = newR, B = newB;
-                }
-            }
-            m_transitionMul = 4;
-            m_transitionDelay = (int)( (totalTime * 1000) / steps );
-        } break;
-
-            // wipe: implemented for 4 canonical angles
-        case Okular::PageTransition::Wipe:
-        {
-            const int angle = transition->angle();
-            const int steps = (angle == 0) || (angle == 180) ? m_width / 8 : m_height / 8;
-            if ( angle == 0 )
-            {
-                int xPosition = 0;
-                for ( int i = 0; i < steps; i++ )
-                {
-                    int xNext = ((i + 1) * m_width) / steps;
-                    m_transitionRects.push_back( QRect( xPosition, 0, xNext - xPosition, m_height ) );
-                    xPosition = xNext;
-                }
-            }
-            else if ( angle == 90 )
-            {
-                int yPosition = m_height;
-                for ( int i = 0; i < steps; i++ )
-                {
-                    int yNext = ((steps - (i + 1)) * m_height) / steps;
-                    m_transitionRects.push_back( QRect( 0, yNext, m_width, yPosition - yNext ) );
-                    yPosition = yNext;
-                }
-            }
-            else if ( angle == 180 )
-            {
-                int xPosition = m_width;
-                for ( int i = 0; i < steps; i++ )
-                {
-                    int xNext = ((steps - (i + 1)) * m_width) / steps;
-                    m_transitionRects.push_back( QRect( xNext, 0, xPosition - xNext, m_height ) );
-                    xPosition = xNext;
-                }
-            }
-            else if ( angle == 270 )
-            {
-                int yPosition = 0;
-                for ( int i = 0; i < steps; i++ )
-                {
-                    int yNext = ((i + 1) * m_height) / steps;
-                    m_transitionRects.push_back( QRect( 0, yPosition, m_width, yNext - yPosition ) );
-                    yPosition = yNext;
-                }
-            }
-            else
-            {
-                update();
-                return;
-            }
-            m_transitionMul = 1;
-            m_transitionDelay = (int)( (totalTime * 1000) / steps );
-        } break;
-
-            // dissolve: replace 'random' rects
-        case Okular::PageTransition::Dissolve:
-        {
-            const int gridXsteps = 50;
-            const int gridYsteps = 38;
-            const int steps = gridXsteps * gridYsteps;
-            int oldX = 0;
-            int oldY = 0;
-            // create a grid of gridXstep by gridYstep QRects
-            for ( int y = 0; y < gridYsteps; y++ )
-            {
-                int newY = (int)( m_height * ((float)(y+1) / (float)gridYsteps) );
-                for ( int x = 0; x < gridXsteps; x++ )
-                {
-                    int newX = (int)( m_width * ((float)(x+1) / (float)gridXsteps) );
-                    m_transitionRects.push_back( QRect( oldX, oldY, newX - oldX, newY - oldY ) );
-                    oldX = newX;
-                }
-                oldX = 0;
-                oldY = newY;
-            }
-            // randomize the grid
-            for ( int i = 0; i < steps; i++ )
-            {
-#ifndef Q_OS_WIN
-                int n1 = (int)(steps * drand48());
-                int n2 = (int)(steps * drand48());
-#else
-                int n1 = (int)(steps * (std::rand() / RAND_MAX));
-                int n2 = (int)(steps * (std::rand() / RAND_MAX));
-#endif
-                // swap items if index differs
-                if ( n1 != n2 )
-                {
-                    QRect r = m_transitionRects[ n2 ];
-                    m_transitionRects[ n2 ] = m_transitionRects[ n1 ];
-                    m_transitionRects[ n1 ] = r;
-                }
-            }
-            // set global transition parameters
-            m_transitionMul = 40;
-            m_transitionDelay = (int)( (m_transitionMul * 1000 * totalTime) / steps );
-        } break;
-
-            // glitter: similar to dissolve but has a direction
-        case Okular::PageTransition::Glitter:
-        {
-            const int gridXsteps = 50;
-            const int gridYsteps = 38;
-            const int steps = gridXsteps * gridYsteps;
-            const int angle = transition->angle();
-            // generate boxes using a given direction
-            if ( angle == 90 )
-            {
-                int yPosition = m_height;
-                for ( int i = 0; i < gridYsteps; i++ )
-                {
-                    int yNext = ((gridYsteps - (i + 1)) * m_height) / gridYsteps;
-                    int xPosition = 0;
-                    for ( int j = 0; j < gridXsteps; j++ )
-                    {
-                        int xNext = ((j + 1) * m_width) / gridXsteps;
-                        m_transitionRects.push_back( QRect( xPosition, yNext, xNext - xPosition, yPosition - yNext ) );
-                        xPosition = xNext;
-                    }
-                    yPosition = yNext;
-                }
-            }
-            else if ( angle == 180 )
-            {
-                int xPosition = m_width;
-                for ( int i = 0; i < gridXsteps; i++ )
-                {
-                    int xNext = ((gridXsteps - (i + 1)) * m_width) / gridXsteps;
-                    int yPosition = 0;
-                    for ( int j = 0; j < gridYsteps; j++ )
-                    {
-                        int yNext = ((j + 1) * m_height) / gridYsteps;
-                        m_transitionRects.push_back( QRect( xNext, yPosition, xPosition - xNext, yNext - yPosition ) );
-                        yPosition = yNext;
-                    }
-                    xPosition = xNext;
-                }
-            }
-            else if ( angle == 270 )
-            {
-                int yPosition = 0;
-                for ( int i = 0; i < gridYsteps; i++ )
-                {
-                    int yNext = ((i + 1) * m_height) / gridYsteps;
-                    int xPosition = 0;
-                    for ( int j = 0; j < gridXsteps; j++ )
-                    {
-                        int xNext = ((j + 1) * m_width) / gridXsteps;
-                        m_transitionRects.push_back( QRect( xPosition, yPosition, xNext - xPosition, yNext - yPosition ) );
-                        xPosition = xNext;
-                    }
-                    yPosition = yNext;
-                }
-            }
-            else // if angle is 0 or 315
-            {
-                int xPosition = 0;
-                for ( int i = 0; i < gridXsteps; i++ )
-                {
-                    int xNext = ((i + 1) * m_width) / gridXsteps;
-                    int yPosition = 0;
-                    for ( int j = 0; j < gridYsteps; j++ )
-                    {
-                        int yNext = ((j + 1) * m_height) / gridYsteps;
-                        m_transitionRects.push_back( QRect( xPosition, yPosition, xNext - xPosition, yNext - yPosition ) );
-                        yPosition = yNext;
-                    }
-                    xPosition = xNext;
-                }
-            }
-            // add a 'glitter' (1 over 10 pieces is randomized)
-            int randomSteps = steps / 20;
-            for ( int i = 0; i < randomSteps; i++ )
-            {
-#ifndef Q_OS_WIN
-                int n1 = (int)(steps * drand48());
-                int n2 = (int)(steps * drand48());
-#else
-                int n1 = (int)(steps * (std::rand() / RAND_MAX));
-                int n2 = (int)(steps * (std::rand() / RAND_MAX));
-#endif
-                // swap items if index differs
-                if ( n1 != n2 )
-                {
-                    QRect r = m_transitionRects[ n2 ];
-                    m_transitionRects[ n2 ] = m_transitionRects[ n1 ];
-                    m_transitionRects[ n1 ] = r;
-                }
-            }
-            // set global transition parameters
-            m_transitionMul = (angle == 90) || (angle == 270) ? gridYsteps : gridXsteps;
-            m_transitionMul /= 2;
-            m_transitionDelay = (int)( (m_transitionMul * 1000 * totalTime) / steps );
-        } break;
-
-        case Okular::PageTransition::Fade:
-        {
-            enum {FADE_TRANSITION_FPS = 20};
-            const int steps = totalTime * FADE_TRANSITION_FPS;
-            m_transitionSteps = steps;
-            QPainter pixmapPainter;
-            m_currentPixmapOpacity = (double) 1 / steps;
-            m_transitionDelay = (int)( totalTime * 1000 ) / steps;
-            m_lastRenderedPixmap = QPixmap( m_lastRenderedPixmap.size() );
-            m_lastRenderedPixmap.fill( Qt::transparent );
-            pixmapPainter.begin( &m_lastRenderedPixmap );
-            pixmapPainter.setCompositionMode( QPainter::CompositionMode_Source );
-            pixmapPainter.setOpacity( 1 - m_currentPixmapOpacity );
-            pixmapPainter.drawPixmap( 0, 0, m_previousPagePixmap );
-            pixmapPainter.setOpacity( m_currentPixmapOpacity );
-            pixmapPainter.drawPixmap( 0, 0, m_currentPagePixmap );
-            pixmapPainter.end();
-            update();
-        } break;
-        // implement missing transitions (a binary raster engine needed here)
-        case Okular::PageTransition::Fly:
-
-        case Okular::PageTransition::Push:
-
-        case Okular::PageTransition::Cover:
-
-        case Okular::PageTransition::Uncover:
-
-        default:
-            update();
-            return;
-    }
-
     // send the first start to the timer
+    m_transitionTime.start();
     m_transitionTimer->start( 0 );
 }
 
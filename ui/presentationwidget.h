@@ -11,6 +11,7 @@
 #define _OKULAR_PRESENTATIONWIDGET_H_
 
 #include <QDomElement>
+#include <QElapsedTimer>
 #include <qlist.h>
 #include <qpixmap.h>
 #include <qstringlist.h>
@@ -18,6 +19,7 @@
 #include "core/area.h"
 #include "core/observer.h"
 #include "core/pagetransition.h"
+#include "presentationtransition.h"
 
 class QLineEdit;
 class QToolBar;
@@ -120,14 +122,11 @@ class PresentationWidget : public QWidget, public Okular::DocumentObserver
         QTimer * m_transitionTimer;
         QTimer * m_overlayHideTimer;
         QTimer * m_nextPageTimer;
-        int m_transitionDelay;
-        int m_transitionMul;
-        int m_transitionSteps;
-        QList< QRect > m_transitionRects;
-        Okular::PageTransition m_currentTransition;
-        QPixmap m_currentPagePixmap;
+        QElapsedTimer m_transitionTime;
+        PresentationTransition m_transition;
         QPixmap m_previousPagePixmap;
-        double m_currentPixmapOpacity;
+        QRect m_lastRenderedArea;
+        QRect m_previousRenderedArea;
 
         // misc stuff
         QWidget * m_parentWidget;
@@ -147,6 +146,7 @@ class PresentationWidget : public QWidget, public Okular::DocumentObserver
         bool m_showSummaryView;
         bool m_advanceSlides;
         bool m_goToNextPageOnRelease;
+        bool m_goingBackwards;
 
     private Q_SLOTS:
         void slotNextPage();
@@ -60,7 +60,10 @@ TOC::~TOC()
 
 void TOC::notifySetup( const QVector< Okular::Page * > & /*pages*/, int setupFlags )
 {
-    if ( !( setupFlags & Okular::DocumentObserver::DocumentChanged ) )
+    // a document reloaded in place (see prepareForReload) only changes its
+    // url, but it may come with a different synopsis
+    const bool reloaded = ( setupFlags & Okular::DocumentObserver::UrlChanged ) && ( m_model->hasOldModelData() || m_model->isEmpty() );
+    if ( !( setupFlags & Okular::DocumentObserver::DocumentChanged ) && !reloaded )
         return;
 
     // clear contents
@@ -123,12 +126,11 @@ QVector<QModelIndex> TOC::expandedNodes( const QModelIndex &parent ) const
     for ( int i = 0; i < m_model->rowCount( parent ); i++ )
     {
         const QModelIndex index = m_model->index( i, 0, parent );
+        // children of collapsed nodes are not looked at, so that a huge
+        // synopsis does not get fully loaded on every reload
         if ( m_treeView->isExpanded( index ) )
         {
             list << index;
-        }
-        if ( m_model->hasChildren( index ) )
-        {
             list << expandedNodes( index );
         }
     }
@@ -11,28 +11,72 @@
 
 #include <qapplication.h>
 #include <qdom.h>
+#include <qelapsedtimer.h>
+#include <qhash.h>
 #include <qlist.h>
+#include <qtimer.h>
 #include <qtreeview.h>
 
 #include <QIcon>
 
+#include <algorithm>
+
 #include "pageitemdelegate.h"
 #include "core/document.h"
 #include "core/page.h"
 
 Q_DECLARE_METATYPE( QModelIndex )
 
+// how long (in milliseconds) a batch of named viewport lookups may take
+// before giving control back to the event loop
+#define NAMED_VIEWPORT_BATCH_TIME 10
+
+/**
+ * One entry of the synopsis, stored flat in document (pre)order.
+ *
+ * The entries are cheap to build for the whole synopsis and hold what is
+ * needed to locate the current page; the TOCItem shown by the view are only
+ * created when their parent is expanded.
+ */
+struct TOCItem;
+
+struct TOCEntry
+{
+    QDomElement element;
+    Okular::DocumentViewport viewport;
+    int parent;         // -1 for the top level entries
+    int nextSibling;    // -1 for the last child
+    int row;
+    bool resolved : 1;  // false until the ViewportName has been looked up
+    TOCItem *item;
+};
+
+/**
+ * The pages of the children of an entry that have a valid viewport,
+ * in document order; when they are sorted they can be bisected.
+ */
+struct TOCPageIndex
+{
+    QVector< int > pages;
+    QVector< int > entries;
+    bool sorted;
+};
+
 struct TOCItem
 {
     TOCItem();
-    TOCItem( TOCItem *parent, const QDomElement &e );
+    TOCItem( TOCItem *parent, int entry );
     ~TOCItem();
 
+    const Okular::DocumentViewport &viewport() const;
+
     QString text;
-    Okular::DocumentViewport viewport;
     QString extFileName;
     QString url;
     bool highlight : 1;
+    bool populated : 1;
+    int entry;
+    int row;
     TOCItem *parent;
     QList< TOCItem* > children;
     TOCModelPrivate *model;
@@ -45,50 +89,51 @@ public:
     TOCModelPrivate( TOCModel *qq );
     ~TOCModelPrivate();
 
-    void addChildren( const QDomNode &parentNode, TOCItem * parentItem );
+    void addEntries( const QDomNode &parentNode, int parent, int depth, QVector< QPair< int, int > > &named );
+    int firstChild( int entry ) const;
+    void populate( TOCItem *item );
+    TOCItem *itemForEntry( int entry );
+    bool resolveEntry( int entry );
+    void resolveNamedViewports();
+    void stopResolving();
+    const TOCPageIndex &pageIndex( int parent );
     QModelIndex indexForItem( TOCItem *item ) const;
-    void findViewport( const Okular::DocumentViewport &viewport, TOCItem *item, QList< TOCItem* > &list ) const;
+    void findViewport( const Okular::DocumentViewport &viewport, QList< TOCItem* > &list );
 
     TOCModel *q;
     TOCItem *root;
     bool dirty : 1;
     Okular::Document *document;
-    QList< TOCItem* > itemsToOpen;
+    QVector< TOCEntry > entries;
+    QHash< int, TOCPageIndex > pageIndexes;
+    QVector< int > pendingNamedViewports;
+    int pendingNamedViewportsPos;
+    QTimer resolveTimer;
+    QVector< int > entriesToOpen;
     QList< TOCItem* > currentPage;
+    Okular::DocumentViewport currentViewport;
     TOCModel *m_oldModel;
     QVector<QModelIndex> m_oldTocExpandedIndexes;
 };
 
 
 TOCItem::TOCItem()
-    : highlight( false ), parent( nullptr ), model( nullptr )
+    : highlight( false ), populated( false ), entry( -1 ), row( 0 ), parent( nullptr ), model( nullptr )
 {
 }
 
-TOCItem::TOCItem( TOCItem *_parent, const QDomElement &e )
-    : highlight( false ), parent( _parent )
+TOCItem::TOCItem( TOCItem *_parent, int _entry )
+    : highlight( false ), populated( false ), entry( _entry ), parent( _parent )
 {
+    row = parent->children.count();
     parent->children.append( this );
     model = parent->model;
-    text = e.tagName();
 
-    // viewport loading
-    if ( e.hasAttribute( QStringLiteral("Viewport") ) )
-    {
-        // if the node has a viewport, set it
-        viewport = Okular::DocumentViewport( e.attribute( QStringLiteral("Viewport") ) );
-    }
-    else if ( e.hasAttribute( QStringLiteral("ViewportName") ) )
-    {
-        // if the node references a viewport, get the reference and set it
-        const QString & page = e.attribute( QStringLiteral("ViewportName") );
-        QString viewport_string = model->document->metaData( QStringLiteral("NamedViewport"), page ).toString();
-        if ( !viewport_string.isEmpty() )
-            viewport = Okular::DocumentViewport( viewport_string );
-    }
-
-    extFileName = e.attribute( QStringLiteral("ExternalFileName") );
-    url = e.attribute( QStringLiteral("URL") );
+    TOCEntry &e = model->entries[ entry ];
+    e.item = this;
+    text = e.element.tagName();
+    extFileName = e.element.attribute( QStringLiteral("ExternalFileName") );
+    url = e.element.attribute( QStringLiteral("URL") );
 }
 
 TOCItem::~TOCItem()
@@ -96,11 +141,19 @@ TOCItem::~TOCItem()
     qDeleteAll( children );
 }
 
+const Okular::DocumentViewport &TOCItem::viewport() const
+{
+    return model->entries.at( entry ).viewport;
+}
+
 
 TOCModelPrivate::TOCModelPrivate( TOCModel *qq )
-    : q( qq ), root( new TOCItem ), dirty( false ), m_oldModel( nullptr )
+    : q( qq ), root( new TOCItem ), dirty( false ), pendingNamedViewportsPos( 0 ), m_oldModel( nullptr )
 {
     root->model = this;
+    resolveTimer.setSingleShot( true );
+    resolveTimer.setInterval( 0 );
+    QObject::connect( &resolveTimer, &QTimer::timeout, q, [this] { resolveNamedViewports(); } );
 }
 
 TOCModelPrivate::~TOCModelPrivate()
@@ -109,82 +162,202 @@ TOCModelPrivate::~TOCModelPrivate()
     delete m_oldModel;
 }
 
-void TOCModelPrivate::addChildren( const QDomNode & parentNode, TOCItem * parentItem )
+void TOCModelPrivate::addEntries( const QDomNode &parentNode, int parent, int depth, QVector< QPair< int, int > > &named )
 {
-    TOCItem * currentItem = nullptr;
+    int previous = -1;
+    int row = 0;
     QDomNode n = parentNode.firstChild();
     while( !n.isNull() )
     {
         // convert the node to an element (sure it is)
-        QDomElement e = n.toElement();
+        const QDomElement e = n.toElement();
+        const int current = entries.count();
+
+        TOCEntry entry;
+        entry.element = e;
+        entry.parent = parent;
+        entry.nextSibling = -1;
+        entry.row = row++;
+        entry.resolved = true;
+        entry.item = nullptr;
+
+        // viewport loading; named viewports need to ask the generator, so
+        // they are looked up later in batches, top level entries first
+        if ( e.hasAttribute( QStringLiteral("Viewport") ) )
+        {
+            entry.viewport = Okular::DocumentViewport( e.attribute( QStringLiteral("Viewport") ) );
+        }
+        else if ( e.hasAttribute( QStringLiteral("ViewportName") ) )
+        {
+            entry.resolved = false;
+            named.append( qMakePair( depth, current ) );
+        }
 
-        // insert the entry as top level (listview parented) or 2nd+ level
-        currentItem = new TOCItem( parentItem, e );
+        entries.append( entry );
+        if ( previous != -1 )
+            entries[ previous ].nextSibling = current;
+        previous = current;
+
+        // open/keep close the item
+        if ( e.hasAttribute( QStringLiteral("Open") ) && QVariant( e.attribute( QStringLiteral("Open") ) ).toBool() )
+            entriesToOpen.append( current );
 
         // descend recursively and advance to the next node
         if ( e.hasChildNodes() )
-            addChildren( n, currentItem );
-
-        // open/keep close the item
-        bool isOpen = false;
-        if ( e.hasAttribute( QStringLiteral("Open") ) )
-            isOpen = QVariant( e.attribute( QStringLiteral("Open") ) ).toBool();
-        if ( isOpen )
-            itemsToOpen.append( currentItem );
+            addEntries( n, current, depth + 1, named );
 
         n = n.nextSibling();
-        emit q->countChanged();
     }
 }
 
-QModelIndex TOCModelPrivate::indexForItem( TOCItem *item ) const
+int TOCModelPrivate::firstChild( int entry ) const
 {
-    if ( item->parent )
+    // the children of an entry directly follow it
+    const int child = entry + 1;
+    if ( child < entries.count() && entries.at( child ).parent == entry )
+        return child;
+    return -1;
+}
+
+void TOCModelPrivate::populate( TOCItem *item )
+{
+    if ( item->populated )
+        return;
+
+    item->populated = true;
+    for ( int child = firstChild( item->entry ); child != -1; child = entries.at( child ).nextSibling )
+        new TOCItem( item, child );
+}
+
+TOCItem *TOCModelPrivate::itemForEntry( int entry )
+{
+    TOCEntry &e = entries[ entry ];
+    if ( !e.item )
+        populate( e.parent == -1 ? root : itemForEntry( e.parent ) );
+    return e.item;
+}
+
+bool TOCModelPrivate::resolveEntry( int entry )
+{
+    TOCEntry &e = entries[ entry ];
+    if ( e.resolved )
+        return false;
+
+    e.resolved = true;
+    const QString &page = e.element.attribute( QStringLiteral("ViewportName") );
+    const QString viewport_string = document->metaData( QStringLiteral("NamedViewport"), page ).toString();
+    if ( viewport_string.isEmpty() )
+        return false;
+
+    e.viewport = Okular::DocumentViewport( viewport_string );
+    pageIndexes.remove( e.parent );
+    if ( e.item )
+    {
+        const QModelIndex index = indexForItem( e.item );
+        emit q->dataChanged( index, index );
+    }
+    return true;
+}
+
+void TOCModelPrivate::resolveNamedViewports()
+{
+    QElapsedTimer time;
+    time.start();
+
+    bool changed = false;
+    do
+    {
+        changed |= resolveEntry( pendingNamedViewports.at( pendingNamedViewportsPos++ ) );
+    } while ( pendingNamedViewportsPos < pendingNamedViewports.count() && !time.hasExpired( NAMED_VIEWPORT_BATCH_TIME ) );
+
+    if ( pendingNamedViewportsPos < pendingNamedViewports.count() )
+        resolveTimer.start();
+    else
+        stopResolving();
+
+    // the new pages may move the highlight
+    if ( changed && currentViewport.isValid() )
+        q->setCurrentViewport( currentViewport );
+}
+
+void TOCModelPrivate::stopResolving()
+{
+    resolveTimer.stop();
+    pendingNamedViewports.clear();
+    pendingNamedViewportsPos = 0;
+}
+
+const TOCPageIndex &TOCModelPrivate::pageIndex( int parent )
+{
+    QHash< int, TOCPageIndex >::iterator it = pageIndexes.find( parent );
+    if ( it == pageIndexes.end() )
     {
-        int id = item->parent->children.indexOf( item );
-        if ( id >= 0 && id < item->parent->children.count() )
-           return q->createIndex( id, 0, item );
+        TOCPageIndex index;
+        index.sorted = true;
+        for ( int child = firstChild( parent ); child != -1; child = entries.at( child ).nextSibling )
+        {
+            const Okular::DocumentViewport &viewport = entries.at( child ).viewport;
+            if ( !viewport.isValid() )
+                continue;
+
+            if ( !index.pages.isEmpty() && viewport.pageNumber < index.pages.last() )
+                index.sorted = false;
+            index.pages.append( viewport.pageNumber );
+            index.entries.append( child );
+        }
+        it = pageIndexes.insert( parent, index );
     }
+    return it.value();
+}
+
+QModelIndex TOCModelPrivate::indexForItem( TOCItem *item ) const
+{
+    if ( item->parent )
+        return q->createIndex( item->row, 0, item );
+
     return QModelIndex();
 }
 
-void TOCModelPrivate::findViewport( const Okular::DocumentViewport &viewport, TOCItem *item, QList< TOCItem* > &list ) const
+void TOCModelPrivate::findViewport( const Okular::DocumentViewport &viewport, QList< TOCItem* > &list )
 {
-    TOCItem *todo = item;
+    int parent = -1;
 
-    while ( todo )
+    while ( true )
     {
-        TOCItem *current = todo;
-        todo = nullptr;
-        TOCItem *pos = nullptr;
+        const TOCPageIndex &index = pageIndex( parent );
+        int pos = -1;
 
-        foreach ( TOCItem *child, current->children )
+        if ( index.sorted )
+        {
+            // the first child on the page, or else the last one before it
+            const QVector< int >::const_iterator it = std::lower_bound( index.pages.constBegin(), index.pages.constEnd(), viewport.pageNumber );
+            if ( it != index.pages.constEnd() && *it == viewport.pageNumber )
+                pos = index.entries.at( it - index.pages.constBegin() );
+            else if ( it != index.pages.constBegin() )
+                pos = index.entries.at( it - index.pages.constBegin() - 1 );
+        }
+        else
         {
-            if ( child->viewport.isValid() )
+            for ( int i = 0; i < index.pages.count(); ++i )
             {
-                if ( child->viewport.pageNumber <= viewport.pageNumber )
-                {
-                    pos = child;
-                    if ( child->viewport.pageNumber == viewport.pageNumber )
-                    {
-                        break;
-                    }
-                }
-                else
-                {
+                const int page = index.pages.at( i );
+                if ( page > viewport.pageNumber )
+                    break;
+
+                pos = index.entries.at( i );
+                if ( page == viewport.pageNumber )
                     break;
-                }
             }
         }
-        if ( pos )
-        {
-            list.append( pos );
-            todo = pos;
-        }
+
+        if ( pos == -1 )
+            break;
+
+        list.append( itemForEntry( pos ) );
+        parent = pos;
     }
 }
 
-
 TOCModel::TOCModel( Okular::Document *document, QObject *parent )
     : QAbstractItemModel( parent ), d( new TOCModelPrivate( this ) )
 {
@@ -253,12 +426,12 @@ QVariant TOCModel::data( const QModelIndex &index, int role ) const
             }
             break;
         case PageItemDelegate::PageRole:
-            if ( item->viewport.isValid() )
-                return item->viewport.pageNumber + 1;
+            if ( item->viewport().isValid() )
+                return item->viewport().pageNumber + 1;
             break;
         case PageItemDelegate::PageLabelRole:
-            if ( item->viewport.isValid() && item->viewport.pageNumber < int(d->document->pages()) )
-                return d->document->page( item->viewport.pageNumber )->label();
+            if ( item->viewport().isValid() && item->viewport().pageNumber < int(d->document->pages()) )
+                return d->document->page( item->viewport().pageNumber )->label();
             break;
     }
     return QVariant();
@@ -270,7 +443,7 @@ bool TOCModel::hasChildren( const QModelIndex &parent ) const
         return true;
 
     TOCItem *item = static_cast< TOCItem* >( parent.internalPointer() );
-    return !item->children.isEmpty();
+    return d->firstChild( item->entry ) != -1;
 }
 
 QVariant TOCModel::headerData( int section, Qt::Orientation orientation, int role ) const
@@ -290,6 +463,7 @@ QModelIndex TOCModel::index( int row, int column, const QModelIndex &parent ) co
         return QModelIndex();
 
     TOCItem *item = parent.isValid() ? static_cast< TOCItem* >( parent.internalPointer() ) : d->root;
+    d->populate( item );
     if ( row < item->children.count() )
         return createIndex( row, column, item->children.at( row ) );
 
@@ -308,6 +482,7 @@ QModelIndex TOCModel::parent( const QModelIndex &index ) const
 int TOCModel::rowCount( const QModelIndex &parent ) const
 {
     TOCItem *item = parent.isValid() ? static_cast< TOCItem* >( parent.internalPointer() ) : d->root;
+    d->populate( item );
     return item->children.count();
 }
 
@@ -332,9 +507,21 @@ void TOCModel::fill( const Okular::DocumentSynopsis *toc )
 
     clear();
     emit layoutAboutToBeChanged();
-    d->addChildren( *toc, d->root );
+    QVector< QPair< int, int > > named;
+    d->addEntries( *toc, -1, 0, named );
     d->dirty = true;
     emit layoutChanged();
+    emit countChanged();
+
+    // look up the named viewports level by level, so the ones most likely
+    // visible (and needed to find the current page) come first
+    std::stable_sort( named.begin(), named.end(), []( const QPair< int, int > &a, const QPair< int, int > &b ) { return a.first < b.first; } );
+    d->pendingNamedViewports.reserve( named.count() );
+    for ( const QPair< int, int > &entry : qAsConst( named ) )
+        d->pendingNamedViewports.append( entry.second );
+    if ( !d->pendingNamedViewports.isEmpty() )
+        d->resolveTimer.start();
+
     if ( equals( d->m_oldModel ) )
     {
         foreach( const QModelIndex &oldIndex, d->m_oldTocExpandedIndexes )
@@ -349,9 +536,9 @@ void TOCModel::fill( const Okular::DocumentSynopsis *toc )
     }
     else
     {
-        foreach ( TOCItem *item, d->itemsToOpen )
+        foreach ( int entry, d->entriesToOpen )
         {
-            const QModelIndex index = d->indexForItem( item );
+            const QModelIndex index = d->indexForItem( d->itemForEntry( entry ) );
             if ( !index.isValid() )
                 continue;
 
@@ -359,7 +546,7 @@ void TOCModel::fill( const Okular::DocumentSynopsis *toc )
             QMetaObject::invokeMethod( QObject::parent(), "expand", Qt::QueuedConnection, Q_ARG( QModelIndex, index ) );
         }
     }
-    d->itemsToOpen.clear();
+    d->entriesToOpen.clear();
     delete d->m_oldModel;
     d->m_oldModel = nullptr;
     d->m_oldTocExpandedIndexes.clear();
@@ -371,9 +558,14 @@ void TOCModel::clear()
        return;
 
     beginResetModel();
+    d->stopResolving();
     qDeleteAll( d->root->children );
     d->root->children.clear();
+    d->root->populated = false;
+    d->entries.clear();
+    d->pageIndexes.clear();
     d->currentPage.clear();
+    d->currentViewport = Okular::DocumentViewport();
     endResetModel();
     d->dirty = false;
 }
@@ -390,9 +582,10 @@ void TOCModel::setCurrentViewport( const Okular::DocumentViewport &viewport )
         emit dataChanged( index, index );
     }
     d->currentPage.clear();
+    d->currentViewport = viewport;
 
     QList< TOCItem* > newCurrentPage;
-    d->findViewport( viewport, d->root, newCurrentPage );
+    d->findViewport( viewport, newCurrentPage );
 
     d->currentPage = newCurrentPage;
 
@@ -409,7 +602,7 @@ void TOCModel::setCurrentViewport( const Okular::DocumentViewport &viewport )
 
 bool TOCModel::isEmpty() const
 {
-    return d->root->children.isEmpty();
+    return d->entries.isEmpty();
 }
 
 bool TOCModel::equals( const TOCModel *model ) const
@@ -425,6 +618,11 @@ void TOCModel::setOldModelData( TOCModel *model, const QVector<QModelIndex> &lis
     delete d->m_oldModel;
     d->m_oldModel = model;
     d->m_oldTocExpandedIndexes = list;
+
+    // the old model is only kept to be compared with the new one, and its
+    // named viewports belong to the previous generator
+    if ( model )
+        model->d->stopResolving();
 }
 
 bool TOCModel::hasOldModelData() const
@@ -455,7 +653,8 @@ Okular::DocumentViewport TOCModel::viewportForIndex( const QModelIndex &index )
         return Okular::DocumentViewport();
 
     TOCItem *item = static_cast< TOCItem* >( index.internalPointer() );
-    return item->viewport;
+    d->resolveEntry( item->entry );
+    return item->viewport();
 }
 
 QString TOCModel::urlForIndex( const QModelIndex &index ) const
@@ -483,6 +682,12 @@ bool TOCModel::checkequality( const TOCModel *model, const QModelIndex & parentA
         {
             return false;
         }
+        // branches never expanded in the old model have no state to restore,
+        // don't create all of their items just to compare them
+        if ( !static_cast< TOCItem* >( indxB.internalPointer() )->populated )
+        {
+            continue;
+        }
         if ( !checkequality( model, indxA, indxB ) )
         {
             return false;